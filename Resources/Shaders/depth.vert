@@ -0,0 +1,16 @@
+#version 450
+
+layout (set = 0, binding = 0) uniform transforms_ {
+    mat4 view;
+    mat4 projection;
+} transforms;
+
+
+layout (location = 0) in vec3 positions;
+
+// Must match shader.vert bit for bit, the color pass tests with VK_COMPARE_OP_EQUAL.
+invariant gl_Position;
+
+void main() {
+    gl_Position = transforms.projection * transforms.view * vec4(positions, 1.0);
+}
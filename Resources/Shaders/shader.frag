@@ -1,9 +1,19 @@
 #version 450
 
 layout(location = 0) in vec4 fragColor;
+layout(location = 1) flat in uint fragTriangleBase;
 
 layout(location = 0) out vec4 outColor;
+layout(location = 1) out uint outId;
+
+// Set by PipelineManager when the render pass has the id attachment (VkAppSettings::id_buffer).
+layout (constant_id = 4) const bool object_id = false;
 
 void main() {
     outColor = fragColor;
+
+    // Triangle in the index buffer of the batch, plus one: 0 is the clear value (nothing drawn).
+    if (object_id) {
+        outId = fragTriangleBase + uint(gl_PrimitiveID) + 1u;
+    }
 }
\ No newline at end of file
@@ -12,7 +12,22 @@ layout (location = 2) in vec3 normals;
 
 layout(location = 0) out vec4 fragColor;
 
+// First triangle of the draw (first index / 3), passed as the first instance. See shader.frag.
+layout(location = 1) flat out uint fragTriangleBase;
+
+// Set per pipeline by PipelineManager (PipelineDesc::light_direction, ShaderFeature_Lighting).
+layout (constant_id = 0) const float light_direction_x = -0.0;
+layout (constant_id = 1) const float light_direction_y = 2.0;
+layout (constant_id = 2) const float light_direction_z = -0.2;
+layout (constant_id = 3) const bool lighting = true;
+
+// Must match depth.vert bit for bit, the color pass tests with VK_COMPARE_OP_EQUAL.
+invariant gl_Position;
+
 void main() {
     gl_Position = transforms.projection * transforms.view * vec4(positions, 1.0);
-    fragColor = colors * max(dot(normals, vec3(-0.0, 2.0, -0.2)), 0.1);
+    fragColor = lighting
+        ? colors * max(dot(normals, vec3(light_direction_x, light_direction_y, light_direction_z)), 0.1)
+        : colors;
+    fragTriangleBase = uint(gl_InstanceIndex);
 }
\ No newline at end of file
@@ -0,0 +1,971 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "VkApp.h"
+#include "BatchBuilder.h"
+#include "Bvh.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/// Offline benchmark of the mesh import and render pipeline.
+///
+/// Usage: Benchmark [--iterations N] [--frames N] [--id-buffer] [--output path.json]
+///
+/// Every stage reports min/mean/p50/p95/p99/max in milliseconds and the peak resident memory of the process
+/// at the end of the stage. Rendering uses a headless surface, so it runs on a software driver (lavapipe) too.
+
+namespace
+{
+struct Options
+{
+	uint32_t    iterations  = 10;
+	uint32_t    frame_count = 500;
+	const char* output_path = nullptr;
+
+	/// Render with VkAppSettings::id_buffer and time the GPU picks too.
+	bool id_buffer = false;
+};
+
+struct Stage
+{
+	std::string         name         = {};
+	std::vector<double> samples_ms   = {};
+	uint64_t            peak_memory  = 0;
+	uint64_t            vertex_count = 0;
+	uint64_t            index_count  = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+using LoadFunction = void (*)(const char*, Batch*);
+
+/// Run the query of the given index, appending the objects it finds.
+using QueryFunction = std::function<void(uint32_t query, std::vector<uint32_t>* p_objects)>;
+
+double ElapsedMs(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+/// Peak resident set size of the process, in bytes.
+uint64_t QueryPeakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage = {};
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/// Nearest-rank percentile.
+/// @warning	samples must be sorted.
+double Percentile(
+	const std::vector<double>& samples,
+	double                     percentile)
+{
+	const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+	return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+void ParseOptions(
+	int      argc,
+	char**   argv,
+	Options* p_options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+
+		if (std::strcmp(argv[i], "--iterations") == 0 && has_value)
+		{
+			p_options->iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && has_value)
+		{
+			p_options->frame_count = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(argv[i], "--output") == 0 && has_value)
+		{
+			p_options->output_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--id-buffer") == 0)
+		{
+			p_options->id_buffer = true;
+		}
+		else
+		{
+			throw std::runtime_error(
+				"Usage: Benchmark [--iterations N] [--frames N] [--id-buffer] [--output path.json]");
+		}
+	}
+}
+
+/// Time `iterations` runs of the mesh loader, the last loaded batch is returned.
+Stage BenchmarkLoad(
+	const char*  name,
+	uint32_t     iterations,
+	LoadFunction load,
+	const char*  file_path,
+	Batch*       p_batch)
+{
+	Stage stage = {.name = name};
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		*p_batch = {};
+
+		const Clock::time_point begin = Clock::now();
+		load(file_path, p_batch);
+		stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+
+	stage.vertex_count = p_batch->position.size();
+	stage.index_count  = p_batch->indices.size();
+	stage.peak_memory  = QueryPeakMemory();
+
+	return stage;
+}
+
+/// Check the native OBJ parser against the Assimp import of the same file: same vertices in the same order,
+/// same triangles. The numbers only differ by the float parsing and normal generation of each.
+void CompareImports(
+	const char*  name,
+	const Batch& reference,
+	const Batch& batch)
+{
+	if (batch.position.size() != reference.position.size() ||
+	    batch.normals.size() != reference.normals.size() ||
+	    batch.indices != reference.indices)
+	{
+		throw std::runtime_error(std::string("Import mismatch: ") + name);
+	}
+
+	float position_error = 0.0f;
+	float normal_error   = 0.0f;
+
+	for (size_t i = 0; i < reference.position.size(); i++)
+	{
+		const glm::vec3 position_delta = glm::abs(batch.position[i] - reference.position[i]);
+		const glm::vec3 normal_delta   = glm::abs(batch.normals[i] - reference.normals[i]);
+
+		position_error = std::max({position_error, position_delta.x, position_delta.y, position_delta.z});
+		normal_error   = std::max({normal_error, normal_delta.x, normal_delta.y, normal_delta.z});
+	}
+
+	std::printf("[BENCHMARK] %s: max position error %g, max normal error %g\n", name, position_error, normal_error);
+}
+
+/// Time `iterations` palette updates of a crowd sharing a synthetic skeleton (binary tree of joints) and two
+/// clips of random rotations, every instance cross-fading between them.
+Stage BenchmarkAnimation(
+	uint32_t    iterations,
+	uint32_t    instance_count,
+	uint32_t    joint_count,
+	ThreadPool* thread_pool)
+{
+	Stage stage = {.name = "Animation::Update " + std::to_string(instance_count) + " instances " +
+	                       std::to_string(joint_count) + " joints"};
+
+	Skeleton skeleton = {};
+
+	for (uint32_t joint = 0; joint < joint_count; joint++)
+	{
+		skeleton.joint_names.push_back("joint_" + std::to_string(joint));
+		skeleton.parents.push_back((joint == 0) ? -1 : static_cast<int32_t>((joint - 1) / 2));
+		skeleton.inverse_bind_matrices.emplace_back(1.0f);
+	}
+
+	std::mt19937                          random(42);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	const uint32_t stride = GetJointStride(joint_count);
+
+	std::vector<AnimationClip> clips(2);
+
+	for (AnimationClip& clip : clips)
+	{
+		clip.duration    = 2.0f;
+		clip.joint_count = joint_count;
+		clip.frame_count = static_cast<uint32_t>(clip.duration * clip.sample_rate) + 1;
+		clip.samples.resize(static_cast<size_t>(clip.frame_count) * pose_component_count * stride);
+
+		for (uint32_t frame = 0; frame < clip.frame_count; frame++)
+		{
+			float* pose = &clip.samples[static_cast<size_t>(frame) * pose_component_count * stride];
+
+			for (uint32_t joint = 0; joint < stride; joint++)
+			{
+				const glm::vec4 rotation = glm::normalize(glm::vec4(
+					distribution(random),
+					distribution(random),
+					distribution(random),
+					2.0f));
+
+				const float components[pose_component_count] = {
+					0.0f, 1.0f, 0.0f,
+					rotation.x, rotation.y, rotation.z, rotation.w,
+					1.0f, 1.0f, 1.0f,
+				};
+
+				for (uint32_t c = 0; c < pose_component_count; c++)
+				{
+					pose[c * stride + joint] = components[c];
+				}
+			}
+		}
+	}
+
+	std::vector<AnimationInstance> instances(instance_count);
+
+	for (uint32_t i = 0; i < instance_count; i++)
+	{
+		instances[i] = {
+			.clip = 0,
+			.time = static_cast<float>(i) * 0.01f,
+			.blend_clip = 1,
+			.blend_time = static_cast<float>(i) * 0.02f,
+			.blend_weight = static_cast<float>(i % 8) / 8.0f,
+		};
+	}
+
+	std::vector<glm::mat4> palettes(static_cast<size_t>(instance_count) * joint_count);
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		for (AnimationInstance& instance : instances)
+		{
+			instance.time       += 1.0f / 60.0f;
+			instance.blend_time += 1.0f / 60.0f;
+		}
+
+		const Clock::time_point begin = Clock::now();
+
+		Animation::Update(
+			thread_pool,
+			skeleton,
+			clips,
+			instances,
+			palettes);
+
+		stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+
+	stage.peak_memory = QueryPeakMemory();
+
+	return stage;
+}
+
+/// Time `iterations` runs of every query, each sample covers all of them. The objects found by the last run are
+/// returned, one list per query.
+Stage BenchmarkQueries(
+	std::string                         name,
+	uint32_t                            iterations,
+	uint32_t                            query_count,
+	const QueryFunction&                query,
+	std::vector<std::vector<uint32_t>>* p_results)
+{
+	Stage stage = {.name = std::move(name)};
+
+	p_results->resize(query_count);
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		for (std::vector<uint32_t>& objects : *p_results)
+		{
+			objects.clear();
+		}
+
+		const Clock::time_point begin = Clock::now();
+
+		for (uint32_t q = 0; q < query_count; q++)
+		{
+			query(q, &(*p_results)[q]);
+		}
+
+		stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+
+	stage.peak_memory = QueryPeakMemory();
+
+	return stage;
+}
+
+/// The BVH must find the same objects as the linear scan, in any order.
+void CompareQueries(
+	const char*                         name,
+	std::vector<std::vector<uint32_t>>& reference,
+	std::vector<std::vector<uint32_t>>& results)
+{
+	for (size_t q = 0; q < reference.size(); q++)
+	{
+		std::sort(reference[q].begin(), reference[q].end());
+		std::sort(results[q].begin(), results[q].end());
+
+		if (reference[q] != results[q])
+		{
+			throw std::runtime_error(std::string("BVH query mismatch: ") + name);
+		}
+	}
+}
+
+bool IsInFrustum(
+	const Graphics::Frustum& frustum,
+	const Graphics::Aabb&    bounds)
+{
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		float distance = plane.w;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			distance += plane[axis] * ((plane[axis] >= 0.0f) ? bounds.max[axis] : bounds.min[axis]);
+		}
+
+		if (distance < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool IsOnSegment(
+	const glm::vec3&      origin,
+	const glm::vec3&      direction,
+	float                 max_distance,
+	const Graphics::Aabb& bounds)
+{
+	float near = 0.0f;
+	float far  = max_distance;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float inverse = 1.0f / ((std::abs(direction[axis]) > 1e-30f) ? direction[axis] : 1e-30f);
+		const float t0      = (bounds.min[axis] - origin[axis]) * inverse;
+		const float t1      = (bounds.max[axis] - origin[axis]) * inverse;
+
+		near = std::max(near, std::min(t0, t1));
+		far  = std::min(far, std::max(t0, t1) * (1.0f + 6.0f * 0x1p-24f)); // Same rounding margin as the BVH.
+	}
+
+	return near <= far;
+}
+
+/// Scene of random boxes in a 1000 units cube: SAH build, then frustum and ray queries from random cameras through
+/// the BVH and through a linear scan of the boxes, and a frame of 10% of the objects moving (refit and commit).
+void BenchmarkBvh(
+	uint32_t            iterations,
+	uint32_t            object_count,
+	std::vector<Stage>* p_stages)
+{
+	constexpr uint32_t query_count   = 64;
+	constexpr float    view_distance = 1000.0f;
+
+	const std::string suffix = " " + std::to_string(object_count) + " objects";
+
+	std::mt19937                          random(42);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> extent(0.5f, 5.0f);
+	std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+
+	std::vector<Graphics::Aabb> bounds(object_count);
+
+	for (Graphics::Aabb& box : bounds)
+	{
+		const glm::vec3 center      = {position(random), position(random), position(random)};
+		const glm::vec3 half_extent = {extent(random), extent(random), extent(random)};
+
+		box = {.min = center - half_extent, .max = center + half_extent};
+	}
+
+	std::vector<Graphics::Frustum> frustums(query_count);
+	std::vector<glm::vec3>         origins(query_count);
+	std::vector<glm::vec3>         directions(query_count);
+
+	const glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, view_distance);
+
+	for (uint32_t q = 0; q < query_count; q++)
+	{
+		origins[q]    = {position(random), position(random), position(random)};
+		directions[q] = glm::normalize(glm::vec3(velocity(random), velocity(random), velocity(random)));
+		frustums[q]   = Graphics::ExtractFrustum(
+			projection * glm::lookAt(origins[q], origins[q] + directions[q], glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	Bvh                      bvh     = {};
+	std::vector<Bvh::Handle> handles = {};
+
+	Stage build_stage = {.name = "Bvh::Build" + suffix};
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		const Clock::time_point begin = Clock::now();
+		bvh.Build(bounds, &handles);
+		build_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	build_stage.peak_memory = QueryPeakMemory();
+	p_stages->push_back(build_stage);
+
+	std::printf("[BENCHMARK] Bvh%s: SAH cost %.2f\n", suffix.c_str(), bvh.GetCost());
+
+	const QueryFunction bvh_frustum = [&](uint32_t q, std::vector<uint32_t>* p_objects)
+	{
+		bvh.QueryFrustum(frustums[q], p_objects);
+	};
+
+	const QueryFunction linear_frustum = [&](uint32_t q, std::vector<uint32_t>* p_objects)
+	{
+		for (uint32_t object = 0; object < object_count; object++)
+		{
+			if (IsInFrustum(frustums[q], bounds[object]))
+			{
+				p_objects->push_back(object);
+			}
+		}
+	};
+
+	const QueryFunction bvh_ray = [&](uint32_t q, std::vector<uint32_t>* p_objects)
+	{
+		bvh.QueryRay(origins[q], directions[q], view_distance, p_objects);
+	};
+
+	const QueryFunction linear_ray = [&](uint32_t q, std::vector<uint32_t>* p_objects)
+	{
+		for (uint32_t object = 0; object < object_count; object++)
+		{
+			if (IsOnSegment(origins[q], directions[q], view_distance, bounds[object]))
+			{
+				p_objects->push_back(object);
+			}
+		}
+	};
+
+	std::vector<std::vector<uint32_t>> results   = {};
+	std::vector<std::vector<uint32_t>> reference = {};
+
+	p_stages->push_back(BenchmarkQueries(
+		"Bvh::QueryFrustum x64" + suffix,
+		iterations,
+		query_count,
+		bvh_frustum,
+		&results));
+
+	p_stages->push_back(BenchmarkQueries(
+		"Linear frustum scan x64" + suffix,
+		iterations,
+		query_count,
+		linear_frustum,
+		&reference));
+
+	CompareQueries("frustum", reference, results);
+
+	p_stages->push_back(BenchmarkQueries(
+		"Bvh::QueryRay x64" + suffix,
+		iterations,
+		query_count,
+		bvh_ray,
+		&results));
+
+	p_stages->push_back(BenchmarkQueries(
+		"Linear ray scan x64" + suffix,
+		iterations,
+		query_count,
+		linear_ray,
+		&reference));
+
+	CompareQueries("ray", reference, results);
+
+	// Every frame a tenth of the objects move, the tree is refit and the query layout rebuilt.
+	Stage update_stage = {.name = "Bvh::Update 10% + Commit" + suffix};
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		for (uint32_t object = i % 10; object < object_count; object += 10)
+		{
+			const glm::vec3 offset = {velocity(random), velocity(random), velocity(random)};
+
+			bounds[object] = {.min = bounds[object].min + offset, .max = bounds[object].max + offset};
+		}
+
+		const Clock::time_point begin = Clock::now();
+
+		for (uint32_t object = i % 10; object < object_count; object += 10)
+		{
+			bvh.Update(handles[object], bounds[object]);
+		}
+
+		bvh.Commit();
+
+		update_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	update_stage.peak_memory = QueryPeakMemory();
+	p_stages->push_back(update_stage);
+
+	std::printf("[BENCHMARK] Bvh%s: SAH cost %.2f after updates\n", suffix.c_str(), bvh.GetCost());
+
+	p_stages->push_back(BenchmarkQueries(
+		"Bvh::QueryFrustum x64 after updates" + suffix,
+		iterations,
+		query_count,
+		bvh_frustum,
+		&results));
+
+	BenchmarkQueries("", 1, query_count, linear_frustum, &reference);
+	CompareQueries("frustum after updates", reference, results);
+}
+
+void WriteReport(
+	FILE*                     file,
+	const Options&            options,
+	const std::vector<Stage>& stages)
+{
+	std::fprintf(file, "{\n");
+	std::fprintf(file, "  \"iterations\": %u,\n", options.iterations);
+	std::fprintf(file, "  \"frames\": %u,\n", options.frame_count);
+	std::fprintf(file, "  \"peak_memory_bytes\": %llu,\n", static_cast<unsigned long long>(QueryPeakMemory()));
+	std::fprintf(file, "  \"stages\": [\n");
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		std::vector<double> sorted = stages[i].samples_ms;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+		for (const double sample : sorted)
+		{
+			total += sample;
+		}
+
+		std::fprintf(file,
+		             "    {\"name\": \"%s\", \"samples\": %zu, \"vertices\": %llu, \"indices\": %llu, "
+		             "\"min_ms\": %.4f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, "
+		             "\"max_ms\": %.4f, \"peak_memory_bytes\": %llu}%s\n",
+		             stages[i].name.c_str(),
+		             sorted.size(),
+		             static_cast<unsigned long long>(stages[i].vertex_count),
+		             static_cast<unsigned long long>(stages[i].index_count),
+		             sorted.front(),
+		             total / static_cast<double>(sorted.size()),
+		             Percentile(sorted, 50.0),
+		             Percentile(sorted, 95.0),
+		             Percentile(sorted, 99.0),
+		             sorted.back(),
+		             static_cast<unsigned long long>(stages[i].peak_memory),
+		             (i + 1 < stages.size()) ? "," : "");
+	}
+
+	std::fprintf(file, "  ]\n}\n");
+}
+}
+
+int main(int argc, char** argv)
+{
+	Options options = {};
+	ParseOptions(argc, argv, &options);
+
+	std::vector<Stage> stages = {};
+	Batch              bunny  = {};
+	Batch              lucy   = {};
+
+	// Import, Assimp then the native OBJ parser on the same files.
+
+	Batch bunny_reference = {};
+	Batch lucy_reference  = {};
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::Import bunny.obj",
+		options.iterations,
+		&Mesh::Import,
+		"../Resources/Meshes/bunny.obj",
+		&bunny_reference));
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::Import lucy.obj",
+		options.iterations,
+		&Mesh::Import,
+		"../Resources/Meshes/lucy.obj",
+		&lucy_reference));
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::Load bunny.obj",
+		options.iterations,
+		&Mesh::Load,
+		"../Resources/Meshes/bunny.obj",
+		&bunny));
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::Load lucy.obj",
+		options.iterations,
+		&Mesh::Load,
+		"../Resources/Meshes/lucy.obj",
+		&lucy));
+
+	CompareImports("bunny.obj", bunny_reference, bunny);
+	CompareImports("lucy.obj", lucy_reference, lucy);
+
+	// Cooked format, written from the imported batches (not timed).
+
+	Mesh::Cook("../Resources/Meshes/bunny.amesh", bunny);
+	Mesh::Cook("../Resources/Meshes/lucy.amesh", lucy);
+	Mesh::Cook("../Resources/Meshes/lucy_meshopt.amesh", lucy, CookedMeshCompression::Meshopt);
+
+	std::printf(
+		"[BENCHMARK] lucy.amesh: %ju bytes, compressed %ju bytes\n",
+		static_cast<uintmax_t>(std::filesystem::file_size("../Resources/Meshes/lucy.amesh")),
+		static_cast<uintmax_t>(std::filesystem::file_size("../Resources/Meshes/lucy_meshopt.amesh")));
+
+	const LoadFunction load_cooked = [](const char* file_path, Batch* batch) { Mesh::LoadCooked(file_path, batch); };
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::LoadCooked bunny.amesh",
+		options.iterations,
+		load_cooked,
+		"../Resources/Meshes/bunny.amesh",
+		&bunny));
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::LoadCooked lucy.amesh",
+		options.iterations,
+		load_cooked,
+		"../Resources/Meshes/lucy.amesh",
+		&lucy));
+
+	Batch lucy_compressed = {};
+
+	stages.push_back(BenchmarkLoad(
+		"Mesh::LoadCooked lucy_meshopt.amesh",
+		options.iterations,
+		load_cooked,
+		"../Resources/Meshes/lucy_meshopt.amesh",
+		&lucy_compressed));
+
+	// Scene arenas: both meshes appended, then bunny removed and appended again in its freed ranges.
+
+	Stage builder_stage = {.name = "BatchBuilder bunny + lucy"};
+
+	for (uint32_t i = 0; i < options.iterations; i++)
+	{
+		BatchBuilder builder = {};
+
+		const Clock::time_point begin = Clock::now();
+
+		const BatchBuilder::Handle bunny_handle = builder.Append(bunny);
+		builder.Append(lucy);
+		builder.Remove(bunny_handle);
+		builder.Append(bunny);
+
+		builder_stage.samples_ms.push_back(ElapsedMs(begin));
+
+		builder_stage.vertex_count = builder.GetVertexCount();
+		builder_stage.index_count  = builder.GetIndexCount();
+	}
+	builder_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(builder_stage);
+
+	ThreadPool thread_pool = ThreadPool();
+
+	// Bulk import, one importer per file on the workers, merged in order.
+
+	Stage load_many_stage = {.name = "Mesh::LoadMany 4x bunny.obj + 4x lucy.obj"};
+
+	const char* const level_paths[] = {
+		"../Resources/Meshes/bunny.obj",
+		"../Resources/Meshes/lucy.obj",
+		"../Resources/Meshes/bunny.obj",
+		"../Resources/Meshes/lucy.obj",
+		"../Resources/Meshes/bunny.obj",
+		"../Resources/Meshes/lucy.obj",
+		"../Resources/Meshes/bunny.obj",
+		"../Resources/Meshes/lucy.obj",
+	};
+
+	for (uint32_t i = 0; i < options.iterations; i++)
+	{
+		BatchBuilder builder = {};
+
+		const Clock::time_point begin = Clock::now();
+		Mesh::LoadMany(&thread_pool, level_paths, &builder);
+		load_many_stage.samples_ms.push_back(ElapsedMs(begin));
+
+		load_many_stage.vertex_count = builder.GetVertexCount();
+		load_many_stage.index_count  = builder.GetIndexCount();
+	}
+	load_many_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(load_many_stage);
+
+	// Native OBJ parser with the chunks split across the pool.
+
+	Stage load_obj_stage = {.name = "Mesh::LoadObj lucy.obj (thread pool)"};
+	Batch lucy_pooled    = {};
+
+	for (uint32_t i = 0; i < options.iterations; i++)
+	{
+		lucy_pooled = {};
+
+		const Clock::time_point begin = Clock::now();
+
+		if (!Mesh::LoadObj("../Resources/Meshes/lucy.obj", &lucy_pooled, &thread_pool))
+		{
+			throw std::runtime_error("lucy.obj is not supported by the native OBJ parser");
+		}
+
+		load_obj_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	load_obj_stage.vertex_count = lucy_pooled.position.size();
+	load_obj_stage.index_count  = lucy_pooled.indices.size();
+	load_obj_stage.peak_memory  = QueryPeakMemory();
+	stages.push_back(load_obj_stage);
+
+	CompareImports("lucy.obj (thread pool)", lucy_reference, lucy_pooled);
+
+	// Compressed cooked streams, one segment per task.
+
+	Stage load_compressed_stage = {.name = "Mesh::LoadCooked lucy_meshopt.amesh (thread pool)"};
+
+	for (uint32_t i = 0; i < options.iterations; i++)
+	{
+		lucy_compressed = {};
+
+		const Clock::time_point begin = Clock::now();
+		Mesh::LoadCooked("../Resources/Meshes/lucy_meshopt.amesh", &lucy_compressed, &thread_pool);
+		load_compressed_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	load_compressed_stage.vertex_count = lucy_compressed.position.size();
+	load_compressed_stage.index_count  = lucy_compressed.indices.size();
+	load_compressed_stage.peak_memory  = QueryPeakMemory();
+	stages.push_back(load_compressed_stage);
+
+	// Vertices and triangles are reordered and quantized, only the counts match the raw file.
+	if (lucy_compressed.position.size() != lucy.position.size() ||
+	    lucy_compressed.indices.size() != lucy.indices.size())
+	{
+		throw std::runtime_error("Cooked mesh mismatch: lucy_meshopt.amesh");
+	}
+
+	// Animation, crowd of skinned characters.
+
+	stages.push_back(BenchmarkAnimation(
+		std::max(options.iterations, 100u),
+		2048,
+		64,
+		&thread_pool));
+
+	// Scene BVH against a linear scan of the bounds.
+
+	for (const uint32_t object_count : {1000u, 10000u, 100000u})
+	{
+		BenchmarkBvh(
+			options.iterations,
+			object_count,
+			&stages);
+	}
+
+	// Vulkan
+
+	const VkAppSettings settings = {
+		.mesh_path = "../Resources/Meshes/lucy.amesh",
+		.headless = true,
+		.validation = false,
+		.id_buffer = options.id_buffer,
+		.width = 1280,
+		.height = 720,
+	};
+
+	VkApp app = {};
+
+	Stage init_stage = {.name = "VkApp::Init"};
+	{
+		const Clock::time_point begin = Clock::now();
+		app.Init(settings);
+		init_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	init_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(init_stage);
+
+	Stage upload_stage = {
+		.name = "VkApp::UploadBatch lucy",
+		.vertex_count = lucy.position.size(),
+		.index_count = lucy.indices.size(),
+	};
+
+	for (uint32_t i = 0; i < options.iterations; i++)
+	{
+		app.DestroyBatch();
+
+		const Clock::time_point begin = Clock::now();
+		app.UploadBatch(lucy);
+		upload_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	upload_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(upload_stage);
+
+	// Same camera as the interactive view. Frames are paced by the fence wait only (no frame limiter).
+	const glm::vec3 camera_pos   = {0.0f, 140.0f, -1900.0f};
+	const glm::vec3 camera_front = {0.0f, 0.0f, 1.0f};
+
+	Stage frame_stage = {
+		.name = "VkApp::DrawFrame headless",
+		.vertex_count = lucy.position.size(),
+		.index_count = lucy.indices.size(),
+	};
+
+	for (uint32_t i = 0; i < options.frame_count; i++)
+	{
+		const Clock::time_point begin = Clock::now();
+
+		if (!app.DrawFrame(app.GetDefaultPipeline(), camera_pos, camera_front))
+		{
+			throw std::runtime_error("Headless swapchain out of date");
+		}
+
+		frame_stage.samples_ms.push_back(ElapsedMs(begin));
+	}
+	frame_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(frame_stage);
+
+	// Picking through the camera of the last frame, one sample per cursor position on a grid over the view.
+	Stage pick_stage = {
+		.name = "VkApp::Pick lucy 64x36 cursor positions",
+		.vertex_count = lucy.position.size(),
+		.index_count = lucy.indices.size(),
+	};
+
+	constexpr uint32_t pick_columns = 64;
+	constexpr uint32_t pick_rows    = 36;
+
+	uint32_t pick_count = 0;
+
+	for (uint32_t y = 0; y < pick_rows; y++)
+	{
+		for (uint32_t x = 0; x < pick_columns; x++)
+		{
+			const glm::vec2 view_position = {
+				(static_cast<float>(x) + 0.5f) / static_cast<float>(pick_columns),
+				(static_cast<float>(y) + 0.5f) / static_cast<float>(pick_rows),
+			};
+
+			PickHit hit = {};
+
+			const Clock::time_point begin = Clock::now();
+			pick_count += app.Pick(view_position, &hit) ? 1 : 0;
+			pick_stage.samples_ms.push_back(ElapsedMs(begin));
+		}
+	}
+	pick_stage.peak_memory = QueryPeakMemory();
+	stages.push_back(pick_stage);
+
+	std::printf("[BENCHMARK] VkApp::Pick: %u of %u cursor positions hit lucy\n", pick_count, pick_columns * pick_rows);
+
+	// Same grid through the id buffer: one sample per request, from the request to its readback (frames included).
+	if (options.id_buffer)
+	{
+		Stage gpu_pick_stage = {
+			.name = "VkApp::RequestGpuPick lucy 64x36 cursor positions",
+			.vertex_count = lucy.position.size(),
+			.index_count = lucy.indices.size(),
+		};
+
+		uint32_t gpu_pick_count = 0;
+		uint32_t agree_count    = 0;
+		uint32_t max_latency    = 0;
+
+		for (uint32_t y = 0; y < pick_rows; y++)
+		{
+			for (uint32_t x = 0; x < pick_columns; x++)
+			{
+				const glm::vec2 view_position = {
+					(static_cast<float>(x) + 0.5f) / static_cast<float>(pick_columns),
+					(static_cast<float>(y) + 0.5f) / static_cast<float>(pick_rows),
+				};
+
+				GpuPickResult result = {};
+
+				const Clock::time_point begin = Clock::now();
+				app.RequestGpuPick(view_position);
+
+				while (!app.PollGpuPick(&result))
+				{
+					if (!app.DrawFrame(app.GetDefaultPipeline(), camera_pos, camera_front))
+					{
+						throw std::runtime_error("Headless swapchain out of date");
+					}
+				}
+				gpu_pick_stage.samples_ms.push_back(ElapsedMs(begin));
+
+				PickHit hit = {};
+
+				const bool cpu_hit = app.Pick(view_position, &hit);
+
+				gpu_pick_count += result.hit ? 1 : 0;
+				max_latency = std::max(max_latency, result.latency);
+
+				// The ray goes through the center of the pixel, the id is the one of its first sample.
+				if (cpu_hit == result.hit &&
+				    (!cpu_hit || (hit.draw_call == result.draw_call && hit.triangle == result.triangle)))
+				{
+					agree_count++;
+				}
+			}
+		}
+		gpu_pick_stage.peak_memory = QueryPeakMemory();
+		stages.push_back(gpu_pick_stage);
+
+		std::printf("[BENCHMARK] VkApp::RequestGpuPick: %u hits, %u of %u agree with VkApp::Pick, latency %u frames\n",
+		            gpu_pick_count,
+		            agree_count,
+		            pick_columns * pick_rows,
+		            max_latency);
+	}
+
+	app.TearDown();
+
+	FILE* output = options.output_path
+		? std::fopen(options.output_path, "w")
+		: stdout;
+
+	if (!output)
+	{
+		std::printf("[BENCHMARK] Failed to open %s\n", options.output_path);
+		return 1;
+	}
+
+	WriteReport(output, options, stages);
+
+	if (output != stdout)
+	{
+		std::fclose(output);
+	}
+
+	return 0;
+}
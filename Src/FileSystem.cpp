@@ -3,25 +3,379 @@
 //
 
 #include "FileSystem.h"
+#include "PackFormat.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef ADRO_PACK_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef ADRO_PACK_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+/// The single pack currently mounted.
+struct MountedPack
+{
+	FileView           file        = {};
+	std::string        mount_point = {};
+	const Pack::Entry* entries     = nullptr;
+	uint32_t           entry_count = 0;
+};
+
+MountedPack mounted_pack = {};
+
+/// Binary search of the sorted table of contents.
+const Pack::Entry* FindPackEntry(std::string_view path)
+{
+	if (!mounted_pack.entries || !path.starts_with(mounted_pack.mount_point))
+	{
+		return nullptr;
+	}
+
+	const uint64_t     hash  = Pack::HashPath(path.substr(mounted_pack.mount_point.size()));
+	const Pack::Entry* first = mounted_pack.entries;
+	const Pack::Entry* last  = mounted_pack.entries + mounted_pack.entry_count;
+
+	const Pack::Entry* entry = std::lower_bound(
+		first,
+		last,
+		hash,
+		[](const Pack::Entry& lhs, uint64_t rhs)
+		{
+			return lhs.path_hash < rhs;
+		});
+
+	return (entry != last && entry->path_hash == hash)
+		? entry
+		: nullptr;
+}
+}
+
+FileView::~FileView()
+{
+	Unmap();
+}
+
+FileView::FileView(FileView&& other) noexcept
+	: data_(std::exchange(other.data_, nullptr)),
+	  size_(std::exchange(other.size_, 0)),
+	  owns_mapping_(std::exchange(other.owns_mapping_, false)),
+	  buffer_(std::move(other.buffer_))
+{
+}
+
+FileView& FileView::operator=(FileView&& other) noexcept
+{
+	if (this != &other)
+	{
+		Unmap();
+		data_         = std::exchange(other.data_, nullptr);
+		size_         = std::exchange(other.size_, 0);
+		owns_mapping_ = std::exchange(other.owns_mapping_, false);
+		buffer_       = std::move(other.buffer_);
+	}
+
+	return *this;
+}
+
+const std::byte* FileView::GetData() const
+{
+	return data_;
+}
+
+size_t FileView::GetSize() const
+{
+	return size_;
+}
+
+void FileView::Unmap()
+{
+	if (data_ && owns_mapping_)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+#else
+		munmap(const_cast<std::byte*>(data_), size_);
+#endif
+	}
+
+	data_         = nullptr;
+	size_         = 0;
+	owns_mapping_ = false;
+	buffer_       = {};
+}
+
+bool FileSystem::MountPack(
+	const char* pack_path,
+	const char* mount_point)
+{
+	if (!std::filesystem::exists(pack_path))
+	{
+		return false;
+	}
+
+	UnmountPack();
+
+	FileView file = MapFile(pack_path, AccessHint::Random);
+
+	Pack::Header header = {};
+
+	if (file.GetSize() < sizeof(header))
+	{
+		throw std::runtime_error("Failed to mount pack: invalid header");
+	}
+
+	std::memcpy(&header, file.GetData(), sizeof(header));
+
+	if (header.magic != Pack::magic_value || header.version != Pack::version_value)
+	{
+		throw std::runtime_error("Failed to mount pack: invalid header");
+	}
+
+	if (header.toc_offset % alignof(Pack::Entry) != 0 ||
+	    header.toc_offset + sizeof(Pack::Entry) * static_cast<uint64_t>(header.entry_count) > file.GetSize())
+	{
+		throw std::runtime_error("Failed to mount pack: truncated table of contents");
+	}
+
+	const Pack::Entry* entries = reinterpret_cast<const Pack::Entry*>(file.GetData() + header.toc_offset);
+
+	for (uint32_t i = 0; i < header.entry_count; i++)
+	{
+		if (entries[i].offset + entries[i].stored_size > header.toc_offset)
+		{
+			throw std::runtime_error("Failed to mount pack: entry out of bounds");
+		}
+	}
+
+	mounted_pack = {
+		.file = std::move(file),
+		.mount_point = mount_point,
+		.entries = entries,
+		.entry_count = header.entry_count,
+	};
+
+	std::printf("[FILESYSTEM] Mounted %s (%u entries) on %s\n", pack_path, header.entry_count, mount_point);
+
+	return true;
+}
+
+void FileSystem::UnmountPack()
+{
+	mounted_pack = {};
+}
 
 std::vector<char> FileSystem::ReadFile(const char* path)
 {
-	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	ADRO_PROFILE_SCOPE("FileSystem::ReadFile");
+
+	const FileView file = MapFile(path);
+
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+
+	return std::vector<char>(data, data + file.GetSize());
+}
+
+bool FileSystem::Exists(const char* path)
+{
+	if (FindPackEntry(path))
+	{
+		return true;
+	}
+
+	std::error_code error = {};
+	return std::filesystem::exists(path, error);
+}
+
+FileView FileSystem::MapFile(
+	const char* path,
+	AccessHint  hint)
+{
+	ADRO_PROFILE_SCOPE("FileSystem::MapFile");
+
+	FileView view = {};
+
+	if (const Pack::Entry* entry = FindPackEntry(path))
+	{
+		const std::byte* payload = mounted_pack.file.GetData() + entry->offset;
+
+		switch (entry->compression)
+		{
+		case Pack::Compression::None:
+			// Zero copy: the view points into the pack mapping.
+			view.data_ = payload;
+			view.size_ = entry->size;
+			return view;
+
+#ifdef ADRO_PACK_LZ4
+		case Pack::Compression::LZ4:
+			view.buffer_.resize(entry->size);
+			if (LZ4_decompress_safe(reinterpret_cast<const char*>(payload),
+			                        reinterpret_cast<char*>(view.buffer_.data()),
+			                        static_cast<int>(entry->stored_size),
+			                        static_cast<int>(entry->size)) != static_cast<int>(entry->size))
+			{
+				throw std::runtime_error("Failed to decompress pack entry");
+			}
+			break;
+#endif
+
+#ifdef ADRO_PACK_ZSTD
+		case Pack::Compression::Zstd:
+			view.buffer_.resize(entry->size);
+			if (ZSTD_decompress(view.buffer_.data(), entry->size, payload, entry->stored_size) != entry->size)
+			{
+				throw std::runtime_error("Failed to decompress pack entry");
+			}
+			break;
+#endif
+
+		default:
+			throw std::runtime_error("Pack entry compressed with an unsupported codec");
+		}
+
+		view.data_ = view.buffer_.data();
+		view.size_ = view.buffer_.size();
+		return view;
+	}
+
+#ifdef _WIN32
+	const DWORD flags = (hint == AccessHint::Sequential)
+		? FILE_FLAG_SEQUENTIAL_SCAN
+		: (hint == AccessHint::Random)
+		? FILE_FLAG_RANDOM_ACCESS
+		: FILE_ATTRIBUTE_NORMAL;
+
+	const HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
 
-	if (!file.is_open())
+	if (file == INVALID_HANDLE_VALUE)
 	{
 		throw std::runtime_error("Failed to open file");
 	}
 
-	const std::streamsize file_size = static_cast<std::streamsize>(file.tellg());
-	std::vector<char>     output_file(file_size);
+	LARGE_INTEGER file_size = {};
+	GetFileSizeEx(file, &file_size);
+
+	// Mapping an empty file fails, an empty view is returned instead.
+	if (file_size.QuadPart > 0)
+	{
+		const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void*        data    = mapping
+			? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+			: nullptr;
+
+		// The view keeps the mapping alive.
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+
+		if (!data)
+		{
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map file");
+		}
+
+		view.data_         = static_cast<const std::byte*>(data);
+		view.size_         = static_cast<size_t>(file_size.QuadPart);
+		view.owns_mapping_ = true;
+
+		if (hint == AccessHint::WillNeed)
+		{
+			WIN32_MEMORY_RANGE_ENTRY range = {data, view.size_};
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+	}
+
+	CloseHandle(file);
+#else
+	const int file = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file");
+	}
+
+	struct stat file_stat = {};
+	fstat(file, &file_stat);
+
+	// Mapping an empty file fails, an empty view is returned instead.
+	if (file_stat.st_size > 0)
+	{
+		const size_t size = static_cast<size_t>(file_stat.st_size);
+		void*        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			throw std::runtime_error("Failed to map file");
+		}
+
+		view.data_         = static_cast<const std::byte*>(data);
+		view.size_         = size;
+		view.owns_mapping_ = true;
+
+		const int advice = (hint == AccessHint::Sequential)
+			? MADV_SEQUENTIAL
+			: (hint == AccessHint::Random)
+			? MADV_RANDOM
+			: (hint == AccessHint::WillNeed)
+			? MADV_WILLNEED
+			: MADV_NORMAL;
+
+		madvise(data, size, advice);
+	}
+
+	// The mapping keeps the file alive.
+	close(file);
+#endif
+
+	return view;
+}
+
+std::future<FileView> FileSystem::MapFileAsync(
+	ThreadPool& pool,
+	const char* path)
+{
+	return pool.Submit([path]
+	{
+		ADRO_PROFILE_SCOPE("FileSystem::MapFileAsync");
+
+		FileView view = MapFile(path, AccessHint::WillNeed);
 
-	file.seekg(0);
-	file.read(&output_file[0], file_size);
+		// Touch every page, the faults (and the disk reads) happen here instead of on the caller.
+		constexpr size_t page_size = 4096;
+		volatile uint8_t checksum  = 0;
 
-	file.close();
+		for (size_t offset = 0; offset < view.GetSize(); offset += page_size)
+		{
+			checksum = checksum ^ static_cast<uint8_t>(view.GetData()[offset]);
+		}
 
-	return output_file;
-}
\ No newline at end of file
+		return view;
+	});
+}
@@ -5,8 +5,46 @@
 #ifndef FILESYSTEM_H
 #define FILESYSTEM_H
 
+#include <cstddef>
+#include <future>
 #include <vector>
 
+class ThreadPool;
+
+/// Read-only view of a memory-mapped file, unmapped on destruction.
+/// The content is paged in on access, nothing is copied to the heap.
+/// Views of uncompressed pack entries point into the pack mapping, compressed ones own their decompressed copy.
+class FileView
+{
+public:
+	FileView() = default;
+
+	~FileView();
+
+	FileView(const FileView&) = delete;
+
+	FileView& operator=(const FileView&) = delete;
+
+	FileView(FileView&& other) noexcept;
+
+	FileView& operator=(FileView&& other) noexcept;
+
+	/// Page aligned (heap aligned for a compressed pack entry), nullptr for an empty file.
+	[[nodiscard]] const std::byte* GetData() const;
+
+	[[nodiscard]] size_t GetSize() const;
+
+private:
+	friend class FileSystem;
+
+	void Unmap();
+
+	const std::byte*       data_         = nullptr;
+	size_t                 size_         = 0;
+	bool                   owns_mapping_ = false;
+	std::vector<std::byte> buffer_       = {};
+};
+
 /// Not instantiable class.
 class FileSystem
 {
@@ -14,13 +52,54 @@ public:
 	// Delete constructor. This class is not instantiable.
 	FileSystem() = delete;
 
+	/// How the mapped content is going to be read, forwarded to the OS (madvise / PrefetchVirtualMemory).
+	enum class AccessHint
+	{
+		Normal,
+		Sequential, // Read once, front to back (e.g. decoding an asset).
+		Random,     // Sparse reads, disable read-ahead.
+		WillNeed,   // Start reading the whole file in the background now.
+	};
+
+	/// Serve every path starting with mount_point from the pack (paths are hashed relative to it),
+	/// other paths and entries missing from the pack fall back to loose files.
+	/// The pack is mapped once and stays mapped until UnmountPack.
+	/// @param pack_path		path to the .pak written by the Packer tool.
+	/// @param mount_point		prefix replaced by the pack root (e.g. "../Resources/").
+	/// @return false if the pack doesn't exist.
+	/// @warning	Not thread-safe, mount before any file is read.
+	static bool MountPack(
+		const char* pack_path,
+		const char* mount_point);
+
+	static void UnmountPack();
+
 	/// Read the file at the given path and copy the content into the given ptr.
 	/// @param path			path to the file to read.
 	/// @return the copy of the content.
 	///
 	/// @warning 	Is it better to provide a ptr as parameter to fill or return the string?
 	///				Since we are low level, I'd prefer to provide the ptr. Will see...
+	/// @note		Prefer MapFile, this keeps a full heap copy of the file.
 	static std::vector<char> ReadFile(const char* path);
+
+	/// Map the file at the given path, read-only.
+	/// @param path			path to the file to map.
+	/// @param hint			expected access pattern.
+	static FileView MapFile(
+		const char* path,
+		AccessHint  hint = AccessHint::Normal);
+
+	/// Whether MapFile finds the file, from the pack table of contents or the loose files, without mapping it.
+	/// @param path			path to the file.
+	static bool Exists(const char* path);
+
+	/// Map the file on a worker and fault its pages in there, so the caller gets resident memory.
+	/// @param pool			pool running the read, must outlive the future.
+	/// @param path			path to the file to map, must stay valid until the future is ready.
+	static std::future<FileView> MapFileAsync(
+		ThreadPool& pool,
+		const char* path);
 };
 
 #endif //FILESYSTEM_H
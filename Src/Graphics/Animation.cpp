@@ -0,0 +1,319 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Animation.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ADRO_ANIMATION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/// Interpolate two poses (or two frames of a clip) laid out in rows of stride floats.
+/// out may alias a or b: a block of 4 joints is fully read before being written.
+void InterpolatePoses(
+	const float* a,
+	const float* b,
+	float        weight,
+	uint32_t     stride,
+	float*       out)
+{
+	const float* a_rotation   = a + 3 * stride;
+	const float* b_rotation   = b + 3 * stride;
+	float*       out_rotation = out + 3 * stride;
+
+	uint32_t joint = 0;
+
+#ifdef ADRO_ANIMATION_SSE
+	const __m128 weights = _mm_set1_ps(weight);
+	const __m128 zero    = _mm_setzero_ps();
+	const __m128 sign    = _mm_set1_ps(-0.0f);
+
+	for (; joint < stride; joint += 4)
+	{
+		// Translations and scales: a + (b - a) * weight.
+		for (const uint32_t row : {0u, 1u, 2u, 7u, 8u, 9u})
+		{
+			const __m128 a_row = _mm_loadu_ps(a + row * stride + joint);
+			const __m128 b_row = _mm_loadu_ps(b + row * stride + joint);
+
+			_mm_storeu_ps(out + row * stride + joint, _mm_add_ps(a_row, _mm_mul_ps(_mm_sub_ps(b_row, a_row), weights)));
+		}
+
+		__m128 a_q[4];
+		__m128 b_q[4];
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			a_q[c] = _mm_loadu_ps(a_rotation + c * stride + joint);
+			b_q[c] = _mm_loadu_ps(b_rotation + c * stride + joint);
+		}
+
+		// Shortest path: flip b where the dot product is negative.
+		__m128 dot = _mm_mul_ps(a_q[0], b_q[0]);
+		dot = _mm_add_ps(dot, _mm_mul_ps(a_q[1], b_q[1]));
+		dot = _mm_add_ps(dot, _mm_mul_ps(a_q[2], b_q[2]));
+		dot = _mm_add_ps(dot, _mm_mul_ps(a_q[3], b_q[3]));
+
+		const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), sign);
+
+		__m128 q[4];
+		__m128 length_squared = zero;
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			q[c]           = _mm_add_ps(a_q[c], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(b_q[c], flip), a_q[c]), weights));
+			length_squared = _mm_add_ps(length_squared, _mm_mul_ps(q[c], q[c]));
+		}
+
+		const __m128 length = _mm_sqrt_ps(length_squared);
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			_mm_storeu_ps(out_rotation + c * stride + joint, _mm_div_ps(q[c], length));
+		}
+	}
+#endif
+
+	for (; joint < stride; joint++)
+	{
+		for (const uint32_t row : {0u, 1u, 2u, 7u, 8u, 9u})
+		{
+			const float a_value = a[row * stride + joint];
+			const float b_value = b[row * stride + joint];
+
+			out[row * stride + joint] = a_value + (b_value - a_value) * weight;
+		}
+
+		float dot = 0.0f;
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			dot += a_rotation[c * stride + joint] * b_rotation[c * stride + joint];
+		}
+
+		const float flip = (dot < 0.0f) ? -1.0f : 1.0f;
+
+		float q[4];
+		float length_squared = 0.0f;
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const float a_value = a_rotation[c * stride + joint];
+
+			q[c]            = a_value + (b_rotation[c * stride + joint] * flip - a_value) * weight;
+			length_squared += q[c] * q[c];
+		}
+
+		const float length = std::sqrt(length_squared);
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			out_rotation[c * stride + joint] = q[c] / length;
+		}
+	}
+}
+
+/// Translation * rotation * scale of a joint of the pose.
+glm::mat4 LocalTransform(
+	const float* pose,
+	uint32_t     stride,
+	uint32_t     joint)
+{
+	const float x = pose[3 * stride + joint];
+	const float y = pose[4 * stride + joint];
+	const float z = pose[5 * stride + joint];
+	const float w = pose[6 * stride + joint];
+
+	const float scale_x = pose[7 * stride + joint];
+	const float scale_y = pose[8 * stride + joint];
+	const float scale_z = pose[9 * stride + joint];
+
+	return glm::mat4(
+		glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f) * scale_x,
+		glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * scale_y,
+		glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale_z,
+		glm::vec4(pose[0 * stride + joint], pose[1 * stride + joint], pose[2 * stride + joint], 1.0f));
+}
+
+/// Instances [first, last) of Animation::Update, with their own scratch poses.
+void UpdateRange(
+	const Skeleton&                    skeleton,
+	std::span<const AnimationClip>     clips,
+	std::span<const AnimationInstance> instances,
+	std::span<glm::mat4>               palettes,
+	size_t                             first,
+	size_t                             last)
+{
+	ADRO_PROFILE_SCOPE("Animation::UpdateRange");
+
+	const uint32_t joint_count = skeleton.GetJointCount();
+
+	Pose pose       = {};
+	Pose blend_pose = {};
+
+	for (size_t i = first; i < last; i++)
+	{
+		const AnimationInstance& instance = instances[i];
+
+		Animation::SampleClip(
+			clips[instance.clip],
+			instance.time,
+			&pose);
+
+		if (instance.blend_weight > 0.0f)
+		{
+			Animation::SampleClip(
+				clips[instance.blend_clip],
+				instance.blend_time,
+				&blend_pose);
+
+			Animation::BlendPoses(
+				pose,
+				blend_pose,
+				instance.blend_weight,
+				&pose);
+		}
+
+		Animation::ComputePalette(
+			skeleton,
+			pose,
+			palettes.subspan(i * joint_count, joint_count));
+	}
+}
+}
+
+void Animation::SampleClip(
+	const AnimationClip& clip,
+	float                time,
+	Pose*                p_pose)
+{
+	if (clip.frame_count == 0)
+	{
+		throw std::runtime_error("Empty animation clip");
+	}
+
+	const uint32_t stride     = GetJointStride(clip.joint_count);
+	const size_t   frame_size = static_cast<size_t>(pose_component_count) * stride;
+
+	if (clip.duration > 0.0f)
+	{
+		time = std::fmod(time, clip.duration);
+
+		if (time < 0.0f)
+		{
+			time += clip.duration;
+		}
+	}
+	else
+	{
+		time = 0.0f;
+	}
+
+	const float    position = time * clip.sample_rate;
+	const uint32_t frame    = std::min(static_cast<uint32_t>(position), clip.frame_count - 1);
+	const uint32_t next     = std::min(frame + 1, clip.frame_count - 1);
+
+	p_pose->data.resize(frame_size);
+
+	InterpolatePoses(
+		&clip.samples[frame * frame_size],
+		&clip.samples[next * frame_size],
+		position - static_cast<float>(frame),
+		stride,
+		p_pose->data.data());
+}
+
+void Animation::BlendPoses(
+	const Pose& a,
+	const Pose& b,
+	float       weight,
+	Pose*       p_pose)
+{
+	if (a.data.size() != b.data.size())
+	{
+		throw std::runtime_error("Blended poses have different skeletons");
+	}
+
+	p_pose->data.resize(a.data.size());
+
+	InterpolatePoses(
+		a.data.data(),
+		b.data.data(),
+		weight,
+		static_cast<uint32_t>(a.data.size() / pose_component_count),
+		p_pose->data.data());
+}
+
+void Animation::ComputePalette(
+	const Skeleton&      skeleton,
+	const Pose&          pose,
+	std::span<glm::mat4> palette)
+{
+	const uint32_t joint_count = skeleton.GetJointCount();
+	const uint32_t stride      = GetJointStride(joint_count);
+
+	if (pose.data.size() != static_cast<size_t>(pose_component_count) * stride || palette.size() < joint_count)
+	{
+		throw std::runtime_error("Pose doesn't match the skeleton");
+	}
+
+	// Model transforms first: parents are stored before their children, so a single pass resolves the hierarchy.
+	for (uint32_t joint = 0; joint < joint_count; joint++)
+	{
+		const int32_t parent = skeleton.parents[joint];
+
+		const glm::mat4& parent_transform = (parent < 0)
+			? skeleton.root_transform
+			: palette[parent];
+
+		palette[joint] = parent_transform * LocalTransform(pose.data.data(), stride, joint);
+	}
+
+	for (uint32_t joint = 0; joint < joint_count; joint++)
+	{
+		palette[joint] = palette[joint] * skeleton.inverse_bind_matrices[joint];
+	}
+}
+
+void Animation::Update(
+	ThreadPool*                        thread_pool,
+	const Skeleton&                    skeleton,
+	std::span<const AnimationClip>     clips,
+	std::span<const AnimationInstance> instances,
+	std::span<glm::mat4>               palettes)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (palettes.size() < instances.size() * skeleton.GetJointCount())
+	{
+		throw std::runtime_error("Palette buffer too small for the animation instances");
+	}
+
+	// One contiguous range per worker, the calling thread takes the first one.
+	const size_t range_count = std::clamp<size_t>(
+		thread_pool ? thread_pool->GetThreadCount() + 1 : 1,
+		1,
+		std::max<size_t>(instances.size(), 1));
+
+	const size_t range_size = (instances.size() + range_count - 1) / range_count;
+
+	ThreadPool::ParallelFor(
+		thread_pool,
+		range_count,
+		[&](size_t range)
+		{
+			const size_t first = std::min(range * range_size, instances.size());
+			const size_t last  = std::min(first + range_size, instances.size());
+
+			UpdateRange(skeleton, clips, instances, palettes, first, last);
+		});
+}
@@ -0,0 +1,241 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "BatchBuilder.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+BatchBuilder::Handle BatchBuilder::Append(const Batch& batch)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (batch.normals.size() != batch.position.size())
+	{
+		throw std::runtime_error("Failed to append batch: positions and normals mismatch");
+	}
+
+	const uint32_t vertex_count = static_cast<uint32_t>(batch.position.size());
+	const uint32_t index_count  = static_cast<uint32_t>(batch.indices.size());
+
+	Entry entry = {
+		.vertices = {
+			.first = Allocate(&free_vertex_ranges_, static_cast<uint32_t>(batch_.position.size()), vertex_count),
+			.count = vertex_count,
+		},
+		.indices = {
+			.first = Allocate(&free_index_ranges_, static_cast<uint32_t>(batch_.indices.size()), index_count),
+			.count = index_count,
+		},
+		.alive = true,
+	};
+
+	// Grow the arenas when the ranges were taken at their end.
+	const size_t vertex_end = static_cast<size_t>(entry.vertices.first) + vertex_count;
+	const size_t index_end  = static_cast<size_t>(entry.indices.first) + index_count;
+
+	if (vertex_end > batch_.position.size())
+	{
+		batch_.position.resize(vertex_end);
+		batch_.normals.resize(vertex_end);
+		batch_.color.resize(vertex_end);
+	}
+
+	if (index_end > batch_.indices.size())
+	{
+		batch_.indices.resize(index_end);
+	}
+
+	std::ranges::copy(batch.position, batch_.position.begin() + entry.vertices.first);
+	std::ranges::copy(batch.normals, batch_.normals.begin() + entry.vertices.first);
+	std::ranges::copy(batch.indices, batch_.indices.begin() + entry.indices.first);
+
+	if (batch.color.size() == batch.position.size())
+	{
+		std::ranges::copy(batch.color, batch_.color.begin() + entry.vertices.first);
+	}
+	else
+	{
+		std::fill_n(batch_.color.begin() + entry.vertices.first, vertex_count, glm::vec4(.5f, .5f, .5f, 1.0f));
+	}
+
+	// Indices are relative to the batch, so only the range origins move.
+	entry.submeshes = batch.submeshes.empty()
+		? std::vector<Graphics::Submesh>{{.index_count = index_count}}
+		: batch.submeshes;
+
+	for (Graphics::Submesh& submesh : entry.submeshes)
+	{
+		submesh.first_index   += entry.indices.first;
+		submesh.vertex_offset += static_cast<int32_t>(entry.vertices.first);
+	}
+
+	used_vertex_count_ += vertex_count;
+	used_index_count_  += index_count;
+
+	Handle handle = static_cast<Handle>(entries_.size());
+
+	if (!free_handles_.empty())
+	{
+		handle = free_handles_.back();
+		free_handles_.pop_back();
+
+		entries_[handle] = std::move(entry);
+	}
+	else
+	{
+		entries_.push_back(std::move(entry));
+	}
+
+	RebuildSubmeshes();
+
+	return handle;
+}
+
+void BatchBuilder::Remove(Handle handle)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (handle >= entries_.size() || !entries_[handle].alive)
+	{
+		throw std::runtime_error("Invalid batch handle");
+	}
+
+	Entry& entry = entries_[handle];
+
+	const uint32_t vertex_arena_size = Release(
+		&free_vertex_ranges_,
+		static_cast<uint32_t>(batch_.position.size()),
+		entry.vertices);
+
+	const uint32_t index_arena_size = Release(
+		&free_index_ranges_,
+		static_cast<uint32_t>(batch_.indices.size()),
+		entry.indices);
+
+	batch_.position.resize(vertex_arena_size);
+	batch_.normals.resize(vertex_arena_size);
+	batch_.color.resize(vertex_arena_size);
+	batch_.indices.resize(index_arena_size);
+
+	used_vertex_count_ -= entry.vertices.count;
+	used_index_count_  -= entry.indices.count;
+
+	entry = {};
+	free_handles_.push_back(handle);
+
+	RebuildSubmeshes();
+}
+
+void BatchBuilder::Clear()
+{
+	*this = {};
+}
+
+const Batch& BatchBuilder::GetBatch() const
+{
+	return batch_;
+}
+
+uint32_t BatchBuilder::GetVertexCount() const
+{
+	return used_vertex_count_;
+}
+
+uint32_t BatchBuilder::GetIndexCount() const
+{
+	return used_index_count_;
+}
+
+uint32_t BatchBuilder::Allocate(
+	std::vector<Range>* p_free_ranges,
+	uint32_t            arena_size,
+	uint32_t            count)
+{
+	if (count == 0)
+	{
+		return arena_size;
+	}
+
+	const auto free_range = std::ranges::find_if(
+		*p_free_ranges,
+		[count](const Range& range) { return range.count >= count; });
+
+	if (free_range == p_free_ranges->end())
+	{
+		return arena_size;
+	}
+
+	const uint32_t first = free_range->first;
+
+	free_range->first += count;
+	free_range->count -= count;
+
+	if (free_range->count == 0)
+	{
+		p_free_ranges->erase(free_range);
+	}
+
+	return first;
+}
+
+uint32_t BatchBuilder::Release(
+	std::vector<Range>* p_free_ranges,
+	uint32_t            arena_size,
+	Range               range)
+{
+	if (range.count == 0)
+	{
+		return arena_size;
+	}
+
+	// Sorted by first element, so only the neighbours can be merged.
+	auto next = std::ranges::upper_bound(
+		*p_free_ranges,
+		range.first,
+		{},
+		&Range::first);
+
+	if (next != p_free_ranges->end() && range.first + range.count == next->first)
+	{
+		range.count += next->count;
+		next = p_free_ranges->erase(next);
+	}
+
+	if (next != p_free_ranges->begin())
+	{
+		const auto previous = std::prev(next);
+
+		if (previous->first + previous->count == range.first)
+		{
+			range.first  = previous->first;
+			range.count += previous->count;
+			next         = p_free_ranges->erase(previous);
+		}
+	}
+
+	// Nothing lives after it: shrink the arena rather than keeping a free tail.
+	if (range.first + range.count == arena_size)
+	{
+		return range.first;
+	}
+
+	p_free_ranges->insert(next, range);
+
+	return arena_size;
+}
+
+void BatchBuilder::RebuildSubmeshes()
+{
+	batch_.submeshes.clear();
+
+	for (const Entry& entry : entries_)
+	{
+		if (entry.alive)
+		{
+			batch_.submeshes.insert(batch_.submeshes.end(), entry.submeshes.begin(), entry.submeshes.end());
+		}
+	}
+}
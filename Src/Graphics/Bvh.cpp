@@ -0,0 +1,1426 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Bvh.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ADRO_BVH_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/// Bins of the SAH build along the widest axis of the centroids.
+constexpr uint32_t sah_bin_count = 16;
+
+/// Set on the query stack entries whose subtree is fully inside the frustum.
+constexpr uint32_t inside_flag = 0x80000000;
+
+/// The far distance of the slab test is scaled up by 2 gamma(3) (Ize 2013), so the rounding of the test can't
+/// drop a box the segment only grazes (through an edge or a corner, where the triangles meet).
+constexpr float slab_far_scale = 1.0f + 6.0f * 0x1p-24f;
+
+/// Triangles per leaf of a TriangleBvh, one per SIMD lane.
+constexpr uint32_t triangle_block_size = 4;
+
+/// Ray of the watertight triangle test: the axis the direction is largest on becomes z, and the triangles are
+/// sheared so that the ray runs along z from the origin. The hit test is then 2D.
+struct ShearedRay
+{
+	int       axes[3]  = {}; // x, y, z
+	glm::vec3 origin   = {};
+	float     shear[3] = {};
+};
+
+Graphics::Aabb Union(
+	const Graphics::Aabb& a,
+	const Graphics::Aabb& b)
+{
+	return {
+		.min = glm::min(a.min, b.min),
+		.max = glm::max(a.max, b.max),
+	};
+}
+
+/// Half the surface area, the SAH only compares areas.
+float Area(const Graphics::Aabb& bounds)
+{
+	const glm::vec3 extent = bounds.max - bounds.min;
+
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+Graphics::Aabb EmptyAabb()
+{
+	constexpr float max = std::numeric_limits<float>::max();
+
+	return {
+		.min = glm::vec3(max),
+		.max = glm::vec3(-max),
+	};
+}
+
+/// Binned SAH split of the items (indices into bounds and centroids), along the widest axis of their centroids.
+/// The items of the left side are moved first.
+/// @param p_bounds		receives the bounds of all the items.
+/// @return the item count of the left side, never 0 nor the whole range.
+uint32_t SplitSah(
+	std::span<uint32_t>             items,
+	std::span<const Graphics::Aabb> bounds,
+	std::span<const glm::vec3>      centroids,
+	Graphics::Aabb*                 p_bounds)
+{
+	struct Bin
+	{
+		Graphics::Aabb bounds = EmptyAabb();
+		uint32_t       count  = 0;
+	};
+
+	Graphics::Aabb range_bounds    = EmptyAabb();
+	Graphics::Aabb centroid_bounds = EmptyAabb();
+
+	for (const uint32_t item : items)
+	{
+		range_bounds        = Union(range_bounds, bounds[item]);
+		centroid_bounds.min = glm::min(centroid_bounds.min, centroids[item]);
+		centroid_bounds.max = glm::max(centroid_bounds.max, centroids[item]);
+	}
+
+	*p_bounds = range_bounds;
+
+	const glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+	int             axis   = extent.y > extent.x ? 1 : 0;
+
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	uint32_t middle = 0;
+
+	if (extent[axis] > 0.0f)
+	{
+		Bin         bins[sah_bin_count] = {};
+		const float scale               = sah_bin_count / extent[axis];
+
+		const auto bin_of = [&](uint32_t item)
+		{
+			const float offset = (centroids[item][axis] - centroid_bounds.min[axis]) * scale;
+
+			return std::min(static_cast<uint32_t>(offset), sah_bin_count - 1);
+		};
+
+		for (const uint32_t item : items)
+		{
+			Bin& bin = bins[bin_of(item)];
+
+			bin.bounds = Union(bin.bounds, bounds[item]);
+			bin.count++;
+		}
+
+		// Cost of splitting after every bin: sweep the right side, then the left one.
+		float          right_costs[sah_bin_count] = {};
+		Graphics::Aabb right_bounds               = EmptyAabb();
+		uint32_t       right_count                = 0;
+
+		for (uint32_t bin = sah_bin_count - 1; bin > 0; bin--)
+		{
+			right_bounds = Union(right_bounds, bins[bin].bounds);
+			right_count += bins[bin].count;
+
+			right_costs[bin - 1] = right_count > 0 ? Area(right_bounds) * static_cast<float>(right_count) : 0.0f;
+		}
+
+		Graphics::Aabb left_bounds = EmptyAabb();
+		uint32_t       left_count  = 0;
+		uint32_t       best_split  = 0;
+		float          best_cost   = std::numeric_limits<float>::max();
+
+		for (uint32_t bin = 0; bin < sah_bin_count - 1; bin++)
+		{
+			left_bounds = Union(left_bounds, bins[bin].bounds);
+			left_count += bins[bin].count;
+
+			const float left_cost = left_count > 0 ? Area(left_bounds) * static_cast<float>(left_count) : 0.0f;
+
+			if (left_cost + right_costs[bin] < best_cost)
+			{
+				best_cost  = left_cost + right_costs[bin];
+				best_split = bin;
+			}
+		}
+
+		middle = static_cast<uint32_t>(
+			std::partition(items.begin(), items.end(), [&](uint32_t item) { return bin_of(item) <= best_split; }) -
+			items.begin());
+	}
+
+	// Coincident centroids, or a split leaving a side empty: halve the range.
+	if (middle == 0 || middle == items.size())
+	{
+		middle = static_cast<uint32_t>(items.size() / 2);
+	}
+
+	return middle;
+}
+
+/// Lanes of a wide node overlapping the box.
+uint32_t OverlapMask(
+	const float           (&bounds)[6][4],
+	const Graphics::Aabb& query)
+{
+#if defined(ADRO_BVH_SSE)
+	__m128 overlap = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const __m128 min = _mm_load_ps(bounds[axis]);
+		const __m128 max = _mm_load_ps(bounds[axis + 3]);
+
+		overlap = _mm_and_ps(overlap, _mm_cmple_ps(min, _mm_set1_ps(query.max[axis])));
+		overlap = _mm_and_ps(overlap, _mm_cmpge_ps(max, _mm_set1_ps(query.min[axis])));
+	}
+
+	return static_cast<uint32_t>(_mm_movemask_ps(overlap));
+#else
+	uint32_t mask = 0;
+
+	for (uint32_t lane = 0; lane < 4; lane++)
+	{
+		bool overlap = true;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			overlap &= bounds[axis][lane] <= query.max[axis] && bounds[axis + 3][lane] >= query.min[axis];
+		}
+
+		mask |= static_cast<uint32_t>(overlap) << lane;
+	}
+
+	return mask;
+#endif
+}
+
+/// Lanes of a wide node touching the frustum, and the lanes fully inside it in p_inside_mask.
+///
+/// Per plane, the corner furthest along the normal (p-vertex) decides whether the box is outside, the nearest one
+/// (n-vertex) whether it is inside. The normal is the same for the 4 lanes, so the corners are whole rows.
+uint32_t FrustumMask(
+	const float              (&bounds)[6][4],
+	const Graphics::Frustum& frustum,
+	uint32_t*                p_inside_mask)
+{
+#if defined(ADRO_BVH_SSE)
+	__m128 outside = _mm_setzero_ps();
+	__m128 partial = _mm_setzero_ps();
+
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		__m128 p_distance = _mm_set1_ps(plane.w);
+		__m128 n_distance = _mm_set1_ps(plane.w);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const bool   positive = plane[axis] >= 0.0f;
+			const __m128 normal   = _mm_set1_ps(plane[axis]);
+
+			p_distance = _mm_add_ps(p_distance, _mm_mul_ps(normal, _mm_load_ps(bounds[positive ? axis + 3 : axis])));
+			n_distance = _mm_add_ps(n_distance, _mm_mul_ps(normal, _mm_load_ps(bounds[positive ? axis : axis + 3])));
+		}
+
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(p_distance, _mm_setzero_ps()));
+		partial = _mm_or_ps(partial, _mm_cmplt_ps(n_distance, _mm_setzero_ps()));
+	}
+
+	*p_inside_mask = static_cast<uint32_t>(_mm_movemask_ps(partial)) ^ 0xF;
+
+	return static_cast<uint32_t>(_mm_movemask_ps(outside)) ^ 0xF;
+#else
+	uint32_t outside = 0;
+	uint32_t partial = 0;
+
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			float p_distance = plane.w;
+			float n_distance = plane.w;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const bool positive = plane[axis] >= 0.0f;
+
+				p_distance += plane[axis] * bounds[positive ? axis + 3 : axis][lane];
+				n_distance += plane[axis] * bounds[positive ? axis : axis + 3][lane];
+			}
+
+			outside |= static_cast<uint32_t>(p_distance < 0.0f) << lane;
+			partial |= static_cast<uint32_t>(n_distance < 0.0f) << lane;
+		}
+	}
+
+	*p_inside_mask = partial ^ 0xF;
+
+	return outside ^ 0xF;
+#endif
+}
+
+ShearedRay MakeShearedRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction)
+{
+	const glm::vec3 magnitude = glm::abs(direction);
+	int             z         = magnitude.y > magnitude.x ? 1 : 0;
+
+	if (magnitude.z > magnitude[z])
+	{
+		z = 2;
+	}
+
+	int x = (z + 1) % 3;
+	int y = (x + 1) % 3;
+
+	// Keep the winding, so the sign of the edge functions says which side of the triangle is hit.
+	if (direction[z] < 0.0f)
+	{
+		std::swap(x, y);
+	}
+
+	return {
+		.axes = {x, y, z},
+		.origin = origin,
+		.shear = {direction[x] / direction[z], direction[y] / direction[z], 1.0f / direction[z]},
+	};
+}
+
+/// Hit test of a triangle already sheared by the ray, the edge functions are computed in double: products of
+/// floats are exact in double, so their sign is exact too.
+bool IntersectTriangle(
+	const float (&x)[3],
+	const float (&y)[3],
+	const float (&z)[3],
+	float       max_distance,
+	float*      p_distance,
+	glm::vec2*  p_barycentrics)
+{
+	// Edge functions, the ray is inside when they share a sign (zero is on the edge and counts).
+	const double u = static_cast<double>(x[2]) * y[1] - static_cast<double>(y[2]) * x[1];
+	const double v = static_cast<double>(x[0]) * y[2] - static_cast<double>(y[0]) * x[2];
+	const double w = static_cast<double>(x[1]) * y[0] - static_cast<double>(y[1]) * x[0];
+
+	if ((u < 0.0 || v < 0.0 || w < 0.0) && (u > 0.0 || v > 0.0 || w > 0.0))
+	{
+		return false;
+	}
+
+	const double determinant = u + v + w;
+
+	if (determinant == 0.0)
+	{
+		return false;
+	}
+
+	const double distance = (u * z[0] + v * z[1] + w * z[2]) / determinant;
+
+	if (distance <= 0.0 || distance > max_distance)
+	{
+		return false;
+	}
+
+	*p_distance     = static_cast<float>(distance);
+	*p_barycentrics = glm::vec2(static_cast<float>(v / determinant), static_cast<float>(w / determinant));
+
+	return true;
+}
+
+/// Closest triangle of a block the segment crosses.
+///
+/// The 4 lanes are tested in float. Rounding keeps the sign of the edge functions, or makes them zero: lanes with
+/// a zero (the ray through an edge or a vertex, as far as float goes) are decided in double, which is what makes
+/// the test watertight.
+/// @return the lane of the hit, or -1.
+int IntersectBlock(
+	const ShearedRay& ray,
+	const float       (&vertices)[3][3][4],
+	uint32_t          count,
+	float             max_distance,
+	float*            p_distance,
+	glm::vec2*        p_barycentrics)
+{
+	int best_lane = -1;
+
+#if defined(ADRO_BVH_SSE)
+	__m128 x[3] = {};
+	__m128 y[3] = {};
+	__m128 z[3] = {};
+
+	for (int vertex = 0; vertex < 3; vertex++)
+	{
+		const __m128 relative_x = _mm_sub_ps(
+			_mm_load_ps(vertices[vertex][ray.axes[0]]),
+			_mm_set1_ps(ray.origin[ray.axes[0]]));
+		const __m128 relative_y = _mm_sub_ps(
+			_mm_load_ps(vertices[vertex][ray.axes[1]]),
+			_mm_set1_ps(ray.origin[ray.axes[1]]));
+		const __m128 relative_z = _mm_sub_ps(
+			_mm_load_ps(vertices[vertex][ray.axes[2]]),
+			_mm_set1_ps(ray.origin[ray.axes[2]]));
+
+		x[vertex] = _mm_sub_ps(relative_x, _mm_mul_ps(_mm_set1_ps(ray.shear[0]), relative_z));
+		y[vertex] = _mm_sub_ps(relative_y, _mm_mul_ps(_mm_set1_ps(ray.shear[1]), relative_z));
+		z[vertex] = _mm_mul_ps(_mm_set1_ps(ray.shear[2]), relative_z);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 u    = _mm_sub_ps(_mm_mul_ps(x[2], y[1]), _mm_mul_ps(y[2], x[1]));
+	const __m128 v    = _mm_sub_ps(_mm_mul_ps(x[0], y[2]), _mm_mul_ps(y[0], x[2]));
+	const __m128 w    = _mm_sub_ps(_mm_mul_ps(x[1], y[0]), _mm_mul_ps(y[1], x[0]));
+
+	const __m128 negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)), _mm_cmplt_ps(w, zero));
+	const __m128 positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)), _mm_cmpgt_ps(w, zero));
+	const __m128 on_edge  = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(u, zero), _mm_cmpeq_ps(v, zero)), _mm_cmpeq_ps(w, zero));
+
+	// Distance scaled by the determinant, compared with the sign of the determinant folded in.
+	const __m128 determinant     = _mm_add_ps(_mm_add_ps(u, v), w);
+	const __m128 scaled_distance = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(u, z[0]), _mm_mul_ps(v, z[1])),
+		_mm_mul_ps(w, z[2]));
+	const __m128 sign            = _mm_and_ps(determinant, _mm_set1_ps(-0.0f));
+	const __m128 signed_distance = _mm_xor_ps(scaled_distance, sign);
+	const __m128 abs_determinant = _mm_xor_ps(determinant, sign);
+
+	__m128 hit = _mm_andnot_ps(_mm_and_ps(negative, positive), _mm_cmpneq_ps(determinant, zero));
+	hit        = _mm_and_ps(hit, _mm_cmpgt_ps(signed_distance, zero));
+	hit        = _mm_and_ps(hit, _mm_cmple_ps(signed_distance, _mm_mul_ps(_mm_set1_ps(max_distance), abs_determinant)));
+
+	const uint32_t lane_mask = (1u << count) - 1;
+	const uint32_t edge_mask = static_cast<uint32_t>(_mm_movemask_ps(on_edge)) & lane_mask;
+	uint32_t       hit_mask  = static_cast<uint32_t>(_mm_movemask_ps(hit)) & lane_mask & ~edge_mask;
+
+	if (hit_mask)
+	{
+		const __m128 inverse_determinant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+		alignas(16) float distances[4] = {};
+		alignas(16) float weights_v[4] = {};
+		alignas(16) float weights_w[4] = {};
+
+		_mm_store_ps(distances, _mm_mul_ps(scaled_distance, inverse_determinant));
+		_mm_store_ps(weights_v, _mm_mul_ps(v, inverse_determinant));
+		_mm_store_ps(weights_w, _mm_mul_ps(w, inverse_determinant));
+
+		while (hit_mask)
+		{
+			const uint32_t lane = std::countr_zero(hit_mask);
+			hit_mask &= hit_mask - 1;
+
+			if (distances[lane] <= max_distance)
+			{
+				max_distance    = distances[lane];
+				best_lane       = static_cast<int>(lane);
+				*p_distance     = distances[lane];
+				*p_barycentrics = glm::vec2(weights_v[lane], weights_w[lane]);
+			}
+		}
+	}
+
+	if (edge_mask)
+	{
+		alignas(16) float sheared[3][3][4] = {}; // Vertex, then x, y, z.
+
+		for (int vertex = 0; vertex < 3; vertex++)
+		{
+			_mm_store_ps(sheared[vertex][0], x[vertex]);
+			_mm_store_ps(sheared[vertex][1], y[vertex]);
+			_mm_store_ps(sheared[vertex][2], z[vertex]);
+		}
+
+		for (uint32_t mask = edge_mask; mask; mask &= mask - 1)
+		{
+			const uint32_t lane = std::countr_zero(mask);
+
+			const float lane_x[3] = {sheared[0][0][lane], sheared[1][0][lane], sheared[2][0][lane]};
+			const float lane_y[3] = {sheared[0][1][lane], sheared[1][1][lane], sheared[2][1][lane]};
+			const float lane_z[3] = {sheared[0][2][lane], sheared[1][2][lane], sheared[2][2][lane]};
+
+			if (IntersectTriangle(lane_x, lane_y, lane_z, max_distance, p_distance, p_barycentrics))
+			{
+				max_distance = *p_distance;
+				best_lane    = static_cast<int>(lane);
+			}
+		}
+	}
+#else
+	for (uint32_t lane = 0; lane < count; lane++)
+	{
+		float x[3] = {};
+		float y[3] = {};
+		float z[3] = {};
+
+		for (int vertex = 0; vertex < 3; vertex++)
+		{
+			const float relative_x = vertices[vertex][ray.axes[0]][lane] - ray.origin[ray.axes[0]];
+			const float relative_y = vertices[vertex][ray.axes[1]][lane] - ray.origin[ray.axes[1]];
+			const float relative_z = vertices[vertex][ray.axes[2]][lane] - ray.origin[ray.axes[2]];
+
+			x[vertex] = relative_x - ray.shear[0] * relative_z;
+			y[vertex] = relative_y - ray.shear[1] * relative_z;
+			z[vertex] = ray.shear[2] * relative_z;
+		}
+
+		if (IntersectTriangle(x, y, z, max_distance, p_distance, p_barycentrics))
+		{
+			max_distance = *p_distance;
+			best_lane    = static_cast<int>(lane);
+		}
+	}
+#endif
+
+	return best_lane;
+}
+
+/// Axes the ray is parallel to get a huge finite inverse, so the slabs never compute 0 * inf.
+glm::vec3 InverseDirection(const glm::vec3& direction)
+{
+	glm::vec3 inverse_direction = {};
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float component   = std::abs(direction[axis]) > 1e-30f ? direction[axis] : 1e-30f;
+		inverse_direction[axis] = 1.0f / component;
+	}
+
+	return inverse_direction;
+}
+
+/// Lanes of a wide node the segment crosses (slab test).
+/// @param p_near_distances		optional, receives the distance the segment enters every lane at.
+uint32_t RayMask(
+	const float      (&bounds)[6][4],
+	const glm::vec3& origin,
+	const glm::vec3& inverse_direction,
+	float            max_distance,
+	float*           p_near_distances = nullptr)
+{
+#if defined(ADRO_BVH_SSE)
+	__m128 near = _mm_setzero_ps();
+	__m128 far  = _mm_set1_ps(max_distance);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const __m128 start   = _mm_set1_ps(origin[axis]);
+		const __m128 inverse = _mm_set1_ps(inverse_direction[axis]);
+		const __m128 t0      = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds[axis]), start), inverse);
+		const __m128 t1      = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds[axis + 3]), start), inverse);
+
+		near = _mm_max_ps(near, _mm_min_ps(t0, t1));
+		far  = _mm_min_ps(far, _mm_mul_ps(_mm_max_ps(t0, t1), _mm_set1_ps(slab_far_scale)));
+	}
+
+	if (p_near_distances)
+	{
+		_mm_storeu_ps(p_near_distances, near);
+	}
+
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near, far)));
+#else
+	uint32_t mask = 0;
+
+	for (uint32_t lane = 0; lane < 4; lane++)
+	{
+		float near = 0.0f;
+		float far  = max_distance;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float t0 = (bounds[axis][lane] - origin[axis]) * inverse_direction[axis];
+			const float t1 = (bounds[axis + 3][lane] - origin[axis]) * inverse_direction[axis];
+
+			near = std::max(near, std::min(t0, t1));
+			far  = std::min(far, std::max(t0, t1) * slab_far_scale);
+		}
+
+		if (p_near_distances)
+		{
+			p_near_distances[lane] = near;
+		}
+
+		mask |= static_cast<uint32_t>(near <= far) << lane;
+	}
+
+	return mask;
+#endif
+}
+}
+
+void Bvh::Build(
+	std::span<const Graphics::Aabb> bounds,
+	std::vector<Handle>*            p_handles)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (bounds.size() > max_object)
+	{
+		throw std::runtime_error("Failed to build BVH: too many objects");
+	}
+
+	Clear();
+
+	const uint32_t object_count = static_cast<uint32_t>(bounds.size());
+
+	nodes_.reserve(static_cast<size_t>(object_count) * 2);
+
+	// The leaves are the nodes 0 to object_count - 1 (node = object), the internal nodes follow.
+	std::vector<uint32_t>  leaves(object_count);
+	std::vector<glm::vec3> centroids(object_count);
+
+	for (uint32_t object = 0; object < object_count; object++)
+	{
+		const uint32_t leaf = AllocateNode();
+
+		nodes_[leaf].bounds = bounds[object];
+		nodes_[leaf].object = object;
+		leaves[object]      = leaf;
+		centroids[leaf]     = (bounds[object].min + bounds[object].max) * 0.5f;
+	}
+
+	if (p_handles)
+	{
+		p_handles->assign(leaves.begin(), leaves.end());
+	}
+
+	object_count_ = object_count;
+
+	if (object_count > 0)
+	{
+		root_ = BuildRange(leaves, bounds, centroids);
+	}
+
+	Commit();
+}
+
+Bvh::Handle Bvh::Insert(
+	const Graphics::Aabb& bounds,
+	uint32_t              object)
+{
+	if (object > max_object)
+	{
+		throw std::runtime_error("Failed to insert in BVH: object out of range");
+	}
+
+	const uint32_t leaf = AllocateNode();
+
+	nodes_[leaf].bounds = bounds;
+	nodes_[leaf].object = object;
+
+	InsertLeaf(leaf);
+
+	object_count_++;
+	committed_ = false;
+
+	return leaf;
+}
+
+void Bvh::Remove(Handle handle)
+{
+	if (handle >= nodes_.size() || !nodes_[handle].alive || !IsLeaf(handle))
+	{
+		throw std::runtime_error("Invalid BVH handle");
+	}
+
+	RemoveLeaf(handle);
+	FreeNode(handle);
+
+	object_count_--;
+	committed_ = false;
+}
+
+void Bvh::Update(
+	Handle                handle,
+	const Graphics::Aabb& bounds)
+{
+	if (handle >= nodes_.size() || !nodes_[handle].alive || !IsLeaf(handle))
+	{
+		throw std::runtime_error("Invalid BVH handle");
+	}
+
+	nodes_[handle].bounds = bounds;
+
+	RefitAncestors(nodes_[handle].parent);
+
+	committed_ = false;
+}
+
+void Bvh::Clear()
+{
+	nodes_.clear();
+	free_nodes_.clear();
+	wide_nodes_.clear();
+
+	root_         = null_node;
+	object_count_ = 0;
+	committed_    = true;
+}
+
+void Bvh::Commit()
+{
+	ADRO_PROFILE_FUNCTION();
+
+	wide_nodes_.clear();
+	committed_ = true;
+
+	if (root_ == null_node)
+	{
+		return;
+	}
+
+	struct Task
+	{
+		uint32_t node = 0;
+		uint32_t wide = 0;
+	};
+
+	std::vector<Task> stack = {{.node = root_, .wide = 0}};
+
+	wide_nodes_.reserve(object_count_ / 2 + 1);
+	wide_nodes_.emplace_back();
+
+	while (!stack.empty())
+	{
+		const Task task = stack.back();
+		stack.pop_back();
+
+		// Collapse: open the internal lane of largest area until the node has 4 lanes.
+		uint32_t lanes[4]   = {};
+		uint32_t lane_count = 0;
+
+		if (IsLeaf(task.node))
+		{
+			lanes[lane_count++] = task.node;
+		}
+		else
+		{
+			lanes[lane_count++] = nodes_[task.node].children[0];
+			lanes[lane_count++] = nodes_[task.node].children[1];
+		}
+
+		while (lane_count < 4)
+		{
+			uint32_t largest      = lane_count;
+			float    largest_area = -1.0f;
+
+			for (uint32_t lane = 0; lane < lane_count; lane++)
+			{
+				if (!IsLeaf(lanes[lane]) && Area(nodes_[lanes[lane]].bounds) > largest_area)
+				{
+					largest      = lane;
+					largest_area = Area(nodes_[lanes[lane]].bounds);
+				}
+			}
+
+			if (largest == lane_count)
+			{
+				break;
+			}
+
+			const Node& opened = nodes_[lanes[largest]];
+
+			lanes[largest]      = opened.children[0];
+			lanes[lane_count++] = opened.children[1];
+		}
+
+		wide_nodes_[task.wide].count = lane_count;
+
+		for (uint32_t lane = 0; lane < lane_count; lane++)
+		{
+			const Node& node = nodes_[lanes[lane]];
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				wide_nodes_[task.wide].bounds[axis][lane]     = node.bounds.min[axis];
+				wide_nodes_[task.wide].bounds[axis + 3][lane] = node.bounds.max[axis];
+			}
+
+			if (IsLeaf(lanes[lane]))
+			{
+				wide_nodes_[task.wide].children[lane] = leaf_flag | node.object;
+			}
+			else
+			{
+				const uint32_t child = static_cast<uint32_t>(wide_nodes_.size());
+
+				wide_nodes_.emplace_back();
+				wide_nodes_[task.wide].children[lane] = child;
+				stack.push_back({.node = lanes[lane], .wide = child});
+			}
+		}
+	}
+}
+
+void Bvh::QueryAabb(
+	const Graphics::Aabb&  bounds,
+	std::vector<uint32_t>* p_objects) const
+{
+	if (!committed_)
+	{
+		throw std::runtime_error("Failed to query BVH: changes not committed");
+	}
+
+	if (wide_nodes_.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack = {0};
+
+	while (!stack.empty())
+	{
+		const WideNode& node = wide_nodes_[stack.back()];
+		stack.pop_back();
+
+		uint32_t mask = OverlapMask(node.bounds, bounds) & ((1u << node.count) - 1);
+
+		while (mask)
+		{
+			const uint32_t child = node.children[std::countr_zero(mask)];
+			mask &= mask - 1;
+
+			if (child & leaf_flag)
+			{
+				p_objects->push_back(child & ~leaf_flag);
+			}
+			else
+			{
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+void Bvh::QueryFrustum(
+	const Graphics::Frustum& frustum,
+	std::vector<uint32_t>*   p_objects) const
+{
+	if (!committed_)
+	{
+		throw std::runtime_error("Failed to query BVH: changes not committed");
+	}
+
+	if (wide_nodes_.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack = {0};
+
+	while (!stack.empty())
+	{
+		const uint32_t  entry = stack.back();
+		const WideNode& node  = wide_nodes_[entry & ~inside_flag];
+		stack.pop_back();
+
+		const uint32_t lane_mask = (1u << node.count) - 1;
+
+		// Subtrees fully inside the frustum are gathered without testing the planes.
+		uint32_t inside_mask = lane_mask;
+		uint32_t mask        = lane_mask;
+
+		if (!(entry & inside_flag))
+		{
+			mask = FrustumMask(node.bounds, frustum, &inside_mask) & lane_mask;
+		}
+
+		while (mask)
+		{
+			const uint32_t lane  = std::countr_zero(mask);
+			const uint32_t child = node.children[lane];
+			mask &= mask - 1;
+
+			if (child & leaf_flag)
+			{
+				p_objects->push_back(child & ~leaf_flag);
+			}
+			else
+			{
+				stack.push_back(child | ((inside_mask >> lane) & 1 ? inside_flag : 0));
+			}
+		}
+	}
+}
+
+void Bvh::QueryRay(
+	const glm::vec3&       origin,
+	const glm::vec3&       direction,
+	float                  max_distance,
+	std::vector<uint32_t>* p_objects) const
+{
+	if (!committed_)
+	{
+		throw std::runtime_error("Failed to query BVH: changes not committed");
+	}
+
+	if (wide_nodes_.empty())
+	{
+		return;
+	}
+
+	const glm::vec3 inverse_direction = InverseDirection(direction);
+
+	std::vector<uint32_t> stack = {0};
+
+	while (!stack.empty())
+	{
+		const WideNode& node = wide_nodes_[stack.back()];
+		stack.pop_back();
+
+		uint32_t mask = RayMask(node.bounds, origin, inverse_direction, max_distance) & ((1u << node.count) - 1);
+
+		while (mask)
+		{
+			const uint32_t child = node.children[std::countr_zero(mask)];
+			mask &= mask - 1;
+
+			if (child & leaf_flag)
+			{
+				p_objects->push_back(child & ~leaf_flag);
+			}
+			else
+			{
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+uint32_t Bvh::GetObjectCount() const
+{
+	return object_count_;
+}
+
+float Bvh::GetCost() const
+{
+	if (root_ == null_node || IsLeaf(root_))
+	{
+		return 0.0f;
+	}
+
+	float area = 0.0f;
+
+	for (uint32_t node = 0; node < nodes_.size(); node++)
+	{
+		if (nodes_[node].alive && !IsLeaf(node))
+		{
+			area += Area(nodes_[node].bounds);
+		}
+	}
+
+	return area / Area(nodes_[root_].bounds);
+}
+
+bool Bvh::IsLeaf(uint32_t node) const
+{
+	return nodes_[node].children[0] == null_node;
+}
+
+uint32_t Bvh::AllocateNode()
+{
+	uint32_t node = static_cast<uint32_t>(nodes_.size());
+
+	if (free_nodes_.empty())
+	{
+		nodes_.emplace_back();
+	}
+	else
+	{
+		node = free_nodes_.back();
+		free_nodes_.pop_back();
+	}
+
+	nodes_[node].alive = true;
+
+	return node;
+}
+
+void Bvh::FreeNode(uint32_t node)
+{
+	nodes_[node] = {};
+	free_nodes_.push_back(node);
+}
+
+uint32_t Bvh::FindBestSibling(const Graphics::Aabb& bounds) const
+{
+	const float area = Area(bounds);
+
+	// Pairing with a node costs the area of the new parent, plus the growth of every ancestor (inherited).
+	uint32_t best_sibling   = root_;
+	float    best_cost      = Area(Union(nodes_[root_].bounds, bounds));
+	float    inherited_cost = 0.0f;
+	uint32_t node           = root_;
+
+	while (!IsLeaf(node))
+	{
+		inherited_cost += Area(Union(nodes_[node].bounds, bounds)) - Area(nodes_[node].bounds);
+
+		// Any node below costs at least the leaf itself on top of what is inherited.
+		if (area + inherited_cost >= best_cost)
+		{
+			break;
+		}
+
+		uint32_t next        = null_node;
+		float    next_growth = std::numeric_limits<float>::max();
+
+		for (const uint32_t child : nodes_[node].children)
+		{
+			const float combined_area = Area(Union(nodes_[child].bounds, bounds));
+			const float cost          = combined_area + inherited_cost;
+
+			if (cost < best_cost)
+			{
+				best_sibling = child;
+				best_cost    = cost;
+			}
+
+			const float growth = combined_area - Area(nodes_[child].bounds);
+
+			if (!IsLeaf(child) && growth < next_growth)
+			{
+				next        = child;
+				next_growth = growth;
+			}
+		}
+
+		if (next == null_node)
+		{
+			break;
+		}
+
+		node = next;
+	}
+
+	return best_sibling;
+}
+
+void Bvh::InsertLeaf(uint32_t leaf)
+{
+	if (root_ == null_node)
+	{
+		root_               = leaf;
+		nodes_[leaf].parent = null_node;
+		return;
+	}
+
+	const uint32_t sibling    = FindBestSibling(nodes_[leaf].bounds);
+	const uint32_t old_parent = nodes_[sibling].parent;
+	const uint32_t new_parent = AllocateNode();
+
+	nodes_[new_parent].bounds      = Union(nodes_[sibling].bounds, nodes_[leaf].bounds);
+	nodes_[new_parent].parent      = old_parent;
+	nodes_[new_parent].children[0] = sibling;
+	nodes_[new_parent].children[1] = leaf;
+	nodes_[sibling].parent         = new_parent;
+	nodes_[leaf].parent            = new_parent;
+
+	if (old_parent == null_node)
+	{
+		root_ = new_parent;
+		return;
+	}
+
+	const int slot = nodes_[old_parent].children[0] == sibling ? 0 : 1;
+
+	nodes_[old_parent].children[slot] = new_parent;
+
+	RefitAncestors(old_parent);
+}
+
+void Bvh::RemoveLeaf(uint32_t leaf)
+{
+	if (leaf == root_)
+	{
+		root_ = null_node;
+		return;
+	}
+
+	const uint32_t parent       = nodes_[leaf].parent;
+	const uint32_t grand_parent = nodes_[parent].parent;
+	const uint32_t sibling      = nodes_[parent].children[nodes_[parent].children[0] == leaf ? 1 : 0];
+
+	nodes_[sibling].parent = grand_parent;
+	nodes_[leaf].parent    = null_node;
+
+	if (grand_parent == null_node)
+	{
+		root_ = sibling;
+	}
+	else
+	{
+		const int slot = nodes_[grand_parent].children[0] == parent ? 0 : 1;
+
+		nodes_[grand_parent].children[slot] = sibling;
+	}
+
+	FreeNode(parent);
+
+	if (grand_parent != null_node)
+	{
+		RefitAncestors(grand_parent);
+	}
+}
+
+void Bvh::RefitAncestors(uint32_t node)
+{
+	while (node != null_node)
+	{
+		Rotate(node);
+
+		const Node& current = nodes_[node];
+
+		nodes_[node].bounds = Union(nodes_[current.children[0]].bounds, nodes_[current.children[1]].bounds);
+
+		node = current.parent;
+	}
+}
+
+void Bvh::Rotate(uint32_t node)
+{
+	// Node A with children B and C: swap B with a child of C, or C with a child of B. A keeps the same leaves, so
+	// only the area of the child that receives the swapped node changes.
+	const uint32_t children[2] = {nodes_[node].children[0], nodes_[node].children[1]};
+
+	float best_delta       = 0.0f;
+	int   best_child       = -1; // Child of A that moves down.
+	int   best_grand_child = -1; // Child of the other child that moves up.
+
+	for (int child = 0; child < 2; child++)
+	{
+		const uint32_t moved = children[child];
+		const uint32_t other = children[1 - child];
+
+		if (IsLeaf(other))
+		{
+			continue;
+		}
+
+		const float other_area = Area(nodes_[other].bounds);
+
+		for (int grand_child = 0; grand_child < 2; grand_child++)
+		{
+			const uint32_t kept  = nodes_[other].children[1 - grand_child];
+			const float    delta = Area(Union(nodes_[moved].bounds, nodes_[kept].bounds)) - other_area;
+
+			if (delta < best_delta)
+			{
+				best_delta       = delta;
+				best_child       = child;
+				best_grand_child = grand_child;
+			}
+		}
+	}
+
+	if (best_child < 0)
+	{
+		return;
+	}
+
+	const uint32_t moved  = children[best_child];
+	const uint32_t other  = children[1 - best_child];
+	const uint32_t lifted = nodes_[other].children[best_grand_child];
+	const uint32_t kept   = nodes_[other].children[1 - best_grand_child];
+
+	nodes_[node].children[best_child]        = lifted;
+	nodes_[lifted].parent                    = node;
+	nodes_[other].children[best_grand_child] = moved;
+	nodes_[moved].parent                     = other;
+	nodes_[other].bounds                     = Union(nodes_[moved].bounds, nodes_[kept].bounds);
+}
+
+uint32_t Bvh::BuildRange(
+	std::span<uint32_t>             leaves,
+	std::span<const Graphics::Aabb> bounds,
+	std::span<const glm::vec3>      centroids)
+{
+	struct Task
+	{
+		uint32_t begin  = 0;
+		uint32_t end    = 0;
+		uint32_t parent = null_node;
+		uint32_t slot   = 0;
+	};
+
+	uint32_t          root  = null_node;
+	std::vector<Task> stack = {{.begin = 0, .end = static_cast<uint32_t>(leaves.size())}};
+
+	while (!stack.empty())
+	{
+		const Task task = stack.back();
+		stack.pop_back();
+
+		uint32_t node = leaves[task.begin];
+
+		if (task.end - task.begin > 1)
+		{
+			node = AllocateNode();
+
+			const uint32_t middle = task.begin + SplitSah(
+				leaves.subspan(task.begin, task.end - task.begin),
+				bounds,
+				centroids,
+				&nodes_[node].bounds);
+
+			stack.push_back({.begin = task.begin, .end = middle, .parent = node, .slot = 0});
+			stack.push_back({.begin = middle, .end = task.end, .parent = node, .slot = 1});
+		}
+
+		nodes_[node].parent = task.parent;
+
+		if (task.parent == null_node)
+		{
+			root = node;
+		}
+		else
+		{
+			nodes_[task.parent].children[task.slot] = node;
+		}
+	}
+
+	return root;
+}
+
+void TriangleBvh::Build(
+	std::span<const glm::vec3> positions,
+	std::span<const uint32_t>  indices,
+	int32_t                    vertex_offset)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	nodes_.clear();
+	blocks_.clear();
+
+	triangle_count_ = static_cast<uint32_t>(indices.size() / 3);
+
+	if (triangle_count_ == 0)
+	{
+		return;
+	}
+
+	const auto vertex = [&](uint32_t triangle, uint32_t corner) -> const glm::vec3&
+	{
+		return positions[static_cast<int64_t>(indices[triangle * 3 + corner]) + vertex_offset];
+	};
+
+	std::vector<Graphics::Aabb> bounds(triangle_count_);
+	std::vector<glm::vec3>      centroids(triangle_count_);
+	std::vector<uint32_t>       triangles(triangle_count_);
+
+	for (uint32_t triangle = 0; triangle < triangle_count_; triangle++)
+	{
+		bounds[triangle] = {
+			.min = glm::min(glm::min(vertex(triangle, 0), vertex(triangle, 1)), vertex(triangle, 2)),
+			.max = glm::max(glm::max(vertex(triangle, 0), vertex(triangle, 1)), vertex(triangle, 2)),
+		};
+
+		centroids[triangle] = (bounds[triangle].min + bounds[triangle].max) * 0.5f;
+		triangles[triangle] = triangle;
+	}
+
+	struct Task
+	{
+		uint32_t begin = 0;
+		uint32_t end   = 0;
+		uint32_t node  = 0;
+	};
+
+	std::vector<Task> stack = {{.begin = 0, .end = triangle_count_, .node = 0}};
+
+	nodes_.reserve(triangle_count_ / triangle_block_size + 1);
+	blocks_.reserve(triangle_count_ / 2 + 1);
+	nodes_.emplace_back();
+
+	while (!stack.empty())
+	{
+		const Task task = stack.back();
+		stack.pop_back();
+
+		// Split the largest lane until the node has 4, the lanes stay contiguous ranges of the triangles.
+		uint32_t boundaries[5] = {task.begin, task.end};
+		uint32_t lane_count    = 1;
+
+		while (lane_count < 4)
+		{
+			uint32_t largest = 0;
+
+			for (uint32_t lane = 1; lane < lane_count; lane++)
+			{
+				if (boundaries[lane + 1] - boundaries[lane] > boundaries[largest + 1] - boundaries[largest])
+				{
+					largest = lane;
+				}
+			}
+
+			const uint32_t size = boundaries[largest + 1] - boundaries[largest];
+
+			if (size <= triangle_block_size)
+			{
+				break;
+			}
+
+			Graphics::Aabb split_bounds = {};
+
+			const uint32_t middle = boundaries[largest] + SplitSah(
+				std::span(triangles).subspan(boundaries[largest], size),
+				bounds,
+				centroids,
+				&split_bounds);
+
+			std::copy_backward(boundaries + largest + 1, boundaries + lane_count + 1, boundaries + lane_count + 2);
+			boundaries[largest + 1] = middle;
+			lane_count++;
+		}
+
+		nodes_[task.node].count = lane_count;
+
+		for (uint32_t lane = 0; lane < lane_count; lane++)
+		{
+			Graphics::Aabb lane_bounds = EmptyAabb();
+
+			for (uint32_t i = boundaries[lane]; i < boundaries[lane + 1]; i++)
+			{
+				lane_bounds = Union(lane_bounds, bounds[triangles[i]]);
+			}
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				nodes_[task.node].bounds[axis][lane]     = lane_bounds.min[axis];
+				nodes_[task.node].bounds[axis + 3][lane] = lane_bounds.max[axis];
+			}
+
+			if (boundaries[lane + 1] - boundaries[lane] > triangle_block_size)
+			{
+				const uint32_t child = static_cast<uint32_t>(nodes_.size());
+
+				nodes_.emplace_back();
+				nodes_[task.node].children[lane] = child;
+				stack.push_back({.begin = boundaries[lane], .end = boundaries[lane + 1], .node = child});
+				continue;
+			}
+
+			Block block = {};
+
+			for (uint32_t i = boundaries[lane]; i < boundaries[lane + 1]; i++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					for (int axis = 0; axis < 3; axis++)
+					{
+						block.vertices[corner][axis][block.count] = vertex(triangles[i], corner)[axis];
+					}
+				}
+
+				block.triangles[block.count++] = triangles[i];
+			}
+
+			nodes_[task.node].children[lane] = leaf_flag | static_cast<uint32_t>(blocks_.size());
+			blocks_.push_back(block);
+		}
+	}
+}
+
+bool TriangleBvh::Intersect(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float            max_distance,
+	Hit*             p_hit) const
+{
+	if (nodes_.empty())
+	{
+		return false;
+	}
+
+	struct Entry
+	{
+		uint32_t node     = 0;
+		float    distance = 0.0f; // Where the segment enters the node.
+	};
+
+	const ShearedRay ray               = MakeShearedRay(origin, direction);
+	const glm::vec3  inverse_direction = InverseDirection(direction);
+
+	std::vector<Entry> stack = {{.node = 0, .distance = 0.0f}};
+	bool               found = false;
+
+	stack.reserve(64);
+
+	while (!stack.empty())
+	{
+		const Entry entry = stack.back();
+		stack.pop_back();
+
+		// A closer hit was found since the node was pushed.
+		if (entry.distance > max_distance)
+		{
+			continue;
+		}
+
+		if (entry.node & leaf_flag)
+		{
+			const Block& block = blocks_[entry.node & ~leaf_flag];
+
+			float     distance     = 0.0f;
+			glm::vec2 barycentrics = {};
+
+			const int lane = IntersectBlock(ray, block.vertices, block.count, max_distance, &distance, &barycentrics);
+
+			if (lane >= 0)
+			{
+				max_distance = distance;
+				found        = true;
+
+				*p_hit = {
+					.distance = distance,
+					.triangle = block.triangles[lane],
+					.barycentrics = barycentrics,
+				};
+			}
+
+			continue;
+		}
+
+		const Node& node = nodes_[entry.node];
+
+		float    near_distances[4] = {};
+		uint32_t mask              = RayMask(node.bounds, origin, inverse_direction, max_distance, near_distances) &
+		                             ((1u << node.count) - 1);
+
+		// Farthest children first on the stack, the nearest one is visited next.
+		const size_t first = stack.size();
+
+		while (mask)
+		{
+			const uint32_t lane = std::countr_zero(mask);
+			mask &= mask - 1;
+
+			stack.push_back({.node = node.children[lane], .distance = near_distances[lane]});
+		}
+
+		std::sort(
+			stack.begin() + static_cast<ptrdiff_t>(first),
+			stack.end(),
+			[](const Entry& a, const Entry& b) { return a.distance > b.distance; });
+	}
+
+	return found;
+}
+
+uint32_t TriangleBvh::GetTriangleCount() const
+{
+	return triangle_count_;
+}
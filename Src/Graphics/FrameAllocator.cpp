@@ -0,0 +1,108 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+FrameAllocator::~FrameAllocator()
+{
+	Destroy();
+}
+
+void FrameAllocator::Init(
+	uint32_t frame_count,
+	size_t   budget)
+{
+	budget_ = budget;
+	frames_.resize(frame_count);
+
+	for (Frame& frame : frames_)
+	{
+		frame.memory = static_cast<std::byte*>(std::malloc(budget_));
+
+		if (!frame.memory)
+		{
+			throw std::bad_alloc();
+		}
+	}
+}
+
+void FrameAllocator::Destroy()
+{
+	for (Frame& frame : frames_)
+	{
+		for (const Overflow& overflow : frame.overflows)
+		{
+			::operator delete(overflow.memory, std::align_val_t(overflow.alignment));
+		}
+
+		std::free(frame.memory);
+	}
+
+	frames_.clear();
+}
+
+void FrameAllocator::BeginFrame(uint32_t frame_idx)
+{
+	current_frame_ = frame_idx % static_cast<uint32_t>(frames_.size());
+	Frame& frame   = frames_[current_frame_];
+
+	high_water_ = std::max(high_water_, frame.offset + frame.overflow);
+
+	for (const Overflow& overflow : frame.overflows)
+	{
+		::operator delete(overflow.memory, std::align_val_t(overflow.alignment));
+	}
+
+	frame.overflows.clear();
+	frame.offset   = 0;
+	frame.overflow = 0;
+}
+
+void* FrameAllocator::Allocate(
+	size_t size,
+	size_t alignment)
+{
+	assert(!frames_.empty() && "FrameAllocator used before Init");
+	assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	Frame& frame = frames_[current_frame_];
+
+	const size_t aligned_offset = (frame.offset + alignment - 1) & ~(alignment - 1);
+
+	if (aligned_offset + size <= budget_)
+	{
+		frame.offset = aligned_offset + size;
+		return frame.memory + aligned_offset;
+	}
+
+	// Over budget: keep the frame running, but make it visible.
+	if (frame.overflows.empty())
+	{
+		std::printf("[FRAME ALLOCATOR] [WARNING] Frame budget of %zu bytes exceeded\n", budget_);
+	}
+
+	void* p_memory = ::operator new(size, std::align_val_t(alignment));
+
+	frame.overflows.push_back({p_memory, alignment});
+	frame.overflow += size;
+	overflow_count_++;
+
+	return p_memory;
+}
+
+size_t FrameAllocator::GetHighWater() const
+{
+	return high_water_;
+}
+
+uint64_t FrameAllocator::GetOverflowCount() const
+{
+	return overflow_count_;
+}
@@ -0,0 +1,920 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "GltfAsset.h"
+#include "MeshCodec.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+constexpr uint32_t glb_magic      = 0x46546C67; // "glTF"
+constexpr uint32_t glb_version    = 2;
+constexpr uint32_t glb_chunk_json = 0x4E4F534A; // "JSON"
+constexpr uint32_t glb_chunk_bin  = 0x004E4942; // "BIN\0"
+
+constexpr uint32_t component_byte           = 5120;
+constexpr uint32_t component_unsigned_byte  = 5121;
+constexpr uint32_t component_short          = 5122;
+constexpr uint32_t component_unsigned_short = 5123;
+constexpr uint32_t component_unsigned_int   = 5125;
+constexpr uint32_t component_float          = 5126;
+
+constexpr uint32_t mode_triangles = 4;
+
+/// Nesting of the documents we accept, deeper ones are malformed for our purposes (and would exhaust the stack).
+constexpr uint32_t json_max_depth = 64;
+
+/// Extensions a file may require and still be read here, the others go through Assimp.
+constexpr std::string_view supported_extensions[] = {
+	"KHR_mesh_quantization",
+	"EXT_meshopt_compression",
+};
+
+/// DOM of the JSON chunk. Strings are views of the file, escapes are kept as they are (the keys and the
+/// values we compare are plain ASCII).
+struct JsonValue
+{
+	enum class Type : uint8_t
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object,
+	};
+
+	Type                          type     = Type::Null;
+	bool                          boolean  = false;
+	double                        number   = 0.0;
+	std::string_view              string   = {};
+	std::vector<std::string_view> keys     = {}; // Objects: key of every element.
+	std::vector<JsonValue>        elements = {};
+
+	/// @return the member of an object, nullptr if missing.
+	[[nodiscard]] const JsonValue* Find(std::string_view key) const
+	{
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			if (keys[i] == key)
+			{
+				return &elements[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// @return the element of an array, nullptr if out of range.
+	[[nodiscard]] const JsonValue* At(size_t index) const
+	{
+		return (type == Type::Array && index < elements.size()) ? &elements[index] : nullptr;
+	}
+
+	[[nodiscard]] uint32_t GetUint(
+		std::string_view key,
+		uint32_t         fallback) const
+	{
+		const JsonValue* value = Find(key);
+
+		if (!value)
+		{
+			return fallback;
+		}
+
+		if (value->type != Type::Number || value->number < 0.0 || value->number > UINT32_MAX)
+		{
+			throw std::runtime_error("Failed to load glTF: invalid integer");
+		}
+
+		return static_cast<uint32_t>(value->number);
+	}
+
+	[[nodiscard]] std::string_view GetString(std::string_view key) const
+	{
+		const JsonValue* value = Find(key);
+
+		return (value && value->type == Type::String) ? value->string : std::string_view();
+	}
+};
+
+class JsonParser
+{
+public:
+	explicit JsonParser(std::string_view text)
+		: text_(text)
+	{
+	}
+
+	JsonValue Parse()
+	{
+		JsonValue value = ParseValue(0);
+
+		SkipWhitespace();
+
+		if (position_ != text_.size())
+		{
+			Fail();
+		}
+
+		return value;
+	}
+
+private:
+	[[noreturn]] static void Fail()
+	{
+		throw std::runtime_error("Failed to load glTF: malformed JSON");
+	}
+
+	void SkipWhitespace()
+	{
+		while (position_ < text_.size() &&
+		       (text_[position_] == ' ' || text_[position_] == '\t' || text_[position_] == '\n' ||
+		        text_[position_] == '\r'))
+		{
+			position_++;
+		}
+	}
+
+	char Peek()
+	{
+		SkipWhitespace();
+
+		if (position_ >= text_.size())
+		{
+			Fail();
+		}
+
+		return text_[position_];
+	}
+
+	void Expect(char character)
+	{
+		if (Peek() != character)
+		{
+			Fail();
+		}
+
+		position_++;
+	}
+
+	void ExpectWord(std::string_view word)
+	{
+		if (text_.substr(position_, word.size()) != word)
+		{
+			Fail();
+		}
+
+		position_ += word.size();
+	}
+
+	std::string_view ParseString()
+	{
+		Expect('"');
+
+		const size_t begin = position_;
+
+		while (position_ < text_.size() && text_[position_] != '"')
+		{
+			// Skip the escaped character, so an escaped quote doesn't end the string.
+			position_ += (text_[position_] == '\\') ? 2 : 1;
+		}
+
+		if (position_ >= text_.size())
+		{
+			Fail();
+		}
+
+		return text_.substr(begin, position_++ - begin);
+	}
+
+	JsonValue ParseValue(uint32_t depth)
+	{
+		if (depth > json_max_depth)
+		{
+			Fail();
+		}
+
+		JsonValue value = {};
+
+		switch (Peek())
+		{
+		case '{':
+			value.type = JsonValue::Type::Object;
+			position_++;
+
+			if (Peek() == '}')
+			{
+				position_++;
+				break;
+			}
+
+			for (;;)
+			{
+				value.keys.push_back(ParseString());
+				Expect(':');
+				value.elements.push_back(ParseValue(depth + 1));
+
+				if (Peek() != ',')
+				{
+					break;
+				}
+
+				position_++;
+			}
+
+			Expect('}');
+			break;
+
+		case '[':
+			value.type = JsonValue::Type::Array;
+			position_++;
+
+			if (Peek() == ']')
+			{
+				position_++;
+				break;
+			}
+
+			for (;;)
+			{
+				value.elements.push_back(ParseValue(depth + 1));
+
+				if (Peek() != ',')
+				{
+					break;
+				}
+
+				position_++;
+			}
+
+			Expect(']');
+			break;
+
+		case '"':
+			value.type   = JsonValue::Type::String;
+			value.string = ParseString();
+			break;
+
+		case 't':
+			value.type    = JsonValue::Type::Bool;
+			value.boolean = true;
+			ExpectWord("true");
+			break;
+
+		case 'f':
+			value.type = JsonValue::Type::Bool;
+			ExpectWord("false");
+			break;
+
+		case 'n':
+			ExpectWord("null");
+			break;
+
+		default:
+		{
+			value.type = JsonValue::Type::Number;
+
+			const char* begin  = text_.data() + position_;
+			const auto  result = std::from_chars(begin, text_.data() + text_.size(), value.number);
+
+			if (result.ec != std::errc())
+			{
+				Fail();
+			}
+
+			position_ += result.ptr - begin;
+			break;
+		}
+		}
+
+		return value;
+	}
+
+	std::string_view text_     = {};
+	size_t           position_ = 0;
+};
+
+/// Bytes of a buffer view, and where EXT_meshopt_compression decodes it from.
+struct BufferView
+{
+	std::span<const std::byte> data   = {};
+	uint32_t                   stride = 0;
+
+	// Compressed views only.
+	std::span<const std::byte> source  = {};
+	std::string_view           mode    = {};
+	MeshCodec::Filter          filter  = MeshCodec::Filter::None;
+	uint32_t                   count   = 0;
+	size_t                     decoded = SIZE_MAX; // Index in the decoded buffers.
+};
+
+uint32_t GetComponentSize(uint32_t component_type)
+{
+	switch (component_type)
+	{
+	case component_byte:
+	case component_unsigned_byte:
+		return 1;
+	case component_short:
+	case component_unsigned_short:
+		return 2;
+	case component_unsigned_int:
+	case component_float:
+		return 4;
+	default:
+		throw std::runtime_error("Failed to load glTF: invalid component type");
+	}
+}
+
+uint32_t GetComponentCount(std::string_view type)
+{
+	if (type == "SCALAR")
+	{
+		return 1;
+	}
+
+	if (type == "VEC2")
+	{
+		return 2;
+	}
+
+	if (type == "VEC3")
+	{
+		return 3;
+	}
+
+	if (type == "VEC4" || type == "MAT2")
+	{
+		return 4;
+	}
+
+	throw std::runtime_error("Failed to load glTF: unsupported accessor type");
+}
+
+/// Component of an element as a float, normalized integers mapped to [0, 1] or [-1, 1].
+float ReadComponent(
+	const std::byte* data,
+	uint32_t         component_type,
+	bool             normalized)
+{
+	switch (component_type)
+	{
+	case component_byte:
+	{
+		int8_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return normalized ? std::max(value / 127.0f, -1.0f) : static_cast<float>(value);
+	}
+	case component_unsigned_byte:
+	{
+		uint8_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return normalized ? value / 255.0f : static_cast<float>(value);
+	}
+	case component_short:
+	{
+		int16_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+	}
+	case component_unsigned_short:
+	{
+		uint16_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return normalized ? value / 65535.0f : static_cast<float>(value);
+	}
+	default:
+	{
+		float value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	}
+}
+
+void DecodeBufferView(
+	const BufferView&       view,
+	std::vector<std::byte>* p_decoded)
+{
+	if (view.mode == "ATTRIBUTES")
+	{
+		MeshCodec::DecodeVertexBuffer(*p_decoded, view.count, view.stride, view.source);
+		MeshCodec::DecodeFilter(view.filter, *p_decoded, view.count, view.stride);
+	}
+	else if (view.mode == "TRIANGLES")
+	{
+		MeshCodec::DecodeIndexBuffer(*p_decoded, view.count, view.stride, view.source);
+	}
+	else
+	{
+		MeshCodec::DecodeIndexSequence(*p_decoded, view.count, view.stride, view.source);
+	}
+}
+}
+
+bool GltfAsset::Load(
+	std::span<const std::byte> data,
+	ThreadPool*                thread_pool)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	*this = {};
+
+	// Container: 12 bytes header, then the JSON chunk and the optional BIN chunk.
+	uint32_t header[3] = {};
+
+	if (data.size() < sizeof(header) + 8)
+	{
+		throw std::runtime_error("Failed to load glTF: truncated file");
+	}
+
+	std::memcpy(header, data.data(), sizeof(header));
+
+	if (header[0] != glb_magic || header[1] != glb_version || header[2] > data.size())
+	{
+		throw std::runtime_error("Failed to load glTF: not a binary glTF 2.0 file");
+	}
+
+	std::span<const std::byte> json_chunk = {};
+	std::span<const std::byte> bin_chunk  = {};
+
+	for (size_t offset = sizeof(header); offset + 8 <= header[2];)
+	{
+		uint32_t chunk[2] = {};
+		std::memcpy(chunk, data.data() + offset, sizeof(chunk));
+
+		if (chunk[0] > header[2] - offset - 8)
+		{
+			throw std::runtime_error("Failed to load glTF: truncated chunk");
+		}
+
+		const std::span<const std::byte> content = data.subspan(offset + 8, chunk[0]);
+
+		if (chunk[1] == glb_chunk_json && json_chunk.empty())
+		{
+			json_chunk = content;
+		}
+		else if (chunk[1] == glb_chunk_bin && bin_chunk.empty())
+		{
+			bin_chunk = content;
+		}
+
+		offset += 8 + ((chunk[0] + 3) & ~3u);
+	}
+
+	const JsonValue document = JsonParser(
+		std::string_view(reinterpret_cast<const char*>(json_chunk.data()), json_chunk.size())).Parse();
+
+	if (const JsonValue* required = document.Find("extensionsRequired"))
+	{
+		for (const JsonValue& extension : required->elements)
+		{
+			if (std::ranges::find(supported_extensions, extension.string) == std::end(supported_extensions))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Skinned and animated files keep going through Assimp, which builds the skeleton and the clips.
+	if (document.Find("skins") || document.Find("animations"))
+	{
+		return false;
+	}
+
+	// Buffers: the BIN chunk, or the fallback of compressed views (no data, never read).
+	std::vector<std::span<const std::byte>> buffers = {};
+
+	if (const JsonValue* buffer_values = document.Find("buffers"))
+	{
+		for (size_t i = 0; i < buffer_values->elements.size(); i++)
+		{
+			const JsonValue& buffer = buffer_values->elements[i];
+
+			if (buffer.Find("uri"))
+			{
+				return false;
+			}
+
+			const JsonValue* extensions = buffer.Find("extensions");
+			const JsonValue* meshopt    = extensions ? extensions->Find("EXT_meshopt_compression") : nullptr;
+			const JsonValue* fallback   = meshopt ? meshopt->Find("fallback") : nullptr;
+
+			if (fallback && fallback->boolean)
+			{
+				buffers.emplace_back();
+				continue;
+			}
+
+			if (i != 0 || buffer.GetUint("byteLength", 0) > bin_chunk.size())
+			{
+				throw std::runtime_error("Failed to load glTF: invalid buffer");
+			}
+
+			buffers.push_back(bin_chunk.first(buffer.GetUint("byteLength", 0)));
+		}
+	}
+
+	const auto get_buffer_range = [&buffers](const JsonValue& view) -> std::span<const std::byte>
+	{
+		const uint32_t buffer = view.GetUint("buffer", UINT32_MAX);
+		const uint32_t offset = view.GetUint("byteOffset", 0);
+		const uint32_t length = view.GetUint("byteLength", 0);
+
+		if (buffer >= buffers.size() || static_cast<size_t>(offset) + length > buffers[buffer].size())
+		{
+			throw std::runtime_error("Failed to load glTF: buffer view out of range");
+		}
+
+		return buffers[buffer].subspan(offset, length);
+	};
+
+	// Buffer views, the compressed ones are decoded next into buffers of their own.
+	std::vector<BufferView> views = {};
+
+	if (const JsonValue* view_values = document.Find("bufferViews"))
+	{
+		for (const JsonValue& view_value : view_values->elements)
+		{
+			BufferView view = {.stride = view_value.GetUint("byteStride", 0)};
+
+			const JsonValue* extensions = view_value.Find("extensions");
+			const JsonValue* meshopt    = extensions ? extensions->Find("EXT_meshopt_compression") : nullptr;
+
+			if (!meshopt)
+			{
+				view.data = get_buffer_range(view_value);
+				views.push_back(view);
+				continue;
+			}
+
+			const std::string_view filter = meshopt->GetString("filter");
+
+			view.source  = get_buffer_range(*meshopt);
+			view.mode    = meshopt->GetString("mode");
+			view.stride  = meshopt->GetUint("byteStride", 0);
+			view.count   = meshopt->GetUint("count", 0);
+			view.filter  = (filter == "OCTAHEDRAL") ? MeshCodec::Filter::Octahedral
+			             : (filter == "QUATERNION") ? MeshCodec::Filter::Quaternion
+			             : (filter == "EXPONENTIAL") ? MeshCodec::Filter::Exponential
+			             : MeshCodec::Filter::None;
+			view.decoded = decoded_.size();
+
+			if (view.mode != "ATTRIBUTES" && view.mode != "TRIANGLES" && view.mode != "INDICES")
+			{
+				throw std::runtime_error("Failed to load glTF: unknown meshopt mode");
+			}
+
+			decoded_.emplace_back(static_cast<size_t>(view.count) * view.stride);
+			views.push_back(view);
+		}
+	}
+
+	// Every compressed view decodes independently: one task each, the first one on this thread.
+	{
+		ADRO_PROFILE_SCOPE("GltfAsset::Decode");
+
+		std::vector<const BufferView*> compressed = {};
+
+		for (const BufferView& view : views)
+		{
+			if (view.decoded != SIZE_MAX)
+			{
+				compressed.push_back(&view);
+			}
+		}
+
+		ThreadPool::ParallelFor(
+			thread_pool,
+			compressed.size(),
+			[&](size_t i)
+			{
+				DecodeBufferView(*compressed[i], &decoded_[compressed[i]->decoded]);
+			});
+
+		for (BufferView& view : views)
+		{
+			if (view.decoded != SIZE_MAX)
+			{
+				view.data = decoded_[view.decoded];
+			}
+		}
+	}
+
+	const JsonValue* accessor_values = document.Find("accessors");
+
+	const auto get_accessor = [&views, accessor_values](uint32_t index, Accessor* p_accessor, const JsonValue** p_value)
+	{
+		const JsonValue* value = accessor_values ? accessor_values->At(index) : nullptr;
+
+		// Sparse and zero-filled (no view) accessors are rare in meshes, Assimp handles them.
+		if (!value || value->Find("sparse") || !value->Find("bufferView"))
+		{
+			return false;
+		}
+
+		const uint32_t view_index = value->GetUint("bufferView", 0);
+
+		if (view_index >= views.size())
+		{
+			throw std::runtime_error("Failed to load glTF: invalid buffer view");
+		}
+
+		const BufferView& view         = views[view_index];
+		const uint32_t    offset       = value->GetUint("byteOffset", 0);
+		const uint32_t    type         = value->GetUint("componentType", 0);
+		const uint32_t    count        = value->GetUint("count", 0);
+		const uint32_t    components   = GetComponentCount(value->GetString("type"));
+		const uint32_t    element_size = GetComponentSize(type) * components;
+		const uint32_t    stride       = view.stride ? view.stride : element_size;
+
+		if (count > 0 && static_cast<size_t>(offset) + static_cast<size_t>(stride) * (count - 1) + element_size >
+		                 view.data.size())
+		{
+			throw std::runtime_error("Failed to load glTF: accessor out of range");
+		}
+
+		const JsonValue* normalized = value->Find("normalized");
+
+		*p_accessor = {
+			.data = view.data.data() + offset,
+			.count = count,
+			.stride = stride,
+			.component_type = type,
+			.component_count = components,
+			.normalized = normalized && normalized->boolean,
+		};
+		*p_value = value;
+
+		return true;
+	};
+
+	const JsonValue* mesh_values = document.Find("meshes");
+
+	if (!mesh_values)
+	{
+		return false;
+	}
+
+	for (const JsonValue& mesh : mesh_values->elements)
+	{
+		const JsonValue* primitive_values = mesh.Find("primitives");
+
+		if (!primitive_values)
+		{
+			continue;
+		}
+
+		for (const JsonValue& primitive_value : primitive_values->elements)
+		{
+			const JsonValue* attributes = primitive_value.Find("attributes");
+
+			// No Draco decoder here: optional Draco data is read from its uncompressed accessors, required Draco
+			// was rejected with the other extensions.
+			if (primitive_value.GetUint("mode", mode_triangles) != mode_triangles ||
+			    !attributes || !attributes->Find("POSITION") || !attributes->Find("NORMAL"))
+			{
+				return false;
+			}
+
+			Primitive        primitive      = {};
+			const JsonValue* position_value = nullptr;
+			const JsonValue* normal_value   = nullptr;
+			const JsonValue* indices_value  = nullptr;
+
+			if (!get_accessor(attributes->GetUint("POSITION", 0), &primitive.position, &position_value) ||
+			    !get_accessor(attributes->GetUint("NORMAL", 0), &primitive.normal, &normal_value) ||
+			    (primitive_value.Find("indices") &&
+			     !get_accessor(primitive_value.GetUint("indices", 0), &primitive.indices, &indices_value)))
+			{
+				return false;
+			}
+
+			if (primitive.position.component_count != 3 || primitive.normal.component_count != 3 ||
+			    primitive.position.component_type == component_unsigned_int ||
+			    primitive.normal.component_type == component_unsigned_int ||
+			    primitive.normal.count != primitive.position.count ||
+			    (indices_value && (primitive.indices.component_count != 1 ||
+			                       primitive.indices.component_type == component_byte ||
+			                       primitive.indices.component_type == component_short ||
+			                       primitive.indices.component_type == component_float)))
+			{
+				throw std::runtime_error("Failed to load glTF: invalid primitive attributes");
+			}
+
+			const uint32_t index_count = indices_value ? primitive.indices.count : primitive.position.count;
+
+			if (index_count % 3 != 0)
+			{
+				throw std::runtime_error("Failed to load glTF: incomplete triangle");
+			}
+
+			// Float bounds are exact in the document, quantized ones are measured.
+			const JsonValue* min = position_value->Find("min");
+			const JsonValue* max = position_value->Find("max");
+
+			if (primitive.position.component_type == component_float && min && max &&
+			    min->elements.size() == 3 && max->elements.size() == 3)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					primitive.min[c] = static_cast<float>(min->elements[c].number);
+					primitive.max[c] = static_cast<float>(max->elements[c].number);
+				}
+			}
+			else if (primitive.position.count > 0)
+			{
+				std::vector<glm::vec3> positions(primitive.position.count);
+				WriteVectors(primitive.position, positions.data(), glm::mat3(1.0f));
+
+				primitive.min = positions[0];
+				primitive.max = positions[0];
+
+				for (const glm::vec3& position : positions)
+				{
+					primitive.min = glm::min(primitive.min, position);
+					primitive.max = glm::max(primitive.max, position);
+				}
+			}
+
+			submeshes_.push_back({
+				.first_index = index_count_,
+				.index_count = index_count,
+				.vertex_offset = static_cast<int32_t>(vertex_count_),
+				.material = primitive_value.GetUint("material", 0),
+			});
+
+			primitives_.push_back(primitive);
+
+			vertex_count_ += primitive.position.count;
+			index_count_  += index_count;
+		}
+	}
+
+	return !primitives_.empty();
+}
+
+uint32_t GltfAsset::GetVertexCount() const
+{
+	return vertex_count_;
+}
+
+uint32_t GltfAsset::GetIndexCount() const
+{
+	return index_count_;
+}
+
+const std::vector<Graphics::Submesh>& GltfAsset::GetSubmeshes() const
+{
+	return submeshes_;
+}
+
+glm::vec3 GltfAsset::GetSubmeshCenter(size_t submesh) const
+{
+	return (primitives_[submesh].min + primitives_[submesh].max) * 0.5f;
+}
+
+Graphics::Aabb GltfAsset::GetSubmeshBounds(size_t submesh) const
+{
+	return {
+		.min = primitives_[submesh].min,
+		.max = primitives_[submesh].max,
+	};
+}
+
+void GltfAsset::WritePositions(
+	std::span<glm::vec3> positions,
+	const glm::mat3&     rotation) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < primitives_.size(); i++)
+	{
+		WriteVectors(primitives_[i].position, &positions[submeshes_[i].vertex_offset], rotation);
+	}
+}
+
+void GltfAsset::WriteNormals(
+	std::span<glm::vec3> normals,
+	const glm::mat3&     rotation) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < primitives_.size(); i++)
+	{
+		WriteVectors(primitives_[i].normal, &normals[submeshes_[i].vertex_offset], rotation);
+
+		// Quantized normals lose their length.
+		if (primitives_[i].normal.component_type != component_float)
+		{
+			for (uint32_t v = 0; v < primitives_[i].normal.count; v++)
+			{
+				glm::vec3& normal = normals[submeshes_[i].vertex_offset + v];
+				normal = glm::normalize(normal);
+			}
+		}
+	}
+}
+
+void GltfAsset::WriteIndices(std::span<uint32_t> indices) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < primitives_.size(); i++)
+	{
+		const Accessor& accessor = primitives_[i].indices;
+		uint32_t*       output   = &indices[submeshes_[i].first_index];
+
+		if (!accessor.data)
+		{
+			std::iota(output, output + submeshes_[i].index_count, 0u);
+			continue;
+		}
+
+		// Validated on the source: the output can be uncached mapped memory, slow to read back.
+		const uint32_t component_size = GetComponentSize(accessor.component_type);
+		uint32_t       max_index      = 0;
+
+		for (uint32_t j = 0; j < accessor.count; j++)
+		{
+			uint32_t index = 0;
+			std::memcpy(&index, accessor.data + static_cast<size_t>(j) * accessor.stride, component_size);
+
+			max_index = std::max(max_index, index);
+		}
+
+		if (accessor.count > 0 && max_index >= primitives_[i].position.count)
+		{
+			throw std::runtime_error("Failed to load glTF: index out of range");
+		}
+
+		if (accessor.component_type == component_unsigned_int && accessor.stride == sizeof(uint32_t))
+		{
+			std::memcpy(output, accessor.data, static_cast<size_t>(accessor.count) * sizeof(uint32_t));
+			continue;
+		}
+
+		for (uint32_t j = 0; j < accessor.count; j++)
+		{
+			uint32_t index = 0;
+			std::memcpy(&index, accessor.data + static_cast<size_t>(j) * accessor.stride, component_size);
+
+			output[j] = index;
+		}
+	}
+}
+
+void GltfAsset::WriteVectors(
+	const Accessor&  accessor,
+	glm::vec3*       p_vectors,
+	const glm::mat3& rotation)
+{
+	const bool identity = rotation == glm::mat3(1.0f);
+
+	// Already the layout of the batch.
+	if (identity && accessor.component_type == component_float && accessor.stride == sizeof(glm::vec3))
+	{
+		std::memcpy(p_vectors, accessor.data, static_cast<size_t>(accessor.count) * sizeof(glm::vec3));
+		return;
+	}
+
+	if (accessor.component_type == component_float)
+	{
+		for (uint32_t i = 0; i < accessor.count; i++)
+		{
+			glm::vec3 vector;
+			std::memcpy(&vector, accessor.data + static_cast<size_t>(i) * accessor.stride, sizeof(vector));
+
+			p_vectors[i] = rotation * vector;
+		}
+
+		return;
+	}
+
+	const uint32_t component_size = GetComponentSize(accessor.component_type);
+
+	for (uint32_t i = 0; i < accessor.count; i++)
+	{
+		const std::byte* element = accessor.data + static_cast<size_t>(i) * accessor.stride;
+
+		const glm::vec3 vector = {
+			ReadComponent(element, accessor.component_type, accessor.normalized),
+			ReadComponent(element + component_size, accessor.component_type, accessor.normalized),
+			ReadComponent(element + component_size * 2, accessor.component_type, accessor.normalized),
+		};
+
+		p_vectors[i] = identity
+			? vector
+			: rotation * vector;
+	}
+}
@@ -0,0 +1,373 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "GpuProfiler.h"
+#include "vk_utils.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+constexpr VkTimeDomainEXT cpu_time_domain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+constexpr VkTimeDomainEXT cpu_time_domain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+void GpuProfiler::Init(
+	VkDevice               device,
+	VkPhysicalDevice       gpu,
+	VkAllocationCallbacks* p_allocator,
+	uint32_t               queue_family_idx,
+	uint32_t               frame_count,
+	uint32_t               max_scope_count,
+	bool                   calibrated)
+{
+	device_          = device;
+	allocator_       = p_allocator;
+	max_query_count_ = max_scope_count * 2;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+	timestamp_period_ = static_cast<double>(properties.limits.timestampPeriod);
+
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, queue_families.data());
+
+	const uint32_t valid_bits = queue_families[queue_family_idx].timestampValidBits;
+
+	// The queue doesn't support timestamps, every call becomes a no-op.
+	enabled_ = valid_bits > 0;
+	if (!enabled_)
+	{
+		std::printf("[VK] [WARNING] Timestamps not supported, GPU profiler disabled\n");
+		return;
+	}
+
+	timestamp_mask_ = (valid_bits >= 64)
+		? UINT64_MAX
+		: ((uint64_t{1} << valid_bits) - 1);
+
+	// The extension must also expose both the device and the CPU time domain.
+	calibrated_ = false;
+	if (calibrated)
+	{
+		uint32_t domain_count = 0;
+		VK_CHECK(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(gpu, &domain_count, nullptr));
+
+		std::vector<VkTimeDomainEXT> domains(domain_count);
+		VK_CHECK(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(gpu, &domain_count, domains.data()));
+
+		const bool has_device = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+		const bool has_cpu    = std::find(domains.begin(), domains.end(), cpu_time_domain) != domains.end();
+		calibrated_           = has_device && has_cpu;
+	}
+
+	frames_.resize(frame_count);
+
+	for (Frame& frame : frames_)
+	{
+		const VkQueryPoolCreateInfo query_pool_create_info = {
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = max_query_count_,
+			.pipelineStatistics = 0,
+		};
+
+		VK_CHECK(vkCreateQueryPool(
+			device_,
+			&query_pool_create_info,
+			allocator_,
+			&frame.query_pool));
+
+		frame.scopes.reserve(max_scope_count);
+	}
+
+	readback_.resize(2 * static_cast<size_t>(max_query_count_));
+	last_frame_.reserve(max_scope_count);
+	history_.reserve(history_capacity_);
+}
+
+void GpuProfiler::Destroy()
+{
+	for (Frame& frame : frames_)
+	{
+		vkDestroyQueryPool(device_, frame.query_pool, allocator_);
+	}
+
+	frames_.clear();
+}
+
+void GpuProfiler::BeginFrame(
+	VkCommandBuffer command_buffer,
+	uint32_t        frame_idx)
+{
+	if (!enabled_)
+	{
+		return;
+	}
+
+	current_frame_ = frame_idx % static_cast<uint32_t>(frames_.size());
+	Frame& frame   = frames_[current_frame_];
+
+	Resolve(frame);
+
+	frame.scopes.clear();
+	frame.open_scopes.clear();
+	frame.query_count = 0;
+
+	vkCmdResetQueryPool(
+		command_buffer,
+		frame.query_pool,
+		0,
+		max_query_count_);
+
+	Calibrate(frame);
+}
+
+void GpuProfiler::BeginScope(
+	VkCommandBuffer         command_buffer,
+	const char*             name,
+	VkPipelineStageFlagBits stage)
+{
+	if (!enabled_)
+	{
+		return;
+	}
+
+	Frame& frame = frames_[current_frame_];
+
+	// Out of queries: drop the scope rather than overflowing the pool.
+	if (frame.query_count + 2 > max_query_count_)
+	{
+		frame.open_scopes.push_back(UINT32_MAX);
+		return;
+	}
+
+	frame.open_scopes.push_back(static_cast<uint32_t>(frame.scopes.size()));
+	frame.scopes.push_back({
+		.name = name,
+		.depth = static_cast<uint32_t>(frame.open_scopes.size() - 1),
+		.begin_query = frame.query_count++,
+		.end_query = UINT32_MAX,
+	});
+
+	vkCmdWriteTimestamp(
+		command_buffer,
+		stage,
+		frame.query_pool,
+		frame.scopes.back().begin_query);
+}
+
+void GpuProfiler::EndScope(
+	VkCommandBuffer         command_buffer,
+	VkPipelineStageFlagBits stage)
+{
+	if (!enabled_)
+	{
+		return;
+	}
+
+	Frame& frame = frames_[current_frame_];
+	assert(!frame.open_scopes.empty() && "EndScope without BeginScope");
+
+	const uint32_t scope_idx = frame.open_scopes.back();
+	frame.open_scopes.pop_back();
+
+	if (scope_idx == UINT32_MAX)
+	{
+		return;
+	}
+
+	ScopeRecord& scope = frame.scopes[scope_idx];
+	scope.end_query    = frame.query_count++;
+
+	vkCmdWriteTimestamp(
+		command_buffer,
+		stage,
+		frame.query_pool,
+		scope.end_query);
+}
+
+const std::vector<GpuProfiler::Scope>& GpuProfiler::GetLastFrame() const
+{
+	return last_frame_;
+}
+
+double GpuProfiler::GetScopeMs(const char* name) const
+{
+	for (const Scope& scope : last_frame_)
+	{
+		if (std::strcmp(scope.name, name) == 0)
+		{
+			return static_cast<double>(scope.end_ns - scope.begin_ns) / 1000000.0;
+		}
+	}
+
+	return 0.0;
+}
+
+void GpuProfiler::ExportChromeTrace(const char* path) const
+{
+	FILE* file = std::fopen(path, "w");
+
+	if (!file)
+	{
+		std::printf("[GPU PROFILER] Failed to open %s\n", path);
+		return;
+	}
+
+	std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	std::fprintf(file,
+	             "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":\"GPU\",\"args\":{\"name\":\"GPU%s\"}}",
+	             calibrated_ ? "" : " (uncalibrated)");
+
+	// The history is a ring buffer: start from the oldest entry.
+	const size_t count = history_.size();
+	const size_t first = (count < history_capacity_) ? 0 : history_next_;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const Scope& scope = history_[(first + i) % count];
+
+		std::fprintf(file,
+		             ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":\"GPU\",\"ts\":%.3f,\"dur\":%.3f}",
+		             scope.name,
+		             static_cast<double>(scope.begin_ns) / 1000.0,
+		             static_cast<double>(scope.end_ns - scope.begin_ns) / 1000.0);
+	}
+
+	std::fprintf(file, "\n]}\n");
+	std::fclose(file);
+}
+
+void GpuProfiler::Resolve(Frame& frame)
+{
+	if (frame.query_count == 0)
+	{
+		return;
+	}
+
+	uint64_t* results = readback_.data();
+
+	// No VK_QUERY_RESULT_WAIT_BIT: unavailable results are skipped instead of stalling.
+	const VkResult result = vkGetQueryPoolResults(
+		device_,
+		frame.query_pool,
+		0,
+		frame.query_count,
+		readback_.size() * sizeof(uint64_t),
+		results,
+		2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		VK_CHECK(result);
+	}
+
+	last_frame_.clear();
+
+	for (const ScopeRecord& record : frame.scopes)
+	{
+		if (record.end_query == UINT32_MAX ||
+		    results[2 * record.begin_query + 1] == 0 ||
+		    results[2 * record.end_query + 1] == 0)
+		{
+			continue;
+		}
+
+		const uint64_t begin_ticks = results[2 * record.begin_query] & timestamp_mask_;
+		const uint64_t end_ticks   = results[2 * record.end_query] & timestamp_mask_;
+
+		if (!calibrated_ && uncalibrated_base_ == 0)
+		{
+			uncalibrated_base_ = begin_ticks;
+		}
+
+		const uint64_t gpu_base = calibrated_
+			? frame.calibration_gpu_ticks
+			: uncalibrated_base_;
+		const uint64_t cpu_base = calibrated_
+			? frame.calibration_cpu_ns
+			: 0;
+
+		// Timestamps can precede the calibration point, keep the arithmetic signed.
+		const auto to_cpu_ns = [&](uint64_t ticks) -> uint64_t
+		{
+			const double delta_ns = static_cast<double>(static_cast<int64_t>(ticks - gpu_base)) * timestamp_period_;
+			return static_cast<uint64_t>(static_cast<double>(cpu_base) + delta_ns);
+		};
+
+		const Scope scope = {
+			.name = record.name,
+			.depth = record.depth,
+			.begin_ns = to_cpu_ns(begin_ticks),
+			.end_ns = to_cpu_ns(std::max(begin_ticks, end_ticks)),
+		};
+
+		last_frame_.push_back(scope);
+
+		if (history_.size() < history_capacity_)
+		{
+			history_.push_back(scope);
+		}
+		else
+		{
+			history_[history_next_] = scope;
+		}
+
+		history_next_ = (history_next_ + 1) % history_capacity_;
+	}
+}
+
+void GpuProfiler::Calibrate(Frame& frame) const
+{
+	if (!calibrated_)
+	{
+		return;
+	}
+
+	const VkCalibratedTimestampInfoEXT infos[2] = {
+		{
+			.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+			.pNext = nullptr,
+			.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+		},
+		{
+			.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+			.pNext = nullptr,
+			.timeDomain = cpu_time_domain,
+		},
+	};
+
+	uint64_t timestamps[2] = {};
+	uint64_t max_deviation = 0;
+
+	VK_CHECK(vkGetCalibratedTimestampsEXT(
+		device_,
+		2,
+		&infos[0],
+		&timestamps[0],
+		&max_deviation));
+
+	frame.calibration_gpu_ticks = timestamps[0] & timestamp_mask_;
+
+#ifdef _WIN32
+	// QueryPerformanceCounter ticks, the same source std::chrono::steady_clock uses on Windows.
+	LARGE_INTEGER frequency = {};
+	QueryPerformanceFrequency(&frequency);
+	frame.calibration_cpu_ns = static_cast<uint64_t>(
+		static_cast<double>(timestamps[1]) * 1000000000.0 / static_cast<double>(frequency.QuadPart));
+#else
+	// CLOCK_MONOTONIC is already in nanoseconds and matches std::chrono::steady_clock.
+	frame.calibration_cpu_ns = timestamps[1];
+#endif
+}
@@ -8,8 +8,105 @@
 #include <cassert>
 #include <stdexcept>
 #include <cstring>
+#include <algorithm>
+#include <bit>
 
+uint64_t Graphics::MakeSortKey(
+	uint8_t  pipeline,
+	uint32_t material,
+	float    view_depth)
+{
+	// The bit pattern of a positive IEEE-754 float grows with its value, so it can be compared as an integer.
+	const uint32_t depth_bits = std::bit_cast<uint32_t>(std::max(view_depth, 0.0f));
 
+	return (static_cast<uint64_t>(pipeline) << 56) |
+	       (static_cast<uint64_t>(material & 0xFFFFFFu) << 32) |
+	       static_cast<uint64_t>(depth_bits);
+}
 
+glm::mat4 Graphics::ReverseInfinitePerspective(
+	float fov_y,
+	float aspect_ratio,
+	float z_near)
+{
+	const float focal_length = 1.0f / glm::tan(fov_y * 0.5f);
 
+	// clip.z = z_near and clip.w = -view.z: no z term left to lose precision to.
+	glm::mat4 projection = glm::mat4(0.0f);
+	projection[0][0]     = focal_length / aspect_ratio;
+	projection[1][1]     = focal_length;
+	projection[2][3]     = -1.0f;
+	projection[3][2]     = z_near;
 
+	return projection;
+}
+
+Graphics::Frustum Graphics::ExtractFrustum(const glm::mat4& view_projection)
+{
+	// Rows of the matrix (glm is column-major): clip = row_i . point, inside when -w <= x, y <= w and 0 <= z <= w.
+	glm::vec4 rows[4] = {};
+
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			view_projection[0][row],
+			view_projection[1][row],
+			view_projection[2][row],
+			view_projection[3][row]);
+	}
+
+	return {
+		.planes = {
+			rows[3] + rows[0],
+			rows[3] - rows[0],
+			rows[3] + rows[1],
+			rows[3] - rows[1],
+			rows[2],
+			rows[3] - rows[2],
+		},
+	};
+}
+
+Graphics::Aabb Graphics::TransformAabb(
+	const Aabb&      bounds,
+	const glm::mat3& transform)
+{
+	const glm::vec3 center = transform * ((bounds.min + bounds.max) * 0.5f);
+	const glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+
+	// Every axis of the result gathers the absolute contribution of the 3 source axes.
+	glm::vec3 rotated_extent = {};
+
+	for (int column = 0; column < 3; column++)
+	{
+		rotated_extent += glm::abs(transform[column]) * extent[column];
+	}
+
+	return {
+		.min = center - rotated_extent,
+		.max = center + rotated_extent,
+	};
+}
+
+void Graphics::SortDrawCalls(
+	uint8_t             pipeline,
+	const glm::vec3&    camera_pos,
+	const glm::vec3&    camera_front,
+	std::span<DrawCall> draw_calls)
+{
+	for (DrawCall& draw_call : draw_calls)
+	{
+		draw_call.sort_key = MakeSortKey(
+			pipeline,
+			draw_call.material,
+			glm::dot(draw_call.center - camera_pos, camera_front));
+	}
+
+	std::sort(
+		draw_calls.begin(),
+		draw_calls.end(),
+		[](const DrawCall& lhs, const DrawCall& rhs)
+		{
+			return lhs.sort_key < rhs.sort_key;
+		});
+}
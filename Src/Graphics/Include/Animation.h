@@ -0,0 +1,116 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+/// Rows of a pose, each one holds a component of every joint:
+/// translation x y z, rotation (quaternion) x y z w, scale x y z.
+constexpr uint32_t pose_component_count = 10;
+
+/// Joint hierarchy, parents are always stored before their children.
+struct Skeleton
+{
+	std::vector<std::string> joint_names = {};
+
+	/// -1 for the roots.
+	std::vector<int32_t> parents = {};
+
+	/// Mesh space to joint space, in the bind pose.
+	std::vector<glm::mat4> inverse_bind_matrices = {};
+
+	/// Parent of the roots (the import orientation).
+	glm::mat4 root_transform = glm::mat4(1.0f);
+
+	[[nodiscard]] uint32_t GetJointCount() const
+	{
+		return static_cast<uint32_t>(parents.size());
+	}
+};
+
+/// Joint count rounded up to the SIMD width, the row length of poses and clips.
+constexpr uint32_t GetJointStride(uint32_t joint_count)
+{
+	return (joint_count + 3) & ~3u;
+}
+
+/// Local transforms of every joint, pose_component_count rows of GetJointStride floats.
+struct Pose
+{
+	std::vector<float> data = {};
+};
+
+/// Local joint transforms resampled at a fixed rate, one pose per frame:
+/// samples[(frame * pose_component_count + component) * stride + joint].
+struct AnimationClip
+{
+	std::string name = {};
+
+	float    duration    = 0.0f;
+	float    sample_rate = 30.0f;
+	uint32_t joint_count = 0;
+	uint32_t frame_count = 0;
+
+	std::vector<float> samples = {};
+};
+
+/// Clip playback of one character, optionally cross-faded with a second clip.
+struct AnimationInstance
+{
+	uint32_t clip = 0;
+	float    time = 0.0f;
+
+	/// Ignored when blend_weight is 0.
+	uint32_t blend_clip   = 0;
+	float    blend_time   = 0.0f;
+	float    blend_weight = 0.0f;
+};
+
+/// Sampling, blending and joint palettes. Translations and scales are interpolated linearly, rotations with a
+/// normalized lerp (shortest path), 4 joints at a time with SSE when available.
+class Animation
+{
+	Animation() = delete;
+
+public:
+	/// Pose of the clip at the given time, looping.
+	static void SampleClip(
+		const AnimationClip& clip,
+		float                time,
+		Pose*                p_pose);
+
+	/// @param weight		0 gives a, 1 gives b.
+	static void BlendPoses(
+		const Pose& a,
+		const Pose& b,
+		float       weight,
+		Pose*       p_pose);
+
+	/// Skinning matrices of the pose: root transform * joint model transform * inverse bind matrix.
+	/// @param palette		one matrix per joint.
+	static void ComputePalette(
+		const Skeleton&      skeleton,
+		const Pose&          pose,
+		std::span<glm::mat4> palette);
+
+	/// Sample, blend and compute the palettes of every instance, split across the pool's workers.
+	/// @param thread_pool		nullptr runs everything on the calling thread.
+	/// @param palettes			joint count matrices per instance, in order.
+	static void Update(
+		ThreadPool*                        thread_pool,
+		const Skeleton&                    skeleton,
+		std::span<const AnimationClip>     clips,
+		std::span<const AnimationInstance> instances,
+		std::span<glm::mat4>               palettes);
+};
+
+#endif //ANIMATION_H
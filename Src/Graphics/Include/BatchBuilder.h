@@ -0,0 +1,90 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef BATCH_BUILDER_H
+#define BATCH_BUILDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "VkApp.h"
+
+/// Shared vertex and index arenas for many meshes, so the whole scene is drawn from one set of buffers.
+///
+/// Every appended batch gets a vertex range and an index range. Its indices are copied as they are and its
+/// submeshes are moved to the ranges (first_index, vertex_offset). Removed ranges go to sorted free lists,
+/// coalesced with their neighbours, and are reused first-fit by the next appends; a free range at the end of an
+/// arena shrinks it instead.
+///
+/// Usage:
+///		BatchBuilder::Handle bunny = builder.Append(bunny_batch);
+///		BatchBuilder::Handle lucy  = builder.Append(lucy_batch);
+///		builder.Remove(bunny);
+///		app.UploadBatch(builder.GetBatch());
+class BatchBuilder
+{
+public:
+	using Handle = uint32_t;
+
+	/// Copy the streams of the batch into the arenas. Missing colors default to grey, skinning data is dropped.
+	/// @return the handle to remove the batch with.
+	Handle Append(const Batch& batch);
+
+	/// Free the ranges of the batch, its submeshes are no longer part of GetBatch.
+	/// Freed ranges keep their stale content until they are reused.
+	void Remove(Handle handle);
+
+	/// Remove every batch and release the arenas.
+	void Clear();
+
+	/// Streams of the arenas and the submeshes of every live batch, in handle order.
+	[[nodiscard]] const Batch& GetBatch() const;
+
+	/// Vertices and indices in use (excluding the free ranges).
+	[[nodiscard]] uint32_t GetVertexCount() const;
+
+	[[nodiscard]] uint32_t GetIndexCount() const;
+
+private:
+	struct Range
+	{
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	struct Entry
+	{
+		Range                          vertices  = {};
+		Range                          indices   = {};
+		std::vector<Graphics::Submesh> submeshes = {};
+		bool                           alive     = false;
+	};
+
+	/// First free range large enough, the end of the arena otherwise.
+	/// @return the first element of the range, the arena must be grown when it ends past arena_size.
+	static uint32_t Allocate(
+		std::vector<Range>* p_free_ranges,
+		uint32_t            arena_size,
+		uint32_t            count);
+
+	/// Insert the range in the free list, merged with its neighbours.
+	/// @return the new arena size, smaller when the range ends the arena.
+	static uint32_t Release(
+		std::vector<Range>* p_free_ranges,
+		uint32_t            arena_size,
+		Range               range);
+
+	/// Concatenate the submeshes of the live entries.
+	void RebuildSubmeshes();
+
+	Batch               batch_              = {};
+	std::vector<Entry>  entries_            = {};
+	std::vector<Handle> free_handles_       = {};
+	std::vector<Range>  free_vertex_ranges_ = {};
+	std::vector<Range>  free_index_ranges_  = {};
+	uint32_t            used_vertex_count_  = 0;
+	uint32_t            used_index_count_   = 0;
+};
+
+#endif //BATCH_BUILDER_H
@@ -0,0 +1,208 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Graphics.h"
+
+/// Dynamic bounding volume hierarchy over object bounds (scene draws, pickable meshes, colliders), one leaf per
+/// object.
+///
+/// - Build: top-down binned SAH over all the objects at once.
+/// - Insert, Remove, Update: incremental. A new leaf goes down the branch of least surface area growth, and every
+///   change refits the ancestors of the leaf, swapping a child with a grandchild on the way up whenever it shrinks
+///   the surface area (tree rotations), so moving objects don't degrade the tree.
+/// - Queries run over a 4-wide copy of the tree (two binary levels per node, bounds in SoA), the 4 children of a
+///   node are tested at once with SSE2. Commit rebuilds it after the changes of a frame.
+///
+/// Usage:
+///		Bvh bvh = {};
+///		const Bvh::Handle handle = bvh.Insert(bounds, object);
+///		bvh.Update(handle, moved_bounds);
+///		bvh.Commit();
+///		bvh.QueryFrustum(frustum, &visible_objects);
+class Bvh
+{
+public:
+	using Handle = uint32_t;
+
+	/// Objects are below 2^31, the high bit tags the leaves of the query layout.
+	static constexpr uint32_t max_object = 0x7FFFFFFF;
+
+	/// Replace the tree with the objects 0 to bounds.size() - 1, committed.
+	/// @param p_handles	optional, receives the handle of every object, in order.
+	void Build(
+		std::span<const Graphics::Aabb> bounds,
+		std::vector<Handle>*            p_handles = nullptr);
+
+	/// @return the handle to update or remove the object with.
+	Handle Insert(
+		const Graphics::Aabb& bounds,
+		uint32_t              object);
+
+	void Remove(Handle handle);
+
+	/// Move the leaf to the new bounds and refit its ancestors.
+	void Update(
+		Handle                handle,
+		const Graphics::Aabb& bounds);
+
+	void Clear();
+
+	/// Rebuild the query layout after Insert, Remove or Update. The queries throw until then.
+	void Commit();
+
+	/// Append the objects whose bounds overlap the box.
+	void QueryAabb(
+		const Graphics::Aabb&  bounds,
+		std::vector<uint32_t>* p_objects) const;
+
+	/// Append the objects whose bounds are not fully outside one of the planes (conservative near the corners).
+	void QueryFrustum(
+		const Graphics::Frustum& frustum,
+		std::vector<uint32_t>*   p_objects) const;
+
+	/// Append the objects whose bounds the segment [origin, origin + direction * max_distance] crosses, or grazes
+	/// within rounding.
+	void QueryRay(
+		const glm::vec3&       origin,
+		const glm::vec3&       direction,
+		float                  max_distance,
+		std::vector<uint32_t>* p_objects) const;
+
+	[[nodiscard]] uint32_t GetObjectCount() const;
+
+	/// Surface area of the internal nodes relative to the root (the SAH cost of a traversal), lower is better.
+	[[nodiscard]] float GetCost() const;
+
+private:
+	static constexpr uint32_t null_node = UINT32_MAX;
+
+	/// Leaf when children[0] is null_node.
+	struct Node
+	{
+		Graphics::Aabb bounds      = {};
+		uint32_t       parent      = null_node;
+		uint32_t       children[2] = {null_node, null_node};
+		uint32_t       object      = 0;
+		bool           alive       = false;
+	};
+
+	/// Up to 4 children, packed first. Bounds rows: min x, y, z then max x, y, z.
+	struct WideNode
+	{
+		alignas(16) float bounds[6][4] = {};
+		uint32_t          children[4]  = {}; // Wide node index, or leaf_flag | object.
+		uint32_t          count        = 0;
+	};
+
+	static constexpr uint32_t leaf_flag = 0x80000000;
+
+	[[nodiscard]] bool IsLeaf(uint32_t node) const;
+
+	uint32_t AllocateNode();
+
+	void FreeNode(uint32_t node);
+
+	/// Sibling the new leaf is paired with: the node of least cost, going down the branch of least growth.
+	[[nodiscard]] uint32_t FindBestSibling(const Graphics::Aabb& bounds) const;
+
+	void InsertLeaf(uint32_t leaf);
+
+	void RemoveLeaf(uint32_t leaf);
+
+	/// Recompute the bounds from the node up to the root, rotating every node on the way.
+	void RefitAncestors(uint32_t node);
+
+	/// Swap a child with a grandchild of the other child if it lowers the area of that child.
+	void Rotate(uint32_t node);
+
+	/// Binned SAH split of the leaves, one internal node per range.
+	/// @param bounds		bounds of every leaf, indexed by node.
+	/// @param centroids	center of every leaf, indexed by node.
+	/// @return the root of the range.
+	uint32_t BuildRange(
+		std::span<uint32_t>             leaves,
+		std::span<const Graphics::Aabb> bounds,
+		std::span<const glm::vec3>      centroids);
+
+	std::vector<Node>     nodes_        = {};
+	std::vector<uint32_t> free_nodes_   = {};
+	std::vector<WideNode> wide_nodes_   = {};
+	uint32_t              root_         = null_node;
+	uint32_t              object_count_ = 0;
+	bool                  committed_    = true;
+};
+
+/// Static BVH over the triangles of a mesh, for the closest hit of a ray (picking).
+///
+/// Built top-down with the same binned SAH as Bvh, straight into 4-wide nodes whose leaves are blocks of up to 4
+/// triangles in SoA. A ray tests the 4 children of a node, then the 4 triangles of a block, at once with SSE2.
+/// Children are visited nearest first and the segment shortens at every hit, so most of the tree is never entered.
+/// The triangle test is watertight (Woop, Benthin, Wald 2013): rays through shared edges and vertices can't slip
+/// between the triangles.
+///
+/// Usage:
+///		TriangleBvh bvh = {};
+///		bvh.Build(batch.position, batch.indices);
+///		TriangleBvh::Hit hit = {};
+///		if (bvh.Intersect(origin, direction, max_distance, &hit))
+class TriangleBvh
+{
+public:
+	struct Hit
+	{
+		float     distance     = 0.0f; // In lengths of the direction.
+		uint32_t  triangle     = 0;    // Index / 3 in the indices the tree was built from.
+		glm::vec2 barycentrics = {};   // Weights of the second and third vertex, the first one is 1 - x - y.
+	};
+
+	/// Copy the triangles into the tree, the indices are offset by vertex_offset (Submesh::vertex_offset).
+	void Build(
+		std::span<const glm::vec3> positions,
+		std::span<const uint32_t>  indices,
+		int32_t                    vertex_offset = 0);
+
+	/// Closest triangle the segment [origin, origin + direction * max_distance] crosses, both sides count.
+	/// @return false if there is none, p_hit is untouched then.
+	bool Intersect(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float            max_distance,
+		Hit*             p_hit) const;
+
+	[[nodiscard]] uint32_t GetTriangleCount() const;
+
+private:
+	/// Up to 4 children, packed first. Bounds rows: min x, y, z then max x, y, z.
+	struct Node
+	{
+		alignas(16) float bounds[6][4] = {};
+		uint32_t          children[4]  = {}; // Node index, or leaf_flag | block index.
+		uint32_t          count        = 0;
+	};
+
+	/// Up to 4 triangles, packed first. Rows: vertex, then axis.
+	struct Block
+	{
+		alignas(16) float vertices[3][3][4] = {};
+		uint32_t          triangles[4]      = {};
+		uint32_t          count             = 0;
+	};
+
+	static constexpr uint32_t leaf_flag = 0x80000000;
+
+	std::vector<Node>  nodes_          = {};
+	std::vector<Block> blocks_         = {};
+	uint32_t           triangle_count_ = 0;
+};
+
+#endif //BVH_H
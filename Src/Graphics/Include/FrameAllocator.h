@@ -0,0 +1,121 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Linear scratch memory for the transient CPU data of a frame (culling lists, sort keys, command generation).
+///
+/// Each frame in flight owns a fixed budget. Allocations bump a pointer and are never freed one by one:
+/// BeginFrame rewinds the whole region in O(1), once the fence of that frame has signaled.
+/// Requests over the budget fall back to the heap (released on the next rewind) and are reported.
+///
+/// Usage (per frame):
+///		BeginFrame(frame_idx)							after the frame fence wait.
+///		FrameVector<DrawCall> draws(FrameStlAllocator<DrawCall>(&frame_allocator));
+class FrameAllocator
+{
+public:
+	FrameAllocator() = default;
+
+	~FrameAllocator();
+
+	FrameAllocator(const FrameAllocator&) = delete;
+
+	FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+	/// @param frame_count		frames in flight, one region each.
+	/// @param budget			bytes per frame.
+	void Init(
+		uint32_t frame_count,
+		size_t   budget);
+
+	void Destroy();
+
+	/// Rewind the region of the given frame and release its overflow allocations.
+	/// @warning	The fence of the frame must have been waited: everything allocated in it is invalidated.
+	void BeginFrame(uint32_t frame_idx);
+
+	/// @param alignment	power of two.
+	[[nodiscard]] void* Allocate(
+		size_t size,
+		size_t alignment);
+
+	/// Highest number of bytes used by a single frame (overflow included), measured when its region is rewound.
+	[[nodiscard]] size_t GetHighWater() const;
+
+	/// Number of allocations that didn't fit in the budget since Init.
+	[[nodiscard]] uint64_t GetOverflowCount() const;
+
+private:
+	struct Overflow
+	{
+		void*  memory    = nullptr;
+		size_t alignment = 0;
+	};
+
+	struct Frame
+	{
+		std::byte*            memory    = nullptr;
+		size_t                offset    = 0;
+		size_t                overflow  = 0;
+		std::vector<Overflow> overflows = {};
+	};
+
+	std::vector<Frame> frames_         = {};
+	uint32_t           current_frame_  = 0;
+	size_t             budget_         = 0;
+	size_t             high_water_     = 0;
+	uint64_t           overflow_count_ = 0;
+};
+
+/// STL allocator adaptor, deallocate is a no-op: the memory goes back with the frame rewind.
+/// @warning	Containers must not outlive the frame they were allocated in.
+template <typename T>
+class FrameStlAllocator
+{
+public:
+	using value_type = T;
+
+	explicit FrameStlAllocator(FrameAllocator* p_frame_allocator) noexcept
+		: frame_allocator_(p_frame_allocator)
+	{
+	}
+
+	template <typename U>
+	FrameStlAllocator(const FrameStlAllocator<U>& other) noexcept
+		: frame_allocator_(other.frame_allocator_)
+	{
+	}
+
+	[[nodiscard]] T* allocate(size_t count)
+	{
+		return static_cast<T*>(frame_allocator_->Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) noexcept
+	{
+	}
+
+	template <typename U>
+	bool operator==(const FrameStlAllocator<U>& other) const noexcept
+	{
+		return frame_allocator_ == other.frame_allocator_;
+	}
+
+private:
+	template <typename U>
+	friend class FrameStlAllocator;
+
+	FrameAllocator* frame_allocator_ = nullptr;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+
+#endif //FRAME_ALLOCATOR_H
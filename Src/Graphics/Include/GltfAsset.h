@@ -0,0 +1,107 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef GLTF_ASSET_H
+#define GLTF_ASSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Graphics.h"
+
+class ThreadPool;
+
+/// Meshes of a binary glTF 2.0 file (.glb) read in place, the fast path of Mesh::Load for .glb.
+///
+/// The accessors point into the file (or into the buffer views decoded from EXT_meshopt_compression), so the
+/// streams are written once, straight into their destination: the vectors of a Batch, or the mapped vertex
+/// buffers (VkApp::UploadAsset). Accessors already in the layout of the batch (float vec3, uint32 indices,
+/// tightly packed) are a single memcpy; quantized ones (KHR_mesh_quantization) are converted on the way.
+///
+/// Every primitive is a submesh, in mesh then primitive order like Assimp's aiMeshes, node transforms are not
+/// applied. Indices are kept relative to the primitive (Submesh::vertex_offset).
+///
+/// Usage:
+///		GltfAsset asset = {};
+///		if (asset.Load(file_data, &thread_pool))
+///		{
+///			asset.WritePositions(positions, rotation);
+///		}
+class GltfAsset
+{
+public:
+	/// Parse the document and decode the compressed buffer views, on the pool when there are several.
+	/// @param data				content of the .glb, must outlive the asset.
+	/// @param thread_pool		nullptr decodes on the calling thread.
+	/// @return false if the file needs the Assimp importer (Draco, skins, external buffers, sparse accessors,
+	///			non-triangle primitives, missing normals, ...).
+	bool Load(
+		std::span<const std::byte> data,
+		ThreadPool*                thread_pool);
+
+	[[nodiscard]] uint32_t GetVertexCount() const;
+
+	[[nodiscard]] uint32_t GetIndexCount() const;
+
+	[[nodiscard]] const std::vector<Graphics::Submesh>& GetSubmeshes() const;
+
+	/// Center of the POSITION bounds of a submesh, in file space.
+	[[nodiscard]] glm::vec3 GetSubmeshCenter(size_t submesh) const;
+
+	/// POSITION bounds of a submesh, in file space.
+	[[nodiscard]] Graphics::Aabb GetSubmeshBounds(size_t submesh) const;
+
+	/// @param positions	GetVertexCount elements.
+	/// @param rotation		applied to every position, the identity keeps the memcpy path.
+	void WritePositions(
+		std::span<glm::vec3> positions,
+		const glm::mat3&     rotation) const;
+
+	/// @param normals		GetVertexCount elements.
+	void WriteNormals(
+		std::span<glm::vec3> normals,
+		const glm::mat3&     rotation) const;
+
+	/// @param indices		GetIndexCount elements, relative to the vertex offset of their submesh.
+	void WriteIndices(std::span<uint32_t> indices) const;
+
+private:
+	/// Elements of an accessor, resolved to their bytes.
+	struct Accessor
+	{
+		const std::byte* data            = nullptr;
+		uint32_t         count           = 0;
+		uint32_t         stride          = 0;
+		uint32_t         component_type  = 0;
+		uint32_t         component_count = 0;
+		bool             normalized      = false;
+	};
+
+	struct Primitive
+	{
+		Accessor  position = {};
+		Accessor  normal   = {};
+		Accessor  indices  = {}; // No data for non-indexed primitives.
+		glm::vec3 min      = {};
+		glm::vec3 max      = {};
+	};
+
+	/// Read the accessor as floats, converting the normalized integer components.
+	static void WriteVectors(
+		const Accessor&  accessor,
+		glm::vec3*       p_vectors,
+		const glm::mat3& rotation);
+
+	std::vector<Primitive>              primitives_   = {};
+	std::vector<Graphics::Submesh>      submeshes_    = {};
+	std::vector<std::vector<std::byte>> decoded_      = {};
+	uint32_t                            vertex_count_ = 0;
+	uint32_t                            index_count_  = 0;
+};
+
+#endif //GLTF_ASSET_H
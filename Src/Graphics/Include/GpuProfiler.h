@@ -0,0 +1,126 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <volk/volk.h>
+#include <cstdint>
+#include <vector>
+
+/// GPU timings based on timestamp queries.
+///
+/// Every frame in flight owns its query pool. The results of a pool are read back only when the pool is
+/// reused, that is after the fence of that frame has been waited, so the readback never stalls.
+///
+/// Usage (per frame):
+///		BeginFrame(cmd, frame_idx)		after vkBeginCommandBuffer, outside of any render pass.
+///		BeginScope(cmd, "Color Pass")	scopes can be nested.
+///		EndScope(cmd)
+class GpuProfiler
+{
+public:
+	/// Resolved scope, times are in nanoseconds on the CPU clock (std::chrono::steady_clock) when the
+	/// calibration is available, otherwise relative to the first resolved frame.
+	struct Scope
+	{
+		const char* name     = nullptr;
+		uint32_t    depth    = 0;
+		uint64_t    begin_ns = 0;
+		uint64_t    end_ns   = 0;
+	};
+
+	/// @param device				logical device.
+	/// @param gpu					physical device the device was created from.
+	/// @param p_allocator			used for the query pools, must outlive the profiler.
+	/// @param queue_family_idx		queue family the command buffers are submitted to.
+	/// @param frame_count			frames in flight, one query pool each.
+	/// @param max_scope_count		max scopes per frame.
+	/// @param calibrated			VK_EXT_calibrated_timestamps has been enabled on the device.
+	void Init(
+		VkDevice               device,
+		VkPhysicalDevice       gpu,
+		VkAllocationCallbacks* p_allocator,
+		uint32_t               queue_family_idx,
+		uint32_t               frame_count,
+		uint32_t               max_scope_count,
+		bool                   calibrated);
+
+	void Destroy();
+
+	/// Resolve the results previously recorded for the given frame and reset its query pool.
+	/// @warning	The fence of the frame must have been waited.
+	void BeginFrame(
+		VkCommandBuffer command_buffer,
+		uint32_t        frame_idx);
+
+	/// Open a named scope. Use VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT around compute dispatches.
+	/// @param name		must outlive the profiler (string literal).
+	void BeginScope(
+		VkCommandBuffer         command_buffer,
+		const char*             name,
+		VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+	/// Close the innermost open scope.
+	void EndScope(
+		VkCommandBuffer         command_buffer,
+		VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+	/// Scopes of the last resolved frame.
+	[[nodiscard]] const std::vector<Scope>& GetLastFrame() const;
+
+	/// Duration in milliseconds of the first scope with the given name in the last resolved frame, 0 otherwise.
+	[[nodiscard]] double GetScopeMs(const char* name) const;
+
+	/// Write the recorded history as a Chrome trace (chrome://tracing, Perfetto).
+	void ExportChromeTrace(const char* path) const;
+
+private:
+	struct ScopeRecord
+	{
+		const char* name        = nullptr;
+		uint32_t    depth       = 0;
+		uint32_t    begin_query = 0;
+		uint32_t    end_query   = 0;
+	};
+
+	struct Frame
+	{
+		VkQueryPool              query_pool  = {};
+		std::vector<ScopeRecord> scopes      = {};
+		std::vector<uint32_t>    open_scopes = {};
+		uint32_t                 query_count = 0;
+
+		// GPU and CPU time sampled at the same instant when the frame was recorded.
+		uint64_t calibration_gpu_ticks = 0;
+		uint64_t calibration_cpu_ns    = 0;
+	};
+
+	void Resolve(Frame& frame);
+
+	void Calibrate(Frame& frame) const;
+
+	VkDevice               device_            = {};
+	VkAllocationCallbacks* allocator_         = {};
+	std::vector<Frame>     frames_            = {};
+	uint32_t               current_frame_     = 0;
+	uint32_t               max_query_count_   = 0;
+	double                 timestamp_period_  = 1.0;
+	uint64_t               timestamp_mask_    = 0;
+	bool                   calibrated_        = false;
+	bool                   enabled_           = false;
+	uint64_t               uncalibrated_base_ = 0;
+
+	/// Pairs of (timestamp, availability) for each query.
+	std::vector<uint64_t> readback_ = {};
+
+	std::vector<Scope> last_frame_ = {};
+
+	/// Bounded history used for the trace export.
+	std::vector<Scope> history_          = {};
+	size_t             history_capacity_ = 1u << 16;
+	size_t             history_next_     = 0;
+};
+
+#endif //GPU_PROFILER_H
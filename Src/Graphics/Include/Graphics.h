@@ -6,6 +6,7 @@
 #define GRAPHICS_H
 
 #include <Volk/volk.h>
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -36,6 +37,79 @@ public:
 		glm::vec3 pos;
 		glm::vec3 color;
 	};
+
+	/// Index range of one source mesh inside a batch. Indices are relative to vertex_offset.
+	struct Submesh
+	{
+		uint32_t first_index   = 0;
+		uint32_t index_count   = 0;
+		int32_t  vertex_offset = 0;
+		uint32_t material      = 0;
+	};
+
+	/// Axis-aligned bounding box.
+	struct Aabb
+	{
+		glm::vec3 min = {};
+		glm::vec3 max = {};
+	};
+
+	/// Planes of a view volume (left, right, bottom, top, near, far), a point is inside when
+	/// dot(plane.xyz, point) + plane.w >= 0 for every plane. The normals are not normalized.
+	struct Frustum
+	{
+		glm::vec4 planes[6] = {};
+	};
+
+	/// Indexed draw of a range of the batch.
+	struct DrawCall
+	{
+		uint64_t  sort_key      = 0;
+		uint32_t  index_count   = 0;
+		uint32_t  first_index   = 0;
+		int32_t   vertex_offset = 0;
+		uint32_t  material      = 0;
+		glm::vec3 center        = {};
+		Aabb      bounds        = {};
+	};
+
+	/// Pack the draw state into a 64-bit key, so that sorting the keys groups draws by pipeline, then by
+	/// material and finally orders them front-to-back (early-Z friendly).
+	///
+	/// | 63 .. 56 | 55 .. 32 | 31 .. 0    |
+	/// | pipeline | material | view depth |
+	///
+	/// @param pipeline		pipeline identifier.
+	/// @param material		material identifier, only the low 24 bits are used.
+	/// @param view_depth	distance along the camera front axis. Negative values are clamped to zero.
+	static uint64_t MakeSortKey(
+		uint8_t  pipeline,
+		uint32_t material,
+		float    view_depth);
+
+	/// Right-handed perspective with reverse-Z and no far plane: depth is z_near / distance, 1 on the near plane and
+	/// 0 at infinity.
+	/// @param fov_y	vertical field of view, in radians.
+	static glm::mat4 ReverseInfinitePerspective(
+		float fov_y,
+		float aspect_ratio,
+		float z_near);
+
+	/// Planes of a view-projection matrix with a [0, 1] depth range (Gribb-Hartmann), in world space. With
+	/// ReverseInfinitePerspective the near plane comes last and the first depth plane is always passed.
+	static Frustum ExtractFrustum(const glm::mat4& view_projection);
+
+	/// Bounds of the box once rotated (and scaled), the center is transformed and the extent grows to fit.
+	static Aabb TransformAabb(
+		const Aabb&      bounds,
+		const glm::mat3& transform);
+
+	/// Compute the sort key of every draw call and sort them.
+	static void SortDrawCalls(
+		uint8_t             pipeline,
+		const glm::vec3&    camera_pos,
+		const glm::vec3&    camera_front,
+		std::span<DrawCall> draw_calls);
 };
 
 #endif //GRAPHICS_H
@@ -0,0 +1,123 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/// What the keys and buttons are bound to, the application only sees actions.
+enum class InputAction : uint32_t
+{
+	MoveForward        = 0,
+	MoveBackward       = 1,
+	MoveLeft           = 2,
+	MoveRight          = 3,
+	Wireframe          = 4,
+	Filled             = 5,
+	ToggleDepthPrepass = 6,
+	ExportTraces       = 7,
+	Pick               = 8,
+};
+
+constexpr uint32_t input_action_count = 9;
+
+/// Bit of the action in Input::GetHeldActions.
+constexpr uint32_t InputActionBit(InputAction action)
+{
+	return 1u << static_cast<uint32_t>(action);
+}
+
+enum class InputEventType : uint32_t
+{
+	Pressed  = 0, // A key or button bound to the action went down, repeats are ignored.
+	Released = 1,
+	Quit     = 2,
+	Resized  = 3, // The window changed size, the swapchain must be recreated.
+};
+
+struct InputEvent
+{
+	InputEventType type      = InputEventType::Pressed;
+	InputAction    action    = InputAction::MoveForward; // Pressed and Released only.
+	uint64_t       timestamp = 0;                        // SDL_GetPerformanceCounter ticks.
+	glm::ivec2     cursor    = {};                       // Window coordinates, mouse buttons only.
+};
+
+/// Keyboard and mouse input, independent of the frame: SDL events become timestamped action events through the
+/// bindings, and the held actions are tracked from them.
+///
+/// Pump drains the SDL queue and can run several times per frame: at the start of the frame for the discrete
+/// events, and again as late as possible before the camera is written (VkApp::DrawFrame), so the motion is the one
+/// of that instant rather than the one of the start of the frame. Events pumped late are kept for the next frame.
+///
+/// Usage:
+///		Input input = {};
+///		input.BindDefaults();
+///		input.Pump();
+///		for (const InputEvent& event : input.GetEvents()) { ... }
+///		input.ClearEvents();
+///		if (input.IsDown(InputAction::MoveForward)) { ... }
+///
+/// @warning	Not thread-safe, use it from the thread that created the window (SDL event functions).
+class Input
+{
+public:
+	/// WASD moves, Q/E switch to wireframe/filled, P toggles the depth pre-pass, F12 exports the traces, the left
+	/// button picks.
+	void BindDefaults();
+
+	/// A key or button has one action, binding it again replaces it. Several can share an action.
+	void Bind(
+		SDL_Scancode scancode,
+		InputAction  action);
+
+	/// @param button	SDL_BUTTON_LEFT, SDL_BUTTON_RIGHT, ...
+	void BindMouseButton(
+		uint8_t     button,
+		InputAction action);
+
+	/// Non-blocking. Append the events queued since the last call and update the held actions.
+	void Pump();
+
+	/// Events pumped since the last ClearEvents, in order.
+	[[nodiscard]] std::span<const InputEvent> GetEvents() const;
+
+	void ClearEvents();
+
+	/// At least one of the keys or buttons bound to the action is held, as of the last Pump.
+	[[nodiscard]] bool IsDown(InputAction action) const;
+
+	/// InputActionBit of every held action, to hand the input to another thread (Simulation).
+	[[nodiscard]] uint32_t GetHeldActions() const;
+
+	/// SDL_GetPerformanceCounter ticks at the last Pump, the time the held actions were sampled at.
+	[[nodiscard]] uint64_t GetPumpTimestamp() const;
+
+private:
+	/// Count a key or button of the action going down or up, and append the event.
+	void SetAction(
+		InputAction       action,
+		bool              down,
+		uint64_t          timestamp,
+		const glm::ivec2& cursor);
+
+	std::unordered_map<SDL_Scancode, InputAction> key_bindings_    = {};
+	std::unordered_map<uint8_t, InputAction>      button_bindings_ = {};
+
+	/// Keys and buttons held per action.
+	std::array<uint32_t, input_action_count> held_ = {};
+
+	std::vector<InputEvent> events_         = {};
+	uint64_t                pump_timestamp_ = 0;
+};
+
+#endif //INPUT_H
@@ -6,23 +6,133 @@
 #define MESH_H
 
 #include <cstdint>
+#include <functional>
+#include <span>
 #include <vector>
 #include <assimp/scene.h>
 
 #include <glm/glm.hpp>
 
+#include "Animation.h"
+#include "Graphics.h"
+
 class Batch;
+class BatchBuilder;
+class ThreadPool;
+
+/// Encoding of the arrays of a cooked mesh.
+enum class CookedMeshCompression : uint32_t
+{
+	None    = 0, // Raw arrays, a memcpy each.
+	Meshopt = 1, // MeshCodec streams: 16-bit positions and 8-bit octahedral normals (lossy), triangle coded indices.
+};
+
+/// Header of the cooked mesh format (.amesh).
+///
+/// None: followed by the raw arrays: positions (vec3), normals (vec3), indices (uint32), submeshes
+/// (Graphics::Submesh).
+/// Meshopt: followed by the segment tables (CookedIndexSegment, then a CookedVertexSegment per segment_size
+/// vertices), the index streams, the position then normal stream of every vertex segment, and the raw
+/// submeshes. Segments are encoded independently so LoadCooked decodes them in parallel.
+struct CookedMeshHeader
+{
+	static constexpr uint32_t magic_value   = 0x48534D41; // "AMSH"
+	static constexpr uint32_t version_value = 3;
+
+	/// Vertices, or triangles, per segment of the compressed streams.
+	static constexpr uint32_t segment_size = 65536;
+
+	uint32_t              magic               = magic_value;
+	uint32_t              version             = version_value;
+	uint32_t              vertex_count        = 0;
+	uint32_t              index_count         = 0;
+	uint32_t              submesh_count       = 0;
+	CookedMeshCompression compression         = CookedMeshCompression::None;
+	uint32_t              index_segment_count = 0;
+	glm::vec3             position_min        = {}; // Meshopt: position = position_min + quantized * position_scale.
+	glm::vec3             position_scale      = {};
+};
+
+/// Triangles of one submesh at most, in index order. The codec numbers the vertices from 0: the decoded indices
+/// are offset by base.
+struct CookedIndexSegment
+{
+	uint32_t stream_size = 0;
+	uint32_t index_count = 0;
+	uint32_t base        = 0;
+};
+
+struct CookedVertexSegment
+{
+	uint32_t position_stream_size = 0;
+	uint32_t normal_stream_size   = 0;
+};
 
 class Mesh
 {
 	Mesh() = delete;
 
 public:
+	/// Called after each file of LoadMany is merged, on the calling thread.
+	using LoadProgress = std::function<void(uint32_t loaded_count, uint32_t file_count)>;
+
+	/// Cooked files go through LoadCooked, .obj and .glb through LoadObj and LoadGltf when they can read them,
+	/// the rest through Import.
 	static void Load(
 		const char* file_path,
 		Batch*      batch);
 
+	/// Import any format through Assimp.
+	static void Import(
+		const char* file_path,
+		Batch*      batch);
+
+	/// Parse a .obj without Assimp (ObjParser), the chunks of the file are split across the pool.
+	/// @param thread_pool		nullptr parses on the calling thread.
+	/// @return false if the file needs the Assimp importer (objects, groups, materials, ...), see Load.
+	static bool LoadObj(
+		const char* file_path,
+		Batch*      batch,
+		ThreadPool* thread_pool = nullptr);
+
+	/// Read a .glb without Assimp (GltfAsset), the compressed buffer views are decoded on the pool.
+	/// @param thread_pool		nullptr decodes on the calling thread.
+	/// @return false if the file needs the Assimp importer (Draco, skins, ...), see Load.
+	static bool LoadGltf(
+		const char* file_path,
+		Batch*      batch,
+		ThreadPool* thread_pool = nullptr);
+
+	/// Rotation of -90 degrees around X applied to every import (glm, column-major).
+	static glm::mat3 GetImportRotation();
+
+	/// Import the files concurrently on the pool and append them to the builder in the order of the paths.
+	/// @param p_handles		optional, receives the builder handle of every file, in order.
+	static void LoadMany(
+		ThreadPool*                  thread_pool,
+		std::span<const char* const> file_paths,
+		BatchBuilder*                builder,
+		std::vector<uint32_t>*       p_handles = nullptr,
+		const LoadProgress&          progress  = {});
+
+	/// Write the batch in the cooked format, so it can be loaded without going through Assimp.
+	/// @param compression		Meshopt cuts the file size several times, at the cost of the quantization.
+	static void Cook(
+		const char*           file_path,
+		const Batch&          batch,
+		CookedMeshCompression compression = CookedMeshCompression::None);
+
+	/// Load a file written by Cook.
+	/// @param thread_pool		nullptr decodes the compressed streams on the calling thread.
+	static void LoadCooked(
+		const char* file_path,
+		Batch*      batch,
+		ThreadPool* thread_pool = nullptr);
+
 private:
+	/// Rotation of -90 degrees around X applied to the positions and normals of every import.
+	static void ApplyImportRotation(Batch* batch);
+
 	static void QueryVerticesCount(
 		const aiScene* scene,
 		uint32_t*      vertices_count);
@@ -39,9 +149,33 @@ private:
 		const aiScene* scene,
 		uint32_t*      indeces_count);
 
+	/// Indices of every mesh, offset by the vertices of the meshes before it.
 	static void QueryIndices(
 		const aiScene*         scene,
 		std::vector<uint32_t>& indices);
+
+	/// Index range of every mesh, in the order of QueryIndices.
+	static void QuerySubmeshes(
+		const aiScene*                  scene,
+		std::vector<Graphics::Submesh>& submeshes);
+
+	/// Every node of the hierarchy becomes a joint, so the clips can animate the nodes between the bones too.
+	static void QuerySkeleton(
+		const aiScene* scene,
+		Skeleton*      skeleton);
+
+	/// The 4 largest influences of every vertex (aiProcess_LimitBoneWeights), normalized.
+	static void QuerySkinWeights(
+		const aiScene*           scene,
+		const Skeleton&          skeleton,
+		std::vector<glm::uvec4>& joints,
+		std::vector<glm::vec4>&  weights);
+
+	/// Node channels resampled at AnimationClip::sample_rate, joints without a channel keep their bind transform.
+	static void QueryAnimations(
+		const aiScene*              scene,
+		const Skeleton&             skeleton,
+		std::vector<AnimationClip>& clips);
 };
 
 #endif //MESH_H
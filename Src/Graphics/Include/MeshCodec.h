@@ -0,0 +1,88 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef MESH_CODEC_H
+#define MESH_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/// Decoders of the meshoptimizer bitstreams, as specified by EXT_meshopt_compression (version 0 of the
+/// attribute codec, versions 0 and 1 of the index codecs), and the encoders used by Mesh::Cook.
+///
+/// - Vertex buffer: blocks of vertices, every byte of the vertex delta encoded against the previous vertex and
+///   packed in groups of 16 with 0, 2, 4 or 8 bits per byte.
+/// - Index buffer: triangle lists, edges and vertices matched against small FIFOs of the previous triangles.
+/// - Index sequence: any index list, delta encoded against two baselines.
+/// - Filters: applied in place after the vertex buffer decode (octahedral normals, quaternions, exponents).
+///
+/// Every decoder throws on a malformed stream, it never reads outside of the source. The vertex decoder
+/// unpacks the byte groups and interleaves 4 byte columns at a time with SSE2.
+class MeshCodec
+{
+	MeshCodec() = delete;
+
+public:
+	enum class Filter : uint8_t
+	{
+		None,
+		Octahedral,
+		Quaternion,
+		Exponential,
+	};
+
+	/// @param stride	bytes per vertex, a multiple of 4 up to 256.
+	/// @warning		destination must hold count * stride bytes.
+	static void DecodeVertexBuffer(
+		std::span<std::byte>       destination,
+		uint32_t                   count,
+		uint32_t                   stride,
+		std::span<const std::byte> source);
+
+	/// @param count		multiple of 3.
+	/// @param index_size	2 or 4 bytes.
+	static void DecodeIndexBuffer(
+		std::span<std::byte>       destination,
+		uint32_t                   count,
+		uint32_t                   index_size,
+		std::span<const std::byte> source);
+
+	/// @param index_size	2 or 4 bytes.
+	static void DecodeIndexSequence(
+		std::span<std::byte>       destination,
+		uint32_t                   count,
+		uint32_t                   index_size,
+		std::span<const std::byte> source);
+
+	/// Reconstruct the filtered elements in place.
+	/// @param stride	Octahedral: 4 (int8) or 8 (int16), Quaternion: 8, Exponential: a multiple of 4.
+	static void DecodeFilter(
+		Filter               filter,
+		std::span<std::byte> data,
+		uint32_t             count,
+		uint32_t             stride);
+
+	/// Encode in the format of DecodeVertexBuffer, lossless.
+	/// @param stride	bytes per vertex, a multiple of 4 up to 256.
+	static std::vector<std::byte> EncodeVertexBuffer(
+		std::span<const std::byte> vertices,
+		uint32_t                   count,
+		uint32_t                   stride);
+
+	/// Encode a triangle list in the format of DecodeIndexBuffer (version 1). Triangles may be rotated, their
+	/// winding is kept. Compresses best when the vertices are numbered in the order of their first use.
+	static std::vector<std::byte> EncodeIndexBuffer(std::span<const uint32_t> indices);
+
+	/// Unit vectors to int8 octahedral elements (stride 4), the input of DecodeFilter(Filter::Octahedral).
+	/// @warning	data must hold 4 bytes per normal.
+	static void EncodeOctahedral(
+		std::span<const glm::vec3> normals,
+		std::span<std::byte>       data);
+};
+
+#endif //MESH_CODEC_H
@@ -0,0 +1,122 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef NORMAL_GENERATOR_H
+#define NORMAL_GENERATOR_H
+
+#include <volk/volk.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// Smooth vertex normals recomputed from the positions and the indices, for deforming meshes.
+///
+/// Two passes, no atomics: the first writes one area weighted normal per triangle, the second sums, for each
+/// vertex, the normals of the triangles using it (vertex to triangle adjacency, built once per mesh) and
+/// normalizes. The GPU version runs both passes as compute dispatches (normals.comp), ComputeNormals is the CPU
+/// reference.
+///
+/// Usage (per frame):
+///		BeginFrame()	after the fence of the previous frame was waited.
+///		Record(cmd)		outside of any render pass, before the draws reading the normal buffer.
+class NormalGenerator
+{
+public:
+	/// Vertex to triangle adjacency in compressed rows: the triangles of vertex v are
+	/// triangles[offsets[v] .. offsets[v + 1]].
+	struct Adjacency
+	{
+		std::vector<uint32_t> offsets   = {};
+		std::vector<uint32_t> triangles = {};
+	};
+
+	/// Both passes, built from the same version of normals.comp.
+	struct Pipelines
+	{
+		VkPipeline face   = VK_NULL_HANDLE;
+		VkPipeline vertex = VK_NULL_HANDLE;
+	};
+
+	static void BuildAdjacency(
+		std::span<const uint32_t> indices,
+		uint32_t                  vertex_count,
+		Adjacency*                p_adjacency);
+
+	/// CPU reference of the two passes, SSE for the face normals when available.
+	/// @param normals		one per position.
+	static void ComputeNormals(
+		std::span<const glm::vec3> positions,
+		std::span<const uint32_t>  indices,
+		const Adjacency&           adjacency,
+		std::span<glm::vec3>       normals);
+
+	/// @param shader_code		SPIR-V of normals.comp.
+	void Init(
+		VkDevice                  device,
+		VkPhysicalDevice          gpu,
+		VkAllocationCallbacks*    p_allocator,
+		std::span<const uint32_t> shader_code);
+
+	void Destroy();
+
+	/// Build the pipelines from new SPIR-V of normals.comp (shader hot reload). Any thread, only reads the state
+	/// fixed at Init.
+	[[nodiscard]] Pipelines CreatePipelines(std::span<const uint32_t> shader_code) const;
+
+	/// Record with pipelines of CreatePipelines from now on, the current ones are retired.
+	void SetPipelines(const Pipelines& pipelines);
+
+	/// Destroy the pipelines replaced before the previous frame.
+	/// @warning	The fence of the previous frame must have been waited.
+	void BeginFrame();
+
+	/// Build the adjacency of the mesh and bind its buffers (storage usage required).
+	/// The normal buffer is overwritten by every Record.
+	void SetMesh(
+		std::span<const uint32_t> indices,
+		uint32_t                  vertex_count,
+		VkBuffer                  position_buffer,
+		VkBuffer                  index_buffer,
+		VkBuffer                  normal_buffer);
+
+	/// Release the buffers created by SetMesh.
+	/// @warning	The device must be idle.
+	void ClearMesh();
+
+	/// Record both passes and the barrier making the normals visible to the vertex input stage.
+	void Record(VkCommandBuffer command_buffer) const;
+
+private:
+	void Dispatch(
+		VkCommandBuffer command_buffer,
+		VkPipeline      pipeline,
+		uint32_t        invocation_count) const;
+
+	VkDevice               device_    = {};
+	VkPhysicalDevice       gpu_       = {};
+	VkAllocationCallbacks* allocator_ = {};
+
+	VkDescriptorSetLayout descriptor_set_layout_ = {};
+	VkDescriptorPool      descriptor_pool_       = {};
+	VkDescriptorSet       descriptor_set_        = {};
+	VkPipelineLayout      pipeline_layout_       = {};
+	Pipelines             pipelines_             = {};
+
+	/// Replaced pipelines, still bound by the frame in flight.
+	std::vector<VkPipeline> retired_ = {};
+
+	VkBuffer       face_normal_buffer_        = {};
+	VkDeviceMemory face_normal_memory_        = {};
+	VkBuffer       adjacency_offset_buffer_   = {};
+	VkDeviceMemory adjacency_offset_memory_   = {};
+	VkBuffer       adjacency_triangle_buffer_ = {};
+	VkDeviceMemory adjacency_triangle_memory_ = {};
+	VkBuffer       normal_buffer_             = {};
+
+	uint32_t triangle_count_ = 0;
+	uint32_t vertex_count_   = 0;
+};
+
+#endif //NORMAL_GENERATOR_H
@@ -0,0 +1,38 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstddef>
+#include <span>
+
+class Batch;
+class ThreadPool;
+
+/// Wavefront OBJ parser working on the mapped file, the fast path of Mesh::Load for .obj.
+///
+/// The file is split in chunks at line boundaries, parsed in parallel (SSE2 line scanning, std::from_chars for
+/// the numbers), then the face corners are deduplicated on their v/vt/vn triple with a hash table, in order, so
+/// the vertices come out in first use order like Assimp's JoinIdenticalVertices. Polygons are triangulated as
+/// fans. Without vn, smooth normals are generated the way aiProcess_GenSmoothNormals does: normalized face
+/// normals summed per position.
+///
+/// Output is in file space (no import rotation), one submesh.
+class ObjParser
+{
+	ObjParser() = delete;
+
+public:
+	/// @param thread_pool		parses the chunks, nullptr parses on the calling thread.
+	///							Must not be the pool running the caller (the caller waits on the chunks).
+	/// @return false if the file uses statements only Assimp handles (objects, groups, materials, lines, ...),
+	///			the batch is untouched then.
+	static bool Parse(
+		std::span<const std::byte> data,
+		ThreadPool*                thread_pool,
+		Batch*                     batch);
+};
+
+#endif //OBJ_PARSER_H
@@ -0,0 +1,157 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef PIPELINE_MANAGER_H
+#define PIPELINE_MANAGER_H
+
+#include <volk/volk.h>
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+/// SPIR-V modules a pipeline can be built from.
+enum class PipelineShader : uint32_t
+{
+	Vertex      = 0, // shader.vert
+	Fragment    = 1, // shader.frag
+	DepthVertex = 2, // depth.vert
+	None        = 3,
+};
+
+constexpr uint32_t pipeline_shader_count = 3;
+
+/// Compile-time toggles of the shaders, forwarded as specialization constants.
+enum ShaderFeature : uint32_t
+{
+	ShaderFeature_Lighting = 1 << 0, // constant_id 3
+};
+
+/// State a pipeline is built from. Two equal descriptions share the same pipeline.
+/// Everything else (layout, render pass, sample count, color attachments, dynamic viewport) is fixed at
+/// PipelineManager::Init.
+struct PipelineDesc
+{
+	PipelineShader vertex_shader   = PipelineShader::Vertex;
+	PipelineShader fragment_shader = PipelineShader::Fragment;
+
+	/// 3: position, color and normal streams. 1: position only.
+	uint32_t vertex_streams = 3;
+
+	VkPolygonMode polygon_mode  = VK_POLYGON_MODE_FILL;
+	VkCompareOp   depth_compare = VK_COMPARE_OP_LESS; // Depth growing away from the camera, see PipelineManager::Init.
+	VkBool32      depth_write   = VK_TRUE;
+	VkBool32      color_write   = VK_TRUE;
+
+	/// ShaderFeature bits.
+	uint32_t features = ShaderFeature_Lighting;
+
+	/// Specialization constants 0, 1, 2.
+	glm::vec3 light_direction = {-0.0f, 2.0f, -0.2f};
+
+	bool operator==(const PipelineDesc& other) const = default;
+};
+
+/// FNV-1a of the description.
+struct PipelineDescHash
+{
+	size_t operator()(const PipelineDesc& desc) const;
+};
+
+/// Graphics pipelines keyed by their description, compiled on demand.
+///
+/// Get compiles a missing pipeline on a worker and returns the given fallback until it is ready, so the render
+/// loop never waits on the driver compiler. SetShaderCode rebuilds the pipelines using a shader the same way,
+/// the previous version is used meanwhile. All the pipelines go through one VkPipelineCache.
+///
+/// @warning	Not thread-safe, use it from the render thread.
+class PipelineManager
+{
+public:
+	/// @param p_allocator				must outlive the manager, used from the workers.
+	/// @param color_attachment_count	1: color. 2: color and object id (R32_UINT), shader.frag writes the id.
+	/// @param reverse_z				depth shrinks away from the camera, the less and greater compare ops of the
+	///									descriptions are swapped.
+	/// @param thread_pool				runs the compilations, must outlive the manager.
+	void Init(
+		VkDevice               device,
+		VkAllocationCallbacks* p_allocator,
+		VkPipelineLayout       layout,
+		VkRenderPass           render_pass,
+		VkSampleCountFlagBits  sample_count,
+		uint32_t               color_attachment_count,
+		bool                   reverse_z,
+		ThreadPool*            thread_pool);
+
+	/// Wait for the compilations in flight and destroy every pipeline.
+	/// @warning	The device must be idle.
+	void Destroy();
+
+	/// Replace the SPIR-V of a shader, the pipelines using it are rebuilt on a worker.
+	void SetShaderCode(
+		PipelineShader        shader,
+		std::vector<uint32_t> code);
+
+	/// Pipeline of the description, the first call starts its compilation on a worker.
+	/// @return the fallback until the first version is ready, the previous version during a rebuild.
+	VkPipeline Get(
+		const PipelineDesc& desc,
+		VkPipeline          fallback);
+
+	/// Same as Get, but compile on the calling thread if there is no version yet (pipelines of the first frame).
+	VkPipeline GetBlocking(const PipelineDesc& desc);
+
+	/// Destroy the pipelines replaced before the previous frame.
+	/// @warning	The fence of the previous frame must have been waited.
+	void BeginFrame();
+
+	/// Number of distinct descriptions requested.
+	[[nodiscard]] uint32_t GetPipelineCount() const;
+
+private:
+	using ShaderCode = std::array<std::shared_ptr<const std::vector<uint32_t>>, pipeline_shader_count>;
+
+	struct Entry
+	{
+		VkPipeline              pipeline = VK_NULL_HANDLE;
+		std::future<VkPipeline> pending  = {};
+
+		/// A shader changed while the entry was compiling, compile again once done.
+		bool stale = false;
+	};
+
+	/// Build the pipeline, runs on the workers. Only reads state fixed at Init and the given code.
+	VkPipeline Compile(
+		const PipelineDesc& desc,
+		const ShaderCode&   code) const;
+
+	/// Start a compilation of the entry with the current code.
+	void Submit(
+		const PipelineDesc& desc,
+		Entry*              p_entry);
+
+	/// Swap in the result of the entry's compilation if it is ready.
+	void Collect(Entry* p_entry);
+
+	VkDevice               device_                 = {};
+	VkAllocationCallbacks* allocator_              = {};
+	VkPipelineLayout       layout_                 = {};
+	VkRenderPass           render_pass_            = {};
+	VkSampleCountFlagBits  sample_count_           = VK_SAMPLE_COUNT_1_BIT;
+	uint32_t               color_attachment_count_ = 1;
+	bool                   reverse_z_              = false;
+	VkPipelineCache        cache_                  = {};
+	ThreadPool*            thread_pool_            = nullptr;
+
+	ShaderCode                                                code_      = {};
+	std::unordered_map<PipelineDesc, Entry, PipelineDescHash> pipelines_ = {};
+	std::vector<VkPipeline>                                   retired_   = {};
+};
+
+#endif //PIPELINE_MANAGER_H
@@ -0,0 +1,79 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/// CPU instrumentation.
+///
+/// Use only the macros: when ADRO_PROFILER is not defined they expand to nothing, so the markers can stay in
+/// the hot paths of release builds.
+///
+///		ADRO_PROFILE_SCOPE("Mesh::Load");		Time the enclosing block.
+///		ADRO_PROFILE_FUNCTION();				Same, named after the enclosing function.
+///		ADRO_PROFILE_THREAD("Worker");			Name the calling thread in the trace.
+///		ADRO_PROFILE_EXPORT("cpu_trace.json");	Write the recorded events as a Chrome trace.
+///
+/// Each thread writes into its own ring buffer (single producer, no locks). The Chrome trace can be opened with
+/// chrome://tracing, Perfetto, or converted for Tracy with its import-chrome tool.
+/// Times come from std::chrono::steady_clock, the clock GpuProfiler calibrates against.
+
+#ifdef ADRO_PROFILER
+
+#include <cstdint>
+
+class Profiler
+{
+public:
+	Profiler() = delete;
+
+	/// Events kept per thread, older events are overwritten.
+	static constexpr uint32_t ring_capacity = 1u << 15;
+
+	/// RAII marker, records one complete event on destruction.
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name);
+
+		~Scope();
+
+		Scope(const Scope&) = delete;
+
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* name_     = nullptr;
+		uint64_t    begin_ns_ = 0;
+	};
+
+	/// @param name		must outlive the profiler (string literal).
+	static void SetThreadName(const char* name);
+
+	/// Write the events of every thread as a Chrome trace.
+	/// @warning	Events written while exporting may be torn, export from a quiet point (e.g. teardown, between frames).
+	static void ExportChromeTrace(const char* path);
+
+	/// Nanoseconds on std::chrono::steady_clock.
+	static uint64_t Now();
+};
+
+#define ADRO_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ADRO_PROFILE_CONCAT(a, b) ADRO_PROFILE_CONCAT_IMPL(a, b)
+
+#define ADRO_PROFILE_SCOPE(name) const Profiler::Scope ADRO_PROFILE_CONCAT(adro_profile_scope_, __COUNTER__)(name)
+#define ADRO_PROFILE_FUNCTION() ADRO_PROFILE_SCOPE(__func__)
+#define ADRO_PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define ADRO_PROFILE_EXPORT(path) Profiler::ExportChromeTrace(path)
+
+#else
+
+#define ADRO_PROFILE_SCOPE(name) ((void) 0)
+#define ADRO_PROFILE_FUNCTION() ((void) 0)
+#define ADRO_PROFILE_THREAD(name) ((void) 0)
+#define ADRO_PROFILE_EXPORT(path) ((void) 0)
+
+#endif
+
+#endif //PROFILER_H
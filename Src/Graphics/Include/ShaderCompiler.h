@@ -0,0 +1,27 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <cstdint>
+#include <vector>
+
+/// Runtime GLSL to SPIR-V compilation, used by the shader hot reload.
+/// Embeds shaderc when the Vulkan SDK provides it (ADRO_SHADERC), runs glslc otherwise.
+class ShaderCompiler
+{
+public:
+	// Delete constructor. This class is not instantiable.
+	ShaderCompiler() = delete;
+
+	/// Compile a GLSL file, the stage is deduced from the extension (.vert, .frag, .comp).
+	/// Thread-safe.
+	/// @param path			path to the GLSL source.
+	/// @return the SPIR-V words.
+	/// @throw std::runtime_error with the compiler log if the compilation fails.
+	static std::vector<uint32_t> CompileGlsl(const char* path);
+};
+
+#endif //SHADER_COMPILER_H
@@ -0,0 +1,39 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Reports the files written in a directory (not recursive), polled once per frame.
+/// inotify on Linux, a change notification handle plus a scan of the write times on Windows.
+class ShaderWatcher
+{
+public:
+	/// @return false if the directory can't be watched, Poll then never reports anything.
+	bool Init(const char* directory);
+
+	void Destroy();
+
+	/// Non-blocking. Append the names (not the paths) of the files written since the last call, once each.
+	void Poll(std::vector<std::string>* p_changed_files);
+
+	[[nodiscard]] const std::string& GetDirectory() const;
+
+private:
+	std::string directory_ = {};
+
+#ifdef _WIN32
+	void*                                    change_handle_ = nullptr;
+	std::unordered_map<std::string, int64_t> write_times_   = {};
+#else
+	int inotify_fd_ = -1;
+#endif
+};
+
+#endif //SHADER_WATCHER_H
@@ -0,0 +1,135 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+/// Latest value handed from one writer thread to one reader thread, neither side ever waits: the writer fills its
+/// slot and swaps it with the middle one, the reader swaps its slot with the middle one when it holds a newer value.
+///
+/// Usage:
+///		TripleBuffer<State> buffer = {};
+///		buffer.GetWriteSlot() = state;	// Writer thread.
+///		buffer.Publish();
+///		const State& latest = buffer.Read();	// Reader thread.
+template <typename T>
+class TripleBuffer
+{
+public:
+	/// Writer only. The slot holds a stale value, overwrite it entirely before Publish.
+	[[nodiscard]] T& GetWriteSlot()
+	{
+		return slots_[write_];
+	}
+
+	/// Writer only. Make the write slot the latest value and take another one.
+	void Publish()
+	{
+		write_ = middle_.exchange(write_ | fresh_flag, std::memory_order_acq_rel) & index_mask;
+	}
+
+	/// Reader only. The latest published value, or the one of the previous call if nothing was published since.
+	[[nodiscard]] const T& Read()
+	{
+		if (middle_.load(std::memory_order_relaxed) & fresh_flag)
+		{
+			read_ = middle_.exchange(read_, std::memory_order_acq_rel) & index_mask;
+		}
+
+		return slots_[read_];
+	}
+
+private:
+	static constexpr uint32_t index_mask = 0x3;
+	static constexpr uint32_t fresh_flag = 0x4;
+
+	std::array<T, 3>      slots_  = {};
+	std::atomic<uint32_t> middle_ = 1; // Slot index, with fresh_flag until the reader takes it.
+	uint32_t              write_  = 0;
+	uint32_t              read_   = 2;
+};
+
+/// What the simulation hands to the renderer every tick.
+struct SimulationState
+{
+	glm::vec3 camera_pos    = {};
+	glm::vec3 camera_target = {}; // Position the camera is smoothed toward.
+	glm::vec3 camera_front  = {0.0f, 0.0f, 1.0f};
+};
+
+/// Advance the state by one tick of step seconds, with the held actions (Input::GetHeldActions).
+using SimulationStep = std::function<void(SimulationState* p_state, uint32_t held_actions, float step)>;
+
+/// Fixed timestep simulation on a thread of its own, decoupled from the render rate.
+///
+/// - The thread accumulates the elapsed time and runs as many steps as fit in it, so the state only depends on the
+///   input and the number of ticks, never on the frame times. A stall (debugger, suspended process) is caught up
+///   by max_catch_up_steps at most, the rest of the time is dropped.
+/// - After the steps, the last two states go through a TripleBuffer: the renderer samples the latest ones at any
+///   time without ever waiting on the simulation, and the simulation never waits on a frame.
+/// - Sample interpolates between the two states by the time elapsed since the last tick, the motion is smooth
+///   whatever the render rate, one tick behind the simulation.
+///
+/// Usage:
+///		Simulation simulation = {};
+///		simulation.Start(initial_state, step);
+///		simulation.SetHeldActions(input.GetHeldActions());
+///		const SimulationState state = simulation.Sample(SDL_GetPerformanceCounter());
+///		simulation.Stop();
+class Simulation
+{
+public:
+	static constexpr uint32_t max_catch_up_steps = 8;
+
+	~Simulation();
+
+	/// Publish the initial state and start the thread.
+	/// @param step			called on the simulation thread only.
+	/// @param tick_rate	steps per second.
+	void Start(
+		const SimulationState& initial_state,
+		SimulationStep         step,
+		uint32_t               tick_rate = 120);
+
+	/// Join the thread, Sample keeps returning the last state.
+	void Stop();
+
+	/// Any thread. Actions the next steps run with, bits of InputActionBit.
+	void SetHeldActions(uint32_t held_actions);
+
+	/// Reader thread only (a single one). State at the time, interpolated between the last two ticks.
+	/// @param time		SDL_GetPerformanceCounter ticks.
+	[[nodiscard]] SimulationState Sample(uint64_t time);
+
+private:
+	/// Last two states, the current one reached at the time (SDL_GetPerformanceCounter ticks).
+	struct Snapshot
+	{
+		SimulationState previous = {};
+		SimulationState current  = {};
+		uint64_t        time     = 0;
+	};
+
+	void Run(std::stop_token stop_token);
+
+	SimulationStep        step_         = {};
+	uint64_t              step_ticks_   = 1;
+	float                 step_seconds_ = 0.0f;
+	SimulationState       state_        = {}; // Simulation thread only once started.
+	std::atomic<uint32_t> held_actions_ = 0;
+
+	TripleBuffer<Snapshot> snapshots_ = {};
+	std::jthread           thread_    = {};
+};
+
+#endif //SIMULATION_H
@@ -0,0 +1,97 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef SKINNER_H
+#define SKINNER_H
+
+#include <volk/volk.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// GPU skinning as a compute pre-pass: the bind pose is kept in storage buffers and skinned into the vertex
+/// streams every frame (skinning.comp), so the graphics pipelines and the depth pre-pass are unchanged.
+///
+/// Usage (per frame):
+///		BeginFrame()				after the fence of the previous frame was waited.
+///		UpdatePalette(matrices)		after the fence of the previous frame was waited.
+///		Record(cmd)					outside of any render pass, before the draws reading the vertex streams.
+class Skinner
+{
+public:
+	/// @param shader_code		SPIR-V of skinning.comp.
+	void Init(
+		VkDevice                  device,
+		VkPhysicalDevice          gpu,
+		VkAllocationCallbacks*    p_allocator,
+		std::span<const uint32_t> shader_code);
+
+	void Destroy();
+
+	/// Build a pipeline from new SPIR-V of skinning.comp (shader hot reload). Any thread, only reads the state
+	/// fixed at Init.
+	[[nodiscard]] VkPipeline CreatePipeline(std::span<const uint32_t> shader_code) const;
+
+	/// Record with a pipeline of CreatePipeline from now on, the current one is retired.
+	void SetPipeline(VkPipeline pipeline);
+
+	/// Destroy the pipelines replaced before the previous frame.
+	/// @warning	The fence of the previous frame must have been waited.
+	void BeginFrame();
+
+	/// Upload the bind pose and bind the output streams (storage usage required).
+	/// @param joints, weights		4 influences per vertex, the weights sum to 1.
+	void SetMesh(
+		std::span<const glm::vec3>  positions,
+		std::span<const glm::vec3>  normals,
+		std::span<const glm::uvec4> joints,
+		std::span<const glm::vec4>  weights,
+		uint32_t                    joint_count,
+		VkBuffer                    position_buffer,
+		VkBuffer                    normal_buffer);
+
+	/// Release the buffers created by SetMesh.
+	/// @warning	The device must be idle.
+	void ClearMesh();
+
+	/// Copy the skinning matrices used by the next Record, one per joint.
+	void UpdatePalette(std::span<const glm::mat4> palette);
+
+	/// Record the skinning and the barrier making the streams visible to the vertex input and compute stages.
+	void Record(VkCommandBuffer command_buffer) const;
+
+private:
+	VkDevice               device_    = {};
+	VkPhysicalDevice       gpu_       = {};
+	VkAllocationCallbacks* allocator_ = {};
+
+	VkDescriptorSetLayout descriptor_set_layout_ = {};
+	VkDescriptorPool      descriptor_pool_       = {};
+	VkDescriptorSet       descriptor_set_        = {};
+	VkPipelineLayout      pipeline_layout_       = {};
+	VkPipeline            pipeline_              = {};
+
+	/// Replaced pipelines, still bound by the frame in flight.
+	std::vector<VkPipeline> retired_ = {};
+
+	VkBuffer       bind_position_buffer_ = {};
+	VkDeviceMemory bind_position_memory_ = {};
+	VkBuffer       bind_normal_buffer_   = {};
+	VkDeviceMemory bind_normal_memory_   = {};
+	VkBuffer       joint_buffer_         = {};
+	VkDeviceMemory joint_memory_         = {};
+	VkBuffer       weight_buffer_        = {};
+	VkDeviceMemory weight_memory_        = {};
+	VkBuffer       palette_buffer_       = {};
+	VkDeviceMemory palette_memory_       = {};
+	glm::mat4*     palette_data_         = nullptr;
+	VkBuffer       position_buffer_      = {};
+	VkBuffer       normal_buffer_        = {};
+
+	uint32_t vertex_count_ = 0;
+	uint32_t joint_count_  = 0;
+};
+
+#endif //SKINNER_H
@@ -0,0 +1,79 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Fixed set of worker threads consuming a FIFO queue of tasks.
+///
+/// Usage:
+///		ThreadPool pool(4);
+///		std::future<int> result = pool.Submit([] { return 42; });
+class ThreadPool
+{
+public:
+	/// @param thread_count		0 picks std::thread::hardware_concurrency() - 1 (at least 1).
+	explicit ThreadPool(uint32_t thread_count = 0);
+
+	/// Run the tasks left in the queue, then join the workers.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// Queue a task, exceptions thrown by it are rethrown by the future.
+	template <typename F>
+	[[nodiscard]] std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F&& task)
+	{
+		using Result = std::invoke_result_t<std::decay_t<F>>;
+
+		// std::function needs a copyable callable, the packaged task is shared.
+		auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+		std::future<Result> future = packaged_task->get_future();
+
+		Enqueue([packaged_task]
+		{
+			(*packaged_task)();
+		});
+
+		return future;
+	}
+
+	/// Run task(0) to task(count - 1) and return once they are all done: 0 on the calling thread, the others on
+	/// the workers. The tasks may reference the caller's state, nothing is rethrown before every task has finished,
+	/// then the first exception is (the calling thread's first, then in index order).
+	/// @param thread_pool	optional, every task runs on the calling thread without it.
+	/// @warning	Don't call it from a worker of the same pool with every worker busy, the tasks would never start.
+	static void ParallelFor(
+		ThreadPool*                              thread_pool,
+		size_t                                   count,
+		const std::function<void(size_t index)>& task);
+
+	[[nodiscard]] uint32_t GetThreadCount() const;
+
+private:
+	void Enqueue(std::function<void()> task);
+
+	void WorkerLoop();
+
+	std::vector<std::thread>          workers_   = {};
+	std::deque<std::function<void()>> tasks_     = {};
+	std::mutex                        mutex_     = {};
+	std::condition_variable           condition_ = {};
+	bool                              stopping_  = false;
+};
+
+#endif //THREAD_POOL_H
@@ -7,10 +7,28 @@
 
 #include <volk/volk.h>
 #include <SDL2/SDL.h>
+#include <array>
+#include <functional>
+#include <future>
+#include <optional>
+#include <span>
 #include <vector>
 
+#include "Animation.h"
+#include "Bvh.h"
 #include "Graphics.h"
+#include "GpuProfiler.h"
+#include "Input.h"
+#include "PipelineManager.h"
+#include "Simulation.h"
+#include "FrameAllocator.h"
+#include "NormalGenerator.h"
+#include "ShaderWatcher.h"
+#include "Skinner.h"
+#include "ThreadPool.h"
+#include "vk_allocator.h"
 
+class GltfAsset;
 
 /// Groups of all scene vertex data.
 struct Batch
@@ -19,6 +37,15 @@ struct Batch
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec4> color;
 	std::vector<uint32_t>  indices;
+
+	/// One per source mesh. Empty means a single range covering the whole batch.
+	std::vector<Graphics::Submesh> submeshes;
+
+	/// Skinning, empty when the mesh has no bones: 4 joint indices and weights per vertex.
+	std::vector<glm::uvec4>    joints;
+	std::vector<glm::vec4>     weights;
+	Skeleton                   skeleton;
+	std::vector<AnimationClip> clips;
 };
 
 /// Packs all buffer and memory used for graphics.
@@ -37,28 +64,242 @@ struct BatchRender
 	VkDeviceMemory index_memory = {};
 };
 
+/// Init options, the defaults open the interactive window.
+struct VkAppSettings
+{
+	const char* mesh_path = "../Resources/Meshes/lucy.obj";
+
+	/// Render to a VK_EXT_headless_surface instead of a window (benchmarks, CI with a software driver).
+	bool headless = false;
+
+	/// Enable VK_LAYER_KHRONOS_validation and the debug messenger.
+	bool validation = true;
+
+	/// Regenerate the vertex normals on the GPU every frame (NormalGenerator), for deforming meshes.
+	bool compute_normals = false;
+
+	/// Write the triangle of every pixel into an R32_UINT attachment of the color pass, for VkApp::RequestGpuPick.
+	bool id_buffer = false;
+
+	/// Sample the camera again right before the submit, and with VK_KHR_present_wait start every frame once the
+	/// previous one is on screen instead of the frame limiter. See VkApp::GetLatencyMs.
+	bool low_latency = false;
+
+	/// Depth 1 on the near plane and 0 at infinity (infinite far plane), the float precision follows the
+	/// perspective: no z-fighting across the whole view distance. False is the [0, 1] projection up to far 10000.
+	bool reverse_z = true;
+
+	/// Swapchain extent used when the surface doesn't define one (headless).
+	uint32_t width  = 640;
+	uint32_t height = 480;
+};
+
+/// Closest triangle under the cursor, see VkApp::Pick.
+struct PickHit
+{
+	uint32_t  draw_call    = 0;
+	uint32_t  triangle     = 0;  // Index / 3 from the first index of the draw call.
+	glm::vec2 barycentrics = {}; // Weights of the second and third vertex, the first one is 1 - x - y.
+	glm::vec3 position     = {};
+	float     distance     = 0.0f; // From the near plane.
+};
+
+/// Triangle under a pixel of the id attachment, see VkApp::RequestGpuPick.
+struct GpuPickResult
+{
+	glm::vec2 view_position = {};
+	bool      hit           = false; // False when nothing was drawn under the pixel.
+	uint32_t  draw_call     = 0;
+	uint32_t  triangle      = 0; // Index / 3 from the first index of the draw call.
+	uint32_t  latency       = 0; // Frames from the request to the readback.
+};
+
+/// Compute shaders, hot reloaded along with the PipelineShader ones.
+enum class ComputeShader : uint32_t
+{
+	Normals  = 0, // normals.comp, NormalGenerator.
+	Skinning = 1, // skinning.comp, Skinner.
+};
+
+constexpr uint32_t compute_shader_count = 2;
+
+/// Result of a worker run after shader sources changed: SPIR-V indexed by PipelineShader, for the pipeline manager
+/// to rebuild from, and the compute pipelines already built from the ComputeShader sources (null if not rebuilt).
+struct ShaderReload
+{
+	std::array<std::vector<uint32_t>, pipeline_shader_count> code              = {};
+	std::array<bool, pipeline_shader_count>                  dirty             = {};
+	std::array<bool, compute_shader_count>                   compute_dirty     = {};
+	NormalGenerator::Pipelines                               normal_pipelines  = {};
+	VkPipeline                                               skinning_pipeline = VK_NULL_HANDLE;
+};
+
 class VkApp
 {
 public:
-	void Init();
+	void Init(const VkAppSettings& settings = {});
 
 	void Update();
 
-	void TearDown() const;
+	void TearDown();
+
+	/// Late camera update: receives the camera given to DrawFrame, writes the one to render.
+	using CameraSampler = std::function<void(glm::vec3* p_camera_pos, glm::vec3* p_camera_front)>;
+
+	/// Render and present a single frame, waiting for the previous one first.
+	/// @param sample_camera	optional, called after the fence wait and the acquire, right before the camera is
+	///							written, so the camera is as recent as the frame allows (input sampling point).
+	///							Called again right before the submit with VkAppSettings::low_latency.
+	/// @return false if the swapchain is out of date and must be recreated.
+	bool DrawFrame(
+		VkPipeline           chosen_pipeline,
+		const glm::vec3&     camera_pos,
+		const glm::vec3&     camera_front,
+		const CameraSampler& sample_camera = {});
+
+	/// Create the vertex and index buffers of the batch and one draw call per submesh.
+	/// Missing colors default to grey.
+	void UploadBatch(const Batch& batch);
+
+	/// Same as UploadBatch, the streams of the asset are written straight into the mapped buffers.
+	/// @warning	The data the asset was loaded from must still be mapped.
+	void UploadAsset(const GltfAsset& asset);
+
+	/// Cast the ray under the cursor through the camera of the last frame, against the triangles of every draw call
+	/// (scene BVH, then the triangle BVH of the draw calls it crosses). The skinned batch is never hit.
+	/// @param view_position	cursor over the view, from (0, 0) at the top left to (1, 1) at the bottom right.
+	/// @return false if no triangle is under the cursor, p_hit is untouched then.
+	bool Pick(
+		const glm::vec2& view_position,
+		PickHit*         p_hit) const;
+
+	/// Copy the id under the cursor at the end of the next frame, read back gpu_pick_latency frames later once that
+	/// frame's fence has been waited anyway, so it never stalls. Cost doesn't depend on the scene size, and the
+	/// skinned batch is hit as drawn. The last request before a frame wins.
+	/// @param view_position	cursor over the view, from (0, 0) at the top left to (1, 1) at the bottom right.
+	/// @warning	VkAppSettings::id_buffer must be set.
+	void RequestGpuPick(const glm::vec2& view_position);
+
+	/// Take the last result read back since the previous call.
+	/// @return false if no request has completed since then.
+	bool PollGpuPick(GpuPickResult* p_result);
+
+	/// Milliseconds from the camera latch of the last frame seen on screen to the return of its present wait, an
+	/// upper bound of the time to photon. 0 unless VkAppSettings::low_latency runs with VK_KHR_present_wait.
+	[[nodiscard]] double GetLatencyMs() const;
+
+	/// Destroy the buffers created by UploadBatch or UploadAsset.
+	/// @warning	The device must be idle.
+	void DestroyBatch();
+
+	[[nodiscard]] VkPipeline GetDefaultPipeline() const;
+
+	/// Frames between the copy of a GPU pick and its readback. At least the frames in flight, so the readback
+	/// buffer of a frame is only read after its fence has been waited.
+	static constexpr uint32_t gpu_pick_latency = 2;
 
 private:
-	VkAllocationCallbacks         allocator_          = {};
-	VkInstance                    instance_           = {};
-	VkDebugUtilsMessengerEXT      debug_messenger_    = {};
-	std::vector<VkPhysicalDevice> gpus_               = {};
-	VkPhysicalDevice              gpu_                = {};
-	VkDevice                      device_             = {};
-	VkQueue                       queue_              = {};
-	VkCommandPool                 command_pool_       = {};
-	VkCommandBuffer               command_buffer_     = {};
-	VkPipelineLayout              pipeline_layout_    = {};
-	VkPipeline                    pipeline_           = {};
-	VkPipeline                    pipeline_wireframe_ = {};
+	/// Host visible copy of the id of one pixel, one per frame of gpu_pick_latency.
+	struct GpuPickReadback
+	{
+		VkBuffer        buffer        = {};
+		VkDeviceMemory  memory        = {};
+		const uint32_t* mapped        = nullptr;
+		glm::vec2       view_position = {};
+		uint64_t        frame         = 0;
+		bool            pending       = false;
+	};
+
+	/// One leaf per draw call, the index of the draw call is the object, and the triangle BVH of every draw call.
+	void BuildSceneBvh(
+		std::span<const glm::vec3> positions,
+		std::span<const uint32_t>  indices);
+
+	/// Create a host visible buffer and fill it through its mapping, unmapped afterwards.
+	void CreateVertexStream(
+		size_t                            size,
+		VkBufferUsageFlags                usage,
+		const std::function<void(void*)>& write,
+		VkBuffer*                         p_buffer,
+		VkDeviceMemory*                   p_memory);
+
+	/// Fill an undefined surface extent with the drawable size of the window (or the settings extent when headless).
+	void ResolveSurfaceExtent();
+
+	/// Create the swapchain image views, the multisample color image, the depth-stencil image and the id images.
+	/// They all depend on the surface extent and must be rebuilt when the window is resized.
+	void CreateSizeDependentResources();
+
+	/// Create one framebuffer per swapchain image.
+	/// @warning	The render pass and the size-dependent resources must be valid.
+	void CreateFramebuffers();
+
+	/// Destroy everything created by CreateSizeDependentResources and CreateFramebuffers.
+	void DestroySizeDependentResources();
+
+	/// Rebuild the swapchain (passing the current one as old swapchain) and the size-dependent resources.
+	/// Render pass and pipelines are kept since the surface format doesn't change and viewport/scissor are dynamic.
+	/// @return false if the surface has a zero extent (e.g. the window is minimized), true otherwise.
+	bool RecreateSwapchain();
+
+	/// Between frames: hand the SPIR-V of a finished shader reload to the pipeline manager and swap in its compute
+	/// pipelines, or start one if a watched source changed. Then pick up the pipelines rebuilt by the manager.
+	void PollShaderReload();
+
+	/// Use the compute pipelines built by a reload, the current ones are retired until the frame in flight is done.
+	void SetComputePipelines(const ShaderReload& reload);
+
+	/// Advance the clip of the skinned batch and compute its palette on the workers.
+	void UpdateAnimation(float delta_time);
+
+	/// Pick the triangle under the window coordinates and print it, through the id buffer when it is enabled.
+	void PickAt(const glm::ivec2& cursor);
+
+	/// Read the GPU pick copied into the readback buffer of this frame gpu_pick_latency frames ago.
+	/// @warning	The fence of the previous frame must have been waited.
+	void ResolveGpuPick();
+
+	/// Copy the pixel of the pending GPU pick request from the id image into the readback buffer of this frame.
+	/// @warning	After the color pass.
+	void RecordGpuPick();
+
+	/// Write the camera into the uniform buffer of the swapchain image and keep its view projection for picking.
+	/// @return the view frustum of the camera.
+	Graphics::Frustum WriteCamera(
+		uint32_t         image_idx,
+		const glm::vec3& camera_pos,
+		const glm::vec3& camera_front);
+
+	/// Record the frame commands (depth pre-pass, color pass) targeting the given swapchain image.
+	/// @param frustum		draws outside of it are culled (static batches only).
+	void RecordCommandBuffer(
+		uint32_t                 image_idx,
+		VkPipeline               chosen_pipeline,
+		const glm::vec3&         camera_pos,
+		const glm::vec3&         camera_front,
+		const Graphics::Frustum& frustum);
+
+	VkAppSettings                 settings_        = {};
+	Gfx::Allocator                host_allocator_  = {};
+	VkAllocationCallbacks         allocator_       = {};
+	VkInstance                    instance_        = {};
+	VkDebugUtilsMessengerEXT      debug_messenger_ = {};
+	std::vector<VkPhysicalDevice> gpus_            = {};
+	VkPhysicalDevice              gpu_             = {};
+	VkDevice                      device_          = {};
+	VkQueue                       queue_           = {};
+	VkCommandPool                 command_pool_    = {};
+	VkCommandBuffer               command_buffer_  = {};
+	VkPipelineLayout              pipeline_layout_ = {};
+
+	/// Permutations of the shaders, compiled on the workers. The pipeline handles are refreshed between frames.
+	PipelineManager pipeline_manager_ = {};
+	VkPipeline      pipeline_         = {};
+
+	/// Depth-only pipeline (position stream only) and the color pipeline that shades with an equal depth test.
+	VkPipeline pipeline_depth_prepass_ = {};
+	VkPipeline pipeline_depth_equal_   = {};
+	bool       depth_prepass_enabled_  = true;
 
 	SDL_Window*    window_                    = {};
 	VkSurfaceKHR   surface_                   = {};
@@ -81,13 +322,81 @@ private:
 	VkImageView    framebuffer_sample_image_view_   = {};
 	VkDeviceMemory framebuffer_sample_image_memory_ = {};
 
-	VkImage        depth_stencil_image_      = {};
-	VkImageView    depth_stencil_image_view_ = {};
-	VkDeviceMemory depth_stencil_memory_     = {};
+	VkImage        depth_image_      = {};
+	VkImageView    depth_image_view_ = {};
+	VkDeviceMemory depth_memory_     = {};
+
+	/// Object ids (VkAppSettings::id_buffer): multisample attachment of the color pass, resolved into a single
+	/// sample image the picked pixel is copied from.
+	VkImage        id_sample_image_        = {};
+	VkImageView    id_sample_image_view_   = {};
+	VkDeviceMemory id_sample_image_memory_ = {};
+	VkImage        id_image_               = {};
+	VkImageView    id_image_view_          = {};
+	VkDeviceMemory id_image_memory_        = {};
 
 	VkSurfaceCapabilitiesKHR surface_capabilities_ = {};
+	VkSurfaceFormatKHR       surface_format_       = {};
+	VkSampleCountFlagBits    sample_counts_        = VK_SAMPLE_COUNT_1_BIT;
+	VkFormat                 depth_format_         = VK_FORMAT_UNDEFINED;
+
+	/// Swapchain images, fixed at Init: the per image resources are created and destroyed with it.
+	uint32_t swapchain_image_count_ = 0;
+
+	GpuProfiler gpu_profiler_ = {};
+	uint64_t    frame_index_  = 0;
+
+	/// Low latency (VK_KHR_present_wait): id of the last present, first id presented on the current swapchain, and
+	/// the camera latch time of the recent presents, indexed by id.
+	bool                    present_wait_               = false;
+	uint64_t                present_id_                 = 0;
+	uint64_t                swapchain_first_present_id_ = 1;
+	std::array<uint64_t, 4> latch_times_                = {};
+	double                  latency_ms_                 = 0.0;
+
+	/// Transient CPU memory of the frame being recorded.
+	FrameAllocator frame_allocator_ = {};
+
+	/// Background work (file reads, imports).
+	ThreadPool thread_pool_ = ThreadPool();
+
+	/// Keyboard and mouse actions, pumped at the start of the frame and again by the camera sampler.
+	Input input_ = {};
+
+	/// Camera motion at a fixed rate on its own thread, sampled and interpolated by the camera sampler.
+	Simulation simulation_ = {};
+
+	/// Shader hot reload, enabled when the GLSL sources can be watched (not in headless mode).
+	ShaderWatcher             shader_watcher_ = {};
+	std::future<ShaderReload> shader_reload_  = {};
+
+	/// Per frame normal regeneration of the batch (VkAppSettings::compute_normals).
+	NormalGenerator normal_generator_ = {};
+
+	/// Skinned batch: clips played on the CPU, palette skinned into the vertex streams by a compute pre-pass.
+	Skinner                    skinner_   = {};
+	bool                       skinning_  = false;
+	Skeleton                   skeleton_  = {};
+	std::vector<AnimationClip> clips_     = {};
+	AnimationInstance          animation_ = {};
+	std::vector<glm::mat4>     palette_   = {};
+
+	BatchRender                     batch_render_ = {};
+	std::vector<Graphics::DrawCall> draw_calls_   = {};
+
+	/// Bounds of the draw calls, queried with the view frustum every frame. The skinned batch moves out of its
+	/// bind pose bounds, it is not culled.
+	Bvh                   scene_bvh_          = {};
+	std::vector<uint32_t> visible_draw_calls_ = {};
+
+	/// Picking: triangles of every draw call, and the camera of the last frame.
+	std::vector<TriangleBvh> draw_call_bvhs_  = {};
+	glm::mat4                view_projection_ = glm::mat4(1.0f);
 
-	BatchRender batch_render_ = {};
+	/// GPU picking: the request for the next frame, the copies in flight and the last result read back.
+	std::optional<glm::vec2>                      gpu_pick_request_   = {};
+	std::array<GpuPickReadback, gpu_pick_latency> gpu_pick_readbacks_ = {};
+	std::optional<GpuPickResult>                  gpu_pick_result_    = {};
 };
 
 #endif //VKAPP_H
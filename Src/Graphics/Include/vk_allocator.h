@@ -7,12 +7,49 @@
 
 #include <volk/volk.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
 namespace Gfx
 {
-/// Example class of an allocator compatible with Vulkan.
+/// Host allocator compatible with Vulkan, routed by VkSystemAllocationScope:
+///		COMMAND						thread-local linear arena, rewound once all its allocations are freed.
+///		OBJECT						pooled size classes (64 B to 4 KiB), larger requests go to the heap.
+///		CACHE, DEVICE, INSTANCE		general heap.
+///
+/// Every allocation is preceded by a small header, so Free and Reallocation find the source without a lookup.
+///
+/// @warning	pUserData points to this instance: it must outlive every object created with its callbacks
+///				(keep it as a member next to the VkAllocationCallbacks, never a temporary).
 class Allocator
 {
 public:
+	static constexpr uint32_t scope_count = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+	struct ScopeStatistics
+	{
+		uint64_t allocation_count = 0;
+		uint64_t free_count       = 0;
+		uint64_t current_bytes    = 0;
+		uint64_t peak_bytes       = 0;
+	};
+
+	struct Statistics
+	{
+		ScopeStatistics scopes[scope_count] = {};
+	};
+
+	Allocator() = default;
+
+	~Allocator();
+
+	Allocator(const Allocator&) = delete;
+
+	Allocator& operator=(const Allocator&) = delete;
+
 	/// Operator that allows an instance of this class to be used as a
 	/// VkAllocationCallbacks structure
 	explicit inline operator VkAllocationCallbacks()
@@ -27,6 +64,12 @@ public:
 		};
 	}
 
+	/// Snapshot of the per-scope counters.
+	void QueryStatistics(Statistics* p_statistics) const;
+
+	/// Print the per-scope counters and the allocation rate since the previous call.
+	void PrintStatistics();
+
 private:
 	/// Declare the allocator callbacks as static member functions.
 
@@ -61,6 +104,34 @@ private:
 
 	void Free(
 		void* pMemory);
+
+	/// Pop a block of the given size class, carving a new chunk when the free list is empty.
+	void* PoolAcquire(uint32_t pool_idx);
+
+	void PoolRelease(
+		uint32_t pool_idx,
+		void*    p_block);
+
+	static constexpr uint32_t pool_count      = 7;
+	static constexpr size_t   pool_min_block  = 64;
+	static constexpr size_t   pool_chunk_size = 64 * 1024;
+
+	struct Pool
+	{
+		std::mutex         mutex     = {};
+		void*              free_list = nullptr;
+		std::vector<void*> chunks    = {};
+	};
+
+	Pool pools_[pool_count] = {};
+
+	std::atomic<uint64_t> allocation_count_[scope_count] = {};
+	std::atomic<uint64_t> free_count_[scope_count]       = {};
+	std::atomic<uint64_t> current_bytes_[scope_count]    = {};
+	std::atomic<uint64_t> peak_bytes_[scope_count]       = {};
+
+	std::chrono::steady_clock::time_point last_print_time_                     = {};
+	uint64_t                              last_allocation_count_[scope_count] = {};
 };
 }
 
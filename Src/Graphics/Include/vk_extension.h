@@ -0,0 +1,20 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef VK_EXTENSION_H
+#define VK_EXTENSION_H
+
+#include <volk/volk.h>
+
+namespace Gfx
+{
+/// Check whether the gpu exposes the given device extension.
+/// Used for optional extensions that are enabled only when available.
+void QueryDeviceExtensionSupport(
+	VkPhysicalDevice gpu,
+	const char*      extension_name,
+	bool*            p_supported);
+}
+
+#endif //VK_EXTENSION_H
@@ -0,0 +1,177 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Input.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+void Input::BindDefaults()
+{
+	Bind(SDL_SCANCODE_W, InputAction::MoveForward);
+	Bind(SDL_SCANCODE_S, InputAction::MoveBackward);
+	Bind(SDL_SCANCODE_A, InputAction::MoveLeft);
+	Bind(SDL_SCANCODE_D, InputAction::MoveRight);
+	Bind(SDL_SCANCODE_Q, InputAction::Wireframe);
+	Bind(SDL_SCANCODE_E, InputAction::Filled);
+	Bind(SDL_SCANCODE_P, InputAction::ToggleDepthPrepass);
+	Bind(SDL_SCANCODE_F12, InputAction::ExportTraces);
+
+	BindMouseButton(SDL_BUTTON_LEFT, InputAction::Pick);
+}
+
+void Input::Bind(
+	SDL_Scancode scancode,
+	InputAction  action)
+{
+	key_bindings_[scancode] = action;
+}
+
+void Input::BindMouseButton(
+	uint8_t     button,
+	InputAction action)
+{
+	button_bindings_[button] = action;
+}
+
+void Input::Pump()
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const uint64_t now       = SDL_GetPerformanceCounter();
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+	const uint32_t now_ms    = SDL_GetTicks();
+
+	SDL_Event event;
+
+	while (SDL_PollEvent(&event))
+	{
+		// SDL stamps the events in milliseconds of SDL_GetTicks, brought back to the performance counter. Events
+		// queued after now_ms was read are stamped now.
+		const int32_t  age_ms    = std::max(static_cast<int32_t>(now_ms - event.common.timestamp), 0);
+		const uint64_t timestamp = now - std::min(now, static_cast<uint64_t>(age_ms) * frequency / 1000);
+
+		switch (event.type)
+		{
+		case SDL_QUIT:
+			events_.push_back({
+				.type = InputEventType::Quit,
+				.timestamp = timestamp,
+			});
+			break;
+
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			if (event.key.repeat == 0)
+			{
+				const auto binding = key_bindings_.find(event.key.keysym.scancode);
+
+				if (binding != key_bindings_.end())
+				{
+					SetAction(
+						binding->second,
+						event.type == SDL_KEYDOWN,
+						timestamp,
+						{});
+				}
+			}
+			break;
+
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		{
+			const auto binding = button_bindings_.find(event.button.button);
+
+			if (binding != button_bindings_.end())
+			{
+				SetAction(
+					binding->second,
+					event.type == SDL_MOUSEBUTTONDOWN,
+					timestamp,
+					{event.button.x, event.button.y});
+			}
+			break;
+		}
+
+		case SDL_WINDOWEVENT:
+			if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+			{
+				events_.push_back({
+					.type = InputEventType::Resized,
+					.timestamp = timestamp,
+				});
+			}
+			break;
+
+		default:
+			// Do nothing.
+			break;
+		}
+	}
+
+	pump_timestamp_ = now;
+}
+
+std::span<const InputEvent> Input::GetEvents() const
+{
+	return events_;
+}
+
+void Input::ClearEvents()
+{
+	events_.clear();
+}
+
+bool Input::IsDown(InputAction action) const
+{
+	return held_[static_cast<uint32_t>(action)] > 0;
+}
+
+uint32_t Input::GetHeldActions() const
+{
+	uint32_t held_actions = 0;
+
+	for (uint32_t action = 0; action < input_action_count; action++)
+	{
+		if (held_[action] > 0)
+		{
+			held_actions |= InputActionBit(static_cast<InputAction>(action));
+		}
+	}
+
+	return held_actions;
+}
+
+uint64_t Input::GetPumpTimestamp() const
+{
+	return pump_timestamp_;
+}
+
+void Input::SetAction(
+	InputAction       action,
+	bool              down,
+	uint64_t          timestamp,
+	const glm::ivec2& cursor)
+{
+	uint32_t& held = held_[static_cast<uint32_t>(action)];
+
+	// A release without its press (held while the window got the focus) is dropped.
+	if (!down && held == 0)
+	{
+		return;
+	}
+
+	held = down
+		? held + 1
+		: held - 1;
+
+	events_.push_back({
+		.type = down
+			? InputEventType::Pressed
+			: InputEventType::Released,
+		.action = action,
+		.timestamp = timestamp,
+		.cursor = cursor,
+	});
+}
@@ -5,19 +5,546 @@
 #include "Mesh.h"
 
 #include <VkApp.h>
+#include "BatchBuilder.h"
+#include "GltfAsset.h"
+#include "MeshCodec.h"
+#include "ObjParser.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "../FileSystem.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
 #include <stdexcept>
-#include <assimp/cimport.h>        // Plain-C interface
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <assimp/Importer.hpp>     // C++ importer interface
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
 #include <assimp/scene.h>          // Output data structure
 #include <assimp/postprocess.h>    // Post processing flags
 
+namespace
+{
+/// Assimp matrices are row-major, glm's are column-major.
+glm::mat4 ToGlm(const aiMatrix4x4& matrix)
+{
+	glm::mat4 result = {};
+
+	for (uint32_t row = 0; row < 4; row++)
+	{
+		for (uint32_t column = 0; column < 4; column++)
+		{
+			result[column][row] = matrix[row][column];
+		}
+	}
+
+	return result;
+}
+
+/// Index of the last key at or before the tick, clamped to the key range.
+template <typename Key>
+uint32_t FindKey(
+	const Key* keys,
+	uint32_t   key_count,
+	double     tick)
+{
+	const Key* next = std::upper_bound(
+		keys,
+		keys + key_count,
+		tick,
+		[](double value, const Key& key) { return value < key.mTime; });
+
+	return (next == keys) ? 0 : static_cast<uint32_t>(next - keys - 1);
+}
+
+/// Linear interpolation of vector keys (positions, scalings).
+aiVector3D SampleKeys(
+	const aiVectorKey* keys,
+	uint32_t           key_count,
+	double             tick)
+{
+	const uint32_t key = FindKey(keys, key_count, tick);
+
+	if (key + 1 >= key_count)
+	{
+		return keys[key].mValue;
+	}
+
+	const double span   = keys[key + 1].mTime - keys[key].mTime;
+	const float  weight = (span > 0.0) ? static_cast<float>((tick - keys[key].mTime) / span) : 0.0f;
+
+	return keys[key].mValue + (keys[key + 1].mValue - keys[key].mValue) * std::clamp(weight, 0.0f, 1.0f);
+}
+
+aiQuaternion SampleKeys(
+	const aiQuatKey* keys,
+	uint32_t         key_count,
+	double           tick)
+{
+	const uint32_t key = FindKey(keys, key_count, tick);
+
+	if (key + 1 >= key_count)
+	{
+		return keys[key].mValue;
+	}
+
+	const double span   = keys[key + 1].mTime - keys[key].mTime;
+	const float  weight = (span > 0.0) ? static_cast<float>((tick - keys[key].mTime) / span) : 0.0f;
+
+	aiQuaternion result;
+	aiQuaternion::Interpolate(result, keys[key].mValue, keys[key + 1].mValue, std::clamp(weight, 0.0f, 1.0f));
+
+	return result.Normalize();
+}
+
+/// Write a joint transform in a frame of the clip samples (see AnimationClip).
+void StoreJoint(
+	AnimationClip*      clip,
+	uint32_t            frame,
+	uint32_t            joint,
+	const aiVector3D&   translation,
+	const aiQuaternion& rotation,
+	const aiVector3D&   scale)
+{
+	const uint32_t stride = GetJointStride(clip->joint_count);
+	float*         pose   = &clip->samples[static_cast<size_t>(frame) * pose_component_count * stride];
+
+	const float components[pose_component_count] = {
+		translation.x, translation.y, translation.z,
+		rotation.x, rotation.y, rotation.z, rotation.w,
+		scale.x, scale.y, scale.z,
+	};
+
+	for (uint32_t c = 0; c < pose_component_count; c++)
+	{
+		pose[c * stride + joint] = components[c];
+	}
+}
+
+/// Reorder the triangles of a submesh for a vertex cache of 16 entries (Tipsify, Sander et al. 2007): fan around the
+/// last emitted vertex, then jump to the recent vertex with the fewest triangles left. The index codec encodes
+/// a triangle sharing an edge or vertices with the previous ones in a byte or less.
+void OptimizeVertexCache(std::span<uint32_t> indices)
+{
+	constexpr int64_t cache_size = 16;
+
+	const size_t triangle_count = indices.size() / 3;
+	uint32_t     vertex_count   = 0;
+
+	for (const uint32_t index : indices)
+	{
+		vertex_count = std::max(vertex_count, index + 1);
+	}
+
+	// Triangles of every vertex (compressed adjacency) and how many are not emitted yet.
+	std::vector<uint32_t> live_count(vertex_count, 0);
+	std::vector<uint32_t> adjacency_offsets(static_cast<size_t>(vertex_count) + 1, 0);
+	std::vector<uint32_t> adjacency(indices.size());
+
+	for (const uint32_t index : indices)
+	{
+		live_count[index]++;
+	}
+
+	for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_count[vertex];
+	}
+
+	std::vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		adjacency[adjacency_fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int64_t>  cache_time(vertex_count, 0);
+	std::vector<bool>     emitted(triangle_count, false);
+	std::vector<uint32_t> dead_ends  = {};
+	std::vector<uint32_t> candidates = {};
+	std::vector<uint32_t> result     = {};
+
+	result.reserve(indices.size());
+
+	int64_t  time   = cache_size + 1;
+	uint32_t cursor = 0;
+	int64_t  fan    = (vertex_count > 0) ? 0 : -1;
+
+	while (fan >= 0)
+	{
+		candidates.clear();
+
+		for (uint32_t a = adjacency_offsets[fan]; a < adjacency_offsets[fan + 1]; a++)
+		{
+			const uint32_t triangle = adjacency[a];
+
+			if (emitted[triangle])
+			{
+				continue;
+			}
+
+			emitted[triangle] = true;
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const uint32_t vertex = indices[triangle * 3 + k];
+
+				result.push_back(vertex);
+				dead_ends.push_back(vertex);
+				candidates.push_back(vertex);
+				live_count[vertex]--;
+
+				if (time - cache_time[vertex] > cache_size)
+				{
+					cache_time[vertex] = time++;
+				}
+			}
+		}
+
+		// Next fan: the candidate still in the cache after its remaining triangles, the oldest one first.
+		fan = -1;
+
+		int64_t best_priority = -1;
+
+		for (const uint32_t vertex : candidates)
+		{
+			if (live_count[vertex] == 0)
+			{
+				continue;
+			}
+
+			const int64_t age      = time - cache_time[vertex];
+			const int64_t priority = (age + 2 * static_cast<int64_t>(live_count[vertex]) <= cache_size) ? age : 0;
+
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				fan           = vertex;
+			}
+		}
+
+		if (fan >= 0)
+		{
+			continue;
+		}
+
+		// Dead end: a recent vertex with triangles left, else the next one in index order.
+		while (!dead_ends.empty() && fan < 0)
+		{
+			const uint32_t vertex = dead_ends.back();
+			dead_ends.pop_back();
+
+			fan = (live_count[vertex] > 0) ? static_cast<int64_t>(vertex) : -1;
+		}
+
+		for (; fan < 0 && cursor < vertex_count; cursor++)
+		{
+			fan = (live_count[cursor] > 0) ? static_cast<int64_t>(cursor) : -1;
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+/// Index ranges the compressed streams are split on: the submeshes when they tile the index buffer in order,
+/// every range then has its own vertex numbering. Empty if they do not.
+std::vector<Graphics::Submesh> GetIndexRanges(
+	const std::vector<Graphics::Submesh>& submeshes,
+	size_t                                index_count)
+{
+	if (submeshes.empty())
+	{
+		return {{.index_count = static_cast<uint32_t>(index_count)}};
+	}
+
+	size_t index_total = 0;
+
+	for (const Graphics::Submesh& submesh : submeshes)
+	{
+		if (submesh.first_index != index_total || submesh.index_count % 3 != 0)
+		{
+			return {};
+		}
+
+		index_total += submesh.index_count;
+	}
+
+	return (index_total == index_count) ? submeshes : std::vector<Graphics::Submesh>{};
+}
+
+/// Renumber the vertices in the order of their first use in the triangles, which the index and vertex codecs
+/// rely on (small deltas between consecutive vertices, next-vertex codes). Every range keeps a contiguous
+/// vertex range. The arrays are left untouched if the ranges share vertices.
+void OrderVerticesByFirstUse(
+	std::vector<glm::vec3>&         positions,
+	std::vector<glm::vec3>&         normals,
+	std::vector<uint32_t>&          indices,
+	std::vector<Graphics::Submesh>& ranges)
+{
+	constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+	std::vector<uint32_t> remap(positions.size(), unused);
+	std::vector<uint32_t> ordered_indices(indices.size());
+	std::vector<int32_t>  vertex_offsets(ranges.size());
+	uint32_t              next = 0;
+
+	for (size_t r = 0; r < ranges.size(); r++)
+	{
+		const Graphics::Submesh& range = ranges[r];
+		const uint32_t           base  = next;
+
+		for (uint32_t i = range.first_index; i < range.first_index + range.index_count; i++)
+		{
+			const int64_t vertex = static_cast<int64_t>(range.vertex_offset) + indices[i];
+
+			if (vertex < 0 || vertex >= static_cast<int64_t>(positions.size()))
+			{
+				return;
+			}
+
+			uint32_t& target = remap[static_cast<size_t>(vertex)];
+
+			if (target == unused)
+			{
+				target = next++;
+			}
+			else if (target < base)
+			{
+				return;
+			}
+
+			ordered_indices[i] = target - base;
+		}
+
+		vertex_offsets[r] = static_cast<int32_t>(base);
+	}
+
+	// Vertices no triangle uses go last.
+	for (uint32_t& target : remap)
+	{
+		target = (target == unused) ? next++ : target;
+	}
+
+	std::vector<glm::vec3> ordered_positions(positions.size());
+	std::vector<glm::vec3> ordered_normals(normals.size());
+
+	for (size_t i = 0; i < remap.size(); i++)
+	{
+		ordered_positions[remap[i]] = positions[i];
+		ordered_normals[remap[i]]   = normals[i];
+	}
+
+	positions = std::move(ordered_positions);
+	normals   = std::move(ordered_normals);
+	indices   = std::move(ordered_indices);
+
+	for (size_t r = 0; r < ranges.size(); r++)
+	{
+		ranges[r].vertex_offset = vertex_offsets[r];
+	}
+}
+
+/// Decode the streams of a compressed vertex segment and dequantize them into the batch arrays.
+void DecodeCookedVertexSegment(
+	const CookedMeshHeader&    header,
+	std::span<const std::byte> position_stream,
+	std::span<const std::byte> normal_stream,
+	uint32_t                   count,
+	glm::vec3*                 p_positions,
+	glm::vec3*                 p_normals)
+{
+	// 16-bit x, y, z and a padding component.
+	std::vector<uint16_t> positions(static_cast<size_t>(count) * 4);
+	MeshCodec::DecodeVertexBuffer(std::as_writable_bytes(std::span(positions)), count, 8, position_stream);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint16_t* position = &positions[static_cast<size_t>(i) * 4];
+
+		p_positions[i] = header.position_min + glm::vec3(position[0], position[1], position[2]) * header.position_scale;
+	}
+
+	std::vector<int8_t> normals(static_cast<size_t>(count) * 4);
+	MeshCodec::DecodeVertexBuffer(std::as_writable_bytes(std::span(normals)), count, 4, normal_stream);
+	MeshCodec::DecodeFilter(MeshCodec::Filter::Octahedral, std::as_writable_bytes(std::span(normals)), count, 4);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const int8_t* normal = &normals[static_cast<size_t>(i) * 4];
+
+		p_normals[i] = glm::vec3(normal[0], normal[1], normal[2]) * (1.0f / 127.0f);
+	}
+}
+
+/// Read-only Assimp stream over a mapped file.
+class MappedIOStream final : public Assimp::IOStream
+{
+public:
+	explicit MappedIOStream(FileView&& file)
+		: file_(std::move(file))
+	{
+	}
+
+	size_t Read(
+		void*  p_buffer,
+		size_t size,
+		size_t count) override
+	{
+		if (size == 0)
+		{
+			return 0;
+		}
+
+		// Whole elements only, like fread.
+		const size_t read_count = std::min(count, (file_.GetSize() - position_) / size);
+
+		std::memcpy(p_buffer, file_.GetData() + position_, read_count * size);
+		position_ += read_count * size;
+
+		return read_count;
+	}
+
+	size_t Write(
+		const void* /*p_buffer*/,
+		size_t      /*size*/,
+		size_t      /*count*/) override
+	{
+		return 0;
+	}
+
+	aiReturn Seek(
+		size_t   offset,
+		aiOrigin origin) override
+	{
+		const size_t base = (origin == aiOrigin_CUR)
+			? position_
+			: (origin == aiOrigin_END)
+			? file_.GetSize()
+			: 0;
+
+		// aiOrigin_END seeks backward: the offset wraps around like a negative value.
+		const size_t position = base + offset;
+
+		if (position > file_.GetSize())
+		{
+			return aiReturn_FAILURE;
+		}
+
+		position_ = position;
+		return aiReturn_SUCCESS;
+	}
+
+	[[nodiscard]] size_t Tell() const override
+	{
+		return position_;
+	}
+
+	[[nodiscard]] size_t FileSize() const override
+	{
+		return file_.GetSize();
+	}
+
+	void Flush() override
+	{
+	}
+
+private:
+	FileView file_     = {};
+	size_t   position_ = 0;
+};
+
+/// Assimp file access through FileSystem::MapFile: the files an asset references (glTF buffers, OBJ materials)
+/// resolve next to it, in a mounted pack as well as on disk.
+class MappedIOSystem final : public Assimp::IOSystem
+{
+public:
+	bool Exists(const char* path) const override
+	{
+		return FileSystem::Exists(path);
+	}
+
+	[[nodiscard]] char getOsSeparator() const override
+	{
+		return '/';
+	}
+
+	Assimp::IOStream* Open(
+		const char* path,
+		const char* mode = "rb") override
+	{
+		// Read only.
+		if (std::string_view(mode).find_first_of("wa+") != std::string_view::npos)
+		{
+			return nullptr;
+		}
+
+		try
+		{
+			return new MappedIOStream(FileSystem::MapFile(path, FileSystem::AccessHint::Sequential));
+		}
+		catch (const std::runtime_error&)
+		{
+			// Missing reference: Assimp reports it, or skips it (materials).
+			return nullptr;
+		}
+	}
+
+	void Close(Assimp::IOStream* p_stream) override
+	{
+		delete p_stream;
+	}
+};
+}
+
 void Mesh::Load(const char* file_path, Batch* batch)
 {
-	const struct aiScene* scene = aiImportFile(
+	ADRO_PROFILE_SCOPE("Mesh::Load");
+
+	// Cooked files skip Assimp entirely.
+	if (std::string_view(file_path).ends_with(".amesh"))
+	{
+		LoadCooked(file_path, batch);
+		return;
+	}
+
+	// Plain triangle soups skip Assimp, single threaded here: LoadMany already runs one load per worker.
+	if (std::string_view(file_path).ends_with(".obj") && LoadObj(file_path, batch))
+	{
+		return;
+	}
+
+	if (std::string_view(file_path).ends_with(".glb") && LoadGltf(file_path, batch))
+	{
+		return;
+	}
+
+	Import(file_path, batch);
+}
+
+void Mesh::Import(const char* file_path, Batch* batch)
+{
+	ADRO_PROFILE_SCOPE("Mesh::Import");
+
+	// One importer per call: it owns the scene, and concurrent loads (LoadMany) don't share any state.
+	Assimp::Importer importer;
+
+	// Read by path through FileSystem, so the source and the files it references can come from a mounted pack as
+	// well as from loose files. The importer owns the IO system.
+	importer.SetIOHandler(new MappedIOSystem());
+
+	const aiScene* scene = importer.ReadFile(
 		file_path,
 		aiProcess_Triangulate |
 		aiProcess_JoinIdenticalVertices |
-		aiProcess_GenSmoothNormals);
+		aiProcess_GenSmoothNormals |
+		aiProcess_LimitBoneWeights);
 
 	if (!scene)
 	{
@@ -52,7 +579,504 @@ void Mesh::Load(const char* file_path, Batch* batch)
 		scene,
 		batch->indices);
 
-	aiReleaseImport(scene);
+	QuerySubmeshes(
+		scene,
+		batch->submeshes);
+
+	const bool skinned = std::any_of(
+		scene->mMeshes,
+		scene->mMeshes + scene->mNumMeshes,
+		[](const aiMesh* mesh) { return mesh->HasBones(); });
+
+	if (skinned)
+	{
+		QuerySkeleton(
+			scene,
+			&batch->skeleton);
+
+		QuerySkinWeights(
+			scene,
+			batch->skeleton,
+			batch->joints,
+			batch->weights);
+
+		QueryAnimations(
+			scene,
+			batch->skeleton,
+			batch->clips);
+	}
+}
+
+bool Mesh::LoadObj(
+	const char* file_path,
+	Batch*      batch,
+	ThreadPool* thread_pool)
+{
+	ADRO_PROFILE_SCOPE("Mesh::LoadObj");
+
+	const FileView file = FileSystem::MapFile(file_path, FileSystem::AccessHint::Sequential);
+
+	if (!ObjParser::Parse(std::span(file.GetData(), file.GetSize()), thread_pool, batch))
+	{
+		return false;
+	}
+
+	ApplyImportRotation(batch);
+
+	return true;
+}
+
+bool Mesh::LoadGltf(
+	const char* file_path,
+	Batch*      batch,
+	ThreadPool* thread_pool)
+{
+	ADRO_PROFILE_SCOPE("Mesh::LoadGltf");
+
+	const FileView file  = FileSystem::MapFile(file_path, FileSystem::AccessHint::Sequential);
+	GltfAsset      asset = {};
+
+	if (!asset.Load(std::span(file.GetData(), file.GetSize()), thread_pool))
+	{
+		return false;
+	}
+
+	const glm::mat3 rotation = GetImportRotation();
+
+	batch->position.resize(asset.GetVertexCount());
+	batch->normals.resize(asset.GetVertexCount());
+	batch->indices.resize(asset.GetIndexCount());
+
+	asset.WritePositions(batch->position, rotation);
+	asset.WriteNormals(batch->normals, rotation);
+	asset.WriteIndices(batch->indices);
+
+	batch->submeshes = asset.GetSubmeshes();
+
+	return true;
+}
+
+glm::mat3 Mesh::GetImportRotation()
+{
+	aiMatrix4x4 rotation;
+	aiMatrix4x4::RotationX(-AI_MATH_PI / 2, rotation);
+
+	return glm::mat3(ToGlm(rotation));
+}
+
+void Mesh::LoadMany(
+	ThreadPool*                  thread_pool,
+	std::span<const char* const> file_paths,
+	BatchBuilder*                builder,
+	std::vector<uint32_t>*       p_handles,
+	const LoadProgress&          progress)
+{
+	ADRO_PROFILE_SCOPE("Mesh::LoadMany");
+
+	// The tasks own their path and result, so nothing dangles if a merge throws while others still run.
+	std::vector<std::future<Batch>> loads = {};
+	loads.reserve(file_paths.size());
+
+	for (const char* file_path : file_paths)
+	{
+		loads.push_back(thread_pool->Submit([path = std::string(file_path)]
+		{
+			Batch batch = {};
+			Load(path.c_str(), &batch);
+
+			return batch;
+		}));
+	}
+
+	// Merged in the order of the paths, each batch is released as soon as it's in the arenas.
+	for (size_t i = 0; i < loads.size(); i++)
+	{
+		const uint32_t handle = builder->Append(loads[i].get());
+
+		if (p_handles)
+		{
+			p_handles->push_back(handle);
+		}
+
+		if (progress)
+		{
+			progress(static_cast<uint32_t>(i + 1), static_cast<uint32_t>(loads.size()));
+		}
+	}
+}
+
+void Mesh::Cook(
+	const char*           file_path,
+	const Batch&          batch,
+	CookedMeshCompression compression)
+{
+	ADRO_PROFILE_SCOPE("Mesh::Cook");
+
+	if (batch.normals.size() != batch.position.size())
+	{
+		throw std::runtime_error("Failed to cook mesh: positions and normals mismatch");
+	}
+
+	std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open cooked mesh");
+	}
+
+	CookedMeshHeader header = {
+		.vertex_count = static_cast<uint32_t>(batch.position.size()),
+		.index_count = static_cast<uint32_t>(batch.indices.size()),
+		.submesh_count = static_cast<uint32_t>(batch.submeshes.size()),
+		.compression = compression,
+	};
+
+	if (compression == CookedMeshCompression::None)
+	{
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(batch.position.data()),
+		           static_cast<std::streamsize>(sizeof(glm::vec3) * batch.position.size()));
+		file.write(reinterpret_cast<const char*>(batch.normals.data()),
+		           static_cast<std::streamsize>(sizeof(glm::vec3) * batch.normals.size()));
+		file.write(reinterpret_cast<const char*>(batch.indices.data()),
+		           static_cast<std::streamsize>(sizeof(uint32_t) * batch.indices.size()));
+		file.write(reinterpret_cast<const char*>(batch.submeshes.data()),
+		           static_cast<std::streamsize>(sizeof(Graphics::Submesh) * batch.submeshes.size()));
+	}
+	else
+	{
+		if (batch.indices.size() % 3 != 0)
+		{
+			throw std::runtime_error("Failed to cook mesh: compressed indices must be a triangle list");
+		}
+
+		std::vector<glm::vec3>         positions = batch.position;
+		std::vector<glm::vec3>         normals   = batch.normals;
+		std::vector<uint32_t>          indices   = batch.indices;
+		std::vector<Graphics::Submesh> submeshes = batch.submeshes;
+		std::vector<Graphics::Submesh> ranges    = GetIndexRanges(submeshes, indices.size());
+
+		// Triangles in vertex cache order then vertices in order of first use, what the codecs compress best.
+		if (!ranges.empty())
+		{
+			for (const Graphics::Submesh& range : ranges)
+			{
+				OptimizeVertexCache(std::span(indices).subspan(range.first_index, range.index_count));
+			}
+
+			OrderVerticesByFirstUse(positions, normals, indices, ranges);
+
+			if (!submeshes.empty())
+			{
+				submeshes = ranges;
+			}
+		}
+		else
+		{
+			ranges = {{.index_count = static_cast<uint32_t>(indices.size())}};
+		}
+
+		// Positions are quantized to 16 bits per axis in the bounds of the mesh.
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		for (const glm::vec3& position : positions)
+		{
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+
+		if (positions.empty())
+		{
+			min = max = glm::vec3(0.0f);
+		}
+
+		header.position_min   = min;
+		header.position_scale = (max - min) * (1.0f / 65535.0f);
+
+		glm::vec3 inverse_scale = {};
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			inverse_scale[axis] = (header.position_scale[axis] > 0.0f) ? 1.0f / header.position_scale[axis] : 0.0f;
+		}
+
+		std::vector<CookedIndexSegment>     index_segments  = {};
+		std::vector<CookedVertexSegment>    vertex_segments = {};
+		std::vector<std::vector<std::byte>> streams         = {};
+
+		// Ranges split in segments of segment_size triangles. The codec numbers new vertices from 0: a segment
+		// starting inside a range is rebased on the first vertex its range has not used yet.
+		for (const Graphics::Submesh& range : ranges)
+		{
+			const size_t range_end = static_cast<size_t>(range.first_index) + range.index_count;
+			uint32_t     next      = 0;
+
+			for (size_t first = range.first_index; first < range_end; first += CookedMeshHeader::segment_size * 3)
+			{
+				const size_t count = std::min<size_t>(CookedMeshHeader::segment_size * 3, range_end - first);
+
+				const uint32_t base = next;
+
+				std::vector<uint32_t> rebased(indices.begin() + first, indices.begin() + first + count);
+
+				for (uint32_t& index : rebased)
+				{
+					next   = std::max(next, index + 1);
+					index -= base;
+				}
+
+				streams.push_back(MeshCodec::EncodeIndexBuffer(rebased));
+
+				index_segments.push_back({
+					.stream_size = static_cast<uint32_t>(streams.back().size()),
+					.index_count = static_cast<uint32_t>(count),
+					.base = base,
+				});
+			}
+		}
+
+		// Vertex segments: the position then the normal stream.
+		for (uint32_t first = 0; first < header.vertex_count; first += CookedMeshHeader::segment_size)
+		{
+			const uint32_t count = std::min(CookedMeshHeader::segment_size, header.vertex_count - first);
+
+			// 16-bit x, y, z and a padding component, the vertex codec needs a multiple of 4 bytes.
+			std::vector<uint16_t> quantized_positions(static_cast<size_t>(count) * 4);
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const glm::vec3 quantized = (positions[first + i] - min) * inverse_scale;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					quantized_positions[static_cast<size_t>(i) * 4 + axis] =
+						static_cast<uint16_t>(std::clamp(quantized[axis] + 0.5f, 0.0f, 65535.0f));
+				}
+			}
+
+			std::vector<std::byte> encoded_normals(static_cast<size_t>(count) * 4);
+			MeshCodec::EncodeOctahedral(std::span(normals).subspan(first, count), encoded_normals);
+
+			streams.push_back(
+				MeshCodec::EncodeVertexBuffer(std::as_bytes(std::span(quantized_positions)), count, 8));
+			streams.push_back(MeshCodec::EncodeVertexBuffer(encoded_normals, count, 4));
+
+			vertex_segments.push_back({
+				.position_stream_size = static_cast<uint32_t>(streams[streams.size() - 2].size()),
+				.normal_stream_size = static_cast<uint32_t>(streams.back().size()),
+			});
+		}
+
+		header.index_segment_count = static_cast<uint32_t>(index_segments.size());
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(index_segments.data()),
+		           static_cast<std::streamsize>(sizeof(CookedIndexSegment) * index_segments.size()));
+		file.write(reinterpret_cast<const char*>(vertex_segments.data()),
+		           static_cast<std::streamsize>(sizeof(CookedVertexSegment) * vertex_segments.size()));
+
+		for (const std::vector<std::byte>& stream : streams)
+		{
+			file.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+		}
+
+		file.write(reinterpret_cast<const char*>(submeshes.data()),
+		           static_cast<std::streamsize>(sizeof(Graphics::Submesh) * submeshes.size()));
+	}
+
+	if (!file)
+	{
+		throw std::runtime_error("Failed to write cooked mesh");
+	}
+}
+
+void Mesh::LoadCooked(
+	const char* file_path,
+	Batch*      batch,
+	ThreadPool* thread_pool)
+{
+	ADRO_PROFILE_SCOPE("Mesh::LoadCooked");
+
+	// Mapped: the arrays are copied straight from the page cache, no stream buffering.
+	const FileView file = FileSystem::MapFile(file_path, FileSystem::AccessHint::Sequential);
+
+	CookedMeshHeader header = {};
+
+	if (file.GetSize() < sizeof(header))
+	{
+		throw std::runtime_error("Failed to load cooked mesh: invalid header");
+	}
+
+	std::memcpy(&header, file.GetData(), sizeof(header));
+
+	if (header.magic != CookedMeshHeader::magic_value ||
+	    header.version != CookedMeshHeader::version_value)
+	{
+		throw std::runtime_error("Failed to load cooked mesh: invalid header");
+	}
+
+	const size_t submeshes_size = sizeof(Graphics::Submesh) * header.submesh_count;
+
+	if (header.compression == CookedMeshCompression::None)
+	{
+		const size_t positions_size = sizeof(glm::vec3) * header.vertex_count;
+		const size_t normals_size   = sizeof(glm::vec3) * header.vertex_count;
+		const size_t indices_size   = sizeof(uint32_t) * header.index_count;
+
+		if (file.GetSize() != sizeof(header) + positions_size + normals_size + indices_size + submeshes_size)
+		{
+			throw std::runtime_error("Failed to load cooked mesh: truncated file");
+		}
+
+		// The arrays are copied as they are, no parsing or per-vertex conversion.
+		batch->position.resize(header.vertex_count);
+		batch->normals.resize(header.vertex_count);
+		batch->indices.resize(header.index_count);
+		batch->submeshes.resize(header.submesh_count);
+
+		const std::byte* data = file.GetData() + sizeof(header);
+
+		std::memcpy(batch->position.data(), data, positions_size);
+		std::memcpy(batch->normals.data(), data + positions_size, normals_size);
+		std::memcpy(batch->indices.data(), data + positions_size + normals_size, indices_size);
+		std::memcpy(batch->submeshes.data(), data + positions_size + normals_size + indices_size, submeshes_size);
+
+		return;
+	}
+
+	if (header.compression != CookedMeshCompression::Meshopt)
+	{
+		throw std::runtime_error("Failed to load cooked mesh: unsupported compression");
+	}
+
+	const uint32_t vertex_segment_count =
+		(header.vertex_count + CookedMeshHeader::segment_size - 1) / CookedMeshHeader::segment_size;
+
+	const size_t index_table_size  = sizeof(CookedIndexSegment) * header.index_segment_count;
+	const size_t vertex_table_size = sizeof(CookedVertexSegment) * vertex_segment_count;
+
+	if (file.GetSize() < sizeof(header) + index_table_size + vertex_table_size)
+	{
+		throw std::runtime_error("Failed to load cooked mesh: truncated file");
+	}
+
+	std::vector<CookedIndexSegment>  index_segments(header.index_segment_count);
+	std::vector<CookedVertexSegment> vertex_segments(vertex_segment_count);
+
+	std::memcpy(index_segments.data(), file.GetData() + sizeof(header), index_table_size);
+	std::memcpy(vertex_segments.data(), file.GetData() + sizeof(header) + index_table_size, vertex_table_size);
+
+	// Every stream is located and checked against the file before any decode starts.
+	std::vector<size_t> index_offsets(index_segments.size());
+	std::vector<size_t> first_indices(index_segments.size());
+	std::vector<size_t> vertex_offsets(vertex_segments.size());
+
+	size_t offset      = sizeof(header) + index_table_size + vertex_table_size;
+	size_t index_total = 0;
+
+	for (size_t i = 0; i < index_segments.size(); i++)
+	{
+		index_offsets[i] = offset;
+		first_indices[i] = index_total;
+		offset          += index_segments[i].stream_size;
+		index_total     += index_segments[i].index_count;
+	}
+
+	for (size_t i = 0; i < vertex_segments.size(); i++)
+	{
+		vertex_offsets[i] = offset;
+		offset           += static_cast<size_t>(vertex_segments[i].position_stream_size) +
+		                    vertex_segments[i].normal_stream_size;
+	}
+
+	if (file.GetSize() != offset + submeshes_size || index_total != header.index_count)
+	{
+		throw std::runtime_error("Failed to load cooked mesh: truncated file");
+	}
+
+	batch->position.resize(header.vertex_count);
+	batch->normals.resize(header.vertex_count);
+	batch->indices.resize(header.index_count);
+	batch->submeshes.resize(header.submesh_count);
+
+	std::memcpy(batch->submeshes.data(), file.GetData() + offset, submeshes_size);
+
+	const std::byte* data = file.GetData();
+
+	// One task per segment, the segments decode independently.
+	std::vector<std::function<void()>> decodes = {};
+
+	for (size_t segment = 0; segment < index_segments.size(); segment++)
+	{
+		decodes.emplace_back([&, segment]
+		{
+			const CookedIndexSegment& index_segment = index_segments[segment];
+			const std::span<uint32_t> indices       =
+				std::span(batch->indices).subspan(first_indices[segment], index_segment.index_count);
+
+			MeshCodec::DecodeIndexBuffer(
+				std::as_writable_bytes(indices),
+				index_segment.index_count,
+				sizeof(uint32_t),
+				std::span(data + index_offsets[segment], index_segment.stream_size));
+
+			if (index_segment.base != 0)
+			{
+				for (uint32_t& index : indices)
+				{
+					index += index_segment.base;
+				}
+			}
+		});
+	}
+
+	for (uint32_t segment = 0; segment < vertex_segment_count; segment++)
+	{
+		decodes.emplace_back([&, segment]
+		{
+			const CookedVertexSegment& vertex_segment = vertex_segments[segment];
+
+			const uint32_t first = segment * CookedMeshHeader::segment_size;
+			const uint32_t count = std::min(CookedMeshHeader::segment_size, header.vertex_count - first);
+
+			DecodeCookedVertexSegment(
+				header,
+				std::span(data + vertex_offsets[segment], vertex_segment.position_stream_size),
+				std::span(data + vertex_offsets[segment] + vertex_segment.position_stream_size,
+				          vertex_segment.normal_stream_size),
+				count,
+				&batch->position[first],
+				&batch->normals[first]);
+		});
+	}
+
+	ThreadPool::ParallelFor(
+		thread_pool,
+		decodes.size(),
+		[&](size_t i)
+		{
+			decodes[i]();
+		});
+}
+
+void Mesh::ApplyImportRotation(Batch* batch)
+{
+	// Same matrix and arithmetic as the Assimp queries, so both paths rotate identically.
+	aiMatrix4x4 rotation;
+	aiMatrix4x4::RotationX(-AI_MATH_PI / 2, rotation);
+
+	for (glm::vec3& position : batch->position)
+	{
+		const aiVector3D rotated = rotation * aiVector3D(position.x, position.y, position.z);
+		position = glm::vec3(rotated.x, rotated.y, rotated.z);
+	}
+
+	for (glm::vec3& normal : batch->normals)
+	{
+		const aiVector3D rotated = rotation * aiVector3D(normal.x, normal.y, normal.z);
+		normal = glm::vec3(rotated.x, rotated.y, rotated.z);
+	}
 }
 
 void Mesh::QueryVerticesCount(
@@ -115,14 +1139,263 @@ void Mesh::QueryIndices(
 	const aiScene*         scene,
 	std::vector<uint32_t>& indices)
 {
+	// Vertices of all the meshes are concatenated, the indices of a mesh start at its first vertex.
+	uint32_t first_vertex = 0;
+
 	for (size_t i = 0; i < scene->mNumMeshes; i++)
 	{
 		for (size_t j = 0; j < scene->mMeshes[i]->mNumFaces; j++)
 		{
 			const aiFace& face = scene->mMeshes[i]->mFaces[j];
-			indices.push_back(face.mIndices[0]);
-			indices.push_back(face.mIndices[1]);
-			indices.push_back(face.mIndices[2]);
+			indices.push_back(first_vertex + face.mIndices[0]);
+			indices.push_back(first_vertex + face.mIndices[1]);
+			indices.push_back(first_vertex + face.mIndices[2]);
+		}
+
+		first_vertex += scene->mMeshes[i]->mNumVertices;
+	}
+}
+
+void Mesh::QuerySubmeshes(
+	const aiScene*                  scene,
+	std::vector<Graphics::Submesh>& submeshes)
+{
+	uint32_t first_index = 0;
+
+	submeshes.reserve(scene->mNumMeshes);
+
+	for (size_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		const aiMesh* mesh = scene->mMeshes[i];
+
+		// Indices already include the first vertex, so all the ranges share the batch origin.
+		submeshes.push_back({
+			.first_index = first_index,
+			.index_count = mesh->mNumFaces * 3,
+			.vertex_offset = 0,
+			.material = mesh->mMaterialIndex,
+		});
+
+		first_index += mesh->mNumFaces * 3;
+	}
+}
+
+void Mesh::QuerySkeleton(
+	const aiScene* scene,
+	Skeleton*      skeleton)
+{
+	// Rotation of -90 degrees around X axis, applied to the bind pose by the other queries.
+	aiMatrix4x4 rotation;
+	aiMatrix4x4::RotationX(-AI_MATH_PI / 2, rotation);
+
+	aiMatrix4x4 inverse_rotation = rotation;
+	inverse_rotation.Inverse();
+
+	// The root node transform is part of the joint chain but not of the mesh space the offsets are given in.
+	aiMatrix4x4 inverse_root = scene->mRootNode->mTransformation;
+	inverse_root.Inverse();
+
+	skeleton->root_transform = ToGlm(rotation * inverse_root);
+
+	std::unordered_map<std::string, aiMatrix4x4> offsets = {};
+
+	for (size_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		for (size_t j = 0; j < scene->mMeshes[i]->mNumBones; j++)
+		{
+			const aiBone* bone = scene->mMeshes[i]->mBones[j];
+			offsets.try_emplace(bone->mName.C_Str(), bone->mOffsetMatrix);
+		}
+	}
+
+	// Depth first, so parents are stored before their children.
+	std::vector<std::pair<const aiNode*, int32_t>> stack = {{scene->mRootNode, -1}};
+
+	while (!stack.empty())
+	{
+		const auto [node, parent] = stack.back();
+		stack.pop_back();
+
+		const int32_t joint = static_cast<int32_t>(skeleton->parents.size());
+		const auto    offset = offsets.find(node->mName.C_Str());
+
+		skeleton->joint_names.emplace_back(node->mName.C_Str());
+		skeleton->parents.push_back(parent);
+
+		// Positions are stored rotated, the offsets expect them as imported.
+		skeleton->inverse_bind_matrices.push_back((offset != offsets.end())
+			? ToGlm(offset->second * inverse_rotation)
+			: glm::mat4(1.0f));
+
+		for (size_t i = node->mNumChildren; i > 0; i--)
+		{
+			stack.emplace_back(node->mChildren[i - 1], joint);
+		}
+	}
+}
+
+void Mesh::QuerySkinWeights(
+	const aiScene*           scene,
+	const Skeleton&          skeleton,
+	std::vector<glm::uvec4>& joints,
+	std::vector<glm::vec4>&  weights)
+{
+	std::unordered_map<std::string, uint32_t> joint_indices = {};
+
+	for (uint32_t joint = 0; joint < skeleton.GetJointCount(); joint++)
+	{
+		joint_indices.try_emplace(skeleton.joint_names[joint], joint);
+	}
+
+	uint32_t vertices_count = 0;
+	QueryVerticesCount(
+		scene,
+		&vertices_count);
+
+	joints.assign(vertices_count, glm::uvec4(0));
+	weights.assign(vertices_count, glm::vec4(0.0f));
+
+	uint32_t first_vertex = 0;
+
+	for (size_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		const aiMesh* mesh = scene->mMeshes[i];
+
+		for (size_t j = 0; j < mesh->mNumBones; j++)
+		{
+			const aiBone*  bone  = mesh->mBones[j];
+			const uint32_t joint = joint_indices.at(bone->mName.C_Str());
+
+			for (size_t k = 0; k < bone->mNumWeights; k++)
+			{
+				const aiVertexWeight& influence = bone->mWeights[k];
+				glm::vec4&            weight    = weights[first_vertex + influence.mVertexId];
+				glm::uvec4&           slots     = joints[first_vertex + influence.mVertexId];
+
+				// Replace the smallest slot, LimitBoneWeights already dropped all but 4 influences.
+				uint32_t slot = 0;
+				for (uint32_t s = 1; s < 4; s++)
+				{
+					slot = (weight[s] < weight[slot]) ? s : slot;
+				}
+
+				if (influence.mWeight > weight[slot])
+				{
+					weight[slot] = influence.mWeight;
+					slots[slot]  = joint;
+				}
+			}
+		}
+
+		first_vertex += mesh->mNumVertices;
+	}
+
+	for (size_t vertex = 0; vertex < weights.size(); vertex++)
+	{
+		const float sum = weights[vertex].x + weights[vertex].y + weights[vertex].z + weights[vertex].w;
+
+		// Vertices without influence follow the root joint.
+		weights[vertex] = (sum > 0.0f)
+			? weights[vertex] / sum
+			: glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+}
+
+void Mesh::QueryAnimations(
+	const aiScene*              scene,
+	const Skeleton&             skeleton,
+	std::vector<AnimationClip>& clips)
+{
+	const uint32_t joint_count = skeleton.GetJointCount();
+	const uint32_t stride      = GetJointStride(joint_count);
+
+	std::unordered_map<std::string, uint32_t> joint_indices = {};
+
+	for (uint32_t joint = 0; joint < joint_count; joint++)
+	{
+		joint_indices.try_emplace(skeleton.joint_names[joint], joint);
+	}
+
+	// Transforms of the joints without a channel, identity for the padding up to the stride.
+	std::vector<aiVector3D>   bind_translations(stride, aiVector3D(0.0f));
+	std::vector<aiQuaternion> bind_rotations(stride, aiQuaternion());
+	std::vector<aiVector3D>   bind_scales(stride, aiVector3D(1.0f));
+
+	for (uint32_t joint = 0; joint < joint_count; joint++)
+	{
+		const aiNode* node = scene->mRootNode->FindNode(skeleton.joint_names[joint].c_str());
+
+		node->mTransformation.Decompose(
+			bind_scales[joint],
+			bind_rotations[joint],
+			bind_translations[joint]);
+	}
+
+	clips.reserve(scene->mNumAnimations);
+
+	for (size_t i = 0; i < scene->mNumAnimations; i++)
+	{
+		const aiAnimation* animation = scene->mAnimations[i];
+
+		const double ticks_per_second = (animation->mTicksPerSecond > 0.0)
+			? animation->mTicksPerSecond
+			: 25.0;
+
+		AnimationClip clip = {
+			.name = animation->mName.C_Str(),
+			.duration = static_cast<float>(animation->mDuration / ticks_per_second),
+			.joint_count = joint_count,
+		};
+
+		clip.frame_count = static_cast<uint32_t>(std::ceil(clip.duration * clip.sample_rate)) + 1;
+		clip.samples.resize(static_cast<size_t>(clip.frame_count) * pose_component_count * stride);
+
+		for (uint32_t frame = 0; frame < clip.frame_count; frame++)
+		{
+			for (uint32_t joint = 0; joint < stride; joint++)
+			{
+				StoreJoint(
+					&clip,
+					frame,
+					joint,
+					bind_translations[joint],
+					bind_rotations[joint],
+					bind_scales[joint]);
+			}
 		}
+
+		for (size_t j = 0; j < animation->mNumChannels; j++)
+		{
+			const aiNodeAnim* channel = animation->mChannels[j];
+			const auto        joint   = joint_indices.find(channel->mNodeName.C_Str());
+
+			if (joint == joint_indices.end())
+			{
+				continue;
+			}
+
+			for (uint32_t frame = 0; frame < clip.frame_count; frame++)
+			{
+				const double tick = std::min(
+					static_cast<double>(frame) / clip.sample_rate * ticks_per_second,
+					animation->mDuration);
+
+				StoreJoint(
+					&clip,
+					frame,
+					joint->second,
+					(channel->mNumPositionKeys > 0)
+						? SampleKeys(channel->mPositionKeys, channel->mNumPositionKeys, tick)
+						: bind_translations[joint->second],
+					(channel->mNumRotationKeys > 0)
+						? SampleKeys(channel->mRotationKeys, channel->mNumRotationKeys, tick)
+						: bind_rotations[joint->second],
+					(channel->mNumScalingKeys > 0)
+						? SampleKeys(channel->mScalingKeys, channel->mNumScalingKeys, tick)
+						: bind_scales[joint->second]);
+			}
+		}
+
+		clips.push_back(std::move(clip));
 	}
-}
\ No newline at end of file
+}
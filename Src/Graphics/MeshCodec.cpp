@@ -0,0 +1,1263 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "MeshCodec.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ADRO_MESH_CODEC_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr uint8_t vertex_header   = 0xA0;
+constexpr uint8_t index_header    = 0xE0;
+constexpr uint8_t sequence_header = 0xD0;
+
+/// Bytes of a byte group, and the most a group can read (4 bits per byte: 8 packed bytes, 16 escaped ones).
+constexpr size_t byte_group_size         = 16;
+constexpr size_t byte_group_decode_limit = 24;
+
+/// Vertex blocks are at most 8 KiB (and 256 vertices), so a block stays in L1 while it is transposed.
+constexpr size_t vertex_block_size_bytes = 8192;
+constexpr size_t vertex_block_max_size   = 256;
+
+/// The first vertex trails the stream, padded so the group reads never need bounds checks.
+constexpr size_t vertex_tail_min_size = 32;
+
+/// Table of the triangle codes, stored at the end of the index stream (also the padding of its reads).
+constexpr size_t index_table_size = 16;
+
+/// Index sequences end with 4 zero bytes.
+constexpr size_t sequence_tail_size = 4;
+
+/// Code table written by the index encoder: the FIFO codes of b and c for the most frequent new triangles.
+constexpr uint8_t index_code_table[index_table_size] = {
+	0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xA9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00,
+};
+
+/// Rotations of a triangle, the encoder puts the shared edge or the next vertex first.
+constexpr uint32_t triangle_rotations[3][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}};
+
+uint32_t GetVertexBlockSize(uint32_t stride)
+{
+	const size_t block_size = (vertex_block_size_bytes / stride) & ~(byte_group_size - 1);
+
+	return static_cast<uint32_t>(std::min(block_size, vertex_block_max_size));
+}
+
+#ifndef ADRO_MESH_CODEC_SSE
+uint8_t Unzigzag8(uint8_t value)
+{
+	return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+}
+#endif
+
+uint8_t Zigzag8(uint8_t value)
+{
+	return static_cast<uint8_t>((static_cast<int8_t>(value) >> 7) ^ (value << 1));
+}
+
+/// Unpack a group of 16 bytes. Values equal to the all-ones sentinel are escaped: read whole after the packed bytes.
+const uint8_t* DecodeBytesGroup(
+	const uint8_t* data,
+	uint8_t*       p_buffer,
+	uint32_t       bits_log2)
+{
+#ifdef ADRO_MESH_CODEC_SSE
+	// Unpacked with shifts and masks, the escapes (rare on smooth data) are patched in afterwards.
+	__m128i  values   = _mm_setzero_si128();
+	uint32_t sentinel = 0;
+
+	switch (bits_log2)
+	{
+	case 0:
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p_buffer), values);
+		return data;
+
+	case 1:
+	{
+		// 4 values per byte, first value in the high bits.
+		int packed_bytes;
+		std::memcpy(&packed_bytes, data, sizeof(packed_bytes));
+
+		const __m128i packed = _mm_cvtsi32_si128(packed_bytes);
+		const __m128i mask   = _mm_set1_epi8(3);
+
+		const __m128i value0 = _mm_and_si128(_mm_srli_epi16(packed, 6), mask);
+		const __m128i value1 = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+		const __m128i value2 = _mm_and_si128(_mm_srli_epi16(packed, 2), mask);
+		const __m128i value3 = _mm_and_si128(packed, mask);
+
+		values   = _mm_unpacklo_epi16(_mm_unpacklo_epi8(value0, value1), _mm_unpacklo_epi8(value2, value3));
+		sentinel = 3;
+		data    += 4;
+		break;
+	}
+
+	case 2:
+	{
+		// 2 values per byte, first value in the high bits.
+		const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+		const __m128i mask   = _mm_set1_epi8(15);
+
+		values   = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), mask), _mm_and_si128(packed, mask));
+		sentinel = 15;
+		data    += 8;
+		break;
+	}
+
+	default:
+		std::memcpy(p_buffer, data, byte_group_size);
+		return data + byte_group_size;
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p_buffer), values);
+
+	uint32_t escapes = static_cast<uint32_t>(
+		_mm_movemask_epi8(_mm_cmpeq_epi8(values, _mm_set1_epi8(static_cast<char>(sentinel)))));
+
+	for (; escapes != 0; escapes &= escapes - 1)
+	{
+		p_buffer[std::countr_zero(escapes)] = *data++;
+	}
+
+	return data;
+#else
+	switch (bits_log2)
+	{
+	case 0:
+		std::memset(p_buffer, 0, byte_group_size);
+		return data;
+
+	case 1:
+	case 2:
+	{
+		const uint32_t bits     = 1u << bits_log2;
+		const uint32_t sentinel = (1u << bits) - 1;
+		const uint32_t per_byte = 8 / bits;
+		const uint8_t* data_var = data + byte_group_size / per_byte;
+
+		for (size_t i = 0; i < byte_group_size; i += per_byte)
+		{
+			uint32_t byte = *data++;
+
+			for (uint32_t k = 0; k < per_byte; k++)
+			{
+				// First value in the high bits.
+				const uint32_t encoded = (byte >> (8 - bits)) & sentinel;
+				byte <<= bits;
+
+				p_buffer[i + k] = (encoded == sentinel) ? *data_var : static_cast<uint8_t>(encoded);
+				data_var       += (encoded == sentinel);
+			}
+		}
+
+		return data_var;
+	}
+
+	default:
+		std::memcpy(p_buffer, data, byte_group_size);
+		return data + byte_group_size;
+	}
+#endif
+}
+
+/// Decode `size` bytes (a multiple of the group size): 2 header bits per group, then the groups.
+const uint8_t* DecodeBytes(
+	const uint8_t* data,
+	const uint8_t* data_end,
+	uint8_t*       p_buffer,
+	size_t         size)
+{
+	const size_t header_size = (size / byte_group_size + 3) / 4;
+
+	if (static_cast<size_t>(data_end - data) < header_size)
+	{
+		throw std::runtime_error("Failed to decode vertex buffer: truncated stream");
+	}
+
+	const uint8_t* header = data;
+	data += header_size;
+
+	for (size_t i = 0; i < size; i += byte_group_size)
+	{
+		if (static_cast<size_t>(data_end - data) < byte_group_decode_limit)
+		{
+			throw std::runtime_error("Failed to decode vertex buffer: truncated stream");
+		}
+
+		const size_t   group     = i / byte_group_size;
+		const uint32_t bits_log2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+
+		data = DecodeBytesGroup(data, p_buffer + i, bits_log2);
+	}
+
+	return data;
+}
+
+/// Decode the byte columns of a block, undo the deltas against the previous vertex and interleave them back.
+const uint8_t* DecodeVertexBlock(
+	const uint8_t* data,
+	const uint8_t* data_end,
+	uint8_t*       p_vertices,
+	uint32_t       count,
+	uint32_t       stride,
+	uint8_t*       p_last_vertex)
+{
+	uint8_t transposed[vertex_block_size_bytes];
+
+	const size_t count_aligned = (count + byte_group_size - 1) & ~(byte_group_size - 1);
+
+#ifdef ADRO_MESH_CODEC_SSE
+	// 4 columns at a time: 16 deltas per column are unzigzagged and prefix summed in a register, then the 4
+	// registers are interleaved into the 4-byte words of 16 vertices.
+	alignas(16) uint8_t buffer[4][vertex_block_max_size];
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one  = _mm_set1_epi8(1);
+	const __m128i low7 = _mm_set1_epi8(0x7F);
+
+	for (uint32_t k = 0; k < stride; k += 4)
+	{
+		uint8_t previous[4];
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			data        = DecodeBytes(data, data_end, buffer[c], count_aligned);
+			previous[c] = p_last_vertex[k + c];
+		}
+
+		for (uint32_t i = 0; i < count; i += byte_group_size)
+		{
+			__m128i columns[4];
+
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				const __m128i encoded = _mm_load_si128(reinterpret_cast<const __m128i*>(&buffer[c][i]));
+
+				__m128i value = _mm_xor_si128(
+					_mm_and_si128(_mm_srli_epi16(encoded, 1), low7),
+					_mm_sub_epi8(zero, _mm_and_si128(encoded, one)));
+
+				value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+				value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+				value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+				value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+				value = _mm_add_epi8(value, _mm_set1_epi8(static_cast<char>(previous[c])));
+
+				previous[c] = static_cast<uint8_t>(_mm_extract_epi16(value, 7) >> 8);
+				columns[c]  = value;
+			}
+
+			const __m128i low01  = _mm_unpacklo_epi8(columns[0], columns[1]);
+			const __m128i high01 = _mm_unpackhi_epi8(columns[0], columns[1]);
+			const __m128i low23  = _mm_unpacklo_epi8(columns[2], columns[3]);
+			const __m128i high23 = _mm_unpackhi_epi8(columns[2], columns[3]);
+
+			alignas(16) uint32_t words[byte_group_size];
+			_mm_store_si128(reinterpret_cast<__m128i*>(&words[0]), _mm_unpacklo_epi16(low01, low23));
+			_mm_store_si128(reinterpret_cast<__m128i*>(&words[4]), _mm_unpackhi_epi16(low01, low23));
+			_mm_store_si128(reinterpret_cast<__m128i*>(&words[8]), _mm_unpacklo_epi16(high01, high23));
+			_mm_store_si128(reinterpret_cast<__m128i*>(&words[12]), _mm_unpackhi_epi16(high01, high23));
+
+			const uint32_t group_count = std::min<uint32_t>(byte_group_size, count - i);
+
+			for (uint32_t j = 0; j < group_count; j++)
+			{
+				std::memcpy(&transposed[static_cast<size_t>(i + j) * stride + k], &words[j], 4);
+			}
+		}
+	}
+#else
+	uint8_t buffer[vertex_block_max_size];
+
+	for (uint32_t k = 0; k < stride; k++)
+	{
+		data = DecodeBytes(data, data_end, buffer, count_aligned);
+
+		uint8_t previous = p_last_vertex[k];
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint8_t value = static_cast<uint8_t>(Unzigzag8(buffer[i]) + previous);
+
+			transposed[static_cast<size_t>(i) * stride + k] = value;
+			previous = value;
+		}
+	}
+#endif
+
+	std::memcpy(p_vertices, transposed, static_cast<size_t>(count) * stride);
+	std::memcpy(p_last_vertex, &transposed[static_cast<size_t>(count - 1) * stride], stride);
+
+	return data;
+}
+
+/// Bytes of a group packed with `bits` per byte, SIZE_MAX if a byte does not fit in 0 bits.
+size_t MeasureBytesGroup(
+	const uint8_t* buffer,
+	uint32_t       bits)
+{
+	if (bits == 0)
+	{
+		return std::all_of(buffer, buffer + byte_group_size, [](uint8_t value) { return value == 0; })
+			? 0
+			: SIZE_MAX;
+	}
+
+	if (bits == 8)
+	{
+		return byte_group_size;
+	}
+
+	// Values at or above the sentinel are escaped, one more byte each.
+	const uint32_t sentinel = (1u << bits) - 1;
+
+	return byte_group_size * bits / 8 +
+	       std::count_if(buffer, buffer + byte_group_size, [&](uint8_t value) { return value >= sentinel; });
+}
+
+/// Inverse of DecodeBytesGroup.
+uint8_t* EncodeBytesGroup(
+	uint8_t*       p_data,
+	const uint8_t* buffer,
+	uint32_t       bits)
+{
+	if (bits == 0)
+	{
+		return p_data;
+	}
+
+	if (bits == 8)
+	{
+		std::memcpy(p_data, buffer, byte_group_size);
+		return p_data + byte_group_size;
+	}
+
+	const uint32_t sentinel = (1u << bits) - 1;
+	const uint32_t per_byte = 8 / bits;
+
+	for (size_t i = 0; i < byte_group_size; i += per_byte)
+	{
+		uint32_t byte = 0;
+
+		for (uint32_t k = 0; k < per_byte; k++)
+		{
+			byte = (byte << bits) | std::min<uint32_t>(buffer[i + k], sentinel);
+		}
+
+		*p_data++ = static_cast<uint8_t>(byte);
+	}
+
+	for (size_t i = 0; i < byte_group_size; i++)
+	{
+		if (buffer[i] >= sentinel)
+		{
+			*p_data++ = buffer[i];
+		}
+	}
+
+	return p_data;
+}
+
+/// Inverse of DecodeBytes, every group takes the smallest of the 4 bit counts.
+uint8_t* EncodeBytes(
+	uint8_t*       p_data,
+	const uint8_t* buffer,
+	size_t         size)
+{
+	const size_t header_size = (size / byte_group_size + 3) / 4;
+
+	uint8_t* header = p_data;
+	std::memset(header, 0, header_size);
+	p_data += header_size;
+
+	for (size_t i = 0; i < size; i += byte_group_size)
+	{
+		uint32_t best_log2 = 3;
+		size_t   best_size = byte_group_size;
+
+		for (uint32_t bits_log2 = 0; bits_log2 < 3; bits_log2++)
+		{
+			const uint32_t bits       = (bits_log2 == 0) ? 0 : (1u << bits_log2);
+			const size_t   group_size = MeasureBytesGroup(buffer + i, bits);
+
+			if (group_size < best_size)
+			{
+				best_log2 = bits_log2;
+				best_size = group_size;
+			}
+		}
+
+		const size_t group = i / byte_group_size;
+		header[group / 4] |= static_cast<uint8_t>(best_log2 << ((group % 4) * 2));
+
+		p_data = EncodeBytesGroup(p_data, buffer + i, (best_log2 == 0) ? 0 : (1u << best_log2));
+	}
+
+	return p_data;
+}
+
+/// Inverse of DecodeVertexBlock: one zigzag delta column per byte of the vertex.
+uint8_t* EncodeVertexBlock(
+	uint8_t*       p_data,
+	const uint8_t* vertices,
+	uint32_t       count,
+	uint32_t       stride,
+	uint8_t*       p_last_vertex)
+{
+	uint8_t buffer[vertex_block_max_size] = {};
+
+	const size_t count_aligned = (count + byte_group_size - 1) & ~(byte_group_size - 1);
+
+	for (uint32_t k = 0; k < stride; k++)
+	{
+		uint8_t previous = p_last_vertex[k];
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint8_t value = vertices[static_cast<size_t>(i) * stride + k];
+
+			buffer[i] = Zigzag8(static_cast<uint8_t>(value - previous));
+			previous  = value;
+		}
+
+		p_data = EncodeBytes(p_data, buffer, count_aligned);
+	}
+
+	std::memcpy(p_last_vertex, &vertices[static_cast<size_t>(count - 1) * stride], stride);
+
+	return p_data;
+}
+
+uint32_t DecodeVByte(const uint8_t*& data)
+{
+	const uint8_t lead = *data++;
+
+	if (lead < 128)
+	{
+		return lead;
+	}
+
+	// At most 4 more groups, so a malformed stream still terminates.
+	uint32_t result = lead & 127;
+	uint32_t shift  = 7;
+
+	for (int i = 0; i < 4; i++)
+	{
+		const uint8_t group = *data++;
+
+		result |= static_cast<uint32_t>(group & 127) << shift;
+		shift  += 7;
+
+		if (group < 128)
+		{
+			break;
+		}
+	}
+
+	return result;
+}
+
+/// Zigzag delta against the last free index.
+uint32_t DecodeIndex(
+	const uint8_t*& data,
+	uint32_t        last)
+{
+	const uint32_t value = DecodeVByte(data);
+
+	return last + ((value >> 1) ^ (0u - (value & 1)));
+}
+
+void EncodeVByte(
+	uint8_t*& p_data,
+	uint32_t  value)
+{
+	// 7 bits per byte, the high bit continues.
+	while (value >= 128)
+	{
+		*p_data++ = static_cast<uint8_t>((value & 127) | 128);
+		value   >>= 7;
+	}
+
+	*p_data++ = static_cast<uint8_t>(value);
+}
+
+void EncodeIndex(
+	uint8_t*& p_data,
+	uint32_t  index,
+	uint32_t  last)
+{
+	const uint32_t delta = index - last;
+
+	EncodeVByte(p_data, (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31));
+}
+
+void WriteIndex(
+	std::byte* p_destination,
+	size_t     position,
+	uint32_t   index_size,
+	uint32_t   index)
+{
+	if (index_size == 2)
+	{
+		const uint16_t index16 = static_cast<uint16_t>(index);
+		std::memcpy(p_destination + position * 2, &index16, 2);
+	}
+	else
+	{
+		std::memcpy(p_destination + position * 4, &index, 4);
+	}
+}
+
+/// FIFOs of the index codec, both 16 entries, read backwards from the last pushed entry.
+struct IndexFifos
+{
+	uint32_t vertices[16]  = {};
+	uint32_t edges[16][2]  = {};
+	size_t   vertex_offset = 0;
+	size_t   edge_offset   = 0;
+
+	IndexFifos()
+	{
+		std::memset(vertices, -1, sizeof(vertices));
+		std::memset(edges, -1, sizeof(edges));
+	}
+
+	void PushVertex(
+		uint32_t vertex,
+		bool     condition = true)
+	{
+		vertices[vertex_offset] = vertex;
+		vertex_offset = (vertex_offset + condition) & 15;
+	}
+
+	void PushEdge(
+		uint32_t a,
+		uint32_t b)
+	{
+		edges[edge_offset][0] = a;
+		edges[edge_offset][1] = b;
+		edge_offset = (edge_offset + 1) & 15;
+	}
+
+	/// Age of the most recent edge of the triangle (times 4, plus the rotation that puts it first), or -1.
+	[[nodiscard]] int FindEdge(
+		uint32_t a,
+		uint32_t b,
+		uint32_t c) const
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			const size_t   edge = (edge_offset - 1 - i) & 15;
+			const uint32_t e0   = edges[edge][0];
+			const uint32_t e1   = edges[edge][1];
+
+			if (e0 == a && e1 == b)
+			{
+				return (i << 2) | 0;
+			}
+
+			if (e0 == b && e1 == c)
+			{
+				return (i << 2) | 1;
+			}
+
+			if (e0 == c && e1 == a)
+			{
+				return (i << 2) | 2;
+			}
+		}
+
+		return -1;
+	}
+
+	/// Age of the vertex in the FIFO, or -1.
+	[[nodiscard]] int FindVertex(uint32_t vertex) const
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			if (vertices[(vertex_offset - 1 - i) & 15] == vertex)
+			{
+				return i;
+			}
+		}
+
+		return -1;
+	}
+};
+
+template <typename T>
+void DecodeOctahedral(
+	std::byte* p_data,
+	uint32_t   count)
+{
+	const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		T element[4];
+		std::memcpy(element, p_data + i * sizeof(element), sizeof(element));
+
+		// z is stored as the octahedron scale (1.0 at the same bit count) to rebuild it.
+		float x = static_cast<float>(element[0]);
+		float y = static_cast<float>(element[1]);
+		float z = static_cast<float>(element[2]) - std::fabs(x) - std::fabs(y);
+
+		// Lower hemisphere folded over the diagonals.
+		const float t = (z < 0.0f) ? z : 0.0f;
+		x += (x >= 0.0f) ? t : -t;
+		y += (y >= 0.0f) ? t : -t;
+
+		const float scale = max / std::sqrt(x * x + y * y + z * z);
+
+		element[0] = static_cast<T>(static_cast<int>(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+		element[1] = static_cast<T>(static_cast<int>(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+		element[2] = static_cast<T>(static_cast<int>(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+
+		std::memcpy(p_data + i * sizeof(element), element, sizeof(element));
+	}
+}
+
+void DecodeQuaternion(
+	std::byte* p_data,
+	uint32_t   count)
+{
+	const float scale = 1.0f / std::sqrt(2.0f);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		int16_t element[4];
+		std::memcpy(element, p_data + i * sizeof(element), sizeof(element));
+
+		// The last component stores the range of the 3 others (high bits) and the index of the dropped one.
+		const float range = scale / static_cast<float>(element[3] | 3);
+
+		const float x = static_cast<float>(element[0]) * range;
+		const float y = static_cast<float>(element[1]) * range;
+		const float z = static_cast<float>(element[2]) * range;
+
+		const float ww = 1.0f - x * x - y * y - z * z;
+		const float w  = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+		const int dropped = element[3] & 3;
+
+		const int16_t components[4] = {
+			static_cast<int16_t>(static_cast<int>(w * 32767.0f + 0.5f)),
+			static_cast<int16_t>(static_cast<int>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f))),
+			static_cast<int16_t>(static_cast<int>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f))),
+			static_cast<int16_t>(static_cast<int>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f))),
+		};
+
+		for (int c = 0; c < 4; c++)
+		{
+			element[(dropped + c) & 3] = components[c];
+		}
+
+		std::memcpy(p_data + i * sizeof(element), element, sizeof(element));
+	}
+}
+
+int8_t QuantizeSnorm8(float value)
+{
+	value = std::clamp(value, -1.0f, 1.0f) * 127.0f;
+
+	return static_cast<int8_t>(static_cast<int>(value + (value >= 0.0f ? 0.5f : -0.5f)));
+}
+
+void DecodeExponential(
+	std::byte* p_data,
+	size_t     count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t value;
+		std::memcpy(&value, p_data + i * 4, 4);
+
+		// 24-bit signed mantissa, 8-bit signed exponent: ldexp(mantissa, exponent) built from the exponent bits.
+		const int32_t mantissa = static_cast<int32_t>(value << 8) >> 8;
+		const int32_t exponent = static_cast<int32_t>(value) >> 24;
+
+		const float result = std::bit_cast<float>(static_cast<uint32_t>(exponent + 127) << 23) *
+		                     static_cast<float>(mantissa);
+
+		std::memcpy(p_data + i * 4, &result, 4);
+	}
+}
+}
+
+void MeshCodec::DecodeVertexBuffer(
+	std::span<std::byte>       destination,
+	uint32_t                   count,
+	uint32_t                   stride,
+	std::span<const std::byte> source)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (stride == 0 || stride > 256 || stride % 4 != 0 || destination.size() < static_cast<size_t>(count) * stride)
+	{
+		throw std::runtime_error("Failed to decode vertex buffer: invalid layout");
+	}
+
+	const uint8_t* data     = reinterpret_cast<const uint8_t*>(source.data());
+	const uint8_t* data_end = data + source.size();
+
+	if (source.size() < 1 + stride || (data[0] & 0xF0) != vertex_header || (data[0] & 0x0F) != 0)
+	{
+		throw std::runtime_error("Failed to decode vertex buffer: unsupported stream");
+	}
+
+	data++;
+
+	// Deltas of the first block start from the first vertex, stored in the tail.
+	uint8_t last_vertex[256];
+	std::memcpy(last_vertex, data_end - stride, stride);
+
+	const uint32_t block_size = GetVertexBlockSize(stride);
+	uint8_t*       vertices   = reinterpret_cast<uint8_t*>(destination.data());
+
+	for (uint32_t first = 0; first < count; first += block_size)
+	{
+		const uint32_t block_count = std::min(block_size, count - first);
+
+		data = DecodeVertexBlock(
+			data,
+			data_end,
+			vertices + static_cast<size_t>(first) * stride,
+			block_count,
+			stride,
+			last_vertex);
+	}
+
+	if (static_cast<size_t>(data_end - data) != std::max<size_t>(stride, vertex_tail_min_size))
+	{
+		throw std::runtime_error("Failed to decode vertex buffer: unexpected size");
+	}
+}
+
+void MeshCodec::DecodeIndexBuffer(
+	std::span<std::byte>       destination,
+	uint32_t                   count,
+	uint32_t                   index_size,
+	std::span<const std::byte> source)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (count % 3 != 0 || (index_size != 2 && index_size != 4) ||
+	    destination.size() < static_cast<size_t>(count) * index_size)
+	{
+		throw std::runtime_error("Failed to decode index buffer: invalid layout");
+	}
+
+	const uint8_t* buffer = reinterpret_cast<const uint8_t*>(source.data());
+
+	// Header, 1 code per triangle and the code table at least.
+	if (source.size() < 1 + count / 3 + index_table_size || (buffer[0] & 0xF0) != index_header ||
+	    (buffer[0] & 0x0F) > 1)
+	{
+		throw std::runtime_error("Failed to decode index buffer: unsupported stream");
+	}
+
+	const uint32_t version = buffer[0] & 0x0F;
+
+	// Version 1 uses the codes 13 and 14 for last - 1 and last + 1.
+	const uint32_t vertex_code_max = (version >= 1) ? 13 : 15;
+
+	const uint8_t* code          = buffer + 1;
+	const uint8_t* data          = code + count / 3;
+	const uint8_t* data_safe_end = buffer + source.size() - index_table_size;
+	const uint8_t* code_table    = data_safe_end;
+
+	IndexFifos fifos = {};
+	uint32_t   next  = 0;
+	uint32_t   last  = 0;
+
+	for (size_t i = 0; i < count; i += 3)
+	{
+		// A triangle reads at most 16 bytes (code byte and 3 varints), the table pads the last one.
+		if (data > data_safe_end)
+		{
+			throw std::runtime_error("Failed to decode index buffer: truncated stream");
+		}
+
+		const uint8_t triangle_code = *code++;
+
+		if (triangle_code < 0xF0)
+		{
+			// Shares an edge of a previous triangle, only the third vertex is coded.
+			const size_t   edge = (fifos.edge_offset - 1 - (triangle_code >> 4)) & 15;
+			const uint32_t a    = fifos.edges[edge][0];
+			const uint32_t b    = fifos.edges[edge][1];
+
+			const uint32_t vertex_code = triangle_code & 15;
+			uint32_t       c           = 0;
+
+			if (vertex_code < vertex_code_max)
+			{
+				c     = (vertex_code == 0) ? next : fifos.vertices[(fifos.vertex_offset - 1 - vertex_code) & 15];
+				next += (vertex_code == 0);
+
+				fifos.PushVertex(c, vertex_code == 0);
+			}
+			else
+			{
+				// 13 and 14 decode to -1 and +1.
+				c = (vertex_code != 15)
+					? last + (vertex_code - (vertex_code ^ 3))
+					: DecodeIndex(data, last);
+				last = c;
+
+				fifos.PushVertex(c);
+			}
+
+			WriteIndex(destination.data(), i + 0, index_size, a);
+			WriteIndex(destination.data(), i + 1, index_size, b);
+			WriteIndex(destination.data(), i + 2, index_size, c);
+
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+		}
+		else
+		{
+			// New triangle: a is next or free, b and c are next, in the vertex FIFO, or free.
+			const bool    table_code = triangle_code < 0xFE;
+			const uint8_t aux_code   = table_code ? code_table[triangle_code & 15] : *data++;
+
+			const uint32_t a_code = (table_code || triangle_code == 0xFE) ? 0 : 15;
+			const uint32_t b_code = aux_code >> 4;
+			const uint32_t c_code = aux_code & 15;
+
+			// Restart of the vertex numbering.
+			if (!table_code && aux_code == 0)
+			{
+				next = 0;
+			}
+
+			uint32_t a = (a_code == 0) ? next++ : 0;
+			uint32_t b = (b_code == 0) ? next++ : fifos.vertices[(fifos.vertex_offset - b_code) & 15];
+			uint32_t c = (c_code == 0) ? next++ : fifos.vertices[(fifos.vertex_offset - c_code) & 15];
+
+			if (a_code == 15)
+			{
+				last = a = DecodeIndex(data, last);
+			}
+
+			if (b_code == 15)
+			{
+				last = b = DecodeIndex(data, last);
+			}
+
+			if (c_code == 15)
+			{
+				last = c = DecodeIndex(data, last);
+			}
+
+			WriteIndex(destination.data(), i + 0, index_size, a);
+			WriteIndex(destination.data(), i + 1, index_size, b);
+			WriteIndex(destination.data(), i + 2, index_size, c);
+
+			fifos.PushVertex(a);
+			fifos.PushVertex(b, b_code == 0 || b_code == 15);
+			fifos.PushVertex(c, c_code == 0 || c_code == 15);
+
+			fifos.PushEdge(b, a);
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+		}
+	}
+
+	if (data != data_safe_end)
+	{
+		throw std::runtime_error("Failed to decode index buffer: unexpected size");
+	}
+}
+
+void MeshCodec::DecodeIndexSequence(
+	std::span<std::byte>       destination,
+	uint32_t                   count,
+	uint32_t                   index_size,
+	std::span<const std::byte> source)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if ((index_size != 2 && index_size != 4) || destination.size() < static_cast<size_t>(count) * index_size)
+	{
+		throw std::runtime_error("Failed to decode index sequence: invalid layout");
+	}
+
+	const uint8_t* buffer = reinterpret_cast<const uint8_t*>(source.data());
+
+	if (source.size() < 1 + static_cast<size_t>(count) + sequence_tail_size ||
+	    (buffer[0] & 0xF0) != sequence_header || (buffer[0] & 0x0F) > 1)
+	{
+		throw std::runtime_error("Failed to decode index sequence: unsupported stream");
+	}
+
+	const uint8_t* data          = buffer + 1;
+	const uint8_t* data_safe_end = buffer + source.size() - sequence_tail_size;
+
+	uint32_t last[2] = {};
+
+	for (size_t i = 0; i < count; i++)
+	{
+		// A varint reads at most 5 bytes, the tail pads the last one.
+		if (data >= data_safe_end)
+		{
+			throw std::runtime_error("Failed to decode index sequence: truncated stream");
+		}
+
+		// Low bit selects the baseline, then a zigzag delta against it.
+		const uint32_t value    = DecodeVByte(data);
+		const uint32_t baseline = value & 1;
+		const uint32_t delta    = value >> 1;
+		const uint32_t index    = last[baseline] + ((delta >> 1) ^ (0u - (delta & 1)));
+
+		last[baseline] = index;
+
+		WriteIndex(destination.data(), i, index_size, index);
+	}
+
+	if (data != data_safe_end)
+	{
+		throw std::runtime_error("Failed to decode index sequence: unexpected size");
+	}
+}
+
+void MeshCodec::DecodeFilter(
+	Filter               filter,
+	std::span<std::byte> data,
+	uint32_t             count,
+	uint32_t             stride)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (data.size() < static_cast<size_t>(count) * stride)
+	{
+		throw std::runtime_error("Failed to decode filter: invalid layout");
+	}
+
+	switch (filter)
+	{
+	case Filter::None:
+		break;
+
+	case Filter::Octahedral:
+		if (stride == 4)
+		{
+			DecodeOctahedral<int8_t>(data.data(), count);
+		}
+		else if (stride == 8)
+		{
+			DecodeOctahedral<int16_t>(data.data(), count);
+		}
+		else
+		{
+			throw std::runtime_error("Failed to decode filter: octahedral stride must be 4 or 8");
+		}
+		break;
+
+	case Filter::Quaternion:
+		if (stride != 8)
+		{
+			throw std::runtime_error("Failed to decode filter: quaternion stride must be 8");
+		}
+		DecodeQuaternion(data.data(), count);
+		break;
+
+	case Filter::Exponential:
+		if (stride % 4 != 0)
+		{
+			throw std::runtime_error("Failed to decode filter: exponential stride must be a multiple of 4");
+		}
+		DecodeExponential(data.data(), static_cast<size_t>(count) * stride / 4);
+		break;
+	}
+}
+
+std::vector<std::byte> MeshCodec::EncodeVertexBuffer(
+	std::span<const std::byte> vertices,
+	uint32_t                   count,
+	uint32_t                   stride)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (stride == 0 || stride > 256 || stride % 4 != 0 || vertices.size() < static_cast<size_t>(count) * stride)
+	{
+		throw std::runtime_error("Failed to encode vertex buffer: invalid layout");
+	}
+
+	const uint32_t block_size   = GetVertexBlockSize(stride);
+	const size_t   total_blocks = (static_cast<size_t>(count) + block_size - 1) / block_size;
+	const size_t   tail_size    = std::max<size_t>(stride, vertex_tail_min_size);
+
+	// Every column of a block is at most its deltas, the padding of the last group and the group header.
+	std::vector<std::byte> result(
+		1 + (static_cast<size_t>(count) + total_blocks * (byte_group_size + 4)) * stride + tail_size);
+
+	uint8_t* const begin = reinterpret_cast<uint8_t*>(result.data());
+	uint8_t*       data  = begin;
+
+	*data++ = vertex_header;
+
+	const uint8_t* source = reinterpret_cast<const uint8_t*>(vertices.data());
+
+	uint8_t first_vertex[256] = {};
+
+	if (count > 0)
+	{
+		std::memcpy(first_vertex, source, stride);
+	}
+
+	uint8_t last_vertex[256];
+	std::memcpy(last_vertex, first_vertex, stride);
+
+	for (uint32_t first = 0; first < count; first += block_size)
+	{
+		const uint32_t block_count = std::min(block_size, count - first);
+
+		data = EncodeVertexBlock(
+			data,
+			source + static_cast<size_t>(first) * stride,
+			block_count,
+			stride,
+			last_vertex);
+	}
+
+	std::memset(data, 0, tail_size - stride);
+	data += tail_size - stride;
+
+	std::memcpy(data, first_vertex, stride);
+	data += stride;
+
+	result.resize(static_cast<size_t>(data - begin));
+
+	return result;
+}
+
+std::vector<std::byte> MeshCodec::EncodeIndexBuffer(std::span<const uint32_t> indices)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (indices.size() % 3 != 0)
+	{
+		throw std::runtime_error("Failed to encode index buffer: not a triangle list");
+	}
+
+	const size_t triangle_count = indices.size() / 3;
+
+	// Header, a code per triangle, at most an aux byte and 3 varints per triangle, the code table.
+	std::vector<std::byte> result(1 + triangle_count * 17 + index_table_size);
+
+	uint8_t* const begin = reinterpret_cast<uint8_t*>(result.data());
+	uint8_t*       code  = begin + 1;
+	uint8_t*       data  = code + triangle_count;
+
+	begin[0] = index_header | 1;
+
+	constexpr uint32_t vertex_code_max = 13;
+
+	IndexFifos fifos = {};
+	uint32_t   next  = 0;
+	uint32_t   last  = 0;
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const int edge_code = fifos.FindEdge(indices[i + 0], indices[i + 1], indices[i + 2]);
+
+		if (edge_code >= 0 && (edge_code >> 2) < 15)
+		{
+			// Shares an edge of a previous triangle: rotated so the edge is a, b, only c is coded.
+			const uint32_t* rotation = triangle_rotations[edge_code & 3];
+
+			const uint32_t a = indices[i + rotation[0]];
+			const uint32_t b = indices[i + rotation[1]];
+			const uint32_t c = indices[i + rotation[2]];
+
+			const int vertex_age  = fifos.FindVertex(c);
+			uint32_t  vertex_code = 15;
+
+			if (vertex_age >= 1 && vertex_age < static_cast<int>(vertex_code_max))
+			{
+				vertex_code = static_cast<uint32_t>(vertex_age);
+			}
+			else if (c == next)
+			{
+				vertex_code = 0;
+				next++;
+			}
+			else if (c + 1 == last)
+			{
+				vertex_code = 13;
+			}
+			else if (c == last + 1)
+			{
+				vertex_code = 14;
+			}
+
+			*code++ = static_cast<uint8_t>(((edge_code >> 2) << 4) | vertex_code);
+
+			if (vertex_code == 15)
+			{
+				EncodeIndex(data, c, last);
+			}
+
+			if (vertex_code >= vertex_code_max)
+			{
+				last = c;
+			}
+
+			if (vertex_code == 0 || vertex_code >= vertex_code_max)
+			{
+				fifos.PushVertex(c);
+			}
+
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+		}
+		else
+		{
+			// New triangle, rotated so next comes first when it is one of the vertices.
+			const size_t    rotation_index = (indices[i + 1] == next) ? 1 : (indices[i + 2] == next) ? 2 : 0;
+			const uint32_t* rotation       = triangle_rotations[rotation_index];
+
+			const uint32_t a = indices[i + rotation[0]];
+			const uint32_t b = indices[i + rotation[1]];
+			const uint32_t c = indices[i + rotation[2]];
+
+			// Restart of the vertex numbering (concatenated meshes), signalled by an explicit aux code of 0.
+			const bool reset = a == 0 && b == 1 && c == 2 && next > 0;
+
+			if (reset)
+			{
+				next = 0;
+				std::memset(fifos.vertices, -1, sizeof(fifos.vertices));
+			}
+
+			const int b_age = fifos.FindVertex(b);
+			const int c_age = fifos.FindVertex(c);
+
+			const uint32_t a_code = (a == next) ? 0 : 15;
+			next += (a_code == 0);
+
+			uint32_t b_code = 15;
+
+			if (b_age >= 0 && b_age < 14)
+			{
+				b_code = static_cast<uint32_t>(b_age) + 1;
+			}
+			else if (b == next)
+			{
+				b_code = 0;
+				next++;
+			}
+
+			uint32_t c_code = 15;
+
+			if (c_age >= 0 && c_age < 14)
+			{
+				c_code = static_cast<uint32_t>(c_age) + 1;
+			}
+			else if (c == next)
+			{
+				c_code = 0;
+				next++;
+			}
+
+			const uint8_t  aux_code    = static_cast<uint8_t>((b_code << 4) | c_code);
+			const uint8_t* table_entry = std::find(index_code_table, index_code_table + 14, aux_code);
+
+			if (a_code == 0 && table_entry != index_code_table + 14 && !reset)
+			{
+				*code++ = static_cast<uint8_t>(0xF0 | (table_entry - index_code_table));
+			}
+			else
+			{
+				*code++ = static_cast<uint8_t>(0xFE + (a_code == 15));
+				*data++ = aux_code;
+			}
+
+			if (a_code == 15)
+			{
+				EncodeIndex(data, a, last);
+				last = a;
+			}
+
+			if (b_code == 15)
+			{
+				EncodeIndex(data, b, last);
+				last = b;
+			}
+
+			if (c_code == 15)
+			{
+				EncodeIndex(data, c, last);
+				last = c;
+			}
+
+			fifos.PushVertex(a);
+
+			if (b_code == 0 || b_code == 15)
+			{
+				fifos.PushVertex(b);
+			}
+
+			if (c_code == 0 || c_code == 15)
+			{
+				fifos.PushVertex(c);
+			}
+
+			fifos.PushEdge(b, a);
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+		}
+	}
+
+	std::memcpy(data, index_code_table, index_table_size);
+	data += index_table_size;
+
+	result.resize(static_cast<size_t>(data - begin));
+
+	return result;
+}
+
+void MeshCodec::EncodeOctahedral(
+	std::span<const glm::vec3> normals,
+	std::span<std::byte>       data)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (data.size() < normals.size() * 4)
+	{
+		throw std::runtime_error("Failed to encode octahedral normals: invalid layout");
+	}
+
+	for (size_t i = 0; i < normals.size(); i++)
+	{
+		const glm::vec3 normal = normals[i];
+
+		// Projected on the octahedron |x| + |y| + |z| = 1.
+		const float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+		const float scale  = (length == 0.0f) ? 0.0f : 1.0f / length;
+
+		const float x = normal.x * scale;
+		const float y = normal.y * scale;
+
+		// Lower hemisphere folded over the diagonals.
+		const float u = (normal.z >= 0.0f) ? x : (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		const float v = (normal.z >= 0.0f) ? y : (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+		// z holds the scale of the octahedron, 1.0 at the same bit count.
+		const int8_t element[4] = {QuantizeSnorm8(u), QuantizeSnorm8(v), 127, 0};
+
+		std::memcpy(data.data() + i * 4, element, sizeof(element));
+	}
+}
@@ -0,0 +1,628 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "NormalGenerator.h"
+#include "Profiler.h"
+#include "vk_buffer.h"
+#include "vk_shader_module.h"
+#include "vk_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ADRO_NORMALS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr uint32_t workgroup_size = 64;
+
+/// Groups per dispatch dimension guaranteed by the spec (maxComputeWorkGroupCount).
+constexpr uint32_t max_group_count = 65535;
+
+struct PushConstants
+{
+	uint32_t triangle_count = 0;
+	uint32_t vertex_count   = 0;
+};
+
+/// Host visible buffer filled with the given data, the size is at least 4 bytes (empty meshes).
+void CreateFilledBuffer(
+	VkDevice               device,
+	VkPhysicalDevice       gpu,
+	VkAllocationCallbacks* p_allocator,
+	const void*            data,
+	size_t                 size,
+	VkBuffer*              p_buffer,
+	VkDeviceMemory*        p_memory)
+{
+	Gfx::CreateBuffer(
+		device,
+		gpu,
+		std::max<size_t>(size, sizeof(uint32_t)),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		p_allocator,
+		p_buffer,
+		p_memory);
+
+	if (!data || size == 0)
+	{
+		return;
+	}
+
+	void* mapped = nullptr;
+	VK_CHECK(vkMapMemory(
+		device,
+		*p_memory,
+		0,
+		size,
+		0,
+		&mapped));
+
+	memcpy(mapped, data, size);
+
+	vkUnmapMemory(device, *p_memory);
+}
+
+/// First pass: area weighted normal of every triangle (the cross product of two edges).
+void ComputeFaceNormals(
+	std::span<const glm::vec3> positions,
+	std::span<const uint32_t>  indices,
+	std::span<glm::vec3>       face_normals)
+{
+	const size_t triangle_count = face_normals.size();
+	size_t       triangle       = 0;
+
+#ifdef ADRO_NORMALS_SSE
+	// 4 triangles at a time: positions are gathered into x/y/z lanes, the cross products run on the lanes.
+	for (; triangle + 4 <= triangle_count; triangle += 4)
+	{
+		const uint32_t* triangle_indices = &indices[triangle * 3];
+
+		const glm::vec3* p0[4];
+		const glm::vec3* p1[4];
+		const glm::vec3* p2[4];
+
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			p0[lane] = &positions[triangle_indices[lane * 3 + 0]];
+			p1[lane] = &positions[triangle_indices[lane * 3 + 1]];
+			p2[lane] = &positions[triangle_indices[lane * 3 + 2]];
+		}
+
+		const __m128 p0_x = _mm_setr_ps(p0[0]->x, p0[1]->x, p0[2]->x, p0[3]->x);
+		const __m128 p0_y = _mm_setr_ps(p0[0]->y, p0[1]->y, p0[2]->y, p0[3]->y);
+		const __m128 p0_z = _mm_setr_ps(p0[0]->z, p0[1]->z, p0[2]->z, p0[3]->z);
+
+		const __m128 e1_x = _mm_sub_ps(_mm_setr_ps(p1[0]->x, p1[1]->x, p1[2]->x, p1[3]->x), p0_x);
+		const __m128 e1_y = _mm_sub_ps(_mm_setr_ps(p1[0]->y, p1[1]->y, p1[2]->y, p1[3]->y), p0_y);
+		const __m128 e1_z = _mm_sub_ps(_mm_setr_ps(p1[0]->z, p1[1]->z, p1[2]->z, p1[3]->z), p0_z);
+
+		const __m128 e2_x = _mm_sub_ps(_mm_setr_ps(p2[0]->x, p2[1]->x, p2[2]->x, p2[3]->x), p0_x);
+		const __m128 e2_y = _mm_sub_ps(_mm_setr_ps(p2[0]->y, p2[1]->y, p2[2]->y, p2[3]->y), p0_y);
+		const __m128 e2_z = _mm_sub_ps(_mm_setr_ps(p2[0]->z, p2[1]->z, p2[2]->z, p2[3]->z), p0_z);
+
+		alignas(16) float normal_x[4];
+		alignas(16) float normal_y[4];
+		alignas(16) float normal_z[4];
+
+		_mm_store_ps(normal_x, _mm_sub_ps(_mm_mul_ps(e1_y, e2_z), _mm_mul_ps(e1_z, e2_y)));
+		_mm_store_ps(normal_y, _mm_sub_ps(_mm_mul_ps(e1_z, e2_x), _mm_mul_ps(e1_x, e2_z)));
+		_mm_store_ps(normal_z, _mm_sub_ps(_mm_mul_ps(e1_x, e2_y), _mm_mul_ps(e1_y, e2_x)));
+
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			face_normals[triangle + lane] = {normal_x[lane], normal_y[lane], normal_z[lane]};
+		}
+	}
+#endif
+
+	for (; triangle < triangle_count; triangle++)
+	{
+		const glm::vec3& p0 = positions[indices[triangle * 3 + 0]];
+		const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+		const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+		face_normals[triangle] = glm::cross(p1 - p0, p2 - p0);
+	}
+}
+}
+
+void NormalGenerator::BuildAdjacency(
+	std::span<const uint32_t> indices,
+	uint32_t                  vertex_count,
+	Adjacency*                p_adjacency)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	// Counting sort of the triangles by vertex: count, prefix sum, scatter.
+	p_adjacency->offsets.assign(vertex_count + 1, 0);
+	p_adjacency->triangles.resize(indices.size());
+
+	for (const uint32_t index : indices)
+	{
+		p_adjacency->offsets[index + 1]++;
+	}
+
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		p_adjacency->offsets[i + 1] += p_adjacency->offsets[i];
+	}
+
+	std::vector<uint32_t> cursors(p_adjacency->offsets.begin(), p_adjacency->offsets.end() - 1);
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		p_adjacency->triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+}
+
+void NormalGenerator::ComputeNormals(
+	std::span<const glm::vec3> positions,
+	std::span<const uint32_t>  indices,
+	const Adjacency&           adjacency,
+	std::span<glm::vec3>       normals)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	std::vector<glm::vec3> face_normals(indices.size() / 3);
+
+	ComputeFaceNormals(
+		positions,
+		indices,
+		face_normals);
+
+	// Second pass: gather, every vertex only writes its own normal.
+	for (size_t vertex = 0; vertex < normals.size(); vertex++)
+	{
+		glm::vec3 normal = {};
+
+		for (uint32_t i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++)
+		{
+			normal += face_normals[adjacency.triangles[i]];
+		}
+
+		const float length_squared = glm::dot(normal, normal);
+
+		normals[vertex] = (length_squared > 0.0f)
+			? normal / std::sqrt(length_squared)
+			: normal;
+	}
+}
+
+void NormalGenerator::Init(
+	VkDevice                  device,
+	VkPhysicalDevice          gpu,
+	VkAllocationCallbacks*    p_allocator,
+	std::span<const uint32_t> shader_code)
+{
+	device_    = device;
+	gpu_       = gpu;
+	allocator_ = p_allocator;
+
+	VkDescriptorSetLayoutBinding bindings[6] = {};
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = nullptr,
+		};
+	}
+
+	const VkDescriptorSetLayoutCreateInfo layout_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 6,
+		.pBindings = &bindings[0],
+	};
+
+	VK_CHECK(vkCreateDescriptorSetLayout(
+		device_,
+		&layout_info,
+		allocator_,
+		&descriptor_set_layout_));
+
+	const VkDescriptorPoolSize pool_size = {
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.descriptorCount = 6,
+	};
+
+	const VkDescriptorPoolCreateInfo pool_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.maxSets = 1,
+		.poolSizeCount = 1,
+		.pPoolSizes = &pool_size,
+	};
+
+	VK_CHECK(vkCreateDescriptorPool(
+		device_,
+		&pool_info,
+		allocator_,
+		&descriptor_pool_));
+
+	const VkDescriptorSetAllocateInfo set_allocate_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = descriptor_pool_,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &descriptor_set_layout_,
+	};
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		device_,
+		&set_allocate_info,
+		&descriptor_set_));
+
+	const VkPushConstantRange push_constant_range = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(PushConstants),
+	};
+
+	const VkPipelineLayoutCreateInfo pipeline_layout_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptor_set_layout_,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &push_constant_range,
+	};
+
+	VK_CHECK(vkCreatePipelineLayout(
+		device_,
+		&pipeline_layout_info,
+		allocator_,
+		&pipeline_layout_));
+
+	pipelines_ = CreatePipelines(shader_code);
+}
+
+void NormalGenerator::Destroy()
+{
+	ClearMesh();
+	BeginFrame();
+
+	vkDestroyPipeline(device_, pipelines_.face, allocator_);
+	vkDestroyPipeline(device_, pipelines_.vertex, allocator_);
+	vkDestroyPipelineLayout(device_, pipeline_layout_, allocator_);
+	vkDestroyDescriptorPool(device_, descriptor_pool_, allocator_);
+	vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, allocator_);
+
+	*this = {};
+}
+
+NormalGenerator::Pipelines NormalGenerator::CreatePipelines(std::span<const uint32_t> shader_code) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	VkShaderModule shader_module = {};
+	Gfx::CreateShaderModule(
+		device_,
+		static_cast<uint32_t>(shader_code.size() * sizeof(uint32_t)),
+		reinterpret_cast<const char*>(shader_code.data()),
+		allocator_,
+		&shader_module);
+
+	// Same module, the pass is a specialization constant.
+	const uint32_t passes[2] = {0, 1};
+
+	const VkSpecializationMapEntry specialization_entry = {
+		.constantID = 0,
+		.offset = 0,
+		.size = sizeof(uint32_t),
+	};
+
+	const VkSpecializationInfo specialization_infos[2] = {
+		{1, &specialization_entry, sizeof(uint32_t), &passes[0]},
+		{1, &specialization_entry, sizeof(uint32_t), &passes[1]},
+	};
+
+	VkComputePipelineCreateInfo pipeline_infos[2] = {};
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		pipeline_infos[i] = {
+			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.stage = {
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+				.module = shader_module,
+				.pName = "main",
+				.pSpecializationInfo = &specialization_infos[i],
+			},
+			.layout = pipeline_layout_,
+			.basePipelineHandle = VK_NULL_HANDLE,
+			.basePipelineIndex = -1,
+		};
+	}
+
+	VkPipeline pipelines[2] = {};
+
+	const VkResult result = vkCreateComputePipelines(
+		device_,
+		VK_NULL_HANDLE,
+		2,
+		&pipeline_infos[0],
+		allocator_,
+		&pipelines[0]);
+
+	vkDestroyShaderModule(device_, shader_module, allocator_);
+
+	// A failed batch can still hold the pipelines that were created.
+	if (result != VK_SUCCESS)
+	{
+		vkDestroyPipeline(device_, pipelines[0], allocator_);
+		vkDestroyPipeline(device_, pipelines[1], allocator_);
+	}
+
+	VK_CHECK(result);
+
+	return {
+		.face = pipelines[0],
+		.vertex = pipelines[1],
+	};
+}
+
+void NormalGenerator::SetPipelines(const Pipelines& pipelines)
+{
+	// Still bound by the frame in flight, destroyed by the BeginFrame after the next fence wait.
+	retired_.push_back(pipelines_.face);
+	retired_.push_back(pipelines_.vertex);
+
+	pipelines_ = pipelines;
+}
+
+void NormalGenerator::BeginFrame()
+{
+	for (VkPipeline pipeline : retired_)
+	{
+		vkDestroyPipeline(device_, pipeline, allocator_);
+	}
+
+	retired_.clear();
+}
+
+void NormalGenerator::SetMesh(
+	std::span<const uint32_t> indices,
+	uint32_t                  vertex_count,
+	VkBuffer                  position_buffer,
+	VkBuffer                  index_buffer,
+	VkBuffer                  normal_buffer)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	ClearMesh();
+
+	Adjacency adjacency = {};
+	BuildAdjacency(
+		indices,
+		vertex_count,
+		&adjacency);
+
+	triangle_count_ = static_cast<uint32_t>(indices.size() / 3);
+	vertex_count_   = vertex_count;
+	normal_buffer_  = normal_buffer;
+
+	// Written by the first pass only, no initial data.
+	CreateFilledBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		nullptr,
+		sizeof(glm::vec4) * triangle_count_,
+		&face_normal_buffer_,
+		&face_normal_memory_);
+
+	CreateFilledBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		adjacency.offsets.data(),
+		sizeof(uint32_t) * adjacency.offsets.size(),
+		&adjacency_offset_buffer_,
+		&adjacency_offset_memory_);
+
+	CreateFilledBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		adjacency.triangles.data(),
+		sizeof(uint32_t) * adjacency.triangles.size(),
+		&adjacency_triangle_buffer_,
+		&adjacency_triangle_memory_);
+
+	const VkDescriptorBufferInfo buffer_infos[6] = {
+		{position_buffer, 0, VK_WHOLE_SIZE},
+		{index_buffer, 0, VK_WHOLE_SIZE},
+		{face_normal_buffer_, 0, VK_WHOLE_SIZE},
+		{adjacency_offset_buffer_, 0, VK_WHOLE_SIZE},
+		{adjacency_triangle_buffer_, 0, VK_WHOLE_SIZE},
+		{normal_buffer, 0, VK_WHOLE_SIZE},
+	};
+
+	VkWriteDescriptorSet writes[6] = {};
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		writes[i] = {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = descriptor_set_,
+			.dstBinding = i,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.pBufferInfo = &buffer_infos[i],
+		};
+	}
+
+	vkUpdateDescriptorSets(
+		device_,
+		6,
+		&writes[0],
+		0,
+		nullptr);
+}
+
+void NormalGenerator::ClearMesh()
+{
+	vkDestroyBuffer(device_, face_normal_buffer_, allocator_);
+	vkFreeMemory(device_, face_normal_memory_, allocator_);
+
+	vkDestroyBuffer(device_, adjacency_offset_buffer_, allocator_);
+	vkFreeMemory(device_, adjacency_offset_memory_, allocator_);
+
+	vkDestroyBuffer(device_, adjacency_triangle_buffer_, allocator_);
+	vkFreeMemory(device_, adjacency_triangle_memory_, allocator_);
+
+	face_normal_buffer_        = VK_NULL_HANDLE;
+	face_normal_memory_        = VK_NULL_HANDLE;
+	adjacency_offset_buffer_   = VK_NULL_HANDLE;
+	adjacency_offset_memory_   = VK_NULL_HANDLE;
+	adjacency_triangle_buffer_ = VK_NULL_HANDLE;
+	adjacency_triangle_memory_ = VK_NULL_HANDLE;
+	normal_buffer_             = VK_NULL_HANDLE;
+	triangle_count_            = 0;
+	vertex_count_              = 0;
+}
+
+void NormalGenerator::Record(VkCommandBuffer command_buffer) const
+{
+	if (!normal_buffer_)
+	{
+		return;
+	}
+
+	const PushConstants push_constants = {
+		.triangle_count = triangle_count_,
+		.vertex_count = vertex_count_,
+	};
+
+	vkCmdBindDescriptorSets(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline_layout_,
+		0,
+		1,
+		&descriptor_set_,
+		0,
+		nullptr);
+
+	vkCmdPushConstants(
+		command_buffer,
+		pipeline_layout_,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(push_constants),
+		&push_constants);
+
+	// The previous frame read the normals as vertex attributes: wait for it before overwriting them.
+	const VkMemoryBarrier vertex_read_barrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = 0,
+		.dstAccessMask = 0,
+	};
+
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1,
+		&vertex_read_barrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
+	Dispatch(command_buffer, pipelines_.face, triangle_count_);
+
+	const VkBufferMemoryBarrier face_normal_barrier = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = face_normal_buffer_,
+		.offset = 0,
+		.size = VK_WHOLE_SIZE,
+	};
+
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		1,
+		&face_normal_barrier,
+		0,
+		nullptr);
+
+	Dispatch(command_buffer, pipelines_.vertex, vertex_count_);
+
+	const VkBufferMemoryBarrier normal_barrier = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = normal_buffer_,
+		.offset = 0,
+		.size = VK_WHOLE_SIZE,
+	};
+
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0,
+		0,
+		nullptr,
+		1,
+		&normal_barrier,
+		0,
+		nullptr);
+}
+
+void NormalGenerator::Dispatch(
+	VkCommandBuffer command_buffer,
+	VkPipeline      pipeline,
+	uint32_t        invocation_count) const
+{
+	if (invocation_count == 0)
+	{
+		return;
+	}
+
+	vkCmdBindPipeline(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline);
+
+	// Rows of max_group_count groups, the shader flattens the 2D id.
+	const uint32_t group_count   = (invocation_count + workgroup_size - 1) / workgroup_size;
+	const uint32_t group_count_x = std::min(group_count, max_group_count);
+	const uint32_t group_count_y = (group_count + group_count_x - 1) / group_count_x;
+
+	vkCmdDispatch(
+		command_buffer,
+		group_count_x,
+		group_count_y,
+		1);
+}
@@ -0,0 +1,535 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "ObjParser.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "VkApp.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ADRO_OBJ_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/// Smaller files are parsed by fewer threads, splitting costs more than it saves below this.
+constexpr size_t min_chunk_size = 256 * 1024;
+
+/// 0-based indices of a face corner, -1 when absent.
+struct Corner
+{
+	int32_t position = -1;
+	int32_t texcoord = -1;
+	int32_t normal   = -1;
+
+	bool operator==(const Corner& other) const = default;
+};
+
+/// Corner indices given as negative (relative) in the file are relative to the chunk until it is merged.
+enum CornerRelative : uint8_t
+{
+	CornerRelative_Position = 1 << 0,
+	CornerRelative_Texcoord = 1 << 1,
+	CornerRelative_Normal   = 1 << 2,
+};
+
+/// Statements of a range of lines.
+struct Chunk
+{
+	std::vector<glm::vec3> positions      = {};
+	std::vector<glm::vec3> normals        = {};
+	uint32_t               texcoord_count = 0;
+
+	/// 3 per triangle, with their CornerRelative bits.
+	std::vector<Corner>  corners  = {};
+	std::vector<uint8_t> relative = {};
+
+	bool supported = true;
+};
+
+/// Open addressing (linear probing) from corner to output vertex, grown at half load.
+class VertexTable
+{
+public:
+	explicit VertexTable(size_t expected_count)
+	{
+		slots_.resize(std::bit_ceil(std::max<size_t>(expected_count * 2, 16)));
+	}
+
+	/// @return the vertex of the corner, or inserts the given one.
+	uint32_t FindOrInsert(
+		const Corner& corner,
+		uint32_t      vertex)
+	{
+		if ((count_ + 1) * 2 > slots_.size())
+		{
+			Grow();
+		}
+
+		const size_t mask = slots_.size() - 1;
+
+		for (size_t slot = Hash(corner) & mask;; slot = (slot + 1) & mask)
+		{
+			if (slots_[slot].vertex == empty_vertex)
+			{
+				slots_[slot] = {corner, vertex};
+				count_++;
+
+				return vertex;
+			}
+
+			if (slots_[slot].corner == corner)
+			{
+				return slots_[slot].vertex;
+			}
+		}
+	}
+
+private:
+	static constexpr uint32_t empty_vertex = UINT32_MAX;
+
+	struct Slot
+	{
+		Corner   corner = {};
+		uint32_t vertex = empty_vertex;
+	};
+
+	static size_t Hash(const Corner& corner)
+	{
+		uint64_t hash = static_cast<uint32_t>(corner.position);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.texcoord);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.normal);
+
+		return static_cast<size_t>(hash ^ (hash >> 29));
+	}
+
+	void Grow()
+	{
+		std::vector<Slot> slots(slots_.size() * 2);
+		const size_t      mask = slots.size() - 1;
+
+		for (const Slot& old_slot : slots_)
+		{
+			if (old_slot.vertex == empty_vertex)
+			{
+				continue;
+			}
+
+			size_t slot = Hash(old_slot.corner) & mask;
+			while (slots[slot].vertex != empty_vertex)
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			slots[slot] = old_slot;
+		}
+
+		slots_ = std::move(slots);
+	}
+
+	std::vector<Slot> slots_ = {};
+	size_t            count_ = 0;
+};
+
+/// The '\n' ending the line, 16 bytes at a time with SSE2.
+const char* FindLineEnd(
+	const char* begin,
+	const char* end)
+{
+#ifdef ADRO_OBJ_SSE
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	for (; begin + 16 <= end; begin += 16)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		const int     mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+
+		if (mask != 0)
+		{
+			return begin + std::countr_zero(static_cast<uint32_t>(mask));
+		}
+	}
+#endif
+
+	for (; begin < end && *begin != '\n'; begin++)
+	{
+	}
+
+	return begin;
+}
+
+const char* SkipSpaces(
+	const char* cursor,
+	const char* end)
+{
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+	{
+		cursor++;
+	}
+
+	return cursor;
+}
+
+glm::vec3 ParseVec3(
+	const char* cursor,
+	const char* end)
+{
+	float values[3] = {};
+
+	for (float& value : values)
+	{
+		cursor = SkipSpaces(cursor, end);
+
+		// from_chars doesn't take an explicit plus sign.
+		if (cursor < end && *cursor == '+')
+		{
+			cursor++;
+		}
+
+		const std::from_chars_result result = std::from_chars(cursor, end, value);
+
+		if (result.ec != std::errc())
+		{
+			throw std::runtime_error("Failed to parse OBJ: invalid vector");
+		}
+
+		cursor = result.ptr;
+	}
+
+	return {values[0], values[1], values[2]};
+}
+
+/// One index of a face corner: 1-based, or negative for relative to the current count.
+int32_t ParseIndex(
+	const char** p_cursor,
+	const char*  end,
+	uint32_t     count,
+	uint8_t      relative_bit,
+	uint8_t*     p_relative)
+{
+	int32_t                      index  = 0;
+	const std::from_chars_result result = std::from_chars(*p_cursor, end, index);
+
+	if (result.ec != std::errc() || index == 0)
+	{
+		throw std::runtime_error("Failed to parse OBJ: invalid face index");
+	}
+
+	*p_cursor = result.ptr;
+
+	if (index < 0)
+	{
+		*p_relative |= relative_bit;
+		return static_cast<int32_t>(count) + index;
+	}
+
+	return index - 1;
+}
+
+/// @return false if the statement is one only Assimp handles.
+bool ParseLine(
+	const char*           line,
+	const char*           end,
+	std::vector<Corner>*  p_polygon,
+	std::vector<uint8_t>* p_polygon_relative,
+	Chunk*                p_chunk)
+{
+	const char* cursor = SkipSpaces(line, end);
+
+	if (cursor == end || *cursor == '#')
+	{
+		return true;
+	}
+
+	const char* keyword_end = cursor;
+	while (keyword_end < end && *keyword_end != ' ' && *keyword_end != '\t' && *keyword_end != '\r')
+	{
+		keyword_end++;
+	}
+
+	const std::string_view keyword(cursor, keyword_end - cursor);
+
+	if (keyword == "v")
+	{
+		p_chunk->positions.push_back(ParseVec3(keyword_end, end));
+	}
+	else if (keyword == "vn")
+	{
+		p_chunk->normals.push_back(ParseVec3(keyword_end, end));
+	}
+	else if (keyword == "vt")
+	{
+		p_chunk->texcoord_count++;
+	}
+	else if (keyword == "f")
+	{
+		p_polygon->clear();
+		p_polygon_relative->clear();
+
+		for (cursor = SkipSpaces(keyword_end, end); cursor < end; cursor = SkipSpaces(cursor, end))
+		{
+			Corner  corner   = {};
+			uint8_t relative = 0;
+
+			corner.position = ParseIndex(
+				&cursor,
+				end,
+				static_cast<uint32_t>(p_chunk->positions.size()),
+				CornerRelative_Position,
+				&relative);
+
+			// v/vt, v//vn or v/vt/vn.
+			if (cursor < end && *cursor == '/')
+			{
+				cursor++;
+
+				if (cursor < end && *cursor != '/')
+				{
+					corner.texcoord = ParseIndex(
+						&cursor,
+						end,
+						p_chunk->texcoord_count,
+						CornerRelative_Texcoord,
+						&relative);
+				}
+
+				if (cursor < end && *cursor == '/')
+				{
+					cursor++;
+
+					corner.normal = ParseIndex(
+						&cursor,
+						end,
+						static_cast<uint32_t>(p_chunk->normals.size()),
+						CornerRelative_Normal,
+						&relative);
+				}
+			}
+
+			p_polygon->push_back(corner);
+			p_polygon_relative->push_back(relative);
+		}
+
+		// Points and lines are kept by Assimp as separate primitive types.
+		if (p_polygon->size() < 3)
+		{
+			return false;
+		}
+
+		for (size_t i = 1; i + 1 < p_polygon->size(); i++)
+		{
+			for (const size_t corner : {size_t{0}, i, i + 1})
+			{
+				p_chunk->corners.push_back((*p_polygon)[corner]);
+				p_chunk->relative.push_back((*p_polygon_relative)[corner]);
+			}
+		}
+	}
+	else if (keyword != "s")
+	{
+		// Objects, groups and materials split the meshes, lines and the rest aren't triangles.
+		return false;
+	}
+
+	return true;
+}
+
+/// Parse the lines of [begin, end), the range starts at a line start and ends after a '\n' (or at the end).
+void ParseChunk(
+	const char* begin,
+	const char* end,
+	Chunk*      p_chunk)
+{
+	ADRO_PROFILE_SCOPE("ObjParser::ParseChunk");
+
+	// Sized for the usual OBJ line lengths, reallocating as we go is most of the cost otherwise.
+	const size_t line_estimate = static_cast<size_t>(end - begin) / 32;
+	p_chunk->positions.reserve(line_estimate);
+	p_chunk->corners.reserve(line_estimate * 3);
+	p_chunk->relative.reserve(line_estimate * 3);
+
+	std::vector<Corner>  polygon          = {};
+	std::vector<uint8_t> polygon_relative = {};
+
+	for (const char* line = begin; line < end;)
+	{
+		const char* line_end = FindLineEnd(line, end);
+
+		if (!ParseLine(line, line_end, &polygon, &polygon_relative, p_chunk))
+		{
+			p_chunk->supported = false;
+			return;
+		}
+
+		line = line_end + 1;
+	}
+}
+
+glm::vec3 NormalizeSafe(const glm::vec3& vector)
+{
+	const float length = std::sqrt(glm::dot(vector, vector));
+
+	return (length > 0.0f)
+		? vector / length
+		: vector;
+}
+}
+
+bool ObjParser::Parse(
+	std::span<const std::byte> data,
+	ThreadPool*                thread_pool,
+	Batch*                     batch)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const char* begin = reinterpret_cast<const char*>(data.data());
+	const char* end   = begin + data.size();
+
+	// Chunks end after a '\n', so no line is split between two threads.
+	const size_t thread_count = thread_pool ? thread_pool->GetThreadCount() + 1 : 1;
+	const size_t chunk_count  = std::clamp<size_t>(data.size() / min_chunk_size, 1, thread_count);
+
+	std::vector<const char*> bounds = {begin};
+
+	for (size_t i = 1; i < chunk_count; i++)
+	{
+		const char* split = std::max(bounds.back(), begin + data.size() * i / chunk_count);
+		const char* line  = FindLineEnd(split, end);
+
+		bounds.push_back(std::min(line + 1, end));
+	}
+
+	bounds.push_back(end);
+
+	std::vector<Chunk> chunks(chunk_count);
+
+	ThreadPool::ParallelFor(
+		thread_pool,
+		chunk_count,
+		[&](size_t i)
+		{
+			ParseChunk(bounds[i], bounds[i + 1], &chunks[i]);
+		});
+
+	if (std::ranges::any_of(chunks, [](const Chunk& chunk) { return !chunk.supported; }))
+	{
+		return false;
+	}
+
+	ADRO_PROFILE_SCOPE("ObjParser::Merge");
+
+	// Concatenate the attributes and resolve the corners to file-wide indices, in file order.
+	std::vector<glm::vec3> positions      = {};
+	std::vector<glm::vec3> normals        = {};
+	uint32_t               texcoord_count = 0;
+	size_t                 corner_count   = 0;
+
+	for (const Chunk& chunk : chunks)
+	{
+		corner_count += chunk.corners.size();
+	}
+
+	std::vector<Corner> corners = {};
+	corners.reserve(corner_count);
+
+	for (Chunk& chunk : chunks)
+	{
+		const int32_t position_base = static_cast<int32_t>(positions.size());
+		const int32_t texcoord_base = static_cast<int32_t>(texcoord_count);
+		const int32_t normal_base   = static_cast<int32_t>(normals.size());
+
+		for (size_t i = 0; i < chunk.corners.size(); i++)
+		{
+			Corner corner = chunk.corners[i];
+
+			corner.position += (chunk.relative[i] & CornerRelative_Position) ? position_base : 0;
+			corner.texcoord += (chunk.relative[i] & CornerRelative_Texcoord) ? texcoord_base : 0;
+			corner.normal   += (chunk.relative[i] & CornerRelative_Normal) ? normal_base : 0;
+
+			corners.push_back(corner);
+		}
+
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		texcoord_count += chunk.texcoord_count;
+
+		chunk = {};
+	}
+
+	// Deduplicate the corners in order: a vertex is created by the first corner using it.
+	Batch                 result           = {};
+	std::vector<uint32_t> vertex_positions = {};
+	VertexTable           vertex_table(positions.size());
+
+	result.indices.reserve(corners.size());
+	result.position.reserve(positions.size());
+	vertex_positions.reserve(positions.size());
+
+	for (const Corner& corner : corners)
+	{
+		if (corner.position < 0 || static_cast<size_t>(corner.position) >= positions.size() ||
+		    corner.texcoord >= static_cast<int32_t>(texcoord_count) ||
+		    corner.normal >= static_cast<int32_t>(normals.size()) ||
+		    corner.texcoord < -1 || corner.normal < -1)
+		{
+			throw std::runtime_error("Failed to parse OBJ: face index out of range");
+		}
+
+		const uint32_t next_vertex = static_cast<uint32_t>(result.position.size());
+		const uint32_t vertex      = vertex_table.FindOrInsert(corner, next_vertex);
+
+		if (vertex == next_vertex)
+		{
+			result.position.push_back(positions[corner.position]);
+			result.normals.push_back((corner.normal >= 0) ? normals[corner.normal] : glm::vec3(0.0f));
+			vertex_positions.push_back(static_cast<uint32_t>(corner.position));
+		}
+
+		result.indices.push_back(vertex);
+	}
+
+	// No normals in the file: sum the normalized face normals on the positions, like GenSmoothNormals.
+	if (normals.empty())
+	{
+		std::vector<glm::vec3> position_normals(positions.size(), glm::vec3(0.0f));
+
+		for (size_t i = 0; i + 2 < result.indices.size(); i += 3)
+		{
+			const uint32_t p0 = vertex_positions[result.indices[i + 0]];
+			const uint32_t p1 = vertex_positions[result.indices[i + 1]];
+			const uint32_t p2 = vertex_positions[result.indices[i + 2]];
+
+			const glm::vec3 face_normal = NormalizeSafe(glm::cross(
+				positions[p1] - positions[p0],
+				positions[p2] - positions[p0]));
+
+			position_normals[p0] += face_normal;
+			position_normals[p1] += face_normal;
+			position_normals[p2] += face_normal;
+		}
+
+		for (size_t vertex = 0; vertex < result.normals.size(); vertex++)
+		{
+			result.normals[vertex] = NormalizeSafe(position_normals[vertex_positions[vertex]]);
+		}
+	}
+
+	result.submeshes.push_back({
+		.first_index = 0,
+		.index_count = static_cast<uint32_t>(result.indices.size()),
+	});
+
+	*batch = std::move(result);
+
+	return true;
+}
@@ -0,0 +1,542 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "PipelineManager.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "vk_shader_module.h"
+#include "vk_utils.h"
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+
+namespace
+{
+/// Layout of the specialization constants of shader.vert and shader.frag.
+struct SpecializationData
+{
+	float    light_direction[3] = {};
+	VkBool32 lighting           = VK_TRUE;
+	VkBool32 object_id          = VK_FALSE;
+};
+
+constexpr VkSpecializationMapEntry specialization_entries[5] = {
+	{0, offsetof(SpecializationData, light_direction) + 0 * sizeof(float), sizeof(float)},
+	{1, offsetof(SpecializationData, light_direction) + 1 * sizeof(float), sizeof(float)},
+	{2, offsetof(SpecializationData, light_direction) + 2 * sizeof(float), sizeof(float)},
+	{3, offsetof(SpecializationData, lighting), sizeof(VkBool32)},
+	{4, offsetof(SpecializationData, object_id), sizeof(VkBool32)},
+};
+
+bool UsesShader(
+	const PipelineDesc& desc,
+	PipelineShader      shader)
+{
+	return desc.vertex_shader == shader || desc.fragment_shader == shader;
+}
+
+/// The same test with the depth range flipped (reverse-Z).
+VkCompareOp MirrorCompareOp(VkCompareOp op)
+{
+	switch (op)
+	{
+	case VK_COMPARE_OP_LESS:
+		return VK_COMPARE_OP_GREATER;
+
+	case VK_COMPARE_OP_LESS_OR_EQUAL:
+		return VK_COMPARE_OP_GREATER_OR_EQUAL;
+
+	case VK_COMPARE_OP_GREATER:
+		return VK_COMPARE_OP_LESS;
+
+	case VK_COMPARE_OP_GREATER_OR_EQUAL:
+		return VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	default:
+		// Equal, not equal, always and never don't depend on the direction.
+		return op;
+	}
+}
+}
+
+size_t PipelineDescHash::operator()(const PipelineDesc& desc) const
+{
+	// Adding 0 folds -0.0 into 0.0: equal descriptions must hash the same.
+	const uint32_t words[] = {
+		static_cast<uint32_t>(desc.vertex_shader),
+		static_cast<uint32_t>(desc.fragment_shader),
+		desc.vertex_streams,
+		static_cast<uint32_t>(desc.polygon_mode),
+		static_cast<uint32_t>(desc.depth_compare),
+		desc.depth_write,
+		desc.color_write,
+		desc.features,
+		std::bit_cast<uint32_t>(desc.light_direction.x + 0.0f),
+		std::bit_cast<uint32_t>(desc.light_direction.y + 0.0f),
+		std::bit_cast<uint32_t>(desc.light_direction.z + 0.0f),
+	};
+
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	for (const uint32_t word : words)
+	{
+		hash ^= word;
+		hash *= 0x100000001B3ull;
+	}
+
+	return static_cast<size_t>(hash);
+}
+
+void PipelineManager::Init(
+	VkDevice               device,
+	VkAllocationCallbacks* p_allocator,
+	VkPipelineLayout       layout,
+	VkRenderPass           render_pass,
+	VkSampleCountFlagBits  sample_count,
+	uint32_t               color_attachment_count,
+	bool                   reverse_z,
+	ThreadPool*            thread_pool)
+{
+	device_                 = device;
+	allocator_              = p_allocator;
+	layout_                 = layout;
+	render_pass_            = render_pass;
+	sample_count_           = sample_count;
+	color_attachment_count_ = color_attachment_count;
+	reverse_z_              = reverse_z;
+	thread_pool_            = thread_pool;
+
+	const VkPipelineCacheCreateInfo cache_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.initialDataSize = 0,
+		.pInitialData = nullptr,
+	};
+
+	VK_CHECK(vkCreatePipelineCache(
+		device_,
+		&cache_info,
+		allocator_,
+		&cache_));
+}
+
+void PipelineManager::Destroy()
+{
+	for (auto& [desc, entry] : pipelines_)
+	{
+		if (entry.pending.valid())
+		{
+			try
+			{
+				retired_.push_back(entry.pending.get());
+			}
+			catch (const std::exception&)
+			{
+				// Nothing was created.
+			}
+		}
+
+		retired_.push_back(entry.pipeline);
+	}
+
+	for (VkPipeline pipeline : retired_)
+	{
+		vkDestroyPipeline(device_, pipeline, allocator_);
+	}
+
+	vkDestroyPipelineCache(device_, cache_, allocator_);
+
+	pipelines_.clear();
+	retired_.clear();
+	code_  = {};
+	cache_ = VK_NULL_HANDLE;
+}
+
+void PipelineManager::SetShaderCode(
+	PipelineShader        shader,
+	std::vector<uint32_t> code)
+{
+	code_[static_cast<uint32_t>(shader)] = std::make_shared<const std::vector<uint32_t>>(std::move(code));
+
+	for (auto& [desc, entry] : pipelines_)
+	{
+		if (!UsesShader(desc, shader))
+		{
+			continue;
+		}
+
+		// The compilation in flight uses the old code, its result is swapped in and rebuilt right after.
+		if (entry.pending.valid())
+		{
+			entry.stale = true;
+		}
+		else
+		{
+			Submit(desc, &entry);
+		}
+	}
+}
+
+VkPipeline PipelineManager::Get(
+	const PipelineDesc& desc,
+	VkPipeline          fallback)
+{
+	auto [it, inserted] = pipelines_.try_emplace(desc);
+	Entry& entry        = it->second;
+
+	if (inserted)
+	{
+		Submit(desc, &entry);
+	}
+	else
+	{
+		Collect(&entry);
+
+		if (entry.stale && !entry.pending.valid())
+		{
+			entry.stale = false;
+			Submit(desc, &entry);
+		}
+	}
+
+	return entry.pipeline
+		? entry.pipeline
+		: fallback;
+}
+
+VkPipeline PipelineManager::GetBlocking(const PipelineDesc& desc)
+{
+	auto [it, inserted] = pipelines_.try_emplace(desc);
+	Entry& entry        = it->second;
+
+	if (inserted)
+	{
+		entry.pipeline = Compile(desc, code_);
+	}
+	else if (!entry.pipeline && entry.pending.valid())
+	{
+		entry.pending.wait();
+	}
+
+	return Get(desc, VK_NULL_HANDLE);
+}
+
+void PipelineManager::BeginFrame()
+{
+	for (VkPipeline pipeline : retired_)
+	{
+		vkDestroyPipeline(device_, pipeline, allocator_);
+	}
+
+	retired_.clear();
+}
+
+uint32_t PipelineManager::GetPipelineCount() const
+{
+	return static_cast<uint32_t>(pipelines_.size());
+}
+
+VkPipeline PipelineManager::Compile(
+	const PipelineDesc& desc,
+	const ShaderCode&   code) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const SpecializationData specialization_data = {
+		.light_direction = {desc.light_direction.x, desc.light_direction.y, desc.light_direction.z},
+		.lighting = (desc.features & ShaderFeature_Lighting) ? VK_TRUE : VK_FALSE,
+		.object_id = (color_attachment_count_ > 1) ? VK_TRUE : VK_FALSE,
+	};
+
+	// Map entries of constants missing from a shader are ignored, one info serves every stage.
+	const VkSpecializationInfo specialization_info = {
+		.mapEntryCount = 5,
+		.pMapEntries = &specialization_entries[0],
+		.dataSize = sizeof(specialization_data),
+		.pData = &specialization_data,
+	};
+
+	const PipelineShader shaders[2] = {
+		desc.vertex_shader,
+		desc.fragment_shader,
+	};
+
+	VkShaderModule                  shader_modules[2] = {};
+	VkPipelineShaderStageCreateInfo shader_stages[2]  = {};
+	uint32_t                        stage_count       = 0;
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		if (shaders[i] == PipelineShader::None)
+		{
+			continue;
+		}
+
+		const std::vector<uint32_t>& shader_code = *code[static_cast<uint32_t>(shaders[i])];
+
+		Gfx::CreateShaderModule(
+			device_,
+			static_cast<uint32_t>(shader_code.size() * sizeof(uint32_t)),
+			reinterpret_cast<const char*>(shader_code.data()),
+			allocator_,
+			&shader_modules[stage_count]);
+
+		shader_stages[stage_count] = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.stage = (i == 0)
+				? VK_SHADER_STAGE_VERTEX_BIT
+				: VK_SHADER_STAGE_FRAGMENT_BIT,
+			.module = shader_modules[stage_count],
+			.pName = "main",
+			.pSpecializationInfo = &specialization_info,
+		};
+
+		stage_count++;
+	}
+
+	const VkVertexInputBindingDescription bind_descs[] = {
+		// position
+		{
+			.binding = 0,
+			.stride = sizeof(glm::vec3),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		},
+		// color.
+		{
+			.binding = 1,
+			.stride = sizeof(glm::vec4),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		},
+		// normal.
+		{
+			.binding = 2,
+			.stride = sizeof(glm::vec3),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		}
+	};
+
+	const VkVertexInputAttributeDescription attribute_description[3] = {
+		{
+			.location = 0,
+			.binding = 0,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = 0
+		},
+		{
+			.location = 1,
+			.binding = 1,
+			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
+			.offset = 0
+		},
+		{
+			.location = 2,
+			.binding = 2,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = 0
+		}
+	};
+
+	// The streams are bound in order: 1 stream is the position only (depth pre-pass).
+	const VkPipelineVertexInputStateCreateInfo vertex_input_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.vertexBindingDescriptionCount = desc.vertex_streams,
+		.pVertexBindingDescriptions = &bind_descs[0],
+		.vertexAttributeDescriptionCount = desc.vertex_streams,
+		.pVertexAttributeDescriptions = &attribute_description[0],
+	};
+
+	constexpr VkPipelineInputAssemblyStateCreateInfo input_assembly_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+		.primitiveRestartEnable = VK_FALSE,
+	};
+
+	// Viewport and scissor are dynamic: the pipelines don't depend on the surface extent (which a compilation on a
+	// worker couldn't read safely while the swapchain is recreated).
+	constexpr VkPipelineViewportStateCreateInfo viewport_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.viewportCount = 1,
+		.pViewports = nullptr,
+		.scissorCount = 1,
+		.pScissors = nullptr,
+	};
+
+	const VkPipelineRasterizationStateCreateInfo rasterization_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.depthClampEnable = VK_FALSE,
+		.rasterizerDiscardEnable = VK_FALSE,
+		.polygonMode = desc.polygon_mode,
+		.cullMode = VK_CULL_MODE_BACK_BIT,
+		.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+		.depthBiasEnable = VK_FALSE,
+		.depthBiasConstantFactor = 0.0f,
+		.depthBiasClamp = 0.0f,
+		.depthBiasSlopeFactor = 0.0f,
+		.lineWidth = 1.0f,
+	};
+
+	const VkPipelineMultisampleStateCreateInfo multisample_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.rasterizationSamples = sample_count_,
+		.sampleShadingEnable = VK_FALSE,
+		.minSampleShading = 1.0f,
+		.pSampleMask = nullptr,
+		.alphaToCoverageEnable = VK_FALSE,
+		.alphaToOneEnable = VK_FALSE,
+	};
+
+	const VkPipelineDepthStencilStateCreateInfo depth_stencil_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.depthTestEnable = VK_TRUE,
+		.depthWriteEnable = desc.depth_write,
+		.depthCompareOp = reverse_z_
+			? MirrorCompareOp(desc.depth_compare)
+			: desc.depth_compare,
+		.depthBoundsTestEnable = VK_FALSE,
+		.stencilTestEnable = VK_FALSE,
+		.front = {},
+		.back = {},
+		.minDepthBounds = 0.0f,
+		.maxDepthBounds = 1.0f,
+	};
+
+	const VkPipelineColorBlendAttachmentState color_blend_attachment = {
+		.blendEnable = VK_FALSE,
+		.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+		.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+		.colorBlendOp = VK_BLEND_OP_ADD,
+		.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+		.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+		.alphaBlendOp = VK_BLEND_OP_ADD,
+		.colorWriteMask = desc.color_write
+			? VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+			: 0u,
+	};
+
+	// The object id attachment takes the same state: no blending, and identical states don't need independentBlend.
+	const VkPipelineColorBlendAttachmentState color_blend_attachments[2] = {
+		color_blend_attachment,
+		color_blend_attachment,
+	};
+
+	const VkPipelineColorBlendStateCreateInfo color_blend_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.logicOpEnable = VK_FALSE,
+		.logicOp = VK_LOGIC_OP_COPY,
+		.attachmentCount = color_attachment_count_,
+		.pAttachments = &color_blend_attachments[0],
+		.blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
+	};
+
+	constexpr VkDynamicState dynamic_states[] = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR,
+	};
+
+	const VkPipelineDynamicStateCreateInfo dynamic_state_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.dynamicStateCount = 2,
+		.pDynamicStates = &dynamic_states[0],
+	};
+
+	const VkGraphicsPipelineCreateInfo pipeline_info = {
+		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.stageCount = stage_count,
+		.pStages = &shader_stages[0],
+		.pVertexInputState = &vertex_input_info,
+		.pInputAssemblyState = &input_assembly_info,
+		.pTessellationState = nullptr,
+		.pViewportState = &viewport_info,
+		.pRasterizationState = &rasterization_info,
+		.pMultisampleState = &multisample_info,
+		.pDepthStencilState = &depth_stencil_info,
+		.pColorBlendState = &color_blend_info,
+		.pDynamicState = &dynamic_state_info,
+		.layout = layout_,
+		.renderPass = render_pass_,
+		.subpass = 0,
+		.basePipelineHandle = VK_NULL_HANDLE,
+		.basePipelineIndex = -1,
+	};
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	// The pipeline cache is internally synchronized, the workers share it.
+	const VkResult result = vkCreateGraphicsPipelines(
+		device_,
+		cache_,
+		1,
+		&pipeline_info,
+		allocator_,
+		&pipeline);
+
+	for (uint32_t i = 0; i < stage_count; i++)
+	{
+		vkDestroyShaderModule(device_, shader_modules[i], allocator_);
+	}
+
+	VK_CHECK(result);
+
+	return pipeline;
+}
+
+void PipelineManager::Submit(
+	const PipelineDesc& desc,
+	Entry*              p_entry)
+{
+	// The code is captured by value: a later SetShaderCode doesn't affect this compilation.
+	p_entry->pending = thread_pool_->Submit([this, desc, code = code_]
+	{
+		return Compile(desc, code);
+	});
+}
+
+void PipelineManager::Collect(Entry* p_entry)
+{
+	if (!p_entry->pending.valid() ||
+	    p_entry->pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	try
+	{
+		const VkPipeline pipeline = p_entry->pending.get();
+
+		// Still bound by the frame in flight, destroyed by the BeginFrame after the next fence wait.
+		if (p_entry->pipeline)
+		{
+			retired_.push_back(p_entry->pipeline);
+		}
+
+		p_entry->pipeline = pipeline;
+	}
+	catch (const std::exception& exception)
+	{
+		// Keep the previous version.
+		std::printf("[PIPELINE] Compilation failed: %s\n", exception.what());
+	}
+}
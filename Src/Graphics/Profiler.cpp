@@ -0,0 +1,145 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Profiler.h"
+
+#ifdef ADRO_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+struct Event
+{
+	const char* name     = nullptr;
+	uint64_t    begin_ns = 0;
+	uint64_t    end_ns   = 0;
+};
+
+/// Written only by its owner thread, read by the exporter.
+struct ThreadBuffer
+{
+	alignas(64) std::atomic<uint64_t> head = 0;
+	const char* name                       = nullptr;
+	uint32_t    thread_idx                 = 0;
+	Event       events[Profiler::ring_capacity];
+};
+
+/// Buffers outlive their threads, so events of joined threads can still be exported.
+struct Registry
+{
+	std::mutex                                 mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+ThreadBuffer& GetThreadBuffer()
+{
+	// The registry lock is taken once per thread, on its first event.
+	thread_local ThreadBuffer* buffer = []
+	{
+		Registry&                   registry = GetRegistry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+
+		registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+		registry.buffers.back()->thread_idx = static_cast<uint32_t>(registry.buffers.size() - 1);
+
+		return registry.buffers.back().get();
+	}();
+
+	return *buffer;
+}
+}
+
+Profiler::Scope::Scope(const char* name)
+	: name_(name),
+	  begin_ns_(Now())
+{
+}
+
+Profiler::Scope::~Scope()
+{
+	const uint64_t end_ns = Now();
+	ThreadBuffer&  buffer = GetThreadBuffer();
+
+	const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	buffer.events[head % ring_capacity] = {name_, begin_ns_, end_ns};
+
+	// Publish the event to the exporter.
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	GetThreadBuffer().name = name;
+}
+
+void Profiler::ExportChromeTrace(const char* path)
+{
+	FILE* file = std::fopen(path, "w");
+
+	if (!file)
+	{
+		std::printf("[PROFILER] Failed to open %s\n", path);
+		return;
+	}
+
+	std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	Registry&                         registry = GetRegistry();
+	const std::lock_guard<std::mutex> lock(registry.mutex);
+
+	bool first_event = true;
+
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		if (buffer->name)
+		{
+			std::fprintf(file,
+			             "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+			             first_event ? "" : ",\n",
+			             buffer->thread_idx,
+			             buffer->name);
+			first_event = false;
+		}
+
+		const uint64_t head  = buffer->head.load(std::memory_order_acquire);
+		const uint64_t count = (head < ring_capacity) ? head : ring_capacity;
+
+		for (uint64_t i = head - count; i < head; i++)
+		{
+			const Event& event = buffer->events[i % ring_capacity];
+
+			std::fprintf(file,
+			             "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			             first_event ? "" : ",\n",
+			             event.name,
+			             buffer->thread_idx,
+			             static_cast<double>(event.begin_ns) / 1000.0,
+			             static_cast<double>(event.end_ns - event.begin_ns) / 1000.0);
+			first_event = false;
+		}
+	}
+
+	std::fprintf(file, "\n]}\n");
+	std::fclose(file);
+}
+
+uint64_t Profiler::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif
@@ -0,0 +1,125 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "ShaderCompiler.h"
+#include "Profiler.h"
+#include "../FileSystem.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef ADRO_SHADERC
+#include <shaderc/shaderc.h>
+#endif
+
+#ifndef ADRO_GLSLC_PATH
+#define ADRO_GLSLC_PATH "glslc"
+#endif
+
+std::vector<uint32_t> ShaderCompiler::CompileGlsl(const char* path)
+{
+	ADRO_PROFILE_SCOPE("ShaderCompiler::CompileGlsl");
+
+	const std::string extension = std::filesystem::path(path).extension().string();
+
+	if (extension != ".vert" && extension != ".frag" && extension != ".comp")
+	{
+		throw std::runtime_error("Unknown shader stage");
+	}
+
+#ifdef ADRO_SHADERC
+	const std::vector<char> source = FileSystem::ReadFile(path);
+
+	const shaderc_shader_kind kind = (extension == ".frag")
+		? shaderc_glsl_fragment_shader
+		: (extension == ".comp")
+		? shaderc_glsl_compute_shader
+		: shaderc_glsl_vertex_shader;
+
+	// A compiler object per call: compilations are rare and this keeps the function free of shared state.
+	shaderc_compiler_t        compiler = shaderc_compiler_initialize();
+	shaderc_compile_options_t options  = shaderc_compile_options_initialize();
+
+	shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+	shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance);
+
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(
+		compiler,
+		source.data(),
+		source.size(),
+		kind,
+		path,
+		"main",
+		options);
+
+	const bool succeeded = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+
+	std::vector<uint32_t> spirv = {};
+	std::string           log   = {};
+
+	if (succeeded)
+	{
+		spirv.resize(shaderc_result_get_length(result) / sizeof(uint32_t));
+		std::memcpy(spirv.data(), shaderc_result_get_bytes(result), spirv.size() * sizeof(uint32_t));
+	}
+	else
+	{
+		log = shaderc_result_get_error_message(result);
+	}
+
+	shaderc_result_release(result);
+	shaderc_compile_options_release(options);
+	shaderc_compiler_release(compiler);
+
+	if (!succeeded)
+	{
+		throw std::runtime_error(log);
+	}
+
+	return spirv;
+#else
+	// Unique per thread, concurrent compilations don't share the output files.
+	const std::filesystem::path output = std::filesystem::temp_directory_path() /
+		("adro_" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".spv");
+	const std::filesystem::path log_path = std::filesystem::path(output).replace_extension(".log");
+
+	std::string command = std::string("\"") + ADRO_GLSLC_PATH + "\" -O -fshader-stage=" + extension.substr(1) +
+		" \"" + path + "\" -o \"" + output.string() + "\" 2> \"" + log_path.string() + "\"";
+
+#ifdef _WIN32
+	// cmd.exe strips the first and last quote of the line.
+	command = "\"" + command + "\"";
+#endif
+
+	const int status = std::system(command.c_str());
+
+	if (status != 0)
+	{
+		const std::vector<char> log = FileSystem::ReadFile(log_path.string().c_str());
+		std::filesystem::remove(log_path);
+
+		throw std::runtime_error(std::string(log.begin(), log.end()));
+	}
+
+	std::vector<uint32_t> spirv = {};
+
+	// Unmapped before the removal, Windows can't delete a mapped file.
+	{
+		const FileView file = FileSystem::MapFile(output.string().c_str());
+
+		spirv.resize(file.GetSize() / sizeof(uint32_t));
+		std::memcpy(spirv.data(), file.GetData(), spirv.size() * sizeof(uint32_t));
+	}
+
+	std::error_code error = {};
+	std::filesystem::remove(output, error);
+	std::filesystem::remove(log_path, error);
+
+	return spirv;
+#endif
+}
@@ -0,0 +1,162 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+void AppendOnce(
+	std::vector<std::string>* p_files,
+	std::string               file)
+{
+	if (std::find(p_files->begin(), p_files->end(), file) == p_files->end())
+	{
+		p_files->push_back(std::move(file));
+	}
+}
+}
+
+bool ShaderWatcher::Init(const char* directory)
+{
+	directory_ = directory;
+
+#ifdef _WIN32
+	change_handle_ = FindFirstChangeNotificationA(
+		directory,
+		FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+
+	if (change_handle_ == INVALID_HANDLE_VALUE)
+	{
+		change_handle_ = nullptr;
+	}
+	else
+	{
+		// The notification doesn't name the file, the write times tell which one changed.
+		std::error_code error = {};
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			write_times_[entry.path().filename().string()] = entry.last_write_time(error).time_since_epoch().count();
+		}
+	}
+
+	const bool watching = change_handle_ != nullptr;
+#else
+	inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	// Editors either write in place (close after write) or write a temporary and rename it (moved to).
+	if (inotify_fd_ >= 0 && inotify_add_watch(inotify_fd_, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(inotify_fd_);
+		inotify_fd_ = -1;
+	}
+
+	const bool watching = inotify_fd_ >= 0;
+#endif
+
+	if (watching)
+	{
+		std::printf("[SHADER] Watching %s\n", directory);
+	}
+	else
+	{
+		std::printf("[SHADER] Can't watch %s, hot reload disabled\n", directory);
+	}
+
+	return watching;
+}
+
+void ShaderWatcher::Destroy()
+{
+#ifdef _WIN32
+	if (change_handle_)
+	{
+		FindCloseChangeNotification(change_handle_);
+		change_handle_ = nullptr;
+	}
+
+	write_times_.clear();
+#else
+	if (inotify_fd_ >= 0)
+	{
+		close(inotify_fd_);
+		inotify_fd_ = -1;
+	}
+#endif
+}
+
+void ShaderWatcher::Poll(std::vector<std::string>* p_changed_files)
+{
+#ifdef _WIN32
+	if (!change_handle_ || WaitForSingleObject(change_handle_, 0) != WAIT_OBJECT_0)
+	{
+		return;
+	}
+
+	FindNextChangeNotification(change_handle_);
+
+	std::error_code error = {};
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory_, error))
+	{
+		const std::string name       = entry.path().filename().string();
+		const int64_t     write_time = entry.last_write_time(error).time_since_epoch().count();
+
+		int64_t& known_write_time = write_times_[name];
+
+		if (known_write_time != write_time)
+		{
+			known_write_time = write_time;
+			AppendOnce(p_changed_files, name);
+		}
+	}
+#else
+	if (inotify_fd_ < 0)
+	{
+		return;
+	}
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		const ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+
+		// EAGAIN: nothing left to read.
+		if (length <= 0)
+		{
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			if (event->len > 0)
+			{
+				AppendOnce(p_changed_files, event->name);
+			}
+
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+		}
+	}
+#endif
+}
+
+const std::string& ShaderWatcher::GetDirectory() const
+{
+	return directory_;
+}
@@ -0,0 +1,122 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Simulation.h"
+#include "Profiler.h"
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+void Simulation::Start(
+	const SimulationState& initial_state,
+	SimulationStep         step,
+	uint32_t               tick_rate)
+{
+	Stop();
+
+	step_         = std::move(step);
+	step_ticks_   = std::max<uint64_t>(SDL_GetPerformanceFrequency() / tick_rate, 1);
+	step_seconds_ = 1.0f / static_cast<float>(tick_rate);
+	state_        = initial_state;
+
+	// Published before the thread exists, Sample never sees an empty slot.
+	snapshots_.GetWriteSlot() = {
+		.previous = initial_state,
+		.current = initial_state,
+		.time = SDL_GetPerformanceCounter(),
+	};
+
+	snapshots_.Publish();
+
+	thread_ = std::jthread([this](std::stop_token stop_token)
+	{
+		Run(stop_token);
+	});
+}
+
+void Simulation::Stop()
+{
+	if (thread_.joinable())
+	{
+		thread_.request_stop();
+		thread_.join();
+	}
+}
+
+void Simulation::SetHeldActions(uint32_t held_actions)
+{
+	held_actions_.store(held_actions, std::memory_order_relaxed);
+}
+
+SimulationState Simulation::Sample(uint64_t time)
+{
+	const Snapshot& snapshot = snapshots_.Read();
+
+	// Sampled before the tick (a timestamp older than the last pass of the thread): the previous state.
+	const double elapsed = time > snapshot.time
+		? static_cast<double>(time - snapshot.time)
+		: 0.0;
+
+	const float alpha = static_cast<float>(std::min(elapsed / static_cast<double>(step_ticks_), 1.0));
+
+	return {
+		.camera_pos = glm::mix(snapshot.previous.camera_pos, snapshot.current.camera_pos, alpha),
+		.camera_target = glm::mix(snapshot.previous.camera_target, snapshot.current.camera_target, alpha),
+		.camera_front = glm::normalize(
+			glm::mix(snapshot.previous.camera_front, snapshot.current.camera_front, alpha)),
+	};
+}
+
+void Simulation::Run(std::stop_token stop_token)
+{
+	ADRO_PROFILE_THREAD("Simulation");
+
+	const uint64_t frequency   = SDL_GetPerformanceFrequency();
+	uint64_t       last        = SDL_GetPerformanceCounter();
+	uint64_t       accumulator = 0;
+
+	while (!stop_token.stop_requested())
+	{
+		const uint64_t now = SDL_GetPerformanceCounter();
+
+		accumulator = std::min(accumulator + (now - last), max_catch_up_steps * step_ticks_);
+		last        = now;
+
+		if (accumulator >= step_ticks_)
+		{
+			ADRO_PROFILE_SCOPE("Simulation Step");
+
+			const uint32_t  held_actions = held_actions_.load(std::memory_order_relaxed);
+			SimulationState previous     = state_;
+
+			while (accumulator >= step_ticks_)
+			{
+				previous = state_;
+				step_(&state_, held_actions, step_seconds_);
+				accumulator -= step_ticks_;
+			}
+
+			// The leftover of the accumulator is the time since the current state was due.
+			snapshots_.GetWriteSlot() = {
+				.previous = previous,
+				.current = state_,
+				.time = now - accumulator,
+			};
+
+			snapshots_.Publish();
+		}
+
+		// Oversleeping only means more steps on the next pass.
+		const uint64_t sleep_ns = (step_ticks_ - accumulator) * 1'000'000'000 / frequency;
+
+		std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+	}
+}
@@ -0,0 +1,473 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "Skinner.h"
+#include "Profiler.h"
+#include "vk_buffer.h"
+#include "vk_shader_module.h"
+#include "vk_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+constexpr uint32_t workgroup_size = 64;
+
+/// Groups per dispatch dimension guaranteed by the spec (maxComputeWorkGroupCount).
+constexpr uint32_t max_group_count = 65535;
+
+constexpr uint32_t binding_count = 7;
+
+/// Host visible storage buffer, mapped when p_mapped is given, filled with data otherwise.
+void CreateStorageBuffer(
+	VkDevice               device,
+	VkPhysicalDevice       gpu,
+	VkAllocationCallbacks* p_allocator,
+	const void*            data,
+	size_t                 size,
+	VkBuffer*              p_buffer,
+	VkDeviceMemory*        p_memory,
+	void**                 p_mapped = nullptr)
+{
+	Gfx::CreateBuffer(
+		device,
+		gpu,
+		std::max<size_t>(size, sizeof(uint32_t)),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		p_allocator,
+		p_buffer,
+		p_memory);
+
+	void* mapped = nullptr;
+	VK_CHECK(vkMapMemory(
+		device,
+		*p_memory,
+		0,
+		VK_WHOLE_SIZE,
+		0,
+		&mapped));
+
+	if (data)
+	{
+		memcpy(mapped, data, size);
+	}
+
+	if (p_mapped)
+	{
+		*p_mapped = mapped;
+		return;
+	}
+
+	vkUnmapMemory(device, *p_memory);
+}
+}
+
+void Skinner::Init(
+	VkDevice                  device,
+	VkPhysicalDevice          gpu,
+	VkAllocationCallbacks*    p_allocator,
+	std::span<const uint32_t> shader_code)
+{
+	device_    = device;
+	gpu_       = gpu;
+	allocator_ = p_allocator;
+
+	VkDescriptorSetLayoutBinding bindings[binding_count] = {};
+
+	for (uint32_t i = 0; i < binding_count; i++)
+	{
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = nullptr,
+		};
+	}
+
+	const VkDescriptorSetLayoutCreateInfo layout_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = binding_count,
+		.pBindings = &bindings[0],
+	};
+
+	VK_CHECK(vkCreateDescriptorSetLayout(
+		device_,
+		&layout_info,
+		allocator_,
+		&descriptor_set_layout_));
+
+	const VkDescriptorPoolSize pool_size = {
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.descriptorCount = binding_count,
+	};
+
+	const VkDescriptorPoolCreateInfo pool_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.maxSets = 1,
+		.poolSizeCount = 1,
+		.pPoolSizes = &pool_size,
+	};
+
+	VK_CHECK(vkCreateDescriptorPool(
+		device_,
+		&pool_info,
+		allocator_,
+		&descriptor_pool_));
+
+	const VkDescriptorSetAllocateInfo set_allocate_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = descriptor_pool_,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &descriptor_set_layout_,
+	};
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		device_,
+		&set_allocate_info,
+		&descriptor_set_));
+
+	const VkPushConstantRange push_constant_range = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(uint32_t),
+	};
+
+	const VkPipelineLayoutCreateInfo pipeline_layout_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptor_set_layout_,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &push_constant_range,
+	};
+
+	VK_CHECK(vkCreatePipelineLayout(
+		device_,
+		&pipeline_layout_info,
+		allocator_,
+		&pipeline_layout_));
+
+	pipeline_ = CreatePipeline(shader_code);
+}
+
+void Skinner::Destroy()
+{
+	ClearMesh();
+	BeginFrame();
+
+	vkDestroyPipeline(device_, pipeline_, allocator_);
+	vkDestroyPipelineLayout(device_, pipeline_layout_, allocator_);
+	vkDestroyDescriptorPool(device_, descriptor_pool_, allocator_);
+	vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, allocator_);
+
+	*this = {};
+}
+
+VkPipeline Skinner::CreatePipeline(std::span<const uint32_t> shader_code) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	VkShaderModule shader_module = {};
+	Gfx::CreateShaderModule(
+		device_,
+		static_cast<uint32_t>(shader_code.size() * sizeof(uint32_t)),
+		reinterpret_cast<const char*>(shader_code.data()),
+		allocator_,
+		&shader_module);
+
+	const VkComputePipelineCreateInfo pipeline_info = {
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.stage = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+			.module = shader_module,
+			.pName = "main",
+			.pSpecializationInfo = nullptr,
+		},
+		.layout = pipeline_layout_,
+		.basePipelineHandle = VK_NULL_HANDLE,
+		.basePipelineIndex = -1,
+	};
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	const VkResult result = vkCreateComputePipelines(
+		device_,
+		VK_NULL_HANDLE,
+		1,
+		&pipeline_info,
+		allocator_,
+		&pipeline);
+
+	vkDestroyShaderModule(device_, shader_module, allocator_);
+
+	VK_CHECK(result);
+
+	return pipeline;
+}
+
+void Skinner::SetPipeline(VkPipeline pipeline)
+{
+	// Still bound by the frame in flight, destroyed by the BeginFrame after the next fence wait.
+	retired_.push_back(pipeline_);
+
+	pipeline_ = pipeline;
+}
+
+void Skinner::BeginFrame()
+{
+	for (VkPipeline pipeline : retired_)
+	{
+		vkDestroyPipeline(device_, pipeline, allocator_);
+	}
+
+	retired_.clear();
+}
+
+void Skinner::SetMesh(
+	std::span<const glm::vec3>  positions,
+	std::span<const glm::vec3>  normals,
+	std::span<const glm::uvec4> joints,
+	std::span<const glm::vec4>  weights,
+	uint32_t                    joint_count,
+	VkBuffer                    position_buffer,
+	VkBuffer                    normal_buffer)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (normals.size() != positions.size() ||
+	    joints.size() != positions.size() ||
+	    weights.size() != positions.size())
+	{
+		throw std::runtime_error("Skinned mesh streams mismatch");
+	}
+
+	ClearMesh();
+
+	vertex_count_    = static_cast<uint32_t>(positions.size());
+	joint_count_     = joint_count;
+	position_buffer_ = position_buffer;
+	normal_buffer_   = normal_buffer;
+
+	CreateStorageBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		positions.data(),
+		positions.size_bytes(),
+		&bind_position_buffer_,
+		&bind_position_memory_);
+
+	CreateStorageBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		normals.data(),
+		normals.size_bytes(),
+		&bind_normal_buffer_,
+		&bind_normal_memory_);
+
+	CreateStorageBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		joints.data(),
+		joints.size_bytes(),
+		&joint_buffer_,
+		&joint_memory_);
+
+	CreateStorageBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		weights.data(),
+		weights.size_bytes(),
+		&weight_buffer_,
+		&weight_memory_);
+
+	// Rewritten every frame, stays mapped.
+	void* palette_data = nullptr;
+	CreateStorageBuffer(
+		device_,
+		gpu_,
+		allocator_,
+		nullptr,
+		sizeof(glm::mat4) * joint_count_,
+		&palette_buffer_,
+		&palette_memory_,
+		&palette_data);
+
+	palette_data_ = static_cast<glm::mat4*>(palette_data);
+	std::fill_n(palette_data_, joint_count_, glm::mat4(1.0f));
+
+	const VkDescriptorBufferInfo buffer_infos[binding_count] = {
+		{bind_position_buffer_, 0, VK_WHOLE_SIZE},
+		{bind_normal_buffer_, 0, VK_WHOLE_SIZE},
+		{joint_buffer_, 0, VK_WHOLE_SIZE},
+		{weight_buffer_, 0, VK_WHOLE_SIZE},
+		{palette_buffer_, 0, VK_WHOLE_SIZE},
+		{position_buffer, 0, VK_WHOLE_SIZE},
+		{normal_buffer, 0, VK_WHOLE_SIZE},
+	};
+
+	VkWriteDescriptorSet writes[binding_count] = {};
+
+	for (uint32_t i = 0; i < binding_count; i++)
+	{
+		writes[i] = {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = descriptor_set_,
+			.dstBinding = i,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.pBufferInfo = &buffer_infos[i],
+		};
+	}
+
+	vkUpdateDescriptorSets(
+		device_,
+		binding_count,
+		&writes[0],
+		0,
+		nullptr);
+}
+
+void Skinner::ClearMesh()
+{
+	if (palette_data_)
+	{
+		vkUnmapMemory(device_, palette_memory_);
+	}
+
+	vkDestroyBuffer(device_, bind_position_buffer_, allocator_);
+	vkFreeMemory(device_, bind_position_memory_, allocator_);
+
+	vkDestroyBuffer(device_, bind_normal_buffer_, allocator_);
+	vkFreeMemory(device_, bind_normal_memory_, allocator_);
+
+	vkDestroyBuffer(device_, joint_buffer_, allocator_);
+	vkFreeMemory(device_, joint_memory_, allocator_);
+
+	vkDestroyBuffer(device_, weight_buffer_, allocator_);
+	vkFreeMemory(device_, weight_memory_, allocator_);
+
+	vkDestroyBuffer(device_, palette_buffer_, allocator_);
+	vkFreeMemory(device_, palette_memory_, allocator_);
+
+	bind_position_buffer_ = VK_NULL_HANDLE;
+	bind_position_memory_ = VK_NULL_HANDLE;
+	bind_normal_buffer_   = VK_NULL_HANDLE;
+	bind_normal_memory_   = VK_NULL_HANDLE;
+	joint_buffer_         = VK_NULL_HANDLE;
+	joint_memory_         = VK_NULL_HANDLE;
+	weight_buffer_        = VK_NULL_HANDLE;
+	weight_memory_        = VK_NULL_HANDLE;
+	palette_buffer_       = VK_NULL_HANDLE;
+	palette_memory_       = VK_NULL_HANDLE;
+	palette_data_         = nullptr;
+	position_buffer_      = VK_NULL_HANDLE;
+	normal_buffer_        = VK_NULL_HANDLE;
+	vertex_count_         = 0;
+	joint_count_          = 0;
+}
+
+void Skinner::UpdatePalette(std::span<const glm::mat4> palette)
+{
+	if (palette.size() != joint_count_)
+	{
+		throw std::runtime_error("Palette doesn't match the skinned mesh");
+	}
+
+	std::copy(palette.begin(), palette.end(), palette_data_);
+}
+
+void Skinner::Record(VkCommandBuffer command_buffer) const
+{
+	if (vertex_count_ == 0)
+	{
+		return;
+	}
+
+	vkCmdBindPipeline(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline_);
+
+	vkCmdBindDescriptorSets(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline_layout_,
+		0,
+		1,
+		&descriptor_set_,
+		0,
+		nullptr);
+
+	vkCmdPushConstants(
+		command_buffer,
+		pipeline_layout_,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(vertex_count_),
+		&vertex_count_);
+
+	// Rows of max_group_count groups, the shader flattens the 2D id.
+	const uint32_t group_count   = (vertex_count_ + workgroup_size - 1) / workgroup_size;
+	const uint32_t group_count_x = std::min(group_count, max_group_count);
+	const uint32_t group_count_y = (group_count + group_count_x - 1) / group_count_x;
+
+	vkCmdDispatch(
+		command_buffer,
+		group_count_x,
+		group_count_y,
+		1);
+
+	// Read as vertex attributes by the draws, and as storage buffers by NormalGenerator when it runs after.
+	const VkBufferMemoryBarrier barriers[2] = {
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = position_buffer_,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		},
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = normal_buffer_,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		},
+	};
+
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		2,
+		&barriers[0],
+		0,
+		nullptr);
+}
@@ -0,0 +1,132 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		// Leave a core to the main thread.
+		thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	workers_.reserve(thread_count);
+
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+
+	condition_.notify_all();
+
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(
+	ThreadPool*                              thread_pool,
+	size_t                                   count,
+	const std::function<void(size_t index)>& task)
+{
+	std::vector<std::future<void>> tasks = {};
+
+	for (size_t i = 1; thread_pool && i < count; i++)
+	{
+		tasks.push_back(thread_pool->Submit([&task, i]
+		{
+			task(i);
+		}));
+	}
+
+	// The tasks reference the caller's state: wait for all of them before rethrowing anything.
+	std::exception_ptr error = nullptr;
+
+	try
+	{
+		const size_t inline_count = thread_pool ? std::min<size_t>(count, 1) : count;
+
+		for (size_t i = 0; i < inline_count; i++)
+		{
+			task(i);
+		}
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	for (std::future<void>& pending : tasks)
+	{
+		pending.wait();
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+
+	for (std::future<void>& pending : tasks)
+	{
+		pending.get();
+	}
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+	return static_cast<uint32_t>(workers_.size());
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push_back(std::move(task));
+	}
+
+	condition_.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	ADRO_PROFILE_THREAD("Worker");
+
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]
+			{
+				return stopping_ || !tasks_.empty();
+			});
+
+			// Drain the queue before leaving, so no future is left without a value.
+			if (tasks_.empty())
+			{
+				return;
+			}
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+		}
+
+		task();
+	}
+}
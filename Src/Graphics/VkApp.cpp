@@ -6,6 +6,8 @@
 
 #include "../FileSystem.h"
 #include "Include/Graphics.h"
+#include "Bvh.h"
+#include "GltfAsset.h"
 #include "Mesh.h"
 #include "vk_instance.h"
 #include "vk_physical_device.h"
@@ -21,71 +23,224 @@
 #include "vk_image.h"
 #include "vk_shader_module.h"
 #include "vk_buffer.h"
+#include "vk_extension.h"
+#include "Profiler.h"
+#include "ShaderCompiler.h"
 
 #define VOLK_IMPLEMENTATION
 #include <volk/volk.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <SDL2/SDL_vulkan.h>
 
+namespace
+{
+/// GLSL source of each PipelineShader, relative to the watched directory.
+constexpr const char* shader_sources[pipeline_shader_count] = {
+	"shader.vert",
+	"shader.frag",
+	"depth.vert",
+};
+
+/// GLSL source of each ComputeShader, relative to the watched directory.
+constexpr const char* compute_shader_sources[compute_shader_count] = {
+	"normals.comp",
+	"skinning.comp",
+};
+
+/// Permutations used by the frame. The light direction is a specialization constant of shader.vert.
+const PipelineDesc color_pipeline_desc = {};
+
+const PipelineDesc wireframe_pipeline_desc = {
+	.polygon_mode = VK_POLYGON_MODE_LINE,
+};
+
+/// Depth pre-pass: vertex stage and position stream only, no color write.
+const PipelineDesc depth_prepass_pipeline_desc = {
+	.vertex_shader = PipelineShader::DepthVertex,
+	.fragment_shader = PipelineShader::None,
+	.vertex_streams = 1,
+	.color_write = VK_FALSE,
+	.features = 0,
+};
+
+/// Color pass after the pre-pass: depth is already resolved, shade only the visible samples.
+const PipelineDesc depth_equal_pipeline_desc = {
+	.depth_compare = VK_COMPARE_OP_EQUAL,
+	.depth_write = VK_FALSE,
+};
+
+const float     camera_fov  = glm::radians(45.0f);
+constexpr float camera_near = 0.1f;
+
+/// Without reverse-Z, and the length of the picking ray.
+constexpr float camera_far = 10000.0f;
+
+/// Gfx::CreateDevice for a single queue, with feature structures chained to the create info.
+/// @param p_next	VkPhysicalDevice*Features chain, the features it enables must be supported.
+void CreateDeviceWithFeatureChain(
+	VkPhysicalDevice                gpu,
+	uint32_t                        queue_family_index,
+	uint32_t                        extension_count,
+	const char* const*              p_extensions,
+	const VkPhysicalDeviceFeatures* p_features,
+	const void*                     p_next,
+	VkAllocationCallbacks*          p_allocator,
+	VkDevice*                       p_device)
+{
+	constexpr float queue_priority = 1.0f;
+
+	const VkDeviceQueueCreateInfo queue_create_info = {
+		.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.queueFamilyIndex = queue_family_index,
+		.queueCount = 1,
+		.pQueuePriorities = &queue_priority,
+	};
+
+	const VkDeviceCreateInfo device_create_info = {
+		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+		.pNext = p_next,
+		.flags = 0,
+		.queueCreateInfoCount = 1,
+		.pQueueCreateInfos = &queue_create_info,
+		.enabledLayerCount = 0,
+		.ppEnabledLayerNames = nullptr,
+		.enabledExtensionCount = extension_count,
+		.ppEnabledExtensionNames = p_extensions,
+		.pEnabledFeatures = p_features,
+	};
+
+	VK_CHECK(vkCreateDevice(
+		gpu,
+		&device_create_info,
+		p_allocator,
+		p_device));
+}
+}
 
-void VkApp::Init()
+
+void VkApp::Init(const VkAppSettings& settings)
 {
-	// Init the window class
-	VK_CHECK((SDL_Init(SDL_INIT_VIDEO) == 0)
-		? VK_SUCCESS
-		: VK_ERROR_UNKNOWN);
+	ADRO_PROFILE_THREAD("Main");
+	ADRO_PROFILE_FUNCTION();
+
+	settings_ = settings;
 
-	window_ = SDL_CreateWindow(
-		"Adro Engine",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		640,
-		480,
-		SDL_WINDOW_VULKAN);
+	// Shaders are mapped and paged in on the workers while the device is being created.
+	std::future<FileView> vert_shader_file  = FileSystem::MapFileAsync(thread_pool_, "../Resources/Shaders/vert.spv");
+	std::future<FileView> frag_shader_file  = FileSystem::MapFileAsync(thread_pool_, "../Resources/Shaders/frag.spv");
+	std::future<FileView> depth_shader_file = FileSystem::MapFileAsync(thread_pool_, "../Resources/Shaders/depth.spv");
+
+	std::future<FileView> normals_shader_file = {};
+	if (settings_.compute_normals)
+	{
+		normals_shader_file = FileSystem::MapFileAsync(thread_pool_, "../Resources/Shaders/normals.spv");
+	}
+
+	// Whether the mesh is skinned is only known once it's loaded, unused otherwise.
+	std::future<FileView> skinning_shader_file = FileSystem::MapFileAsync(
+		thread_pool_,
+		"../Resources/Shaders/skinning.spv");
+
+	// Init the window class
+	if (!settings_.headless)
+	{
+		VK_CHECK((SDL_Init(SDL_INIT_VIDEO) == 0)
+			? VK_SUCCESS
+			: VK_ERROR_UNKNOWN);
+
+		window_ = SDL_CreateWindow(
+			"Adro Engine",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			static_cast<int>(settings_.width),
+			static_cast<int>(settings_.height),
+			SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+	}
 
 	VK_CHECK(volkInitialize());
 
-	// Create the custom allocator
-	allocator_ = static_cast<VkAllocationCallbacks>(Gfx::Allocator());
+	// Create the custom allocator. pUserData points to host_allocator_, which lives as long as the app.
+	allocator_ = static_cast<VkAllocationCallbacks>(host_allocator_);
 
-	// @todo:	calculate the layers count from the array.
-	constexpr uint32_t requested_layer_count                   = 1;
-	const char*        requested_layers[requested_layer_count] = {
+	const char* requested_layers[] = {
 		"VK_LAYER_KHRONOS_validation"
 	};
 
-	// @todo:	calculate the extension count from the array.
-	constexpr uint32_t requested_extension_count                       = 3;
-	const char*        requested_extensions[requested_extension_count] = {
-		VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+	const uint32_t requested_layer_count = settings_.validation
+		? 1
+		: 0;
+
+	std::vector<const char*> requested_extensions = {
 		VK_KHR_SURFACE_EXTENSION_NAME,
-		VK_KHR_WIN32_SURFACE_EXTENSION_NAME
 	};
 
-	Gfx::CreateInstance(
-		requested_layer_count,
-		requested_layers,
-		requested_extension_count,
-		requested_extensions,
-		nullptr,
-		&instance_);
+	if (settings_.validation)
+	{
+		requested_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+
+	// The headless surface is platform independent, it is what lets the benchmark run on a software driver.
+	requested_extensions.push_back(settings_.headless
+		? VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME
+		: VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+
+	{
+		ADRO_PROFILE_SCOPE("Gfx::CreateInstance");
+		Gfx::CreateInstance(
+			requested_layer_count,
+			requested_layers,
+			static_cast<uint32_t>(requested_extensions.size()),
+			requested_extensions.data(),
+			&allocator_,
+			&instance_);
+	}
 
 	volkLoadInstance(instance_);
 
-	Gfx::CreateDebugMessenger(
-		instance_,
-		nullptr,
-		&debug_messenger_);
+	if (settings_.validation)
+	{
+		Gfx::CreateDebugMessenger(
+			instance_,
+			&allocator_,
+			&debug_messenger_);
+	}
+
+	// Create the surface. SDL doesn't take allocation callbacks, so both surfaces use the driver allocator.
+	if (settings_.headless)
+	{
+		const VkHeadlessSurfaceCreateInfoEXT headless_surface_create_info = {
+			.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+			.pNext = nullptr,
+			.flags = 0,
+		};
 
-	// Create the surface
-	VK_CHECK(SDL_Vulkan_CreateSurface(
-			window_,
+		VK_CHECK(vkCreateHeadlessSurfaceEXT(
 			instance_,
-			&surface_)
-		? VK_SUCCESS
-		: VK_ERROR_UNKNOWN);
+			&headless_surface_create_info,
+			nullptr,
+			&surface_));
+	}
+	else
+	{
+		VK_CHECK(SDL_Vulkan_CreateSurface(
+				window_,
+				instance_,
+				&surface_)
+			? VK_SUCCESS
+			: VK_ERROR_UNKNOWN);
+	}
 
 	// List the required gpu features
 	const VkPhysicalDeviceFeatures gpu_required_features = {
@@ -117,16 +272,106 @@ void VkApp::Init()
 		nullptr,
 		&queue_family_index);
 
-	constexpr uint32_t queue_family_count = 1;
-	Gfx::CreateDevice(
+	// Optional extensions are enabled only when the selected gpu exposes them.
+	std::vector<const char*> enabled_device_extensions(
+		&device_extensions[0],
+		&device_extensions[requested_device_ext_count]);
+
+	bool calibrated_timestamps_supported = false;
+	Gfx::QueryDeviceExtensionSupport(
 		gpu_,
-		queue_family_count,
-		&queue_family_index,
-		requested_device_ext_count,
-		device_extensions,
-		&gpu_required_features,
-		nullptr,
-		&device_);
+		VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+		&calibrated_timestamps_supported);
+
+	if (calibrated_timestamps_supported)
+	{
+		enabled_device_extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
+
+	// Low latency: the present ids and the wait on them need both extensions and both features.
+	VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+		.pNext = nullptr,
+		.presentWait = VK_FALSE,
+	};
+
+	VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+		.pNext = &present_wait_features,
+		.presentId = VK_FALSE,
+	};
+
+	if (settings_.low_latency)
+	{
+		bool present_id_supported   = false;
+		bool present_wait_supported = false;
+
+		Gfx::QueryDeviceExtensionSupport(
+			gpu_,
+			VK_KHR_PRESENT_ID_EXTENSION_NAME,
+			&present_id_supported);
+
+		Gfx::QueryDeviceExtensionSupport(
+			gpu_,
+			VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+			&present_wait_supported);
+
+		// Vulkan 1.1 entry point, null on a 1.0 instance.
+		if (present_id_supported && present_wait_supported && vkGetPhysicalDeviceFeatures2)
+		{
+			VkPhysicalDeviceFeatures2 features = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+				.pNext = &present_id_features,
+				.features = {},
+			};
+
+			vkGetPhysicalDeviceFeatures2(gpu_, &features);
+		}
+
+		present_wait_ = present_id_features.presentId && present_wait_features.presentWait;
+
+		if (present_wait_)
+		{
+			enabled_device_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			enabled_device_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+		else
+		{
+			std::printf("[VK] VK_KHR_present_wait is not supported, the low latency mode only latches the camera\n");
+		}
+	}
+
+	{
+		ADRO_PROFILE_SCOPE("Gfx::CreateDevice");
+
+		// Gfx::CreateDevice doesn't chain feature structures, the present features need a create info of their own.
+		if (present_wait_)
+		{
+			CreateDeviceWithFeatureChain(
+				gpu_,
+				queue_family_index,
+				static_cast<uint32_t>(enabled_device_extensions.size()),
+				enabled_device_extensions.data(),
+				&gpu_required_features,
+				&present_id_features,
+				&allocator_,
+				&device_);
+		}
+		else
+		{
+			constexpr uint32_t queue_family_count = 1;
+
+			Gfx::CreateDevice(
+				gpu_,
+				queue_family_count,
+				&queue_family_index,
+				static_cast<uint32_t>(enabled_device_extensions.size()),
+				enabled_device_extensions.data(),
+				&gpu_required_features,
+				&allocator_,
+				&device_);
+		}
+	}
 
 	vkGetDeviceQueue(
 		device_,
@@ -139,40 +384,49 @@ void VkApp::Init()
 		VK_FORMAT_R8G8B8A8_SRGB,
 	};
 
-	VkSurfaceFormatKHR surface_format = {};
 	Gfx::QuerySurfaceFormat(
 		gpu_,
 		surface_,
 		required_surface_format_count,
 		required_surface_formats,
-		&surface_format);
+		&surface_format_);
 
 	Gfx::QuerySurfaceCapabilities(
 		gpu_,
 		surface_,
 		&surface_capabilities_);
 
+	ResolveSurfaceExtent();
+
 	Gfx::CreateSwapchain(
 		device_,
 		surface_,
-		&surface_format,
+		&surface_format_,
 		&surface_capabilities_,
 		// At this point is VK_NULL_HANDLE
 		swapchain_,
-		nullptr,
+		&allocator_,
 		&swapchain_);
 
+	// Every per image resource is sized by it, recreated swapchains keep it. The driver may create more images than
+	// minImageCount, so it's the count of the swapchain actually created.
+	VK_CHECK(vkGetSwapchainImagesKHR(
+		device_,
+		swapchain_,
+		&swapchain_image_count_,
+		nullptr));
+
 	// Resize per-frame presentation
-	presentation_frames_.images.resize(surface_capabilities_.minImageCount);
-	presentation_frames_.image_views.resize(surface_capabilities_.minImageCount);
-	presentation_frames_.framebuffers.resize(surface_capabilities_.minImageCount);
+	presentation_frames_.images.resize(swapchain_image_count_);
+	presentation_frames_.image_views.resize(swapchain_image_count_);
+	presentation_frames_.framebuffers.resize(swapchain_image_count_);
 
 	// Resize per-frame data (Uniform Buffer)
-	per_frame_data_buffers_.resize(surface_capabilities_.minImageCount);
-	per_frame_data_mapped_.resize(surface_capabilities_.minImageCount);
-	per_frame_data_memories_.resize(surface_capabilities_.minImageCount);
+	per_frame_data_buffers_.resize(swapchain_image_count_);
+	per_frame_data_mapped_.resize(swapchain_image_count_);
+	per_frame_data_memories_.resize(swapchain_image_count_);
 
-	for (uint32_t i = 0; i < surface_capabilities_.minImageCount; i++)
+	for (uint32_t i = 0; i < swapchain_image_count_; i++)
 	{
 		constexpr VkDeviceSize buffer_size = sizeof(Graphics::PerFrameData);
 
@@ -182,125 +436,112 @@ void VkApp::Init()
 			buffer_size,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			nullptr,
+			&allocator_,
 			&per_frame_data_buffers_[i],
 			&per_frame_data_memories_[i]);
-	}
 
-	Gfx::QuerySwapchainImages(
-		device_,
-		swapchain_,
-		&presentation_frames_.images[0]);
+		// Mapped until TearDown, the camera can be written at any point of the frame (WriteCamera).
+		VK_CHECK(vkMapMemory(
+			device_,
+			per_frame_data_memories_[i],
+			0,
+			buffer_size,
+			0,
+			&per_frame_data_mapped_[i]));
+	}
 
-	for (uint32_t i = 0; i < surface_capabilities_.minImageCount; i++)
+	// GPU picking readback, one id per buffer, mapped until TearDown.
+	if (settings_.id_buffer)
 	{
-		Gfx::CreateImageView(
-			device_,
-			presentation_frames_.images[i],
-			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_VIEW_TYPE_2D,
-			surface_format.format,
-			{
-				VK_COMPONENT_SWIZZLE_IDENTITY,
-				VK_COMPONENT_SWIZZLE_IDENTITY,
-				VK_COMPONENT_SWIZZLE_IDENTITY,
-				VK_COMPONENT_SWIZZLE_IDENTITY},
-			nullptr,
-			&presentation_frames_.image_views[i]);
+		for (GpuPickReadback& readback : gpu_pick_readbacks_)
+		{
+			Gfx::CreateBuffer(
+				device_,
+				gpu_,
+				sizeof(uint32_t),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&allocator_,
+				&readback.buffer,
+				&readback.memory);
+
+			void* mapped = nullptr;
+			VK_CHECK(vkMapMemory(
+				device_,
+				readback.memory,
+				0,
+				VK_WHOLE_SIZE,
+				0,
+				&mapped));
+
+			readback.mapped = static_cast<const uint32_t*>(mapped);
+		}
 	}
 
 	// Sample image resolver
-	VkSampleCountFlagBits sample_counts = VK_SAMPLE_COUNT_1_BIT;
 	Gfx::QuerySampleCounts(
 		gpu_,
-		&sample_counts);
-
-	Gfx::CreateImage(
-		device_,
-		gpu_,
-		VK_IMAGE_TYPE_2D,
-		surface_format.format,
-		{
-			surface_capabilities_.currentExtent.width,
-			surface_capabilities_.currentExtent.height,
-			1
-		},
-		sample_counts,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		nullptr,
-		&framebuffer_sample_image_,
-		&framebuffer_sample_image_memory_);
-
-	Gfx::CreateImageView(
-		device_,
-		framebuffer_sample_image_,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		VK_IMAGE_VIEW_TYPE_2D,
-		surface_format.format,
-		{
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY
-		},
-		nullptr,
-		&framebuffer_sample_image_view_);
-
-	// Depth + Stencil
+		&sample_counts_);
 
-	constexpr VkFormat depth_stencil_format_requested[] = {
-		VK_FORMAT_D32_SFLOAT_S8_UINT,
-		VK_FORMAT_D24_UNORM_S8_UINT,
-		VK_FORMAT_D24_UNORM_S8_UINT,
-		VK_FORMAT_D16_UNORM_S8_UINT,
+	// Depth, no pass uses stencil. Float first: reverse-Z only gains precision from the floating point exponent.
+	constexpr VkFormat depth_format_requested[] = {
+		VK_FORMAT_D32_SFLOAT,
+		VK_FORMAT_X8_D24_UNORM_PACK32,
+		VK_FORMAT_D16_UNORM,
 	};
 
-	VkFormat depth_stencil_format = {};
-
 	Gfx::QuerySupportedFormat(
 		gpu_,
-		4,
-		&depth_stencil_format_requested[0],
+		3,
+		&depth_format_requested[0],
 		VK_IMAGE_TILING_OPTIMAL,
 		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		&depth_stencil_format);
+		&depth_format_);
 
-	Gfx::CreateImage(
+	// Object ids: the color attachments of a subpass share the sample count, integer formats may support fewer.
+	if (settings_.id_buffer)
+	{
+		VkImageFormatProperties id_format_properties = {};
+
+		const VkResult id_format_result = vkGetPhysicalDeviceImageFormatProperties(
+			gpu_,
+			VK_FORMAT_R32_UINT,
+			VK_IMAGE_TYPE_2D,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+			0,
+			&id_format_properties);
+
+		VK_CHECK((id_format_result == VK_SUCCESS && (id_format_properties.sampleCounts & sample_counts_))
+			? VK_SUCCESS
+			: VK_ERROR_FORMAT_NOT_SUPPORTED);
+	}
+
+	CreateSizeDependentResources();
+
+	// 16 scopes per frame are plenty for the current passes.
+	constexpr uint32_t gpu_profiler_max_scopes = 16;
+	gpu_profiler_.Init(
 		device_,
 		gpu_,
-		VK_IMAGE_TYPE_2D,
-		depth_stencil_format,
-		{surface_capabilities_.currentExtent.width, surface_capabilities_.currentExtent.width, 1},
-		sample_counts,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		nullptr,
-		&depth_stencil_image_,
-		&depth_stencil_memory_);
+		&allocator_,
+		queue_family_index,
+		swapchain_image_count_,
+		gpu_profiler_max_scopes,
+		calibrated_timestamps_supported);
 
-	Gfx::CreateImageView(
-		device_,
-		depth_stencil_image_,
-		VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
-		VK_IMAGE_VIEW_TYPE_2D,
-		depth_stencil_format,
-		{
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY,
-			VK_COMPONENT_SWIZZLE_IDENTITY
-		},
-		nullptr,
-		&depth_stencil_image_view_);
+	// A single fence guards the submission, so only one frame is in flight.
+	constexpr uint32_t frames_in_flight     = 1;
+	constexpr size_t   frame_scratch_budget = 1024 * 1024;
+	frame_allocator_.Init(
+		frames_in_flight,
+		frame_scratch_budget);
 
 	Gfx::CreateCommandPool(
 		device_,
 		VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
 		queue_family_index,
-		nullptr,
+		&allocator_,
 		&command_pool_);
 
 	Gfx::CreateCommandBuffer(
@@ -312,139 +553,72 @@ void VkApp::Init()
 
 	Gfx::CreateSemaphore(
 		device_,
-		nullptr,
+		&allocator_,
 		&image_available_semaphore_);
 
 	Gfx::CreateSemaphore(
 		device_,
-		nullptr,
+		&allocator_,
 		&render_finished_semaphore_);
 
 	Gfx::CreateFence(
 		device_,
-		nullptr,
+		&allocator_,
 		&submit_finished_fence_);
 
-	Batch batch = {};
-	Mesh::Load("../Resources/Meshes/lucy.obj", &batch);
-	std::vector<glm::vec4> default_colors(batch.position.size(), glm::vec4(.5f, .5f, .5f, 1.0f));
-	batch.color = default_colors;
-
-	const size_t position_buffer_size = sizeof(glm::vec3) * batch.position.size();
-	Gfx::CreateBuffer(
-		device_,
-		gpu_,
-		position_buffer_size,
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-		nullptr,
-		&batch_render_.position_buffer,
-		&batch_render_.position_memory);
-
-	void* position_data = nullptr;
-	VK_CHECK(vkMapMemory(
-		device_,
-		batch_render_.position_memory,
-		0,
-		position_buffer_size,
-		0,
-		&position_data));
-
-	memcpy(
-		position_data,
-		&batch.position[0],
-		position_buffer_size);
-
-	vkUnmapMemory(
-		device_,
-		batch_render_.position_memory);
-
-	const size_t normal_buffer_size = sizeof(glm::vec3) * batch.normals.size();
-	Gfx::CreateBuffer(
-		device_,
-		gpu_,
-		normal_buffer_size,
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-		nullptr,
-		&batch_render_.normal_buffer,
-		&batch_render_.normal_memory);
-
-	void* normal_data = nullptr;
-	VK_CHECK(vkMapMemory(
-		device_,
-		batch_render_.normal_memory,
-		0,
-		normal_buffer_size,
-		0,
-		&normal_data));
-
-	memcpy(
-		normal_data,
-		&batch.normals[0],
-		normal_buffer_size);
+	if (settings_.compute_normals)
+	{
+		const FileView normals_shader = normals_shader_file.get();
 
-	vkUnmapMemory(
-		device_,
-		batch_render_.normal_memory);
+		normal_generator_.Init(
+			device_,
+			gpu_,
+			&allocator_,
+			std::span(
+				reinterpret_cast<const uint32_t*>(normals_shader.GetData()),
+				normals_shader.GetSize() / sizeof(uint32_t)));
+	}
 
-	const size_t color_buffer_size = sizeof(glm::vec4) * batch.color.size();
-	Gfx::CreateBuffer(
-		device_,
-		gpu_,
-		color_buffer_size,
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-		nullptr,
-		&batch_render_.color_buffer,
-		&batch_render_.color_memory);
+	// Binary glTF goes from the mapped file straight into the vertex buffers, the other formats through a Batch.
+	const FileView mesh_file = std::string_view(settings_.mesh_path).ends_with(".glb")
+		? FileSystem::MapFile(settings_.mesh_path, FileSystem::AccessHint::Sequential)
+		: FileView();
 
-	void* color_data = nullptr;
-	VK_CHECK(vkMapMemory(
-		device_,
-		batch_render_.color_memory,
-		0,
-		color_buffer_size,
-		0,
-		&color_data));
+	GltfAsset asset = {};
+	Batch     batch = {};
 
-	memcpy(
-		color_data,
-		&batch.color[0],
-		color_buffer_size);
+	const bool direct_upload = mesh_file.GetSize() > 0 &&
+	                           asset.Load(std::span(mesh_file.GetData(), mesh_file.GetSize()), &thread_pool_);
 
-	vkUnmapMemory(
-		device_,
-		batch_render_.color_memory);
+	if (!direct_upload)
+	{
+		Mesh::Load(settings_.mesh_path, &batch);
+	}
 
-	const size_t index_buffer_size = sizeof(uint32_t) * batch.indices.size();
-	Gfx::CreateBuffer(
-		device_,
-		gpu_,
-		index_buffer_size,
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-		nullptr,
-		&batch_render_.index_buffer,
-		&batch_render_.index_memory);
+	// Only meshes with both bones and clips are skinned, the others are drawn in their bind pose.
+	skinning_ = !batch.joints.empty() && !batch.clips.empty();
 
-	void* index_data = nullptr;
-	VK_CHECK(vkMapMemory(
-		device_,
-		batch_render_.index_memory,
-		0,
-		index_buffer_size,
-		0,
-		&index_data));
+	if (skinning_)
+	{
+		const FileView skinning_shader = skinning_shader_file.get();
 
-	memcpy(
-		index_data,
-		&batch.indices[0],
-		index_buffer_size);
+		skinner_.Init(
+			device_,
+			gpu_,
+			&allocator_,
+			std::span(
+				reinterpret_cast<const uint32_t*>(skinning_shader.GetData()),
+				skinning_shader.GetSize() / sizeof(uint32_t)));
+	}
 
-	vkUnmapMemory(
-		device_,
-		batch_render_.index_memory);
+	if (direct_upload)
+	{
+		UploadAsset(asset);
+	}
+	else
+	{
+		UploadBatch(batch);
+	}
 
 	// Render Pass
 
@@ -453,8 +627,8 @@ void VkApp::Init()
 
 	const VkAttachmentDescription color_attachment = {
 		.flags = VK_ATTACHMENT_LOAD_OP_CLEAR,
-		.format = surface_format.format,
-		.samples = sample_counts,
+		.format = surface_format_.format,
+		.samples = sample_counts_,
 		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
 		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
 		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
@@ -470,7 +644,7 @@ void VkApp::Init()
 
 	const VkAttachmentDescription color_attachment_resolve = {
 		.flags = VK_ATTACHMENT_LOAD_OP_CLEAR,
-		.format = surface_format.format,
+		.format = surface_format_.format,
 		.samples = VK_SAMPLE_COUNT_1_BIT,
 		.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
@@ -485,14 +659,14 @@ void VkApp::Init()
 		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 	};
 
-	// Depth + stencil
+	// Depth
 	const VkAttachmentDescription depth_attachment = {
 		.flags = VK_ATTACHMENT_LOAD_OP_CLEAR,
-		.format = depth_stencil_format,
-		.samples = sample_counts,
+		.format = depth_format_,
+		.samples = sample_counts_,
 		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
 		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
 		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 		.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
@@ -503,276 +677,122 @@ void VkApp::Init()
 		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
 	};
 
-	const VkSubpassDescription subpass = {
+	// Object ids (VkAppSettings::id_buffer), cleared to 0 (nothing drawn).
+	const VkAttachmentDescription id_attachment = {
 		.flags = 0,
-		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-		.inputAttachmentCount = 0,
+		.format = VK_FORMAT_R32_UINT,
+		.samples = sample_counts_,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+	};
+
+	// Integer formats resolve to a single sample (not an average), an id of a triangle drawn over the pixel.
+	const VkAttachmentDescription id_attachment_resolve = {
+		.flags = 0,
+		.format = VK_FORMAT_R32_UINT,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	};
+
+	const VkAttachmentReference color_attachment_refs[2] = {
+		color_attachment_ref,
+		{
+			.attachment = 3,
+			.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		},
+	};
+
+	const VkAttachmentReference color_attachment_resolve_refs[2] = {
+		color_attachment_resolve_ref,
+		{
+			.attachment = 4,
+			.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		},
+	};
+
+	const uint32_t color_attachment_count = settings_.id_buffer
+		? 2
+		: 1;
+
+	const VkSubpassDescription subpass = {
+		.flags = 0,
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.inputAttachmentCount = 0,
 		.pInputAttachments = nullptr,
-		.colorAttachmentCount = 1,
-		.pColorAttachments = &color_attachment_ref,
-		.pResolveAttachments = &color_attachment_resolve_ref,
+		.colorAttachmentCount = color_attachment_count,
+		.pColorAttachments = &color_attachment_refs[0],
+		.pResolveAttachments = &color_attachment_resolve_refs[0],
 		.pDepthStencilAttachment = &depth_attachment_reference,
 		.preserveAttachmentCount = 0,
 		.pPreserveAttachments = nullptr,
 	};
 
-	constexpr VkSubpassDependency dependency = {
-		.srcSubpass = VK_SUBPASS_EXTERNAL,
-		.dstSubpass = 0,
-		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		.srcAccessMask = 0,
-		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-		.dependencyFlags = 0,
+	// The second one makes the copy of the picked id (RecordGpuPick) wait for the resolve.
+	constexpr VkSubpassDependency dependencies[2] = {
+		{
+			.srcSubpass = VK_SUBPASS_EXTERNAL,
+			.dstSubpass = 0,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			.dependencyFlags = 0,
+		},
+		{
+			.srcSubpass = 0,
+			.dstSubpass = VK_SUBPASS_EXTERNAL,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+			.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+			.dependencyFlags = 0,
+		},
 	};
 
-	constexpr uint32_t            attachment_desc_count                   = 3;
-	const VkAttachmentDescription attachment_descs[attachment_desc_count] = {
+	const VkAttachmentDescription attachment_descs[5] = {
 		color_attachment,
 		depth_attachment,
 		color_attachment_resolve,
+		id_attachment,
+		id_attachment_resolve,
 	};
 
 	const VkRenderPassCreateInfo render_pass_create_info = {
 		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
-		.attachmentCount = attachment_desc_count,
+		.attachmentCount = settings_.id_buffer
+			? 5u
+			: 3u,
 		.pAttachments = &attachment_descs[0],
 		.subpassCount = 1,
 		.pSubpasses = &subpass,
-		.dependencyCount = 1,
-		.pDependencies = &dependency,
+		.dependencyCount = settings_.id_buffer
+			? 2u
+			: 1u,
+		.pDependencies = &dependencies[0],
 	};
 
 	VK_CHECK(vkCreateRenderPass(
 		device_,
 		&render_pass_create_info,
-		nullptr,
+		&allocator_,
 		&render_pass_));
 
-	for (size_t i = 0; i < surface_capabilities_.minImageCount; i++)
-	{
-		constexpr uint32_t attachments_count              = 3;
-		const VkImageView  attachments[attachments_count] = {
-			framebuffer_sample_image_view_, // Multisample
-			depth_stencil_image_view_,
-			presentation_frames_.image_views[i], // Multisample resolver to 1 sample.
-		};
-
-		VkFramebufferCreateInfo framebuffer_info = {
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.renderPass = render_pass_,
-			.attachmentCount = attachments_count,
-			.pAttachments = &attachments[0],
-			.width = surface_capabilities_.currentExtent.width,
-			.height = surface_capabilities_.currentExtent.height,
-			.layers = 1,
-		};
-
-		VK_CHECK(vkCreateFramebuffer(
-			device_,
-			&framebuffer_info,
-			nullptr,
-			&presentation_frames_.framebuffers[i]));
-	}
+	CreateFramebuffers();
 
 	// @todo:	Pipelines are per-application specific as well.
 	//			We should provide the most common ones in another library that depends on Graphics.
 
-	auto vert_shader_code = FileSystem::ReadFile("../Resources/Shaders/vert.spv");
-	auto frag_shader_code = FileSystem::ReadFile("../Resources/Shaders/frag.spv");
-
-	VkShaderModule shader_modules[2] = {};
-	Gfx::CreateShaderModule(
-		device_,
-		static_cast<uint32_t>(vert_shader_code.size()),
-		vert_shader_code.data(),
-		nullptr,
-		&shader_modules[0]);
-
-	Gfx::CreateShaderModule(
-		device_,
-		static_cast<uint32_t>(frag_shader_code.size()),
-		frag_shader_code.data(),
-		nullptr,
-		&shader_modules[1]);
-
-	const VkPipelineShaderStageCreateInfo vert_shader_stage_create_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.stage = VK_SHADER_STAGE_VERTEX_BIT,
-		.module = shader_modules[0],
-		.pName = "main",
-		.pSpecializationInfo = nullptr,
-	};
-
-	const VkPipelineShaderStageCreateInfo frag_shader_stage_create_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-		.module = shader_modules[1],
-		.pName = "main",
-		.pSpecializationInfo = nullptr,
-	};
-
-	const VkPipelineShaderStageCreateInfo shaderStages[] = {vert_shader_stage_create_info,
-	                                                        frag_shader_stage_create_info};
-
-	const std::vector<VkDynamicState> dynamic_states = {
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR,
-	};
-
-	const VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
-		.pDynamicStates = dynamic_states.data(),
-	};
-
-	const VkVertexInputBindingDescription bind_descs[] = {
-		// position
-		{
-			.binding = 0,
-			.stride = sizeof(glm::vec3),
-			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
-		},
-		// color.
-		{
-			.binding = 1,
-			.stride = sizeof(glm::vec4),
-			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
-		},
-		// normal.
-		{
-			.binding = 2,
-			.stride = sizeof(glm::vec3),
-			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
-		}
-	};
-
-	const VkVertexInputAttributeDescription attribute_description[3] = {
-		{
-			.location = 0,
-			.binding = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = 0
-		},
-		{
-			.location = 1,
-			.binding = 1,
-			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
-			.offset = 0
-		},
-		{
-			.location = 2,
-			.binding = 2,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = 0
-		}
-	};
-
-	const VkPipelineVertexInputStateCreateInfo vertex_input_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.vertexBindingDescriptionCount = 3,
-		.pVertexBindingDescriptions = &bind_descs[0],
-		.vertexAttributeDescriptionCount = 3,
-		.pVertexAttributeDescriptions = &attribute_description[0],
-	};
-
-	constexpr VkPipelineInputAssemblyStateCreateInfo input_assembly_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-		.primitiveRestartEnable = VK_FALSE,
-	};
-
-	const VkViewport viewport = {
-		.x = 0.0f,
-		.y = 0.0f,
-		.width = static_cast<float>(surface_capabilities_.currentExtent.width),
-		.height = static_cast<float>(surface_capabilities_.currentExtent.height),
-		.minDepth = 0.0f,
-		.maxDepth = 1.0f,
-	};
-
-	const VkRect2D scissor = {
-		.offset = {0, 0},
-		.extent = surface_capabilities_.currentExtent,
-	};
-
-	// ReSharper disable once CppVariableCanBeMadeConstexpr
-	const VkPipelineViewportStateCreateInfo viewport_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.viewportCount = 1,
-		.pViewports = &viewport,
-		.scissorCount = 1,
-		.pScissors = &scissor,
-	};
-
-	constexpr VkPipelineRasterizationStateCreateInfo rasterization_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.depthClampEnable = VK_FALSE,
-		.rasterizerDiscardEnable = VK_FALSE,
-		.polygonMode = VK_POLYGON_MODE_FILL,
-		.cullMode = VK_CULL_MODE_BACK_BIT,
-		.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-		.depthBiasEnable = VK_FALSE,
-		.depthBiasConstantFactor = 0.0f,
-		.depthBiasClamp = 0.0f,
-		.depthBiasSlopeFactor = 0.0f,
-		.lineWidth = 1.0f,
-	};
-
-	const VkPipelineMultisampleStateCreateInfo multisample_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.rasterizationSamples = sample_counts,
-		.sampleShadingEnable = VK_FALSE,
-		.minSampleShading = 1.0f,
-		.pSampleMask = nullptr,
-		.alphaToCoverageEnable = VK_FALSE,
-		.alphaToOneEnable = VK_FALSE,
-	};
-
-	const VkPipelineColorBlendAttachmentState color_blend_attachment = {
-		.blendEnable = VK_FALSE,
-		.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-		.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-		.colorBlendOp = VK_BLEND_OP_ADD,
-		.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-		.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-		.alphaBlendOp = VK_BLEND_OP_ADD,
-		.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
-		                  VK_COLOR_COMPONENT_A_BIT,
-	};
-
-	// ReSharper disable once CppVariableCanBeMadeConstexpr
-	const VkPipelineColorBlendStateCreateInfo color_blend_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.logicOpEnable = VK_FALSE,
-		.logicOp = VK_LOGIC_OP_COPY,
-		.attachmentCount = 1,
-		.pAttachments = &color_blend_attachment,
-		.blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
-	};
-
 	const VkDescriptorSetLayoutBinding u_buffer_set_binding = {
 		.binding = 0,
 		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
@@ -790,7 +810,7 @@ void VkApp::Init()
 	VK_CHECK(vkCreateDescriptorSetLayout(
 		device_,
 		&layout_info,
-		nullptr,
+		&allocator_,
 		&descriptor_set_layout_));
 
 	const VkPipelineLayoutCreateInfo pipeline_layout_info = {
@@ -806,112 +826,54 @@ void VkApp::Init()
 	VK_CHECK(vkCreatePipelineLayout(
 		device_,
 		&pipeline_layout_info,
-		nullptr,
+		&allocator_,
 		&pipeline_layout_));
 
-	// depth + stencil
-	const VkPipelineDepthStencilStateCreateInfo depth_stencil_state_create_info = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-		.depthTestEnable = VK_TRUE,
-		.depthWriteEnable = VK_TRUE,
-		.depthCompareOp = VK_COMPARE_OP_LESS,
-		.depthBoundsTestEnable = VK_FALSE,
-		.stencilTestEnable = VK_FALSE,
-		.front = {},
-		.back = {},
-		.minDepthBounds = 0.0f,
-		.maxDepthBounds = 1.0f,
-	};
-
-	const VkGraphicsPipelineCreateInfo pipeline_info = {
-		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.stageCount = 2,
-		.pStages = shaderStages,
-		.pVertexInputState = &vertex_input_info,
-		.pInputAssemblyState = &input_assembly_info,
-		.pTessellationState = nullptr,
-		.pViewportState = &viewport_info,
-		.pRasterizationState = &rasterization_info,
-		.pMultisampleState = &multisample_info,
-		.pDepthStencilState = &depth_stencil_state_create_info,
-		.pColorBlendState = &color_blend_info,
-		.pDynamicState = &dynamic_state_create_info,
-		.layout = pipeline_layout_,
-		.renderPass = render_pass_,
-		.subpass = 0,
-		.basePipelineHandle = VK_NULL_HANDLE,
-		.basePipelineIndex = -1,
-	};
-
-	constexpr VkPipelineRasterizationStateCreateInfo rasterization_info_wireframe = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.depthClampEnable = VK_FALSE,
-		.rasterizerDiscardEnable = VK_FALSE,
-		.polygonMode = VK_POLYGON_MODE_LINE,
-		.cullMode = VK_CULL_MODE_BACK_BIT,
-		.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-		.depthBiasEnable = VK_FALSE,
-		.depthBiasConstantFactor = 0.0f,
-		.depthBiasClamp = 0.0f,
-		.depthBiasSlopeFactor = 0.0f,
-		.lineWidth = 1.0f,
-	};
-
-	const VkGraphicsPipelineCreateInfo pipeline_info_wireframe = {
-		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.stageCount = 2,
-		.pStages = shaderStages,
-		.pVertexInputState = &vertex_input_info,
-		.pInputAssemblyState = &input_assembly_info,
-		.pTessellationState = nullptr,
-		.pViewportState = &viewport_info,
-		.pRasterizationState = &rasterization_info_wireframe,
-		.pMultisampleState = &multisample_info,
-		.pDepthStencilState = &depth_stencil_state_create_info,
-		.pColorBlendState = &color_blend_info,
-		.pDynamicState = &dynamic_state_create_info,
-		.layout = pipeline_layout_,
-		.renderPass = render_pass_,
-		.subpass = 0,
-		.basePipelineHandle = VK_NULL_HANDLE,
-		.basePipelineIndex = -1,
+	pipeline_manager_.Init(
+		device_,
+		&allocator_,
+		pipeline_layout_,
+		render_pass_,
+		sample_counts_,
+		color_attachment_count,
+		settings_.reverse_z,
+		&thread_pool_);
+
+	const FileView shader_files[3] = {
+		vert_shader_file.get(),
+		frag_shader_file.get(),
+		depth_shader_file.get(),
 	};
 
-	VkGraphicsPipelineCreateInfo pipeline_infos[] = {
-		pipeline_info,
-		pipeline_info_wireframe,
-	};
+	for (uint32_t i = 0; i < pipeline_shader_count; i++)
+	{
+		const uint32_t* code = reinterpret_cast<const uint32_t*>(shader_files[i].GetData());
 
-	VkPipeline pipelines[] = {
-		pipeline_,
-		pipeline_wireframe_,
-	};
+		pipeline_manager_.SetShaderCode(
+			static_cast<PipelineShader>(i),
+			std::vector<uint32_t>(code, code + shader_files[i].GetSize() / sizeof(uint32_t)));
+	}
 
-	VK_CHECK(vkCreateGraphicsPipelines(
-		device_,
-		VK_NULL_HANDLE,
-		2,
-		&pipeline_infos[0],
-		nullptr,
-		&pipelines[0]));
+	// Needed by the first frame. The other permutations (wireframe) are compiled on a worker when first used.
+	pipeline_               = pipeline_manager_.GetBlocking(color_pipeline_desc);
+	pipeline_depth_prepass_ = pipeline_manager_.GetBlocking(depth_prepass_pipeline_desc);
+	pipeline_depth_equal_   = pipeline_manager_.GetBlocking(depth_equal_pipeline_desc);
 
-	pipeline_           = pipelines[0];
-	pipeline_wireframe_ = pipelines[1];
+#ifdef ADRO_SHADER_SOURCE_DIR
+	if (!settings_.headless)
+	{
+		shader_watcher_.Init(ADRO_SHADER_SOURCE_DIR);
+	}
+#endif
 
 	const VkDescriptorPoolSize pool_size = {
 		.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-		.descriptorCount = surface_capabilities_.minImageCount
+		.descriptorCount = swapchain_image_count_
 	};
 
 	VkDescriptorPoolCreateInfo pool_create_info = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		.maxSets = surface_capabilities_.minImageCount,
+		.maxSets = swapchain_image_count_,
 		.poolSizeCount = 1,
 		.pPoolSizes = &pool_size,
 	};
@@ -919,28 +881,28 @@ void VkApp::Init()
 	VK_CHECK(vkCreateDescriptorPool(
 		device_,
 		&pool_create_info,
-		nullptr,
+		&allocator_,
 		&descriptor_pool_));
 
 	std::vector<VkDescriptorSetLayout> layouts(
-		surface_capabilities_.minImageCount,
+		swapchain_image_count_,
 		descriptor_set_layout_);
 
 	VkDescriptorSetAllocateInfo set_allocate_info = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 		.descriptorPool = descriptor_pool_,
-		.descriptorSetCount = surface_capabilities_.minImageCount,
+		.descriptorSetCount = swapchain_image_count_,
 		.pSetLayouts = &layouts[0],
 	};
 
-	descriptor_sets_.resize(surface_capabilities_.minImageCount);
+	descriptor_sets_.resize(swapchain_image_count_);
 
 	VK_CHECK(vkAllocateDescriptorSets(
 		device_,
 		&set_allocate_info,
 		&descriptor_sets_[0]));
 
-	for (size_t i = 0; i < surface_capabilities_.minImageCount; i++)
+	for (size_t i = 0; i < swapchain_image_count_; i++)
 	{
 		VkDescriptorBufferInfo buffer_info = {
 			.buffer = per_frame_data_buffers_[i],
@@ -966,9 +928,6 @@ void VkApp::Init()
 			nullptr);
 	}
 
-	vkDestroyShaderModule(device_, shader_modules[0], nullptr);
-	vkDestroyShaderModule(device_, shader_modules[1], nullptr);
-
 	// Transition depth + stencil image layout.
 
 	const VkCommandBufferBeginInfo command_buffer_begin_info = {
@@ -986,9 +945,9 @@ void VkApp::Init()
 		.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 		.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-		.image = depth_stencil_image_,
+		.image = depth_image_,
 		.subresourceRange = {
-			.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
+			.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
 			.baseMipLevel = 0,
 			.levelCount = 1,
 			.baseArrayLayer = 0,
@@ -1040,324 +999,1830 @@ constexpr double targetFrameTime = 1000.0 / targetFPS; // in milliseconds
 void VkApp::Update()
 {
 	// Camera data
-	glm::vec3       camera_pos        = {0.0f, 140.0f, -1900.0f};
-	glm::vec3       camera_pos_new    = {0.0f, 140.0f, -1900.0f};
-	glm::vec3       camera_front      = {0.0f, 0.0f, 1.0f};
-	glm::vec3       camera_up         = {0.0f, 1.0f, 0.0f};
+	const glm::vec3 camera_up         = {0.0f, 1.0f, 0.0f};
 	constexpr float camera_move_speed = 200.639f;
 
 	constexpr float p         = 1.0f / 100.0f;
 	constexpr float t         = 0.396f;
 	const float     half_time = -t / glm::log2(p);
 
-	VkPipeline chosen_pipeline = pipeline_;
+	bool wireframe = false;
+
+	bool   stillRunning      = true;
+	bool   swapchain_dirty   = false;
+	Uint64 last_title_update = 0;
+
+	// Runs on the simulation thread at a fixed rate: the motion doesn't depend on the frame times.
+	const SimulationStep camera_step = [camera_up, half_time](
+		SimulationState* p_state,
+		uint32_t         held_actions,
+		float            step)
+	{
+		const glm::vec3 camera_right = glm::normalize(glm::cross(p_state->camera_front, camera_up));
+
+		if (held_actions & InputActionBit(InputAction::MoveForward))
+		{
+			p_state->camera_target += camera_move_speed * step * p_state->camera_front;
+		}
+
+		if (held_actions & InputActionBit(InputAction::MoveBackward))
+		{
+			p_state->camera_target -= camera_move_speed * step * p_state->camera_front;
+		}
+
+		if (held_actions & InputActionBit(InputAction::MoveLeft))
+		{
+			p_state->camera_target -= camera_move_speed * step * camera_right;
+		}
+
+		if (held_actions & InputActionBit(InputAction::MoveRight))
+		{
+			p_state->camera_target += camera_move_speed * step * camera_right;
+		}
+
+		const float camera_lerp_alpha = 1.0f - glm::pow(2.0f, -step / half_time);
+
+		p_state->camera_pos = glm::mix(p_state->camera_pos, p_state->camera_target, camera_lerp_alpha);
+	};
+
+	simulation_.Start(
+		{
+			.camera_pos = {0.0f, 140.0f, -1900.0f},
+			.camera_target = {0.0f, 140.0f, -1900.0f},
+			.camera_front = {0.0f, 0.0f, 1.0f},
+		},
+		camera_step);
+
+	// Called by DrawFrame after the fence wait and the acquire, right before the camera is written: the held
+	// actions reach the simulation as late as possible, and the camera is interpolated at that instant.
+	const CameraSampler sample_camera = [this](glm::vec3* p_camera_pos, glm::vec3* p_camera_front)
+	{
+		ADRO_PROFILE_SCOPE("Input Sampling");
+
+		input_.Pump();
+		simulation_.SetHeldActions(input_.GetHeldActions());
+
+		const SimulationState state = simulation_.Sample(input_.GetPumpTimestamp());
+
+		*p_camera_pos   = state.camera_pos;
+		*p_camera_front = state.camera_front;
+	};
 
-	bool stillRunning = true;
 	while (stillRunning)
 	{
+		ADRO_PROFILE_SCOPE("Frame");
+
 		LAST = NOW;
 		NOW  = SDL_GetPerformanceCounter();
 
 		// Calculate delta time in seconds
 		deltaTime = static_cast<double>(NOW - LAST) / static_cast<double>(SDL_GetPerformanceFrequency());
 
-		const float camera_lerp_alpha = 1.0f - glm::pow(2.0f, -static_cast<float>(deltaTime) / half_time);
+		// Discrete events: the held actions are sampled again by the camera, late in DrawFrame.
+		{
+			ADRO_PROFILE_SCOPE("Input");
+
+			input_.Pump();
+			simulation_.SetHeldActions(input_.GetHeldActions());
 
-		SDL_Event event;
+			for (const InputEvent& event : input_.GetEvents())
+			{
+				switch (event.type)
+				{
+				case InputEventType::Quit:
+					stillRunning = false;
+					break;
+
+				case InputEventType::Resized:
+					swapchain_dirty = true;
+					break;
+
+				case InputEventType::Pressed:
+					if (event.action == InputAction::Wireframe || event.action == InputAction::Filled)
+					{
+						wireframe = event.action == InputAction::Wireframe;
+					}
+					else if (event.action == InputAction::ToggleDepthPrepass)
+					{
+						depth_prepass_enabled_ = !depth_prepass_enabled_;
+					}
+					else if (event.action == InputAction::ExportTraces)
+					{
+						gpu_profiler_.ExportChromeTrace("gpu_trace.json");
+						ADRO_PROFILE_EXPORT("cpu_trace.json");
+						host_allocator_.PrintStatistics();
+					}
+					else if (event.action == InputAction::Pick)
+					{
+						PickAt(event.cursor);
+					}
+					break;
+
+				default:
+					// Do nothing.
+					break;
+				}
+			}
 
-		// Input state
+			input_.ClearEvents();
+		}
 
-		while (SDL_PollEvent(&event))
+		// Nothing can be presented while minimized: block on the event queue instead of spinning. The events are
+		// handled by the next frame.
+		while (stillRunning && (SDL_GetWindowFlags(window_) & SDL_WINDOW_MINIMIZED))
 		{
-			switch (event.type)
-			{
-			case SDL_QUIT:
-				stillRunning = false;
-				break;
+			SDL_WaitEvent(nullptr);
+			input_.Pump();
+			simulation_.SetHeldActions(input_.GetHeldActions());
 
-			default:
-				// Do nothing.
-				break;
-			}
+			stillRunning = std::ranges::none_of(
+				input_.GetEvents(),
+				[](const InputEvent& event)
+				{
+					return event.type == InputEventType::Quit;
+				});
+
+			swapchain_dirty = true;
+
+			// Don't count the time spent minimized as a frame.
+			NOW = SDL_GetPerformanceCounter();
 		}
 
-		const Uint8* key_states = SDL_GetKeyboardState(nullptr);
+		if (!stillRunning)
+		{
+			break;
+		}
 
-		if (key_states[SDL_SCANCODE_W])
+		if (swapchain_dirty)
 		{
-			camera_pos_new += camera_move_speed * static_cast<float>(deltaTime) * camera_front;
+			swapchain_dirty = !RecreateSwapchain();
+
+			// Zero extent without the minimized flag (e.g. while dragging): wait for the next window event.
+			if (swapchain_dirty)
+			{
+				SDL_WaitEvent(nullptr);
+			}
+
+			continue;
 		}
 
-		if (key_states[SDL_SCANCODE_S])
+		// @todo:	Since render pass and pipelines are per-application specific,
+		//			Also the loop should be. We can provide an example code and let the final application implement it.
+
+		// Frame boundary: the pipelines can be swapped. They are picked after it, a reload may replace them.
+		PollShaderReload();
+
+		UpdateAnimation(static_cast<float>(deltaTime));
+
+		// The wireframe is compiled the first time it's selected, the filled pipeline is drawn meanwhile.
+		const VkPipeline chosen_pipeline = wireframe
+			? pipeline_manager_.Get(wireframe_pipeline_desc, pipeline_)
+			: pipeline_;
+
+		const SimulationState frame_state = simulation_.Sample(SDL_GetPerformanceCounter());
+
+		if (!DrawFrame(chosen_pipeline, frame_state.camera_pos, frame_state.camera_front, sample_camera))
 		{
-			camera_pos_new -= camera_move_speed * static_cast<float>(deltaTime) * camera_front;
+			swapchain_dirty = true;
 		}
 
-		if (key_states[SDL_SCANCODE_A])
+		GpuPickResult gpu_pick = {};
+
+		if (PollGpuPick(&gpu_pick))
 		{
-			camera_pos_new -= glm::normalize(glm::cross(camera_front, camera_up)) * camera_move_speed *
-				static_cast<
-					float>(deltaTime);
+			if (gpu_pick.hit)
+			{
+				std::printf("[PICK] Draw call %u, triangle %u (id buffer, %u frames)\n",
+				            gpu_pick.draw_call,
+				            gpu_pick.triangle,
+				            gpu_pick.latency);
+			}
+			else
+			{
+				std::printf("[PICK] Nothing under the cursor (id buffer, %u frames)\n", gpu_pick.latency);
+			}
 		}
 
-		if (key_states[SDL_SCANCODE_D])
+		// Show the GPU timings of the passes once per second.
+		if (NOW - last_title_update >= SDL_GetPerformanceFrequency())
 		{
-			camera_pos_new += glm::normalize(glm::cross(camera_front, camera_up)) * camera_move_speed *
-				static_cast<
-					float>(deltaTime);
+			last_title_update = NOW;
+
+			char title[160] = {};
+			std::snprintf(title,
+			              sizeof(title),
+			              "Adro Engine | GPU %.3f ms | Depth Pre-Pass %.3f ms | Color Pass %.3f ms | Latency %.3f ms",
+			              gpu_profiler_.GetScopeMs("Frame"),
+			              gpu_profiler_.GetScopeMs("Depth Pre-Pass"),
+			              gpu_profiler_.GetScopeMs("Color Pass"),
+			              GetLatencyMs());
+
+			SDL_SetWindowTitle(window_, title);
 		}
 
-		if (key_states[SDL_SCANCODE_Q])
+		// --- Your game update & render logic here ---
+		// Example: updateGame(deltaTime); render();
+
+		// Frame limiting: Sleep if frame is faster than target frame time. The present wait paces the frames itself.
+		if (!present_wait_ && deltaTime < targetFrameTime)
 		{
-			chosen_pipeline = pipeline_wireframe_;
+			ADRO_PROFILE_SCOPE("Frame Limiter");
+			SDL_Delay(static_cast<Uint32>(targetFrameTime - deltaTime));
 		}
-		else if (key_states[SDL_SCANCODE_E])
+	}
+
+	simulation_.Stop();
+}
+
+bool VkApp::DrawFrame(
+	VkPipeline           chosen_pipeline,
+	const glm::vec3&     camera_pos,
+	const glm::vec3&     camera_front,
+	const CameraSampler& sample_camera)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	// Low latency: start the frame once the previous one is on screen, so no frame waits in the present queue and
+	// the camera is sampled as close to the display as the frame allows.
+	if (present_wait_ && present_id_ >= swapchain_first_present_id_)
+	{
+		ADRO_PROFILE_SCOPE("Present Wait");
+
+		// A present that never completes (occluded window) must not hang the loop.
+		constexpr uint64_t present_wait_timeout_ns = 100'000'000;
+
+		const VkResult wait_result = vkWaitForPresentKHR(
+			device_,
+			swapchain_,
+			present_id_,
+			present_wait_timeout_ns);
+
+		// Nothing was submitted yet, the fence is still signaled.
+		if (wait_result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
-			chosen_pipeline = pipeline_;
+			return false;
 		}
 
-		camera_pos = glm::mix(camera_pos, camera_pos_new, camera_lerp_alpha);
+		if (wait_result == VK_SUCCESS)
+		{
+			const uint64_t latch_time = latch_times_[present_id_ % latch_times_.size()];
 
-		// @todo:	Since render pass and pipelines are per-application specific,
-		//			Also the loop should be. We can provide an example code and let the final application implement it.
+			latency_ms_ = 1000.0 * static_cast<double>(SDL_GetPerformanceCounter() - latch_time) /
+				static_cast<double>(SDL_GetPerformanceFrequency());
+		}
+		else
+		{
+			VK_CHECK((wait_result == VK_TIMEOUT || wait_result == VK_SUBOPTIMAL_KHR)
+				? VK_SUCCESS
+				: wait_result);
+		}
+	}
 
+	{
+		ADRO_PROFILE_SCOPE("Wait Fence");
 		vkWaitForFences(
 			device_,
 			1,
 			&submit_finished_fence_,
 			VK_TRUE,
 			UINT64_MAX);
+	}
 
-		vkResetFences(
-			device_,
-			1,
-			&submit_finished_fence_);
+	// The previous submission is done, its scratch memory can be reused.
+	frame_allocator_.BeginFrame(static_cast<uint32_t>(frame_index_));
 
-		uint32_t next_image = 0u;
-		VK_CHECK(vkAcquireNextImageKHR(
-			device_,
-			swapchain_,
-			UINT64_MAX,
-			image_available_semaphore_,
-			VK_NULL_HANDLE,
-			&next_image));
-
-		Graphics::PerFrameData u_buffer = {
-			glm::lookAt(
-				camera_pos,
-				camera_pos + camera_front,
-				camera_up),
-
-			glm::perspectiveRH_ZO(
-				glm::radians(45.0f),
-				static_cast<float>(surface_capabilities_.currentExtent.width) /
-				static_cast<float>(surface_capabilities_.currentExtent.height),
-				0.1f,
-				10000.0f),
-		};
+	// It was also the last one using the pipelines replaced by a rebuild or a reload.
+	pipeline_manager_.BeginFrame();
 
-		// Flip vulkan Y-axis
-		u_buffer.projection[1][1] *= -1;
+	if (settings_.compute_normals)
+	{
+		normal_generator_.BeginFrame();
+	}
 
-		VK_CHECK(vkMapMemory(
-			device_,
-			per_frame_data_memories_[next_image],
-			0,
-			sizeof(u_buffer),
-			0,
-			&per_frame_data_mapped_[next_image]));
+	if (skinning_)
+	{
+		skinner_.BeginFrame();
+	}
 
-		constexpr size_t u_buffer_size = sizeof(Graphics::PerFrameData);
+	// And the one before the last copying a picked id, which is now in host memory.
+	ResolveGpuPick();
 
-		memcpy(per_frame_data_mapped_[next_image], &u_buffer, u_buffer_size);
+	// And the last one reading the palette.
+	if (!clips_.empty())
+	{
+		skinner_.UpdatePalette(palette_);
+	}
 
-		vkUnmapMemory(
+	uint32_t next_image     = 0u;
+	VkResult acquire_result = VK_SUCCESS;
+	{
+		ADRO_PROFILE_SCOPE("Acquire");
+		acquire_result = vkAcquireNextImageKHR(
 			device_,
-			per_frame_data_memories_[next_image]);
+			swapchain_,
+			UINT64_MAX,
+			image_available_semaphore_,
+			VK_NULL_HANDLE,
+			&next_image);
+	}
 
-		const VkCommandBufferBeginInfo begin_info = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.pInheritanceInfo = nullptr,
-		};
+	// The fence is still signaled at this point, so skipping the frame can't dead-lock the next wait.
+	if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		return false;
+	}
 
-		VK_CHECK(vkResetCommandBuffer(
-			command_buffer_,
-			0));
+	VK_CHECK((acquire_result == VK_SUBOPTIMAL_KHR)
+		? VK_SUCCESS
+		: acquire_result);
 
-		VK_CHECK(vkBeginCommandBuffer(
-			command_buffer_,
-			&begin_info));
+	vkResetFences(
+		device_,
+		1,
+		&submit_finished_fence_);
 
-		vkCmdBindDescriptorSets(
-			command_buffer_,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipeline_layout_,
-			0,
-			1,
-			&descriptor_sets_[next_image],
-			0,
-			nullptr);
+	// Input sampling point: everything the frame could wait on is behind, the camera is written next.
+	glm::vec3 frame_camera_pos   = camera_pos;
+	glm::vec3 frame_camera_front = camera_front;
 
-		constexpr VkClearValue clear_value[2] = {
-			{
-				.color = {
-					.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}
-			},
-			{
-				.depthStencil = {1.0f, 0},
-			}
-		};
+	if (sample_camera)
+	{
+		sample_camera(&frame_camera_pos, &frame_camera_front);
+	}
 
-		VkRenderPassBeginInfo render_pass_begin_info = {
-			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-			.pNext = nullptr,
-			.renderPass = render_pass_,
-			.framebuffer = presentation_frames_.framebuffers[next_image],
-			.renderArea = {
-				.offset = {0, 0},
-				.extent = surface_capabilities_.currentExtent,
-			},
-			.clearValueCount = 2,
-			.pClearValues = &clear_value[0],
-		};
+	// Culling and sorting use this camera.
+	const Graphics::Frustum frustum = WriteCamera(
+		next_image,
+		frame_camera_pos,
+		frame_camera_front);
 
-		vkCmdBeginRenderPass(
-			command_buffer_,
-			&render_pass_begin_info,
-			VK_SUBPASS_CONTENTS_INLINE);
+	RecordCommandBuffer(
+		next_image,
+		chosen_pipeline,
+		frame_camera_pos,
+		frame_camera_front,
+		frustum);
 
-		vkCmdBindPipeline(
-			command_buffer_,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			chosen_pipeline);
-
-		const VkViewport viewport = {
-			.x = 0.0f,
-			.y = 0.0f,
-			.width = static_cast<float>(surface_capabilities_.currentExtent.width),
-			.height = static_cast<float>(surface_capabilities_.currentExtent.height),
-			.minDepth = 0.0f,
-			.maxDepth = 1.0f,
-		};
+	const uint64_t frame_present_id = present_id_ + 1;
 
-		vkCmdSetViewport(
-			command_buffer_,
-			0,
+	// Low latency: the recording is done, sample again and overwrite the camera right before the submit. The
+	// culling is a few milliseconds older, an object entering at the edge of the view can show up a frame late.
+	if (settings_.low_latency)
+	{
+		ADRO_PROFILE_SCOPE("Camera Latch");
+
+		if (sample_camera)
+		{
+			sample_camera(&frame_camera_pos, &frame_camera_front);
+
+			WriteCamera(
+				next_image,
+				frame_camera_pos,
+				frame_camera_front);
+		}
+
+		latch_times_[frame_present_id % latch_times_.size()] = SDL_GetPerformanceCounter();
+	}
+
+	VkSemaphore wait_semaphores[] = {
+		image_available_semaphore_};
+	VkPipelineStageFlags wait_stages[] = {
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+	VkSemaphore signal_semaphores[] = {
+		render_finished_semaphore_};
+
+	VkSubmitInfo submit_info = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.pNext = nullptr,
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = wait_semaphores,
+		.pWaitDstStageMask = wait_stages,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &command_buffer_,
+		.signalSemaphoreCount = 1,
+		.pSignalSemaphores = signal_semaphores,
+	};
+
+	{
+		ADRO_PROFILE_SCOPE("Submit");
+		VK_CHECK(vkQueueSubmit(
+			queue_,
 			1,
-			&viewport);
+			&submit_info,
+			submit_finished_fence_));
+	}
+
+	// Present wait: the id the next frame waits on.
+	const VkPresentIdKHR present_id_info = {
+		.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+		.pNext = nullptr,
+		.swapchainCount = 1,
+		.pPresentIds = &frame_present_id,
+	};
+
+	VkResult               result       = {};
+	const VkPresentInfoKHR present_info = {
+		.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+		.pNext = present_wait_
+			? &present_id_info
+			: nullptr,
+		.waitSemaphoreCount = 1,
+		.pWaitSemaphores = &render_finished_semaphore_,
+		.swapchainCount = 1,
+		.pSwapchains = &swapchain_,
+		.pImageIndices = &next_image,
+		.pResults = &result,
+	};
+
+	VkResult present_result = VK_SUCCESS;
+	{
+		ADRO_PROFILE_SCOPE("Present");
+		present_result = vkQueuePresentKHR(queue_, &present_info);
+	}
+
+	frame_index_++;
+	present_id_ = frame_present_id;
+
+	if (present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR)
+	{
+		return false;
+	}
+
+	VK_CHECK(present_result);
+
+	return true;
+}
+
+Graphics::Frustum VkApp::WriteCamera(
+	uint32_t         image_idx,
+	const glm::vec3& camera_pos,
+	const glm::vec3& camera_front)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const glm::vec3 camera_up = {0.0f, 1.0f, 0.0f};
+
+	const float aspect_ratio = static_cast<float>(surface_capabilities_.currentExtent.width) /
+		static_cast<float>(surface_capabilities_.currentExtent.height);
+
+	Graphics::PerFrameData u_buffer = {
+		glm::lookAt(
+			camera_pos,
+			camera_pos + camera_front,
+			camera_up),
+
+		settings_.reverse_z
+			? Graphics::ReverseInfinitePerspective(camera_fov, aspect_ratio, camera_near)
+			: glm::perspectiveRH_ZO(camera_fov, aspect_ratio, camera_near, camera_far),
+	};
+
+	// Flip vulkan Y-axis
+	u_buffer.projection[1][1] *= -1;
+
+	// Host coherent: visible to the submission that follows.
+	memcpy(per_frame_data_mapped_[image_idx], &u_buffer, sizeof(Graphics::PerFrameData));
+
+	// The flip only swaps the bottom and top planes.
+	view_projection_ = u_buffer.projection * u_buffer.view;
+
+	return Graphics::ExtractFrustum(view_projection_);
+}
+
+void VkApp::RecordCommandBuffer(
+	uint32_t                 image_idx,
+	VkPipeline               chosen_pipeline,
+	const glm::vec3&         camera_pos,
+	const glm::vec3&         camera_front,
+	const Graphics::Frustum& frustum)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const VkCommandBufferBeginInfo begin_info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.pInheritanceInfo = nullptr,
+	};
+
+	VK_CHECK(vkResetCommandBuffer(
+		command_buffer_,
+		0));
+
+	VK_CHECK(vkBeginCommandBuffer(
+		command_buffer_,
+		&begin_info));
+
+	gpu_profiler_.BeginFrame(
+		command_buffer_,
+		static_cast<uint32_t>(frame_index_));
+
+	gpu_profiler_.BeginScope(
+		command_buffer_,
+		"Frame");
+
+	vkCmdBindDescriptorSets(
+		command_buffer_,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipeline_layout_,
+		0,
+		1,
+		&descriptor_sets_[image_idx],
+		0,
+		nullptr);
+
+	// Indexed by attachment, the resolve attachment (2) is not cleared. Depth is cleared to the far plane.
+	const VkClearValue clear_value[4] = {
+		{
+			.color = {
+				.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}
+		},
+		{
+			.depthStencil = {settings_.reverse_z ? 0.0f : 1.0f, 0},
+		},
+		{},
+		{
+			.color = {
+				.uint32 = {0, 0, 0, 0}}
+		}
+	};
 
-		const VkRect2D scissor = {
+	VkRenderPassBeginInfo render_pass_begin_info = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.pNext = nullptr,
+		.renderPass = render_pass_,
+		.framebuffer = presentation_frames_.framebuffers[image_idx],
+		.renderArea = {
 			.offset = {0, 0},
 			.extent = surface_capabilities_.currentExtent,
-		};
+		},
+		.clearValueCount = settings_.id_buffer
+			? 4u
+			: 2u,
+		.pClearValues = &clear_value[0],
+	};
 
-		vkCmdSetScissor(
+	if (!clips_.empty())
+	{
+		gpu_profiler_.BeginScope(
 			command_buffer_,
-			0,
-			1,
-			&scissor);
+			"Skinning",
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
-		const VkBuffer binds_buffer[] = {
-			batch_render_.position_buffer,
-			batch_render_.color_buffer,
-			batch_render_.normal_buffer,
-		};
+		skinner_.Record(command_buffer_);
 
-		const VkDeviceSize offsets[] = {
-			0,
-			0,
-			0
-		};
+		gpu_profiler_.EndScope(command_buffer_);
+	}
+
+	if (settings_.compute_normals)
+	{
+		gpu_profiler_.BeginScope(
+			command_buffer_,
+			"Normals",
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		normal_generator_.Record(command_buffer_);
+
+		gpu_profiler_.EndScope(command_buffer_);
+	}
+
+	vkCmdBeginRenderPass(
+		command_buffer_,
+		&render_pass_begin_info,
+		VK_SUBPASS_CONTENTS_INLINE);
+
+	const VkViewport viewport = {
+		.x = 0.0f,
+		.y = 0.0f,
+		.width = static_cast<float>(surface_capabilities_.currentExtent.width),
+		.height = static_cast<float>(surface_capabilities_.currentExtent.height),
+		.minDepth = 0.0f,
+		.maxDepth = 1.0f,
+	};
+
+	vkCmdSetViewport(
+		command_buffer_,
+		0,
+		1,
+		&viewport);
+
+	const VkRect2D scissor = {
+		.offset = {0, 0},
+		.extent = surface_capabilities_.currentExtent,
+	};
+
+	vkCmdSetScissor(
+		command_buffer_,
+		0,
+		1,
+		&scissor);
+
+	// The wireframe doesn't write depth on filled triangles, the pre-pass would hide it.
+	const bool use_depth_prepass = depth_prepass_enabled_ && chosen_pipeline == pipeline_;
+
+	// Per-frame copy of the draw list, filtered by the frustum, sorted without touching the heap.
+	FrameVector<Graphics::DrawCall> frame_draw_calls(FrameStlAllocator<Graphics::DrawCall>(&frame_allocator_));
+
+	if (skinning_)
+	{
+		frame_draw_calls.assign(
+			draw_calls_.begin(),
+			draw_calls_.end());
+	}
+	else
+	{
+		ADRO_PROFILE_SCOPE("Frustum Culling");
+
+		visible_draw_calls_.clear();
+		scene_bvh_.QueryFrustum(
+			frustum,
+			&visible_draw_calls_);
+
+		frame_draw_calls.reserve(visible_draw_calls_.size());
+
+		for (const uint32_t draw_call : visible_draw_calls_)
+		{
+			frame_draw_calls.push_back(draw_calls_[draw_call]);
+		}
+	}
+
+	Graphics::SortDrawCalls(
+		(chosen_pipeline == pipeline_) ? 0 : 1,
+		camera_pos,
+		camera_front,
+		frame_draw_calls);
+
+	vkCmdBindIndexBuffer(
+		command_buffer_,
+		batch_render_.index_buffer,
+		0,
+		VK_INDEX_TYPE_UINT32);
+
+	const VkDeviceSize offsets[] = {
+		0,
+		0,
+		0
+	};
+
+	if (use_depth_prepass)
+	{
+		gpu_profiler_.BeginScope(
+			command_buffer_,
+			"Depth Pre-Pass");
+
+		vkCmdBindPipeline(
+			command_buffer_,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipeline_depth_prepass_);
 
 		vkCmdBindVertexBuffers(
 			command_buffer_,
 			0,
-			3,
-			&binds_buffer[0],
+			1,
+			&batch_render_.position_buffer,
 			&offsets[0]);
 
-		vkCmdBindIndexBuffer(
-			command_buffer_,
-			batch_render_.index_buffer,
-			0,
-			VK_INDEX_TYPE_UINT32);
+		for (const Graphics::DrawCall& draw_call : frame_draw_calls)
+		{
+			vkCmdDrawIndexed(
+				command_buffer_,
+				draw_call.index_count,
+				1,
+				draw_call.first_index,
+				draw_call.vertex_offset,
+				0);
+		}
+
+		gpu_profiler_.EndScope(command_buffer_);
+	}
+
+	gpu_profiler_.BeginScope(
+		command_buffer_,
+		"Color Pass");
+
+	vkCmdBindPipeline(
+		command_buffer_,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		use_depth_prepass
+			? pipeline_depth_equal_
+			: chosen_pipeline);
+
+	const VkBuffer binds_buffer[] = {
+		batch_render_.position_buffer,
+		batch_render_.color_buffer,
+		batch_render_.normal_buffer,
+	};
+
+	vkCmdBindVertexBuffers(
+		command_buffer_,
+		0,
+		3,
+		&binds_buffer[0],
+		&offsets[0]);
 
+	// The first instance is the first triangle of the draw, shader.frag adds gl_PrimitiveID to get the object id.
+	for (const Graphics::DrawCall& draw_call : frame_draw_calls)
+	{
 		vkCmdDrawIndexed(
 			command_buffer_,
-			299910,
+			draw_call.index_count,
 			1,
-			0,
-			0,
-			0);
+			draw_call.first_index,
+			draw_call.vertex_offset,
+			draw_call.first_index / 3);
+	}
 
-		vkCmdEndRenderPass(
-			command_buffer_);
+	gpu_profiler_.EndScope(command_buffer_);
 
-		VK_CHECK(vkEndCommandBuffer(
-			command_buffer_));
+	vkCmdEndRenderPass(
+		command_buffer_);
 
-		VkSemaphore wait_semaphores[] = {
-			image_available_semaphore_};
-		VkPipelineStageFlags wait_stages[] = {
-			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-		VkSemaphore signal_semaphores[] = {
-			render_finished_semaphore_};
+	RecordGpuPick();
 
-		VkSubmitInfo submit_info = {
-			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-			.pNext = nullptr,
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = wait_semaphores,
-			.pWaitDstStageMask = wait_stages,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &command_buffer_,
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = signal_semaphores,
-		};
+	gpu_profiler_.EndScope(command_buffer_);
 
-		VK_CHECK(vkQueueSubmit(
-			queue_,
-			1,
-			&submit_info,
-			submit_finished_fence_));
+	VK_CHECK(vkEndCommandBuffer(
+		command_buffer_));
+}
 
-		VkResult               result       = {};
-		const VkPresentInfoKHR present_info = {
-			.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &render_finished_semaphore_,
-			.swapchainCount = 1,
-			.pSwapchains = &swapchain_,
-			.pImageIndices = &next_image,
-			.pResults = &result,
-		};
+void VkApp::CreateVertexStream(
+	size_t                            size,
+	VkBufferUsageFlags                usage,
+	const std::function<void(void*)>& write,
+	VkBuffer*                         p_buffer,
+	VkDeviceMemory*                   p_memory)
+{
+	Gfx::CreateBuffer(
+		device_,
+		gpu_,
+		size,
+		usage,
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		&allocator_,
+		p_buffer,
+		p_memory);
 
-		// @todo: cannot present the image if the window is minimized.
-		VK_CHECK(vkQueuePresentKHR(queue_, &present_info));
+	void* data = nullptr;
+	VK_CHECK(vkMapMemory(
+		device_,
+		*p_memory,
+		0,
+		size,
+		0,
+		&data));
 
-		// --- Your game update & render logic here ---
-		// Example: updateGame(deltaTime); render();
+	write(data);
 
-		// Frame limiting: Sleep if frame is faster than target frame time
-		if (deltaTime < targetFrameTime)
-		{
-			SDL_Delay(static_cast<Uint32>(targetFrameTime - deltaTime));
-		}
-	}
+	vkUnmapMemory(
+		device_,
+		*p_memory);
 }
 
-void VkApp::TearDown() const
+void VkApp::UploadBatch(const Batch& batch)
 {
-	VK_CHECK(vkDeviceWaitIdle(device_));
+	ADRO_PROFILE_FUNCTION();
 
-	vkDestroySwapchainKHR(device_, swapchain_, nullptr);
-	vkFreeCommandBuffers(device_, command_pool_, 1, &command_buffer_);
-	vkDestroyCommandPool(device_, command_pool_, nullptr);
-	vkDestroyDevice(device_, nullptr);
-	vkDestroyInstance(instance_, nullptr);
+	// Meshes don't carry colors yet.
+	std::vector<glm::vec4> default_colors = {};
+	if (batch.color.size() != batch.position.size())
+	{
+		default_colors.assign(batch.position.size(), glm::vec4(.5f, .5f, .5f, 1.0f));
+	}
+
+	const std::vector<glm::vec4>& colors = default_colors.empty()
+		? batch.color
+		: default_colors;
+
+	CreateVertexStream(
+		sizeof(glm::vec3) * batch.position.size(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&batch](void* data) { std::memcpy(data, batch.position.data(), sizeof(glm::vec3) * batch.position.size()); },
+		&batch_render_.position_buffer,
+		&batch_render_.position_memory);
+
+	CreateVertexStream(
+		sizeof(glm::vec3) * batch.normals.size(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&batch](void* data) { std::memcpy(data, batch.normals.data(), sizeof(glm::vec3) * batch.normals.size()); },
+		&batch_render_.normal_buffer,
+		&batch_render_.normal_memory);
+
+	CreateVertexStream(
+		sizeof(glm::vec4) * colors.size(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		[&colors](void* data) { std::memcpy(data, colors.data(), sizeof(glm::vec4) * colors.size()); },
+		&batch_render_.color_buffer,
+		&batch_render_.color_memory);
 
-	SDL_DestroyWindow(window_);
-	SDL_Quit();
-}
\ No newline at end of file
+	CreateVertexStream(
+		sizeof(uint32_t) * batch.indices.size(),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&batch](void* data) { std::memcpy(data, batch.indices.data(), sizeof(uint32_t) * batch.indices.size()); },
+		&batch_render_.index_buffer,
+		&batch_render_.index_memory);
+
+	// One draw per submesh, all from the same buffers, centered on the average position of its indexed vertices
+	// and bounded by them.
+	const std::vector<Graphics::Submesh> whole_batch = {
+		{.index_count = static_cast<uint32_t>(batch.indices.size())},
+	};
+
+	const std::vector<Graphics::Submesh>& submeshes = batch.submeshes.empty()
+		? whole_batch
+		: batch.submeshes;
+
+	draw_calls_.reserve(submeshes.size());
+
+	for (const Graphics::Submesh& submesh : submeshes)
+	{
+		glm::vec3      submesh_center = {};
+		Graphics::Aabb submesh_bounds = {
+			.min = glm::vec3(std::numeric_limits<float>::max()),
+			.max = glm::vec3(-std::numeric_limits<float>::max()),
+		};
+
+		for (uint32_t i = submesh.first_index; i < submesh.first_index + submesh.index_count; i++)
+		{
+			const glm::vec3& position = batch.position[batch.indices[i] + submesh.vertex_offset];
+
+			submesh_center     += position;
+			submesh_bounds.min  = glm::min(submesh_bounds.min, position);
+			submesh_bounds.max  = glm::max(submesh_bounds.max, position);
+		}
+
+		draw_calls_.push_back({
+			.index_count = submesh.index_count,
+			.first_index = submesh.first_index,
+			.vertex_offset = submesh.vertex_offset,
+			.material = submesh.material,
+			.center = submesh_center / static_cast<float>(std::max(submesh.index_count, 1u)),
+			.bounds = submesh.index_count > 0 ? submesh_bounds : Graphics::Aabb{},
+		});
+	}
+
+	BuildSceneBvh(
+		batch.position,
+		batch.indices);
+
+	if (skinning_ && !batch.joints.empty() && !batch.clips.empty())
+	{
+		skinner_.SetMesh(
+			batch.position,
+			batch.normals,
+			batch.joints,
+			batch.weights,
+			batch.skeleton.GetJointCount(),
+			batch_render_.position_buffer,
+			batch_render_.normal_buffer);
+
+		skeleton_  = batch.skeleton;
+		clips_     = batch.clips;
+		animation_ = {};
+		palette_.assign(skeleton_.GetJointCount(), glm::mat4(1.0f));
+	}
+
+	// The normal generator reads the indices as they are, it needs them relative to the first vertex.
+	const bool batch_relative_indices = std::ranges::all_of(
+		submeshes,
+		[](const Graphics::Submesh& submesh) { return submesh.vertex_offset == 0; });
+
+	if (settings_.compute_normals && !batch_relative_indices)
+	{
+		std::printf("[NORMALS] Batch with vertex offsets, normals are not regenerated\n");
+	}
+
+	if (settings_.compute_normals && batch_relative_indices)
+	{
+		normal_generator_.SetMesh(
+			batch.indices,
+			static_cast<uint32_t>(batch.position.size()),
+			batch_render_.position_buffer,
+			batch_render_.index_buffer,
+			batch_render_.normal_buffer);
+	}
+}
+
+void VkApp::UploadAsset(const GltfAsset& asset)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	const uint32_t  vertex_count = asset.GetVertexCount();
+	const uint32_t  index_count  = asset.GetIndexCount();
+	const glm::mat3 rotation     = Mesh::GetImportRotation();
+
+	// The streams go from the mapped file (or the decoded views) straight into the mapped buffers.
+	CreateVertexStream(
+		sizeof(glm::vec3) * vertex_count,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&](void* data) { asset.WritePositions(std::span(static_cast<glm::vec3*>(data), vertex_count), rotation); },
+		&batch_render_.position_buffer,
+		&batch_render_.position_memory);
+
+	CreateVertexStream(
+		sizeof(glm::vec3) * vertex_count,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&](void* data) { asset.WriteNormals(std::span(static_cast<glm::vec3*>(data), vertex_count), rotation); },
+		&batch_render_.normal_buffer,
+		&batch_render_.normal_memory);
+
+	CreateVertexStream(
+		sizeof(glm::vec4) * vertex_count,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		[&](void* data) { std::fill_n(static_cast<glm::vec4*>(data), vertex_count, glm::vec4(.5f, .5f, .5f, 1.0f)); },
+		&batch_render_.color_buffer,
+		&batch_render_.color_memory);
+
+	CreateVertexStream(
+		sizeof(uint32_t) * index_count,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[&](void* data) { asset.WriteIndices(std::span(static_cast<uint32_t*>(data), index_count)); },
+		&batch_render_.index_buffer,
+		&batch_render_.index_memory);
+
+	// Centered on the bounds of the primitive, the positions are not read back from the mapped memory.
+	const std::vector<Graphics::Submesh>& submeshes = asset.GetSubmeshes();
+
+	draw_calls_.reserve(submeshes.size());
+
+	for (size_t i = 0; i < submeshes.size(); i++)
+	{
+		draw_calls_.push_back({
+			.index_count = submeshes[i].index_count,
+			.first_index = submeshes[i].first_index,
+			.vertex_offset = submeshes[i].vertex_offset,
+			.material = submeshes[i].material,
+			.center = rotation * asset.GetSubmeshCenter(i),
+			.bounds = Graphics::TransformAabb(asset.GetSubmeshBounds(i), rotation),
+		});
+	}
+
+	// Picking needs the triangles on the CPU, the mapped buffers are not read back.
+	std::vector<glm::vec3> positions(vertex_count);
+	std::vector<uint32_t>  indices(index_count);
+
+	asset.WritePositions(positions, rotation);
+	asset.WriteIndices(indices);
+
+	BuildSceneBvh(
+		positions,
+		indices);
+
+	// The normal generator reads the indices as they are, it needs them relative to the first vertex.
+	if (settings_.compute_normals && submeshes.size() > 1)
+	{
+		std::printf("[NORMALS] Batch with vertex offsets, normals are not regenerated\n");
+	}
+
+	if (settings_.compute_normals && submeshes.size() == 1)
+	{
+		normal_generator_.SetMesh(
+			indices,
+			vertex_count,
+			batch_render_.position_buffer,
+			batch_render_.index_buffer,
+			batch_render_.normal_buffer);
+	}
+}
+
+void VkApp::DestroyBatch()
+{
+	if (skinning_)
+	{
+		skinner_.ClearMesh();
+
+		skeleton_ = {};
+		clips_.clear();
+		palette_.clear();
+	}
+
+	if (settings_.compute_normals)
+	{
+		normal_generator_.ClearMesh();
+	}
+
+	vkDestroyBuffer(device_, batch_render_.position_buffer, &allocator_);
+	vkFreeMemory(device_, batch_render_.position_memory, &allocator_);
+
+	vkDestroyBuffer(device_, batch_render_.normal_buffer, &allocator_);
+	vkFreeMemory(device_, batch_render_.normal_memory, &allocator_);
+
+	vkDestroyBuffer(device_, batch_render_.color_buffer, &allocator_);
+	vkFreeMemory(device_, batch_render_.color_memory, &allocator_);
+
+	vkDestroyBuffer(device_, batch_render_.index_buffer, &allocator_);
+	vkFreeMemory(device_, batch_render_.index_memory, &allocator_);
+
+	batch_render_ = {};
+	draw_calls_.clear();
+	scene_bvh_.Clear();
+	draw_call_bvhs_.clear();
+}
+
+void VkApp::BuildSceneBvh(
+	std::span<const glm::vec3> positions,
+	std::span<const uint32_t>  indices)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	std::vector<Graphics::Aabb> bounds(draw_calls_.size());
+
+	for (size_t i = 0; i < draw_calls_.size(); i++)
+	{
+		bounds[i] = draw_calls_[i].bounds;
+	}
+
+	scene_bvh_.Build(bounds);
+
+	// The skinned batch is not picked, its triangles move away from the bind pose.
+	if (skinning_)
+	{
+		return;
+	}
+
+	// One triangle tree per draw call, built on the workers.
+	draw_call_bvhs_.assign(draw_calls_.size(), {});
+
+	ThreadPool::ParallelFor(
+		&thread_pool_,
+		draw_calls_.size(),
+		[&](size_t draw_call)
+		{
+			draw_call_bvhs_[draw_call].Build(
+				positions,
+				indices.subspan(draw_calls_[draw_call].first_index, draw_calls_[draw_call].index_count),
+				draw_calls_[draw_call].vertex_offset);
+		});
+}
+
+bool VkApp::Pick(
+	const glm::vec2& view_position,
+	PickHit*         p_hit) const
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (draw_call_bvhs_.empty())
+	{
+		return false;
+	}
+
+	// Back through the camera of the last frame: the cursor on the near plane, then camera_far away (the far plane
+	// of the [0, 1] projection, a depth of near / far with reverse-Z).
+	const float near_depth = settings_.reverse_z ? 1.0f : 0.0f;
+	const float far_depth  = settings_.reverse_z ? camera_near / camera_far : 1.0f;
+
+	const glm::mat4 inverse_view_projection = glm::inverse(view_projection_);
+	const glm::vec2 ndc                     = view_position * 2.0f - 1.0f;
+	const glm::vec4 near_point              = inverse_view_projection * glm::vec4(ndc, near_depth, 1.0f);
+	const glm::vec4 far_point               = inverse_view_projection * glm::vec4(ndc, far_depth, 1.0f);
+
+	const glm::vec3 origin    = glm::vec3(near_point) / near_point.w;
+	const glm::vec3 direction = glm::vec3(far_point) / far_point.w - origin;
+
+	// Distances along the segment: 0 on the near plane, 1 on the far plane.
+	std::vector<uint32_t> draw_calls = {};
+	scene_bvh_.QueryRay(
+		origin,
+		direction,
+		1.0f,
+		&draw_calls);
+
+	float closest = 1.0f;
+	bool  found   = false;
+
+	for (const uint32_t draw_call : draw_calls)
+	{
+		TriangleBvh::Hit hit = {};
+
+		if (draw_call_bvhs_[draw_call].Intersect(origin, direction, closest, &hit))
+		{
+			closest = hit.distance;
+			found   = true;
+
+			*p_hit = {
+				.draw_call = draw_call,
+				.triangle = hit.triangle,
+				.barycentrics = hit.barycentrics,
+				.position = origin + direction * hit.distance,
+				.distance = glm::length(direction) * hit.distance,
+			};
+		}
+	}
+
+	return found;
+}
+
+void VkApp::PickAt(const glm::ivec2& cursor)
+{
+	int window_width  = 0;
+	int window_height = 0;
+	SDL_GetWindowSize(window_, &window_width, &window_height);
+
+	// Center of the pixel, over the window size (the extent differs on high DPI displays).
+	const glm::vec2 view_position =
+		(glm::vec2(static_cast<float>(cursor.x), static_cast<float>(cursor.y)) + 0.5f) /
+		glm::vec2(static_cast<float>(std::max(window_width, 1)),
+		          static_cast<float>(std::max(window_height, 1)));
+
+	// The id buffer answers a few frames later, see the readback after DrawFrame.
+	if (settings_.id_buffer)
+	{
+		RequestGpuPick(view_position);
+		return;
+	}
+
+	PickHit hit = {};
+
+	if (Pick(view_position, &hit))
+	{
+		std::printf("[PICK] Draw call %u, triangle %u, barycentrics (%.3f, %.3f), distance %.1f\n",
+		            hit.draw_call,
+		            hit.triangle,
+		            hit.barycentrics.x,
+		            hit.barycentrics.y,
+		            hit.distance);
+	}
+	else
+	{
+		std::printf("[PICK] Nothing under the cursor\n");
+	}
+}
+
+void VkApp::RequestGpuPick(const glm::vec2& view_position)
+{
+	assert(settings_.id_buffer);
+
+	gpu_pick_request_ = view_position;
+}
+
+bool VkApp::PollGpuPick(GpuPickResult* p_result)
+{
+	if (!gpu_pick_result_)
+	{
+		return false;
+	}
+
+	*p_result = *gpu_pick_result_;
+	gpu_pick_result_.reset();
+
+	return true;
+}
+
+double VkApp::GetLatencyMs() const
+{
+	return latency_ms_;
+}
+
+void VkApp::ResolveGpuPick()
+{
+	GpuPickReadback& readback = gpu_pick_readbacks_[frame_index_ % gpu_pick_latency];
+
+	if (!readback.pending)
+	{
+		return;
+	}
+
+	readback.pending = false;
+
+	GpuPickResult result = {
+		.view_position = readback.view_position,
+		.latency = static_cast<uint32_t>(frame_index_ - readback.frame),
+	};
+
+	// 0 where nothing was drawn, otherwise the triangle in the index buffer of the batch plus one.
+	const uint32_t id = *readback.mapped;
+
+	for (uint32_t i = 0; id != 0 && i < draw_calls_.size(); i++)
+	{
+		const uint32_t first_triangle = draw_calls_[i].first_index / 3;
+		const uint32_t triangle       = id - 1;
+
+		if (triangle >= first_triangle && triangle - first_triangle < draw_calls_[i].index_count / 3)
+		{
+			result.hit       = true;
+			result.draw_call = i;
+			result.triangle  = triangle - first_triangle;
+			break;
+		}
+	}
+
+	gpu_pick_result_ = result;
+}
+
+void VkApp::RecordGpuPick()
+{
+	if (!gpu_pick_request_)
+	{
+		return;
+	}
+
+	GpuPickReadback& readback = gpu_pick_readbacks_[frame_index_ % gpu_pick_latency];
+
+	const VkExtent2D extent = surface_capabilities_.currentExtent;
+
+	const VkBufferImageCopy region = {
+		.bufferOffset = 0,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = 0,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+		.imageOffset = {
+			std::clamp(static_cast<int32_t>(gpu_pick_request_->x * static_cast<float>(extent.width)),
+			           0,
+			           static_cast<int32_t>(extent.width) - 1),
+			std::clamp(static_cast<int32_t>(gpu_pick_request_->y * static_cast<float>(extent.height)),
+			           0,
+			           static_cast<int32_t>(extent.height) - 1),
+			0
+		},
+		.imageExtent = {1, 1, 1},
+	};
+
+	// The render pass left the resolved ids in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, after its resolve.
+	vkCmdCopyImageToBuffer(
+		command_buffer_,
+		id_image_,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		readback.buffer,
+		1,
+		&region);
+
+	// Visible to the host once the fence of the frame is signaled.
+	const VkBufferMemoryBarrier barrier = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = readback.buffer,
+		.offset = 0,
+		.size = VK_WHOLE_SIZE,
+	};
+
+	vkCmdPipelineBarrier(
+		command_buffer_,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		0,
+		nullptr,
+		1,
+		&barrier,
+		0,
+		nullptr);
+
+	readback.view_position = *gpu_pick_request_;
+	readback.frame         = frame_index_;
+	readback.pending       = true;
+
+	gpu_pick_request_.reset();
+}
+
+VkPipeline VkApp::GetDefaultPipeline() const
+{
+	return pipeline_;
+}
+
+void VkApp::UpdateAnimation(float delta_time)
+{
+	ADRO_PROFILE_FUNCTION();
+
+	if (clips_.empty())
+	{
+		return;
+	}
+
+	animation_.time += delta_time;
+
+	Animation::Update(
+		&thread_pool_,
+		skeleton_,
+		clips_,
+		std::span(&animation_, 1),
+		palette_);
+}
+
+void VkApp::TearDown()
+{
+	VK_CHECK(vkDeviceWaitIdle(device_));
+
+	// A reload still compiling on a worker, its compute pipelines are destroyed along with the current ones.
+	if (shader_reload_.valid())
+	{
+		try
+		{
+			SetComputePipelines(shader_reload_.get());
+		}
+		catch (const std::exception&)
+		{
+			// Nothing was built.
+		}
+	}
+
+	shader_watcher_.Destroy();
+
+	gpu_profiler_.Destroy();
+	frame_allocator_.Destroy();
+	DestroyBatch();
+	DestroySizeDependentResources();
+
+	if (skinning_)
+	{
+		skinner_.Destroy();
+	}
+
+	if (settings_.compute_normals)
+	{
+		normal_generator_.Destroy();
+	}
+
+	pipeline_manager_.Destroy();
+	vkDestroyPipelineLayout(device_, pipeline_layout_, &allocator_);
+	vkDestroyDescriptorPool(device_, descriptor_pool_, &allocator_);
+	vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, &allocator_);
+	vkDestroyRenderPass(device_, render_pass_, &allocator_);
+
+	for (size_t i = 0; i < per_frame_data_buffers_.size(); i++)
+	{
+		vkDestroyBuffer(device_, per_frame_data_buffers_[i], &allocator_);
+		vkFreeMemory(device_, per_frame_data_memories_[i], &allocator_);
+	}
+
+	// Freeing the memory unmaps it.
+	for (const GpuPickReadback& readback : gpu_pick_readbacks_)
+	{
+		vkDestroyBuffer(device_, readback.buffer, &allocator_);
+		vkFreeMemory(device_, readback.memory, &allocator_);
+	}
+
+	vkDestroySemaphore(device_, image_available_semaphore_, &allocator_);
+	vkDestroySemaphore(device_, render_finished_semaphore_, &allocator_);
+	vkDestroyFence(device_, submit_finished_fence_, &allocator_);
+
+	vkDestroySwapchainKHR(device_, swapchain_, &allocator_);
+	vkFreeCommandBuffers(device_, command_pool_, 1, &command_buffer_);
+	vkDestroyCommandPool(device_, command_pool_, &allocator_);
+	vkDestroyDevice(device_, &allocator_);
+	vkDestroySurfaceKHR(instance_, surface_, nullptr);
+
+	if (debug_messenger_)
+	{
+		vkDestroyDebugUtilsMessengerEXT(instance_, debug_messenger_, &allocator_);
+	}
+
+	vkDestroyInstance(instance_, &allocator_);
+
+	// Everything has been destroyed: non-zero current bytes are leaks (in the app or the driver).
+	host_allocator_.PrintStatistics();
+
+	if (window_)
+	{
+		SDL_DestroyWindow(window_);
+		SDL_Quit();
+	}
+}
+
+void VkApp::PollShaderReload()
+{
+	ADRO_PROFILE_FUNCTION();
+
+	// Compiled SPIR-V: the pipelines using it are rebuilt on the workers, the current ones are drawn meanwhile.
+	if (shader_reload_.valid() && shader_reload_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		try
+		{
+			ShaderReload reload = shader_reload_.get();
+
+			for (uint32_t i = 0; i < pipeline_shader_count; i++)
+			{
+				if (reload.dirty[i])
+				{
+					pipeline_manager_.SetShaderCode(static_cast<PipelineShader>(i), std::move(reload.code[i]));
+				}
+			}
+
+			SetComputePipelines(reload);
+
+			std::printf("[SHADER] Shaders reloaded\n");
+		}
+		catch (const std::exception& exception)
+		{
+			// Keep the current pipelines, the next save retries.
+			std::printf("[SHADER] Reload failed:\n%s\n", exception.what());
+		}
+	}
+
+	// One compilation at a time, the changes made meanwhile stay queued in the watcher.
+	if (!shader_reload_.valid())
+	{
+		std::vector<std::string> changed_files = {};
+		shader_watcher_.Poll(&changed_files);
+
+		ShaderReload reload    = {};
+		bool         any_dirty = false;
+
+		for (uint32_t i = 0; i < pipeline_shader_count; i++)
+		{
+			reload.dirty[i] = std::ranges::find(changed_files, shader_sources[i]) != changed_files.end();
+			any_dirty       = any_dirty || reload.dirty[i];
+		}
+
+		// Only the compute shaders of the passes in use are rebuilt.
+		for (uint32_t i = 0; i < compute_shader_count; i++)
+		{
+			const auto changed = std::ranges::find(changed_files, compute_shader_sources[i]);
+			const bool in_use  = (static_cast<ComputeShader>(i) == ComputeShader::Normals)
+				? settings_.compute_normals
+				: skinning_;
+
+			reload.compute_dirty[i] = in_use && changed != changed_files.end();
+			any_dirty               = any_dirty || reload.compute_dirty[i];
+		}
+
+		if (any_dirty)
+		{
+			shader_reload_ = thread_pool_.Submit([this, reload]() mutable
+			{
+				for (uint32_t i = 0; i < pipeline_shader_count; i++)
+				{
+					if (reload.dirty[i])
+					{
+						const std::string path = shader_watcher_.GetDirectory() + "/" + shader_sources[i];
+						reload.code[i]         = ShaderCompiler::CompileGlsl(path.c_str());
+					}
+				}
+
+				// The compute pipelines are built here too, the render thread only swaps them in. A failure keeps the
+				// current pipelines of that shader only, nothing built so far is lost.
+				for (uint32_t i = 0; i < compute_shader_count; i++)
+				{
+					if (!reload.compute_dirty[i])
+					{
+						continue;
+					}
+
+					try
+					{
+						const std::string path = shader_watcher_.GetDirectory() + "/" + compute_shader_sources[i];
+
+						const std::vector<uint32_t> code = ShaderCompiler::CompileGlsl(path.c_str());
+
+						switch (static_cast<ComputeShader>(i))
+						{
+						case ComputeShader::Normals:
+							reload.normal_pipelines = normal_generator_.CreatePipelines(code);
+							break;
+
+						case ComputeShader::Skinning:
+							reload.skinning_pipeline = skinner_.CreatePipeline(code);
+							break;
+						}
+					}
+					catch (const std::exception& exception)
+					{
+						std::printf("[SHADER] %s reload failed:\n%s\n", compute_shader_sources[i], exception.what());
+					}
+				}
+
+				return reload;
+			});
+		}
+	}
+
+	// Swap in the rebuilt pipelines.
+	pipeline_               = pipeline_manager_.Get(color_pipeline_desc, pipeline_);
+	pipeline_depth_prepass_ = pipeline_manager_.Get(depth_prepass_pipeline_desc, pipeline_depth_prepass_);
+	pipeline_depth_equal_   = pipeline_manager_.Get(depth_equal_pipeline_desc, pipeline_depth_equal_);
+}
+
+void VkApp::SetComputePipelines(const ShaderReload& reload)
+{
+	if (reload.normal_pipelines.face)
+	{
+		normal_generator_.SetPipelines(reload.normal_pipelines);
+	}
+
+	if (reload.skinning_pipeline)
+	{
+		skinner_.SetPipeline(reload.skinning_pipeline);
+	}
+}
+
+void VkApp::CreateSizeDependentResources()
+{
+	uint32_t image_count = 0;
+	VK_CHECK(vkGetSwapchainImagesKHR(
+		device_,
+		swapchain_,
+		&image_count,
+		nullptr));
+
+	// The images are written into the per image arrays, sized at Init.
+	if (image_count != swapchain_image_count_)
+	{
+		throw std::runtime_error("Swapchain image count differs from the one at Init");
+	}
+
+	Gfx::QuerySwapchainImages(
+		device_,
+		swapchain_,
+		&presentation_frames_.images[0]);
+
+	for (uint32_t i = 0; i < swapchain_image_count_; i++)
+	{
+		Gfx::CreateImageView(
+			device_,
+			presentation_frames_.images[i],
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_VIEW_TYPE_2D,
+			surface_format_.format,
+			{
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY},
+			&allocator_,
+			&presentation_frames_.image_views[i]);
+	}
+
+	// Multisample color image, resolved into the swapchain image.
+	Gfx::CreateImage(
+		device_,
+		gpu_,
+		VK_IMAGE_TYPE_2D,
+		surface_format_.format,
+		{
+			surface_capabilities_.currentExtent.width,
+			surface_capabilities_.currentExtent.height,
+			1
+		},
+		sample_counts_,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&allocator_,
+		&framebuffer_sample_image_,
+		&framebuffer_sample_image_memory_);
+
+	Gfx::CreateImageView(
+		device_,
+		framebuffer_sample_image_,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_2D,
+		surface_format_.format,
+		{
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY
+		},
+		&allocator_,
+		&framebuffer_sample_image_view_);
+
+	// Depth
+	Gfx::CreateImage(
+		device_,
+		gpu_,
+		VK_IMAGE_TYPE_2D,
+		depth_format_,
+		{
+			surface_capabilities_.currentExtent.width,
+			surface_capabilities_.currentExtent.height,
+			1
+		},
+		sample_counts_,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&allocator_,
+		&depth_image_,
+		&depth_memory_);
+
+	Gfx::CreateImageView(
+		device_,
+		depth_image_,
+		VK_IMAGE_ASPECT_DEPTH_BIT,
+		VK_IMAGE_VIEW_TYPE_2D,
+		depth_format_,
+		{
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY
+		},
+		&allocator_,
+		&depth_image_view_);
+
+	if (!settings_.id_buffer)
+	{
+		return;
+	}
+
+	// Object ids: multisample attachment, and the single sample resolve the picked pixel is copied from.
+	const VkImageUsageFlags id_usages[2] = {
+		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+	};
+
+	const VkSampleCountFlagBits id_samples[2] = {
+		sample_counts_,
+		VK_SAMPLE_COUNT_1_BIT,
+	};
+
+	VkImage*        id_images[2]      = {&id_sample_image_, &id_image_};
+	VkImageView*    id_image_views[2] = {&id_sample_image_view_, &id_image_view_};
+	VkDeviceMemory* id_memories[2]    = {&id_sample_image_memory_, &id_image_memory_};
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		Gfx::CreateImage(
+			device_,
+			gpu_,
+			VK_IMAGE_TYPE_2D,
+			VK_FORMAT_R32_UINT,
+			{
+				surface_capabilities_.currentExtent.width,
+				surface_capabilities_.currentExtent.height,
+				1
+			},
+			id_samples[i],
+			VK_IMAGE_TILING_OPTIMAL,
+			id_usages[i],
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&allocator_,
+			id_images[i],
+			id_memories[i]);
+
+		Gfx::CreateImageView(
+			device_,
+			*id_images[i],
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_VIEW_TYPE_2D,
+			VK_FORMAT_R32_UINT,
+			{
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			&allocator_,
+			id_image_views[i]);
+	}
+}
+
+void VkApp::CreateFramebuffers()
+{
+	for (size_t i = 0; i < swapchain_image_count_; i++)
+	{
+		const VkImageView attachments[5] = {
+			framebuffer_sample_image_view_, // Multisample
+			depth_image_view_,
+			presentation_frames_.image_views[i], // Multisample resolver to 1 sample.
+			id_sample_image_view_,               // VkAppSettings::id_buffer only.
+			id_image_view_,
+		};
+
+		VkFramebufferCreateInfo framebuffer_info = {
+			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.renderPass = render_pass_,
+			.attachmentCount = settings_.id_buffer
+				? 5u
+				: 3u,
+			.pAttachments = &attachments[0],
+			.width = surface_capabilities_.currentExtent.width,
+			.height = surface_capabilities_.currentExtent.height,
+			.layers = 1,
+		};
+
+		VK_CHECK(vkCreateFramebuffer(
+			device_,
+			&framebuffer_info,
+			&allocator_,
+			&presentation_frames_.framebuffers[i]));
+	}
+}
+
+void VkApp::DestroySizeDependentResources()
+{
+	for (size_t i = 0; i < swapchain_image_count_; i++)
+	{
+		vkDestroyFramebuffer(device_, presentation_frames_.framebuffers[i], &allocator_);
+		vkDestroyImageView(device_, presentation_frames_.image_views[i], &allocator_);
+	}
+
+	vkDestroyImageView(device_, framebuffer_sample_image_view_, &allocator_);
+	vkDestroyImage(device_, framebuffer_sample_image_, &allocator_);
+	vkFreeMemory(device_, framebuffer_sample_image_memory_, &allocator_);
+
+	vkDestroyImageView(device_, depth_image_view_, &allocator_);
+	vkDestroyImage(device_, depth_image_, &allocator_);
+	vkFreeMemory(device_, depth_memory_, &allocator_);
+
+	// Null handles when the id buffer is off.
+	vkDestroyImageView(device_, id_sample_image_view_, &allocator_);
+	vkDestroyImage(device_, id_sample_image_, &allocator_);
+	vkFreeMemory(device_, id_sample_image_memory_, &allocator_);
+
+	vkDestroyImageView(device_, id_image_view_, &allocator_);
+	vkDestroyImage(device_, id_image_, &allocator_);
+	vkFreeMemory(device_, id_image_memory_, &allocator_);
+}
+
+bool VkApp::RecreateSwapchain()
+{
+	const Uint64 recreate_start = SDL_GetPerformanceCounter();
+
+	Gfx::QuerySurfaceCapabilities(
+		gpu_,
+		surface_,
+		&surface_capabilities_);
+
+	ResolveSurfaceExtent();
+
+	// Same image count as the swapchain the per image resources were created for (uniform buffers, descriptor sets,
+	// views and framebuffers), unless the surface now needs more than that.
+	if (surface_capabilities_.minImageCount > swapchain_image_count_)
+	{
+		throw std::runtime_error("Surface requires more swapchain images than at Init");
+	}
+
+	surface_capabilities_.minImageCount = swapchain_image_count_;
+
+	// A minimized window has a zero extent, there is nothing to present to.
+	if (surface_capabilities_.currentExtent.width == 0 || surface_capabilities_.currentExtent.height == 0)
+	{
+		return false;
+	}
+
+	// Only the last submitted frame (and its presentation) can still reference the old images.
+	VK_CHECK(vkQueueWaitIdle(queue_));
+
+	DestroySizeDependentResources();
+
+	VkSwapchainKHR old_swapchain = swapchain_;
+	Gfx::CreateSwapchain(
+		device_,
+		surface_,
+		&surface_format_,
+		&surface_capabilities_,
+		old_swapchain,
+		&allocator_,
+		&swapchain_);
+
+	vkDestroySwapchainKHR(device_, old_swapchain, &allocator_);
+
+	// Present ids are per swapchain: the ids of the old one will never be presented on the new one.
+	swapchain_first_present_id_ = present_id_ + 1;
+
+	CreateSizeDependentResources();
+	CreateFramebuffers();
+
+	const double recreate_ms = 1000.0 * static_cast<double>(SDL_GetPerformanceCounter() - recreate_start) /
+		static_cast<double>(SDL_GetPerformanceFrequency());
+
+	std::printf("[VK] Swapchain recreated (%ux%u) in %.3f ms\n",
+	            surface_capabilities_.currentExtent.width,
+	            surface_capabilities_.currentExtent.height,
+	            recreate_ms);
+
+	// Recreation happens inside the frame loop, so it should never cost more than one frame.
+	if (recreate_ms > targetFrameTime)
+	{
+		std::printf("[VK] [WARNING] Swapchain recreation exceeded the frame budget (%.3f ms)\n", targetFrameTime);
+	}
+
+	return true;
+}
+
+void VkApp::ResolveSurfaceExtent()
+{
+	// Some platforms (and headless surfaces) let the swapchain decide the extent.
+	if (surface_capabilities_.currentExtent.width != UINT32_MAX)
+	{
+		return;
+	}
+
+	if (settings_.headless)
+	{
+		surface_capabilities_.currentExtent = {
+			std::clamp(settings_.width, surface_capabilities_.minImageExtent.width, surface_capabilities_.maxImageExtent.width),
+			std::clamp(settings_.height, surface_capabilities_.minImageExtent.height, surface_capabilities_.maxImageExtent.height),
+		};
+
+		return;
+	}
+
+	int width  = 0;
+	int height = 0;
+	SDL_Vulkan_GetDrawableSize(window_, &width, &height);
+
+	surface_capabilities_.currentExtent = {
+		static_cast<uint32_t>(width),
+		static_cast<uint32_t>(height),
+	};
+}
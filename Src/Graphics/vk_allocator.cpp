@@ -4,11 +4,103 @@
 
 #include "vk_allocator.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
+namespace
+{
+/// Where an allocation comes from. Values from source_pool onwards are the pool index.
+enum Source : uint32_t
+{
+	source_heap  = 0,
+	source_arena = 1,
+	source_pool  = 2,
+};
+
+/// Stored right before every pointer returned to the driver.
+struct AllocationHeader
+{
+	void*    base   = nullptr; // Start of the heap block / pool block, or the owning arena.
+	size_t   size   = 0;
+	uint32_t source = source_heap;
+	uint32_t scope  = 0;
+};
+
+/// Command scope allocations only live for the duration of a single vk call, on the calling thread.
+struct Arena
+{
+	static constexpr size_t capacity = 64 * 1024;
+
+	std::byte*            memory = nullptr;
+	size_t                offset = 0;
+	std::atomic<uint32_t> live   = 0;
+
+	~Arena()
+	{
+		std::free(memory);
+	}
+};
+
+thread_local Arena arena = {};
+
+const char* scope_names[Gfx::Allocator::scope_count] = {
+	"Command",
+	"Object",
+	"Cache",
+	"Device",
+	"Instance",
+};
+
+/// Bytes needed to place the header and an aligned block of the given size anywhere in a 16-byte aligned region.
+size_t RequiredSize(
+	size_t size,
+	size_t alignment)
+{
+	return sizeof(AllocationHeader) + alignment - 1 + size;
+}
+
+/// Aligned user pointer after the header, header written in front of it.
+void* Place(
+	void*    p_region,
+	void*    base,
+	size_t   size,
+	size_t   alignment,
+	uint32_t source,
+	uint32_t scope)
+{
+	const uintptr_t first   = reinterpret_cast<uintptr_t>(p_region) + sizeof(AllocationHeader);
+	const uintptr_t aligned = (first + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+	AllocationHeader* header = reinterpret_cast<AllocationHeader*>(aligned) - 1;
+	*header                  = {base, size, source, scope};
+
+	return reinterpret_cast<void*>(aligned);
+}
+
+AllocationHeader* GetHeader(void* p_memory)
+{
+	return static_cast<AllocationHeader*>(p_memory) - 1;
+}
+}
+
 namespace Gfx
 {
 
+Allocator::~Allocator()
+{
+	for (Pool& pool : pools_)
+	{
+		for (void* chunk : pool.chunks)
+		{
+			std::free(chunk);
+		}
+	}
+}
+
 void* Allocator::Allocation(
 	void*                   pUserData,
 	size_t                  size,
@@ -40,9 +132,75 @@ void* Allocator::Allocation(
 	size_t                  alignment,
 	VkSystemAllocationScope allocation_scope)
 {
-	return _aligned_malloc(
-		size,
-		alignment);
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	// Keep the header itself aligned.
+	alignment = std::max(alignment, alignof(std::max_align_t));
+
+	const uint32_t scope    = std::min(static_cast<uint32_t>(allocation_scope), scope_count - 1);
+	const size_t   required = RequiredSize(size, alignment);
+	void*          p_memory = nullptr;
+
+	if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && required <= Arena::capacity)
+	{
+		if (!arena.memory)
+		{
+			arena.memory = static_cast<std::byte*>(std::malloc(Arena::capacity));
+		}
+
+		// Every command allocation has been freed: rewind.
+		if (arena.live.load(std::memory_order_acquire) == 0)
+		{
+			arena.offset = 0;
+		}
+
+		if (arena.memory && arena.offset + required <= Arena::capacity)
+		{
+			p_memory = Place(arena.memory + arena.offset, &arena, size, alignment, source_arena, scope);
+
+			arena.offset = static_cast<size_t>(static_cast<std::byte*>(p_memory) + size - arena.memory);
+			arena.live.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	else if (scope == VK_SYSTEM_ALLOCATION_SCOPE_OBJECT && required <= (pool_min_block << (pool_count - 1)))
+	{
+		uint32_t pool_idx = 0;
+		while ((pool_min_block << pool_idx) < required)
+		{
+			pool_idx++;
+		}
+
+		void* p_block = PoolAcquire(pool_idx);
+		if (p_block)
+		{
+			p_memory = Place(p_block, p_block, size, alignment, source_pool + pool_idx, scope);
+		}
+	}
+
+	// Device, instance and cache scopes, oversized requests and a full arena.
+	if (!p_memory)
+	{
+		void* p_block = std::malloc(required);
+		if (!p_block)
+		{
+			return nullptr;
+		}
+
+		p_memory = Place(p_block, p_block, size, alignment, source_heap, scope);
+	}
+
+	allocation_count_[scope].fetch_add(1, std::memory_order_relaxed);
+
+	const uint64_t current = current_bytes_[scope].fetch_add(size, std::memory_order_relaxed) + size;
+	uint64_t       peak    = peak_bytes_[scope].load(std::memory_order_relaxed);
+	while (current > peak && !peak_bytes_[scope].compare_exchange_weak(peak, current, std::memory_order_relaxed))
+	{
+	}
+
+	return p_memory;
 }
 
 void* Allocator::Reallocation(
@@ -51,12 +209,142 @@ void* Allocator::Reallocation(
 	size_t                  alignment,
 	VkSystemAllocationScope allocation_scope)
 {
-	return _aligned_realloc(pOriginal, size, alignment);
+	if (!pOriginal)
+	{
+		return Allocation(size, alignment, allocation_scope);
+	}
+
+	if (size == 0)
+	{
+		Free(pOriginal);
+		return nullptr;
+	}
+
+	// The spec keeps the original untouched on failure.
+	void* p_memory = Allocation(size, alignment, allocation_scope);
+	if (!p_memory)
+	{
+		return nullptr;
+	}
+
+	std::memcpy(p_memory, pOriginal, std::min(size, GetHeader(pOriginal)->size));
+	Free(pOriginal);
+
+	return p_memory;
 }
 
 void Allocator::Free(
 	void* pMemory)
 {
-	return _aligned_free(pMemory);
+	if (!pMemory)
+	{
+		return;
+	}
+
+	const AllocationHeader header = *GetHeader(pMemory);
+
+	free_count_[header.scope].fetch_add(1, std::memory_order_relaxed);
+	current_bytes_[header.scope].fetch_sub(header.size, std::memory_order_relaxed);
+
+	if (header.source == source_heap)
+	{
+		std::free(header.base);
+	}
+	else if (header.source == source_arena)
+	{
+		// The owner thread rewinds the arena on its next allocation.
+		static_cast<Arena*>(header.base)->live.fetch_sub(1, std::memory_order_release);
+	}
+	else
+	{
+		PoolRelease(header.source - source_pool, header.base);
+	}
+}
+
+void* Allocator::PoolAcquire(uint32_t pool_idx)
+{
+	Pool&                             pool = pools_[pool_idx];
+	const std::lock_guard<std::mutex> lock(pool.mutex);
+
+	if (!pool.free_list)
+	{
+		std::byte* chunk = static_cast<std::byte*>(std::malloc(pool_chunk_size));
+		if (!chunk)
+		{
+			return nullptr;
+		}
+
+		pool.chunks.push_back(chunk);
+
+		// Thread the blocks of the new chunk into the free list.
+		const size_t block_size = pool_min_block << pool_idx;
+		for (size_t offset = 0; offset + block_size <= pool_chunk_size; offset += block_size)
+		{
+			*reinterpret_cast<void**>(chunk + offset) = pool.free_list;
+			pool.free_list                            = chunk + offset;
+		}
+	}
+
+	void* p_block  = pool.free_list;
+	pool.free_list = *static_cast<void**>(p_block);
+
+	return p_block;
+}
+
+void Allocator::PoolRelease(
+	uint32_t pool_idx,
+	void*    p_block)
+{
+	Pool&                             pool = pools_[pool_idx];
+	const std::lock_guard<std::mutex> lock(pool.mutex);
+
+	*static_cast<void**>(p_block) = pool.free_list;
+	pool.free_list                = p_block;
+}
+
+void Allocator::QueryStatistics(Statistics* p_statistics) const
+{
+	for (uint32_t i = 0; i < scope_count; i++)
+	{
+		p_statistics->scopes[i] = {
+			.allocation_count = allocation_count_[i].load(std::memory_order_relaxed),
+			.free_count = free_count_[i].load(std::memory_order_relaxed),
+			.current_bytes = current_bytes_[i].load(std::memory_order_relaxed),
+			.peak_bytes = peak_bytes_[i].load(std::memory_order_relaxed),
+		};
+	}
+}
+
+void Allocator::PrintStatistics()
+{
+	Statistics statistics = {};
+	QueryStatistics(&statistics);
+
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	const double elapsed_s = (last_print_time_ == std::chrono::steady_clock::time_point{})
+		? 0.0
+		: std::chrono::duration<double>(now - last_print_time_).count();
+
+	for (uint32_t i = 0; i < scope_count; i++)
+	{
+		const ScopeStatistics& scope = statistics.scopes[i];
+
+		const double rate = (elapsed_s > 0.0)
+			? static_cast<double>(scope.allocation_count - last_allocation_count_[i]) / elapsed_s
+			: 0.0;
+
+		std::printf("[VK] [ALLOCATOR] %-8s allocs %llu frees %llu current %llu B peak %llu B rate %.1f allocs/s\n",
+		            scope_names[i],
+		            static_cast<unsigned long long>(scope.allocation_count),
+		            static_cast<unsigned long long>(scope.free_count),
+		            static_cast<unsigned long long>(scope.current_bytes),
+		            static_cast<unsigned long long>(scope.peak_bytes),
+		            rate);
+
+		last_allocation_count_[i] = scope.allocation_count;
+	}
+
+	last_print_time_ = now;
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,39 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "vk_extension.h"
+#include "vk_utils.h"
+
+#include <cstring>
+#include <vector>
+
+namespace Gfx
+{
+void QueryDeviceExtensionSupport(
+	VkPhysicalDevice gpu,
+	const char*      extension_name,
+	bool*            p_supported)
+{
+	uint32_t extension_count = 0;
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(
+		gpu,
+		nullptr,
+		&extension_count,
+		nullptr));
+
+	std::vector<VkExtensionProperties> extension_properties(extension_count);
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(
+		gpu,
+		nullptr,
+		&extension_count,
+		extension_properties.data()));
+
+	*p_supported = false;
+
+	for (uint32_t i = 0; i < extension_count && !*p_supported; i++)
+	{
+		*p_supported = std::strcmp(extension_name, extension_properties[i].extensionName) == 0;
+	}
+}
+}
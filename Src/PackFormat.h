@@ -0,0 +1,66 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#ifndef PACK_FORMAT_H
+#define PACK_FORMAT_H
+
+#include <cstdint>
+#include <string_view>
+
+/// Layout of a pack file (.pak), shared by the Packer tool and the FileSystem backend.
+///
+/// | PackHeader | payloads (each 4 KiB aligned) ... | PackEntry[entry_count] sorted by path_hash |
+///
+/// Uncompressed payloads are page aligned, so they can be handed out directly from the mapping of the pack.
+namespace Pack
+{
+constexpr uint32_t magic_value   = 0x4B415041; // "APAK"
+constexpr uint32_t version_value = 1;
+constexpr uint64_t alignment     = 4096;
+
+enum class Compression : uint32_t
+{
+	None = 0,
+	LZ4  = 1,
+	Zstd = 2,
+};
+
+struct Header
+{
+	uint32_t magic       = magic_value;
+	uint32_t version     = version_value;
+	uint32_t entry_count = 0;
+	uint32_t reserved    = 0;
+	uint64_t toc_offset  = 0;
+};
+
+struct Entry
+{
+	uint64_t    path_hash   = 0;
+	uint64_t    offset      = 0;
+	uint64_t    stored_size = 0; // Bytes in the pack.
+	uint64_t    size        = 0; // Bytes once decompressed.
+	Compression compression = Compression::None;
+	uint32_t    reserved    = 0;
+};
+
+static_assert(sizeof(Header) == 24);
+static_assert(sizeof(Entry) == 40);
+
+/// FNV-1a 64 of the path relative to the pack root, with '\\' folded to '/'.
+constexpr uint64_t HashPath(std::string_view path)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	for (char c : path)
+	{
+		hash ^= static_cast<uint8_t>((c == '\\') ? '/' : c);
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+}
+
+#endif //PACK_FORMAT_H
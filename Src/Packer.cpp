@@ -0,0 +1,236 @@
+//
+// Created by apant on 19/10/2026.
+//
+
+#include "PackFormat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef ADRO_PACK_LZ4
+#include <lz4hc.h>
+#endif
+
+#ifdef ADRO_PACK_ZSTD
+#include <zstd.h>
+#endif
+
+/// Offline tool writing a pack file (see PackFormat.h), run by the Pack build step.
+///
+/// Usage: Packer [--compress none|lz4|zstd] <output.pak> <root_dir> <relative paths...>
+///
+/// Paths are hashed relative to root_dir, the same way FileSystem hashes them relative to the mount point.
+/// A compressed entry is kept only if it is smaller than the source.
+
+namespace
+{
+struct PackedFile
+{
+	std::string       path    = {};
+	Pack::Entry       entry   = {};
+	std::vector<char> payload = {};
+};
+
+bool ReadWholeFile(
+	const std::string& path,
+	std::vector<char>* p_content)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	p_content->resize(static_cast<size_t>(file.tellg()));
+
+	file.seekg(0);
+	file.read(p_content->data(), static_cast<std::streamsize>(p_content->size()));
+
+	return true;
+}
+
+/// Compress the source, empty output if the codec is not available or doesn't shrink it.
+std::vector<char> Compress(
+	Pack::Compression        compression,
+	const std::vector<char>& source)
+{
+	std::vector<char> output = {};
+
+	switch (compression)
+	{
+#ifdef ADRO_PACK_LZ4
+	case Pack::Compression::LZ4:
+	{
+		output.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(source.size()))));
+		const int size = LZ4_compress_HC(
+			source.data(),
+			output.data(),
+			static_cast<int>(source.size()),
+			static_cast<int>(output.size()),
+			LZ4HC_CLEVEL_MAX);
+		output.resize(static_cast<size_t>(std::max(size, 0)));
+		break;
+	}
+#endif
+
+#ifdef ADRO_PACK_ZSTD
+	case Pack::Compression::Zstd:
+	{
+		output.resize(ZSTD_compressBound(source.size()));
+		const size_t size = ZSTD_compress(output.data(), output.size(), source.data(), source.size(), 19);
+		output.resize(ZSTD_isError(size) ? 0 : size);
+		break;
+	}
+#endif
+
+	default:
+		break;
+	}
+
+	if (output.size() >= source.size())
+	{
+		output.clear();
+	}
+
+	return output;
+}
+}
+
+int main(int argc, char** argv)
+{
+	Pack::Compression compression = Pack::Compression::None;
+	int               first_arg   = 1;
+
+	if (argc > 2 && std::strcmp(argv[1], "--compress") == 0)
+	{
+		if (std::strcmp(argv[2], "lz4") == 0)
+		{
+			compression = Pack::Compression::LZ4;
+		}
+		else if (std::strcmp(argv[2], "zstd") == 0)
+		{
+			compression = Pack::Compression::Zstd;
+		}
+
+		first_arg = 3;
+	}
+
+	if (argc - first_arg < 3)
+	{
+		std::printf("Usage: Packer [--compress none|lz4|zstd] <output.pak> <root_dir> <relative paths...>\n");
+		return 1;
+	}
+
+	const char*       output_path = argv[first_arg];
+	const std::string root        = std::string(argv[first_arg + 1]) + "/";
+
+	std::vector<PackedFile> files = {};
+
+	for (int i = first_arg + 2; i < argc; i++)
+	{
+		PackedFile file = {.path = argv[i]};
+
+		std::vector<char> content = {};
+
+		if (!ReadWholeFile(root + file.path, &content))
+		{
+			std::printf("[PACKER] Failed to open %s\n", (root + file.path).c_str());
+			return 1;
+		}
+
+		file.entry.path_hash = Pack::HashPath(file.path);
+		file.entry.size      = content.size();
+
+		file.payload = Compress(compression, content);
+
+		if (file.payload.empty())
+		{
+			file.payload = std::move(content);
+		}
+		else
+		{
+			file.entry.compression = compression;
+		}
+
+		file.entry.stored_size = file.payload.size();
+
+		files.push_back(std::move(file));
+	}
+
+	// The table of contents is binary searched at runtime.
+	std::sort(files.begin(), files.end(), [](const PackedFile& lhs, const PackedFile& rhs)
+	{
+		return lhs.entry.path_hash < rhs.entry.path_hash;
+	});
+
+	for (size_t i = 1; i < files.size(); i++)
+	{
+		if (files[i].entry.path_hash == files[i - 1].entry.path_hash)
+		{
+			std::printf("[PACKER] Hash collision: %s and %s\n", files[i - 1].path.c_str(), files[i].path.c_str());
+			return 1;
+		}
+	}
+
+	std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+
+	if (!output.is_open())
+	{
+		std::printf("[PACKER] Failed to open %s\n", output_path);
+		return 1;
+	}
+
+	const auto align_up = [](uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	};
+
+	const std::vector<char> padding(Pack::alignment, 0);
+	uint64_t                offset = sizeof(Pack::Header);
+
+	// Payloads start on a page boundary, so an uncompressed one is served straight from the mapping.
+	output.seekp(static_cast<std::streamoff>(offset));
+
+	for (PackedFile& file : files)
+	{
+		const uint64_t aligned = align_up(offset, Pack::alignment);
+
+		output.write(padding.data(), static_cast<std::streamsize>(aligned - offset));
+		output.write(file.payload.data(), static_cast<std::streamsize>(file.payload.size()));
+
+		file.entry.offset = aligned;
+		offset            = aligned + file.payload.size();
+	}
+
+	const uint64_t toc_offset = align_up(offset, alignof(Pack::Entry));
+
+	output.write(padding.data(), static_cast<std::streamsize>(toc_offset - offset));
+
+	for (const PackedFile& file : files)
+	{
+		output.write(reinterpret_cast<const char*>(&file.entry), sizeof(file.entry));
+	}
+
+	const Pack::Header header = {
+		.entry_count = static_cast<uint32_t>(files.size()),
+		.toc_offset = toc_offset,
+	};
+
+	output.seekp(0);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	if (!output.good())
+	{
+		std::printf("[PACKER] Failed to write %s\n", output_path);
+		return 1;
+	}
+
+	std::printf("[PACKER] Wrote %s (%zu entries)\n", output_path, files.size());
+
+	return 0;
+}
@@ -1,7 +1,11 @@
 #include "VkApp.h"
+#include "FileSystem.h"
 
 int main()
 {
+	// Optional, loose files are used when the pack hasn't been built.
+	FileSystem::MountPack("../Resources/Resources.pak", "../Resources/");
+
 	VkApp app = {};
 	app.Init();
 	app.Update();